@@ -455,6 +455,15 @@ void D3D12RaytracingHelloWorld::CreateTestCase()
 
     CreateGeometry(0.5f, 0, 0, 1.0f, TRUE);
 
+    TestCaseDescs testCaseDescs;
+    if (LoadTestCaseDescs(&testCaseDescs))
+    {
+        m_geomDescs = testCaseDescs.geomDescs;
+        m_listOfBlasDesc = testCaseDescs.blasDescs;
+        m_listOfTlasDesc = testCaseDescs.tlasDescs;
+        return;
+    }
+
     auto AddGeometryDesc = [&](UINT index,
                                D3D12_RAYTRACING_GEOMETRY_TYPE geomType = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
                                D3D12_RAYTRACING_GEOMETRY_FLAGS flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE)
@@ -507,6 +516,34 @@ void D3D12RaytracingHelloWorld::CreateTestCase()
     AddTlasDesc(3, 3, 1.0f, 1.0f);
 }
 
+// Replace the scene with another test case's, keeping the device, root signatures and state object.
+void D3D12RaytracingHelloWorld::SwapTestCase(const TestCaseDescs& descs)
+{
+    m_deviceResources->WaitForGpu();
+
+    for (UINT i = 0; i < _countof(m_vertexBuffer); i++)
+    {
+        m_vertexBuffer[i].Reset();
+        m_indexBuffer[i].Reset();
+    }
+    m_aabbBuffer.Reset();
+    m_accelerationStructure.Reset();
+    m_topLevelAccelerationStructure.Reset();
+
+    // BuildAccelerationStructures() sizes its arrays by capacity(), so the lists must not keep the old test case's.
+    vector<GeomDesc>().swap(m_geomDescs);
+    vector<DxBlasDesc>().swap(m_listOfBlasDesc);
+    vector<DxTlasDesc>().swap(m_listOfTlasDesc);
+    vector<AccelerationStructureBuffers>().swap(m_listofBlasBuffersInfo);
+
+    m_batchTestCase = &descs;
+    CreateTestCase();
+    m_batchTestCase = nullptr;
+
+    BuildAccelerationStructures();
+    BuildShaderTables();
+}
+
 // Build acceleration structures needed for raytracing.
 void D3D12RaytracingHelloWorld::BuildAccelerationStructures()
 {
@@ -58,6 +58,7 @@ public:
     virtual void OnDestroy();
     virtual IDXGISwapChain* GetSwapchain() { return m_deviceResources->GetSwapChain(); }
     virtual ID3D12DescriptorHeap* GetOutputDescriptorHeap();
+    virtual void SwapTestCase(const TestCaseDescs& descs) override;
 
 private:
     // DirectX Raytracing (DXR) attributes
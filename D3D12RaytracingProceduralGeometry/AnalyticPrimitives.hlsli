@@ -220,4 +220,130 @@ bool RayAABBIntersectionTest(Ray ray, float3 aabb[2], out float thit, out Proced
     return false;
 }
 
+#if USE_ROBUST_ANALYTIC_PRIMITIVES
+// Both intersections of a ray with a sphere, near and far along the ray.
+// b * b - 4 * a * c loses all precision once the origin is many radii away, as both terms grow
+// with the squared distance. Instead the discriminant comes from l, the vector from the center
+// to the point of the line closest to it, which stays as small as the sphere. The roots are
+// q / a and c / q, with q = b + sign(b) * sqrt(discriminant) free of cancellation.
+// The hit points relative to the center are l -/+ offset * ray.direction.
+// Ref: Haines et al., Precision Improvements for Ray/Sphere Intersection, Ray Tracing Gems, 2019
+bool SolveRaySphereIntersectionEquationRobust(in Ray ray, in float3 center, in float radius, out float tnear, out float tfar, out float3 l, out float offset)
+{
+    float3 f = ray.origin - center;
+    float a = dot(ray.direction, ray.direction);
+    float b = -dot(ray.direction, f);       // -b / 2 of the textbook equation.
+    float s = b / a;                        // Parameter of the closest point.
+    l = f + s * ray.direction;
+    float radius2 = radius * radius;
+    float discr = radius2 - dot(l, l);      // Divided by a.
+    if (!(discr >= 0)) return false;
+
+    float root = sqrt(a * discr);
+    float q = (b >= 0) ? b + root : b - root;
+    float c = dot(f, f) - radius2;
+    float qOverA = q / a;
+    float cOverQ = (q != 0) ? c / q : s;
+    tnear = (b >= 0) ? cOverQ : qOverA;
+    tfar = (b >= 0) ? qOverA : cOverQ;
+    offset = root / a;
+    return true;
+}
+
+// Test if a ray with RayFlags and segment <RayTMin(), RayTCurrent()> intersects a hollow sphere.
+// Same hits as RaySphereIntersectionTest(), with the normals taken relative to the closest point.
+bool RaySphereIntersectionTestRobust(in Ray ray, out float thit, out ProceduralPrimitiveAttributes attr, in float3 center = float3(0, 0, 0), in float radius = 1)
+{
+    float tnear, tfar, offset;
+    float3 l;
+    if (!SolveRaySphereIntersectionEquationRobust(ray, center, radius, tnear, tfar, l, offset)) return false;
+
+    attr.normal = normalize(l - offset * ray.direction);
+    if (IsAValidHit(ray, tnear, attr.normal))
+    {
+        thit = tnear;
+        return true;
+    }
+
+    attr.normal = normalize(l + offset * ray.direction);
+    if (IsAValidHit(ray, tfar, attr.normal))
+    {
+        thit = tfar;
+        return true;
+    }
+    return false;
+}
+
+// RaySpheresIntersectionTest() with RaySphereIntersectionTestRobust().
+bool RaySpheresIntersectionTestRobust(in Ray ray, out float thit, out ProceduralPrimitiveAttributes attr)
+{
+    const int N = 3;
+    float3 centers[N] =
+    {
+        float3(-0.3, -0.3, -0.3),
+        float3(0.1, 0.1, 0.4),
+        float3(0.35,0.35, 0.0)
+    };
+    float  radii[N] = { 0.6, 0.3, 0.15 };
+    bool hitFound = false;
+
+    thit = RayTCurrent();
+    for (int i = 0; i < N; i++)
+    {
+        float _thit;
+        ProceduralPrimitiveAttributes _attr = (ProceduralPrimitiveAttributes)0;
+        if (RaySphereIntersectionTestRobust(ray, _thit, _attr, centers[i], radii[i]))
+        {
+            if (_thit < thit)
+            {
+                thit = _thit;
+                attr = _attr;
+                hitFound = true;
+            }
+        }
+    }
+    return hitFound;
+}
+
+// Test if a ray with RayFlags and segment <RayTMin(), RayTCurrent()> intersects a hollow AABB.
+// A zero direction component gets an infinite reciprocal, and a ray in the plane of a slab
+// gets 0 * inf = NaN, which the comparisons below skip, so no case needs special handling.
+// The normal is that of the face the ray enters last, rather than found from the hit
+// position with an absolute epsilon that stops working far from the origin.
+bool RayAABBIntersectionTestRobust(in Ray ray, in float3 aabb[2], out float thit, out ProceduralPrimitiveAttributes attr)
+{
+    const float FLT_INFINITY = 1.#INF;
+    float3 invRayDirection = ray.direction != 0 ? 1 / ray.direction : FLT_INFINITY;
+    bool3 positive = invRayDirection >= 0;
+    float3 tnear3 = ((positive ? aabb[0] : aabb[1]) - ray.origin) * invRayDirection;
+    float3 tfar3 = ((positive ? aabb[1] : aabb[0]) - ray.origin) * invRayDirection;
+    float3 faceNormal = positive ? float3(-1, -1, -1) : float3(1, 1, 1);
+
+    float tenter = -FLT_INFINITY;
+    attr.normal = float3(0, 0, 0);
+    if (tnear3.x > tenter)
+    {
+        tenter = tnear3.x;
+        attr.normal = float3(faceNormal.x, 0, 0);
+    }
+    if (tnear3.y > tenter)
+    {
+        tenter = tnear3.y;
+        attr.normal = float3(0, faceNormal.y, 0);
+    }
+    if (tnear3.z > tenter)
+    {
+        tenter = tnear3.z;
+        attr.normal = float3(0, 0, faceNormal.z);
+    }
+    float texit = min(min(tfar3.x, tfar3.y), tfar3.z);
+
+    // Only consider intersections crossing the surface from the outside.
+    if (!(tenter <= texit) || !IsAValidHit(ray, tenter, attr.normal)) return false;
+
+    thit = tenter;
+    return true;
+}
+#endif
+
 #endif // ANALYTICPRIMITIVES_H
\ No newline at end of file
@@ -25,6 +25,20 @@ const wchar_t* D3D12RaytracingProceduralGeometry::c_intersectionShaderNames[] =
     L"MyIntersectionShader_VolumetricPrimitive",
     L"MyIntersectionShader_SignedDistancePrimitive",
 };
+// Per primitive type intersection shaders of USE_SPECIALIZED_INTERSECTION_SHADERS, in AABB instance order.
+const wchar_t* D3D12RaytracingProceduralGeometry::c_specializedIntersectionShaderNames[] =
+{
+    L"MyIntersectionShader_AnalyticPrimitive_AABB",
+    L"MyIntersectionShader_AnalyticPrimitive_Spheres",
+    L"MyIntersectionShader_VolumetricPrimitive_Metaballs",
+    L"MyIntersectionShader_SignedDistancePrimitive_MiniSpheres",
+    L"MyIntersectionShader_SignedDistancePrimitive_IntersectedRoundCube",
+    L"MyIntersectionShader_SignedDistancePrimitive_SquareTorus",
+    L"MyIntersectionShader_SignedDistancePrimitive_TwistedTorus",
+    L"MyIntersectionShader_SignedDistancePrimitive_Cog",
+    L"MyIntersectionShader_SignedDistancePrimitive_Cylinder",
+    L"MyIntersectionShader_SignedDistancePrimitive_FractalPyramid",
+};
 const wchar_t* D3D12RaytracingProceduralGeometry::c_closestHitShaderNames[] =
 {
     L"MyClosestHitShader_Triangle",
@@ -45,6 +59,19 @@ const wchar_t* D3D12RaytracingProceduralGeometry::c_hitGroupNames_AABBGeometry[]
     { L"MyHitGroup_AABB_VolumetricPrimitive", L"MyHitGroup_AABB_VolumetricPrimitive_ShadowRay" },
     { L"MyHitGroup_AABB_SignedDistancePrimitive", L"MyHitGroup_AABB_SignedDistancePrimitive_ShadowRay" },
 };
+const wchar_t* D3D12RaytracingProceduralGeometry::c_specializedHitGroupNames_AABBGeometry[][RayType::Count] =
+{
+    { L"MyHitGroup_AABB_AnalyticPrimitive_AABB", L"MyHitGroup_AABB_AnalyticPrimitive_AABB_ShadowRay" },
+    { L"MyHitGroup_AABB_AnalyticPrimitive_Spheres", L"MyHitGroup_AABB_AnalyticPrimitive_Spheres_ShadowRay" },
+    { L"MyHitGroup_AABB_VolumetricPrimitive_Metaballs", L"MyHitGroup_AABB_VolumetricPrimitive_Metaballs_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_MiniSpheres", L"MyHitGroup_AABB_SignedDistancePrimitive_MiniSpheres_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_IntersectedRoundCube", L"MyHitGroup_AABB_SignedDistancePrimitive_IntersectedRoundCube_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_SquareTorus", L"MyHitGroup_AABB_SignedDistancePrimitive_SquareTorus_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_TwistedTorus", L"MyHitGroup_AABB_SignedDistancePrimitive_TwistedTorus_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_Cog", L"MyHitGroup_AABB_SignedDistancePrimitive_Cog_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_Cylinder", L"MyHitGroup_AABB_SignedDistancePrimitive_Cylinder_ShadowRay" },
+    { L"MyHitGroup_AABB_SignedDistancePrimitive_FractalPyramid", L"MyHitGroup_AABB_SignedDistancePrimitive_FractalPyramid_ShadowRay" },
+};
 
 D3D12RaytracingProceduralGeometry::D3D12RaytracingProceduralGeometry(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
@@ -393,6 +420,21 @@ void D3D12RaytracingProceduralGeometry::CreateHitGroupSubobjects(CD3DX12_STATE_O
 
     // AABB geometry hit groups
     {
+#if USE_SPECIALIZED_INTERSECTION_SHADERS
+        // Create hit groups for each primitive type's intersection shader.
+        for (UINT p = 0; p < IntersectionShaderType::TotalPrimitiveCount; p++)
+            for (UINT rayType = 0; rayType < RayType::Count; rayType++)
+            {
+                auto hitGroup = raytracingPipeline->CreateSubobject<CD3DX12_HIT_GROUP_SUBOBJECT>();
+                hitGroup->SetIntersectionShaderImport(c_specializedIntersectionShaderNames[p]);
+                if (rayType == RayType::Radiance)
+                {
+                    hitGroup->SetClosestHitShaderImport(c_closestHitShaderNames[GeometryType::AABB]);
+                }
+                hitGroup->SetHitGroupExport(c_specializedHitGroupNames_AABBGeometry[p][rayType]);
+                hitGroup->SetHitGroupType(D3D12_HIT_GROUP_TYPE_PROCEDURAL_PRIMITIVE);
+            }
+#else
         // Create hit groups for each intersection shader.
         for (UINT t = 0; t < IntersectionShaderType::Count; t++)
             for (UINT rayType = 0; rayType < RayType::Count; rayType++)
@@ -406,6 +448,7 @@ void D3D12RaytracingProceduralGeometry::CreateHitGroupSubobjects(CD3DX12_STATE_O
                 hitGroup->SetHitGroupExport(c_hitGroupNames_AABBGeometry[t][rayType]);
                 hitGroup->SetHitGroupType(D3D12_HIT_GROUP_TYPE_PROCEDURAL_PRIMITIVE);
             }
+#endif
     }
 }
 
@@ -433,10 +476,17 @@ void D3D12RaytracingProceduralGeometry::CreateLocalRootSignatureSubobjects(CD3DX
         // Shader association
         auto rootSignatureAssociation = raytracingPipeline->CreateSubobject<CD3DX12_SUBOBJECT_TO_EXPORTS_ASSOCIATION_SUBOBJECT>();
         rootSignatureAssociation->SetSubobjectToAssociate(*localRootSignature);
+#if USE_SPECIALIZED_INTERSECTION_SHADERS
+        for (auto& hitGroupsForPrimitiveType : c_specializedHitGroupNames_AABBGeometry)
+        {
+            rootSignatureAssociation->AddExports(hitGroupsForPrimitiveType);
+        }
+#else
         for (auto& hitGroupsForIntersectionShaderType : c_hitGroupNames_AABBGeometry)
         {
             rootSignatureAssociation->AddExports(hitGroupsForIntersectionShaderType);
         }
+#endif
     }
 }
 
@@ -893,7 +943,11 @@ void D3D12RaytracingProceduralGeometry::BuildShaderTables()
     void* rayGenShaderID;
     void* missShaderIDs[RayType::Count];
     void* hitGroupShaderIDs_TriangleGeometry[RayType::Count];
+#if USE_SPECIALIZED_INTERSECTION_SHADERS
+    void* specializedHitGroupShaderIDs_AABBGeometry[IntersectionShaderType::TotalPrimitiveCount][RayType::Count];
+#else
     void* hitGroupShaderIDs_AABBGeometry[IntersectionShaderType::Count][RayType::Count];
+#endif
 
     // A shader name look-up table for shader table debug print out.
     unordered_map<void*, wstring> shaderIdToStringMap;
@@ -913,12 +967,21 @@ void D3D12RaytracingProceduralGeometry::BuildShaderTables()
             hitGroupShaderIDs_TriangleGeometry[i] = stateObjectProperties->GetShaderIdentifier(c_hitGroupNames_TriangleGeometry[i]);
             shaderIdToStringMap[hitGroupShaderIDs_TriangleGeometry[i]] = c_hitGroupNames_TriangleGeometry[i];
         }
+#if USE_SPECIALIZED_INTERSECTION_SHADERS
+        for (UINT p = 0; p < IntersectionShaderType::TotalPrimitiveCount; p++)
+            for (UINT c = 0; c < RayType::Count; c++)
+            {
+                specializedHitGroupShaderIDs_AABBGeometry[p][c] = stateObjectProperties->GetShaderIdentifier(c_specializedHitGroupNames_AABBGeometry[p][c]);
+                shaderIdToStringMap[specializedHitGroupShaderIDs_AABBGeometry[p][c]] = c_specializedHitGroupNames_AABBGeometry[p][c];
+            }
+#else
         for (UINT r = 0; r < IntersectionShaderType::Count; r++)
             for (UINT c = 0; c < RayType::Count; c++)        
             {
                 hitGroupShaderIDs_AABBGeometry[r][c] = stateObjectProperties->GetShaderIdentifier(c_hitGroupNames_AABBGeometry[r][c]); 
                 shaderIdToStringMap[hitGroupShaderIDs_AABBGeometry[r][c]] = c_hitGroupNames_AABBGeometry[r][c];
             }
+#endif
     };
 
     // Get shader identifiers.
@@ -946,6 +1009,14 @@ void D3D12RaytracingProceduralGeometry::BuildShaderTables()
     | [20] : MyHitGroup_AABB_SignedDistancePrimitive
     | [21] : MyHitGroup_AABB_SignedDistancePrimitive_ShadowRay
     | --------------------------------------------------------------------
+    | With USE_SPECIALIZED_INTERSECTION_SHADERS the AABB records use the
+    | hit groups of their primitive types instead:
+    | [2] : MyHitGroup_AABB_AnalyticPrimitive_AABB
+    | [3] : MyHitGroup_AABB_AnalyticPrimitive_AABB_ShadowRay
+    | ...
+    | [20] : MyHitGroup_AABB_SignedDistancePrimitive_FractalPyramid
+    | [21] : MyHitGroup_AABB_SignedDistancePrimitive_FractalPyramid_ShadowRay
+    | --------------------------------------------------------------------
     **********************************************************************/
 
      // RayGen shader table.
@@ -1011,7 +1082,11 @@ void D3D12RaytracingProceduralGeometry::BuildShaderTables()
                     // Ray types.
                     for (UINT r = 0; r < RayType::Count; r++)
                     {
+#if USE_SPECIALIZED_INTERSECTION_SHADERS
+                        auto& hitGroupShaderID = specializedHitGroupShaderIDs_AABBGeometry[instanceIndex][r];
+#else
                         auto& hitGroupShaderID = hitGroupShaderIDs_AABBGeometry[iShader][r];
+#endif
                         hitGroupShaderTable.push_back(ShaderRecord(hitGroupShaderID, shaderIDSize, &rootArgs, sizeof(rootArgs)));
                     }
                 }
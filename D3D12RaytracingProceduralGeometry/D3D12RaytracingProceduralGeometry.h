@@ -79,6 +79,8 @@ private:
     static const wchar_t* c_hitGroupNames_AABBGeometry[IntersectionShaderType::Count][RayType::Count];
     static const wchar_t* c_raygenShaderName;
     static const wchar_t* c_intersectionShaderNames[IntersectionShaderType::Count];
+    static const wchar_t* c_specializedIntersectionShaderNames[IntersectionShaderType::TotalPrimitiveCount];
+    static const wchar_t* c_specializedHitGroupNames_AABBGeometry[IntersectionShaderType::TotalPrimitiveCount][RayType::Count];
     static const wchar_t* c_closestHitShaderNames[GeometryType::Count];
     static const wchar_t* c_missShaderNames[RayType::Count];
 
@@ -39,8 +39,13 @@ bool RayAnalyticGeometryIntersectionTest(in Ray ray, in AnalyticPrimitive::Enum
 
     switch (analyticPrimitive)
     {
+#if USE_ROBUST_ANALYTIC_PRIMITIVES
+    case AnalyticPrimitive::AABB: return RayAABBIntersectionTestRobust(ray, aabb, thit, attr);
+    case AnalyticPrimitive::Spheres: return RaySpheresIntersectionTestRobust(ray, thit, attr);
+#else
     case AnalyticPrimitive::AABB: return RayAABBIntersectionTest(ray, aabb, thit, attr);
     case AnalyticPrimitive::Spheres: return RaySpheresIntersectionTest(ray, thit, attr);
+#endif
     default: return false;
     }
 }
@@ -51,7 +56,11 @@ bool RayVolumetricGeometryIntersectionTest(in Ray ray, in VolumetricPrimitive::E
 {
     switch (volumetricPrimitive)
     {
+#if USE_METABALL_INTERVAL_BOUNDS
+    case VolumetricPrimitive::Metaballs: return RayMetaballsIntervalIntersectionTest(ray, thit, attr, elapsedTime);
+#else
     case VolumetricPrimitive::Metaballs: return RayMetaballsIntersectionTest(ray, thit, attr, elapsedTime);
+#endif
     default: return false;
     }
 }
@@ -45,8 +45,30 @@ typedef UINT16 Index;
 #define LIMIT_TO_ACTIVE_METABALLS 0
 #endif
 
+// Metaballs skip ray segments whose bounded field potential stays below the isosurface threshold and
+// refine the crossing with Newton iterations (RayMetaballsIntervalIntersectionTest()) instead of
+// taking 128 uniform steps.
+#define USE_METABALL_INTERVAL_BOUNDS 0
+#define METABALL_INTERVAL_MAX_STEPS 256         // Field evaluations, incl. bounds, per ray.
+#define METABALL_INTERVAL_REFINEMENT_STEPS 4
+
 #define N_FRACTAL_ITERATIONS 4      // = <1,...>
 
+// Analytic spheres and AABBs use the intersection tests without catastrophic cancellation
+// (RaySpheresIntersectionTestRobust(), RayAABBIntersectionTestRobust()), which stay accurate
+// for rays from origins far away from the primitive.
+#define USE_ROBUST_ANALYTIC_PRIMITIVES 0
+
+// Over-relaxed sphere tracing clipped to the AABB for signed distance primitives
+// (RaySignedDistancePrimitiveTestRelaxed()), with steps scaled by SPHERE_TRACING_RELAXATION.
+#define USE_RELAXED_SPHERE_TRACING 0
+#define SPHERE_TRACING_RELAXATION 1.6   // = <1,2)
+
+// Builds a hit group per procedural primitive type with its own intersection shader, compiled
+// for that type (MyIntersectionShader_<geometry>_<primitive> in Raytracing.hlsl), so the shader
+// doesn't switch on l_aabbCB.primitiveType at every sphere tracing step.
+#define USE_SPECIALIZED_INTERSECTION_SHADERS 0
+
 // PERFORMANCE TIP: Set max recursion depth as low as needed
 // as drivers may apply optimization strategies for low recursion depths.
 #define MAX_RAY_RECURSION_DEPTH 3    // ~ primary rays + reflections + shadow rays from reflected geometry.
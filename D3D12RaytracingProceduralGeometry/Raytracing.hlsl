@@ -341,7 +341,11 @@ void MyIntersectionShader_SignedDistancePrimitive()
 
     float thit;
     ProceduralPrimitiveAttributes attr = (ProceduralPrimitiveAttributes)0;
+#if USE_RELAXED_SPHERE_TRACING
+    if (RaySignedDistancePrimitiveTestRelaxed(localRay, primitiveType, thit, attr, l_materialCB.stepScale, SPHERE_TRACING_RELAXATION))
+#else
     if (RaySignedDistancePrimitiveTest(localRay, primitiveType, thit, attr, l_materialCB.stepScale))
+#endif
     {
         PrimitiveInstancePerFrameBuffer aabbAttribute = g_AABBPrimitiveAttributes[l_aabbCB.instanceIndex];
         attr.normal = mul(attr.normal, (float3x3) aabbAttribute.localSpaceToBottomLevelAS);
@@ -351,4 +355,79 @@ void MyIntersectionShader_SignedDistancePrimitive()
     }
 }
 
+#if USE_SPECIALIZED_INTERSECTION_SHADERS
+// An intersection shader per primitive type, e.g. MyIntersectionShader_SignedDistancePrimitive_Cog.
+// The bodies are those of the shaders above, with the primitive type passed in instead of read from l_aabbCB.
+// With the type a literal, the switches on it, including the one in GetDistanceFromSignedDistancePrimitive()
+// at every sphere tracing step, fold away once the body is inlined.
+
+// Transform a local space normal to world space and report a hit.
+void ReportAABBPrimitiveHit(in float thit, in ProceduralPrimitiveAttributes attr)
+{
+    PrimitiveInstancePerFrameBuffer aabbAttribute = g_AABBPrimitiveAttributes[l_aabbCB.instanceIndex];
+    attr.normal = mul(attr.normal, (float3x3) aabbAttribute.localSpaceToBottomLevelAS);
+    attr.normal = normalize(mul((float3x3) ObjectToWorld3x4(), attr.normal));
+
+    ReportHit(thit, /*hitKind*/ 0, attr);
+}
+
+void AnalyticPrimitiveIntersection(in AnalyticPrimitive::Enum primitiveType)
+{
+    Ray localRay = GetRayInAABBPrimitiveLocalSpace();
+
+    float thit;
+    ProceduralPrimitiveAttributes attr = (ProceduralPrimitiveAttributes)0;
+    if (RayAnalyticGeometryIntersectionTest(localRay, primitiveType, thit, attr))
+    {
+        ReportAABBPrimitiveHit(thit, attr);
+    }
+}
+
+void VolumetricPrimitiveIntersection(in VolumetricPrimitive::Enum primitiveType)
+{
+    Ray localRay = GetRayInAABBPrimitiveLocalSpace();
+    
+    float thit;
+    ProceduralPrimitiveAttributes attr = (ProceduralPrimitiveAttributes)0;
+    if (RayVolumetricGeometryIntersectionTest(localRay, primitiveType, thit, attr, g_sceneCB.elapsedTime))
+    {
+        ReportAABBPrimitiveHit(thit, attr);
+    }
+}
+
+void SignedDistancePrimitiveIntersection(in SignedDistancePrimitive::Enum primitiveType)
+{
+    Ray localRay = GetRayInAABBPrimitiveLocalSpace();
+
+    float thit;
+    ProceduralPrimitiveAttributes attr = (ProceduralPrimitiveAttributes)0;
+#if USE_RELAXED_SPHERE_TRACING
+    if (RaySignedDistancePrimitiveTestRelaxed(localRay, primitiveType, thit, attr, l_materialCB.stepScale, SPHERE_TRACING_RELAXATION))
+#else
+    if (RaySignedDistancePrimitiveTest(localRay, primitiveType, thit, attr, l_materialCB.stepScale))
+#endif
+    {
+        ReportAABBPrimitiveHit(thit, attr);
+    }
+}
+
+#define SPECIALIZED_INTERSECTION_SHADER(geometry, primitive) \
+[shader("intersection")] \
+void MyIntersectionShader_##geometry##_##primitive() \
+{ \
+    geometry##Intersection(geometry::primitive); \
+}
+
+SPECIALIZED_INTERSECTION_SHADER(AnalyticPrimitive, AABB)
+SPECIALIZED_INTERSECTION_SHADER(AnalyticPrimitive, Spheres)
+SPECIALIZED_INTERSECTION_SHADER(VolumetricPrimitive, Metaballs)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, MiniSpheres)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, IntersectedRoundCube)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, SquareTorus)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, TwistedTorus)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, Cog)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, Cylinder)
+SPECIALIZED_INTERSECTION_SHADER(SignedDistancePrimitive, FractalPyramid)
+#endif
+
 #endif // RAYTRACING_HLSL
\ No newline at end of file
@@ -45,6 +45,9 @@
 
 
 #include "RaytracingShaderHelper.hlsli"
+#if USE_RELAXED_SPHERE_TRACING
+#include "AnalyticPrimitives.hlsli"
+#endif
 
 //------------------------------------------------------------------
 float GetDistanceFromSignedDistancePrimitive(in float3 position, in SignedDistancePrimitive::Enum sdPrimitive);
@@ -318,6 +321,66 @@ bool RaySignedDistancePrimitiveTest(in Ray ray, in SignedDistancePrimitive::Enum
     return false;
 }
 
+#if USE_RELAXED_SPHERE_TRACING
+// Test ray against a signed distance primitive with over-relaxed sphere tracing.
+// Only the part of the ray inside the AABB is marched, and each step is relaxation times
+// the safe distance. When the spheres around the last two positions don't overlap,
+// the step may have crossed the surface. It is then undone before its hit test and
+// marching continues with unrelaxed steps.
+// Ref: Keinert et al., Enhanced Sphere Tracing, 2014
+bool RaySignedDistancePrimitiveTestRelaxed(in Ray ray, in SignedDistancePrimitive::Enum sdPrimitive, out float thit, out ProceduralPrimitiveAttributes attr, in float stepScale = 1.0f, in float relaxation = SPHERE_TRACING_RELAXATION)
+{
+    const float threshold = 0.0001;
+    const UINT MaxSteps = 512;
+
+    float3 aabb[2] = { float3(-1, -1, -1), float3(1, 1, 1) };
+    float tmin, tmax;
+    if (!RayAABBIntersectionTest(ray, aabb, tmin, tmax))
+    {
+        return false;
+    }
+
+    float t = max(RayTMin(), tmin);
+    float tEnd = min(RayTCurrent(), tmax);
+    float omega = relaxation;
+    float previousRadius = 0;
+    float stepLength = 0;
+
+    UINT i = 0;
+    while (i++ < MaxSteps && t <= tEnd)
+    {
+        float3 position = ray.origin + t * ray.direction;
+        float distance = GetDistanceFromSignedDistancePrimitive(position, sdPrimitive);
+        float radius = stepScale * abs(distance);
+
+        // The spheres around the last two positions don't overlap, so the step may have crossed the surface.
+        bool relaxationFailed = omega > 1 && radius + previousRadius < stepLength;
+        if (relaxationFailed)
+        {
+            stepLength *= 1 - omega;
+            omega = 1;
+        }
+        else
+        {
+            if (distance <= threshold * t)
+            {
+                float3 hitSurfaceNormal = sdCalculateNormal(position, sdPrimitive);
+                if (IsAValidHit(ray, t, hitSurfaceNormal))
+                {
+                    thit = t;
+                    attr.normal = hitSurfaceNormal;
+                    return true;
+                }
+            }
+            stepLength = omega * stepScale * distance;
+        }
+        previousRadius = radius;
+        t += stepLength;
+    }
+    return false;
+}
+#endif
+
 // Analytically integrated checkerboard grid (box filter).
 // Ref: http://iquilezles.org/www/articles/filterableprocedurals/filterableprocedurals.htm
 // ratio - Center fill to border ratio.
@@ -201,4 +201,175 @@ bool RayMetaballsIntersectionTest(in Ray ray, out float thit, out ProceduralPrim
     return false;
 }
 
+#if USE_METABALL_INTERVAL_BOUNDS
+// Upper bound of a metaball's potential over the ray segment <t0, t1>.
+// The potential only falls with the distance from the center, so it peaks at the segment's closest point.
+float CalculateMetaballPotentialBound(in Ray ray, in Metaball blob, in float t0, in float t1)
+{
+    float tClosest = clamp(dot(blob.center - ray.origin, ray.direction) / dot(ray.direction, ray.direction), t0, t1);
+    float distance;
+    return CalculateMetaballPotential(ray.origin + tClosest * ray.direction, blob, distance);
+}
+
+// Calculate field potential from all active metaballs and its derivative along the ray.
+float CalculateMetaballsPotentialAndDerivative(in Ray ray, in float t, in Metaball blobs[N_METABALLS], in UINT nActiveMetaballs, out float derivative)
+{
+    float3 position = ray.origin + t * ray.direction;
+    float sumFieldPotential = 0;
+    derivative = 0;
+#if USE_DYNAMIC_LOOPS 
+    for (UINT j = 0; j < nActiveMetaballs; j++)
+#else
+    for (UINT j = 0; j < N_METABALLS; j++)
+#endif
+    {
+        float distance;
+        sumFieldPotential += CalculateMetaballPotential(position, blobs[j], distance);
+        if (distance < blobs[j].radius && distance > 0)
+        {
+            // d/dx (6x^5 - 15x^4 + 10x^3) = 30x^2 (1 - x)^2 with x = (radius - distance) / radius.
+            float r = blobs[j].radius;
+            float x = (r - distance) / r;
+            float dPotentialdDistance = -30 * x * x * (1 - x) * (1 - x) / r;
+            float dDistancedT = dot(position - blobs[j].center, ray.direction) / distance;
+            derivative += dPotentialdDistance * dDistancedT;
+        }
+    }
+    return sumFieldPotential;
+}
+
+// Find the first crossing of the isosurface within <tmin, tmax>.
+// Instead of uniform steps, the test bounds the potential over whole segments of the ray with
+// CalculateMetaballPotentialBound(). Segments whose bound stays below the threshold are skipped and the
+// next segment doubles in length; others are halved down to minTStep. A crossing found at that resolution
+// is refined with Newton iterations safeguarded by bisection. iStep counts potential and bound evaluations.
+bool RayMetaballsIntervalSegmentTest(in Ray ray, in Metaball blobs[N_METABALLS], in UINT nActiveMetaballs, in float tmin, in float tmax, in float minTStep, in UINT maxSteps, inout UINT iStep, out float thit, out ProceduralPrimitiveAttributes attr)
+{
+    // Field potential threshold defining the isosurface, as in RayMetaballsIntersectionTest().
+    const float Threshold = 0.25f;
+
+    float t = tmin;
+    float tStep = tmax - tmin;
+    bool inside = CalculateMetaballsPotential(ray.origin + t * ray.direction, blobs, nActiveMetaballs) >= Threshold;
+    iStep++;
+
+    while (iStep < maxSteps)
+    {
+        if (inside)
+        {
+            // The segment starts inside the isosurface or its crossing was rejected:
+            // test every minTStep inside as RayMetaballsIntersectionTest() does.
+            float3 position = ray.origin + t * ray.direction;
+            float3 normal = CalculateMetaballsNormal(position, blobs, nActiveMetaballs);
+            if (IsAValidHit(ray, t, normal))
+            {
+                thit = t;
+                attr.normal = normal;
+                return true;
+            }
+            if (t >= tmax)
+            {
+                break;
+            }
+            t = min(t + minTStep, tmax);
+            inside = CalculateMetaballsPotential(ray.origin + t * ray.direction, blobs, nActiveMetaballs) >= Threshold;
+            iStep++;
+            continue;
+        }
+        if (t >= tmax)
+        {
+            break;
+        }
+
+        float tEnd = min(t + tStep, tmax);
+        float potentialBound = 0;
+#if USE_DYNAMIC_LOOPS 
+        for (UINT j = 0; j < nActiveMetaballs; j++)
+#else
+        for (UINT j = 0; j < N_METABALLS; j++)
+#endif
+        {
+            potentialBound += CalculateMetaballPotentialBound(ray, blobs[j], t, tEnd);
+        }
+        iStep++;
+
+        // No crossing within the segment, skip it.
+        if (potentialBound < Threshold)
+        {
+            t = tEnd;
+            tStep *= 2;
+            continue;
+        }
+        if (tEnd - t > minTStep)
+        {
+            tStep = 0.5 * (tEnd - t);
+            continue;
+        }
+
+        // Has the segment's end crossed the isosurface?
+        inside = CalculateMetaballsPotential(ray.origin + tEnd * ray.direction, blobs, nActiveMetaballs) >= Threshold;
+        iStep++;
+        if (!inside)
+        {
+            t = tEnd;
+            continue;
+        }
+
+        // Refine the crossing within <t, tEnd>.
+        float tLow = t;
+        float tHigh = tEnd;
+        float tRoot = 0.5 * (tLow + tHigh);
+        for (UINT i = 0; i < METABALL_INTERVAL_REFINEMENT_STEPS; i++)
+        {
+            float derivative;
+            float f = CalculateMetaballsPotentialAndDerivative(ray, tRoot, blobs, nActiveMetaballs, derivative) - Threshold;
+            iStep++;
+            if (f >= 0)
+            {
+                tHigh = tRoot;
+            }
+            else
+            {
+                tLow = tRoot;
+            }
+            float tNewton = tRoot - f / derivative;
+            tRoot = (derivative > 0 && tNewton > tLow && tNewton < tHigh) ? tNewton : 0.5 * (tLow + tHigh);
+        }
+
+        float3 normal = CalculateMetaballsNormal(ray.origin + tRoot * ray.direction, blobs, nActiveMetaballs);
+        if (IsAValidHit(ray, tRoot, normal))
+        {
+            thit = tRoot;
+            attr.normal = normal;
+            return true;
+        }
+        t = tEnd;
+    }
+
+    return false;
+}
+
+// Test if a ray with RayFlags and segment <RayTMin(), RayTCurrent()> intersects metaball field.
+// Same isosurface as RayMetaballsIntersectionTest(), but RayMetaballsIntervalSegmentTest() skips the segments
+// the field can't cross instead of taking 128 uniform steps.
+bool RayMetaballsIntervalIntersectionTest(in Ray ray, out float thit, out ProceduralPrimitiveAttributes attr, in float elapsedTime)
+{
+    Metaball blobs[N_METABALLS];
+    InitializeAnimatedMetaballs(blobs, elapsedTime, 12.0f);
+
+    float tmin, tmax;   // Ray extents to first and last metaball intersections.
+    UINT nActiveMetaballs = 0;  // Number of metaballs's that the ray intersects.
+    FindIntersectingMetaballs(ray, tmin, tmax, blobs, nActiveMetaballs);
+    if (tmin > tmax)
+    {
+        return false;
+    }
+
+    // Halve segments down to the uniform step of RayMetaballsIntersectionTest().
+    const UINT MAX_STEPS = 128;
+    UINT iStep = 0;
+    return RayMetaballsIntervalSegmentTest(ray, blobs, nActiveMetaballs, tmin, tmax, (tmax - tmin) / MAX_STEPS, METABALL_INTERVAL_MAX_STEPS, iStep, thit, attr);
+}
+#endif // USE_METABALL_INTERVAL_BOUNDS
+
 #endif // VOLUMETRICPRIMITIVESLIBRARY_H
\ No newline at end of file
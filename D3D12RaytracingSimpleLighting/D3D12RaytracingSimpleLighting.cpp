@@ -540,6 +540,15 @@ D3D12_RAYTRACING_AABB D3D12RaytracingSimpleLighting::GetAABBForSphere(XMFLOAT3 c
 
 void D3D12RaytracingSimpleLighting::CreateTestCase()
 {
+    TestCaseDescs testCaseDescs;
+    if (LoadTestCaseDescs(&testCaseDescs))
+    {
+        m_geomDescs = testCaseDescs.geomDescs;
+        m_listOfBlasDesc = testCaseDescs.blasDescs;
+        m_listOfTlasDesc = testCaseDescs.tlasDescs;
+        return;
+    }
+
     auto AddGeometryDesc = [&](UINT index,
         D3D12_RAYTRACING_GEOMETRY_TYPE geomType = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
         D3D12_RAYTRACING_GEOMETRY_FLAGS flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE)
@@ -822,6 +831,7 @@ void D3D12RaytracingSimpleLighting::BuildShaderTables()
     {
         UINT numShaderRecords = 2;
         UINT shaderRecordSize = shaderIdentifierSize;
+        m_missShaderStride = shaderRecordSize;
         ShaderTable missShaderTable(device, numShaderRecords, shaderRecordSize, L"MissShaderTable");
         missShaderTable.push_back(ShaderRecord(missShaderIdentifier, shaderIdentifierSize));
         missShaderTable.push_back(ShaderRecord(missShaderShadowIdentifier, shaderIdentifierSize));
@@ -896,7 +906,8 @@ void D3D12RaytracingSimpleLighting::DoRaytracing()
         dispatchDesc->HitGroupTable.StrideInBytes = m_hitGroupShaderStride;//dispatchDesc->HitGroupTable.SizeInBytes / 3;
         dispatchDesc->MissShaderTable.StartAddress = m_missShaderTable->GetGPUVirtualAddress();
         dispatchDesc->MissShaderTable.SizeInBytes = m_missShaderTable->GetDesc().Width;
-        dispatchDesc->MissShaderTable.StrideInBytes = dispatchDesc->MissShaderTable.SizeInBytes;
+        // The shadow rays use the second miss shader, so the stride has to be one record, not the table size.
+        dispatchDesc->MissShaderTable.StrideInBytes = m_missShaderStride;
         dispatchDesc->RayGenerationShaderRecord.StartAddress = m_rayGenShaderTable->GetGPUVirtualAddress();
         dispatchDesc->RayGenerationShaderRecord.SizeInBytes = m_rayGenShaderTable->GetDesc().Width;
         dispatchDesc->Width = m_width;
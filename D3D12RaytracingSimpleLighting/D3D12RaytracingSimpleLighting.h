@@ -109,6 +109,7 @@ private:
     D3D12_GPU_DESCRIPTOR_HANDLE m_raytracingOutputResourceUAVGpuDescriptor;
     UINT m_raytracingOutputResourceUAVDescriptorHeapIndex;
 
+    UINT m_missShaderStride;
     UINT m_hitGroupShaderStride;
 
     // Shader tables
@@ -0,0 +1,242 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+// Analytic primitive benchmark: random rays from origins at increasing distances from the <-1,1> AABB, aimed at
+// points in and around it, against the sample's three spheres and its AABB. Each ray is tested with the float
+// port of the HLSL (RayAnalyticGeometryIntersectionTest()), the robust float tests in batches of eight with the
+// scalar and the AVX2 kernel, and the robust tests in double as the reference. Reports per primitive and
+// distance how many hits differ from the reference, the largest relative distance and normal errors, the rays
+// on which the kernels differ in any bit (must be 0) and the throughput of each version on one thread.
+//
+// Options: -rays <n> per distance (1000000) -distances <list> (1,10,100,1000,10000) -seed <n> (1)
+//          -flags <n> ray flags (0) -iterations <n> (3)
+
+#include "Benchmark.h"
+#include "ProceduralPrimitivesLibrary.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct AnalyticPrimitiveDesc
+    {
+        const char* name;
+        CpuAnalyticPrimitive::Enum primitive;
+    };
+
+    const AnalyticPrimitiveDesc c_primitives[] =
+    {
+        { "Spheres", CpuAnalyticPrimitive::Spheres },
+        { "AABB", CpuAnalyticPrimitive::AABB },
+    };
+
+    struct BatchResult
+    {
+        UINT hitMask;
+        RayBatchHits hits;
+    };
+
+    // Hits that disagree with the reference, or whose normal is off by more than c_maxNormalError as they are on
+    // another face or sphere, and the largest errors of the others. The distance error is that of the hit
+    // position relative to the distance travelled, or to the AABB size for hits closer than that.
+    struct AccuracyStats
+    {
+        static constexpr double c_maxNormalError = 0.1;
+
+        size_t mismatches = 0;
+        double maxDistanceError = 0.0;
+        double maxNormalError = 0.0;
+
+        void Add(bool hit, float t, const float normal[3], bool referenceHit, double referenceT, const double referenceNormal[3],
+            double directionLength)
+        {
+            double normalError = 0.0;
+            if (hit && referenceHit)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    normalError += (normal[axis] - referenceNormal[axis]) * (normal[axis] - referenceNormal[axis]);
+                }
+                normalError = std::sqrt(normalError);
+            }
+            if (hit != referenceHit || !(normalError <= c_maxNormalError))
+            {
+                mismatches++;
+                return;
+            }
+            if (hit)
+            {
+                double distanceError = std::fabs(t - referenceT) * directionLength / (std::max)(std::fabs(referenceT) * directionLength, 2.0);
+                maxDistanceError = (std::max)(maxDistanceError, distanceError);
+                maxNormalError = (std::max)(maxNormalError, normalError);
+            }
+        }
+    };
+
+    // Origins at distance from the center in a random direction, aimed at a random point of the AABB grown by
+    // 20% so that some rays miss or graze it. Directions are not normalized, as after the transform to primitive
+    // local space, and one in sixteen has a zero component.
+    std::vector<Ray> GenerateRays(UINT count, float distance, UINT seed)
+    {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> gaussian;
+        std::uniform_real_distribution<float> target(-1.2f, 1.2f);
+        std::uniform_real_distribution<float> logScale(-2.0f, 2.0f);
+        std::uniform_int_distribution<int> axisPick(0, 15);
+
+        std::vector<Ray> rays(count);
+        for (Ray& ray : rays)
+        {
+            float3 origin(gaussian(rng), gaussian(rng), gaussian(rng));
+            origin = normalize(origin) * distance;
+            float3 direction = normalize(float3(target(rng), target(rng), target(rng)) - origin) * std::exp2(logScale(rng));
+            int axis = axisPick(rng);
+            if (axis < 3)
+            {
+                direction[axis] = 0.0f;
+            }
+            ray = Ray(origin, direction, 0.0f, 1e30f);
+        }
+        return rays;
+    }
+}
+
+static int AnalyticBenchmark(const BenchmarkArgs& args)
+{
+    UINT rayCount = (std::max)(1u, args.GetUInt("rays", 1000000));
+    std::vector<UINT> distances = args.GetUIntList("distances", { 1, 10, 100, 1000, 10000 });
+    UINT seed = args.GetUInt("seed", 1);
+    UINT rayFlags = args.GetUInt("flags", RAY_FLAG_NONE);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+
+    if (!CpuSupportsAvx2())
+    {
+        printf("AVX2 is not supported on this CPU; the avx2 column runs the scalar kernel.\n");
+    }
+    printf("Analytic primitives: %u rays per distance, batches of %u, ray flags 0x%x, best of %u, one thread\n",
+        rayCount, c_rayBatchWidth, rayFlags, iterations);
+    printf("%-8s %9s %6s | %-28s | %-28s | %6s | %-26s\n", "", "", "", "  HLSL port vs double", "  robust vs double", "", "  Mrays/s");
+    printf("%-8s %9s %6s | %8s %9s %9s | %8s %9s %9s | %6s | %8s %8s %8s\n", "", "distance", "hit",
+        "mismatch", "t error", "n error", "mismatch", "t error", "n error", "bits", "port", "scalar", "avx2");
+
+    const UINT batchCount = (rayCount + c_rayBatchWidth - 1) / c_rayBatchWidth;
+    std::vector<RayBatch> batches(batchCount);
+    std::vector<BatchResult> scalarResults(batchCount);
+    std::vector<BatchResult> avx2Results(batchCount);
+    std::vector<UINT8> portHit(rayCount);
+    std::vector<float> portT(rayCount);
+    std::vector<float3> portNormal(rayCount);
+
+    for (const AnalyticPrimitiveDesc& primitive : c_primitives)
+    {
+        for (UINT distance : distances)
+        {
+            std::vector<Ray> rays = GenerateRays(rayCount, static_cast<float>(distance), seed + distance);
+            for (UINT b = 0; b < batchCount; b++)
+            {
+                batches[b] = {};
+                for (UINT i = b * c_rayBatchWidth; i < (std::min)(rayCount, (b + 1) * c_rayBatchWidth); i++)
+                {
+                    batches[b].Set(batches[b].count++, rays[i]);
+                }
+            }
+
+            auto Time = [&](const std::function<void()>& run)
+            {
+                double bestMs = 1e30;
+                for (UINT i = 0; i < iterations; i++)
+                {
+                    BenchmarkTimer timer;
+                    run();
+                    bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+                }
+                return bestMs;
+            };
+
+            double portMs = Time([&]()
+            {
+                for (UINT i = 0; i < rayCount; i++)
+                {
+                    portNormal[i] = float3(0.0f);
+                    portHit[i] = RayAnalyticGeometryIntersectionTest(rays[i], rayFlags, primitive.primitive, &portT[i], &portNormal[i]);
+                }
+            });
+            auto RunKernel = [&](AnalyticKernel::Enum kernel, std::vector<BatchResult>* results)
+            {
+                return Time([&]()
+                {
+                    for (UINT b = 0; b < batchCount; b++)
+                    {
+                        BatchResult& result = (*results)[b];
+                        result.hitMask = RayAnalyticPrimitiveTest8(kernel, batches[b], rayFlags, primitive.primitive, &result.hits);
+                    }
+                });
+            };
+            double scalarMs = RunKernel(AnalyticKernel::Scalar, &scalarResults);
+            double avx2Ms = RunKernel(GetDefaultAnalyticKernel(), &avx2Results);
+
+            AccuracyStats portStats;
+            AccuracyStats robustStats;
+            size_t hitCount = 0;
+            size_t bitMismatches = 0;
+            for (UINT i = 0; i < rayCount; i++)
+            {
+                double referenceT = 0.0;
+                double referenceNormal[3];
+                bool referenceHit = RayAnalyticPrimitiveTestRobust(AnalyticRay<double>(rays[i]), rayFlags, primitive.primitive,
+                    &referenceT, referenceNormal);
+                hitCount += referenceHit;
+                double directionLength = length(rays[i].direction);
+
+                const float normal[3] = { portNormal[i].x, portNormal[i].y, portNormal[i].z };
+                portStats.Add(portHit[i] != 0, portT[i], normal, referenceHit, referenceT, referenceNormal, directionLength);
+
+                const UINT b = i / c_rayBatchWidth;
+                const UINT lane = i % c_rayBatchWidth;
+                const BatchResult& scalar = scalarResults[b];
+                const BatchResult& avx2 = avx2Results[b];
+                bool scalarHit = (scalar.hitMask >> lane) & 1;
+                bool avx2Hit = (avx2.hitMask >> lane) & 1;
+                const float robustNormal[3] = { scalar.hits.normal[0][lane], scalar.hits.normal[1][lane], scalar.hits.normal[2][lane] };
+                robustStats.Add(scalarHit, scalar.hits.t[lane], robustNormal, referenceHit, referenceT, referenceNormal, directionLength);
+
+                bool differs = scalarHit != avx2Hit;
+                if (scalarHit && avx2Hit)
+                {
+                    differs = memcmp(&scalar.hits.t[lane], &avx2.hits.t[lane], sizeof(float)) != 0;
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        differs |= memcmp(&scalar.hits.normal[axis][lane], &avx2.hits.normal[axis][lane], sizeof(float)) != 0;
+                    }
+                }
+                bitMismatches += differs;
+            }
+
+            double mrays = rayCount / 1000.0;
+            printf("%-8s %9u %5.1f%% | %8zu %9.2e %9.2e | %8zu %9.2e %9.2e | %6zu | %8.1f %8.1f %8.1f\n", primitive.name, distance,
+                100.0 * hitCount / rayCount, portStats.mismatches, portStats.maxDistanceError, portStats.maxNormalError,
+                robustStats.mismatches, robustStats.maxDistanceError, robustStats.maxNormalError, bitMismatches,
+                mrays / portMs, mrays / scalarMs, mrays / avx2Ms);
+        }
+    }
+    printf("mismatch counts rays that hit or miss unlike the reference or hit another surface (n error > %.1f). t error is\n"
+        "relative to the distance travelled, n error the length of the normal difference. bits counts rays on which the\n"
+        "scalar and AVX2 kernels differ.\n", AccuracyStats::c_maxNormalError);
+    return 0;
+}
+
+REGISTER_BENCHMARK("analytic", "Robust 8-ray analytic sphere/AABB tests vs the HLSL port and a double reference", AnalyticBenchmark);
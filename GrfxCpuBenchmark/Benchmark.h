@@ -0,0 +1,111 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Minimal benchmark registry. Each benchmark lives in its own translation unit and
+// registers itself with REGISTER_BENCHMARK; Main.cpp dispatches on the name given on the command line.
+
+#include "D3D12Compat.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+class BenchmarkArgs
+{
+public:
+    void Set(const std::string& key, const std::string& value) { m_options[key] = value; }
+    bool Has(const std::string& key) const { return m_options.count(key) != 0; }
+
+    std::string GetString(const std::string& key, const std::string& defaultValue) const
+    {
+        auto it = m_options.find(key);
+        return it != m_options.end() ? it->second : defaultValue;
+    }
+
+    UINT GetUInt(const std::string& key, UINT defaultValue) const
+    {
+        auto it = m_options.find(key);
+        return it != m_options.end() ? static_cast<UINT>(std::stoul(it->second)) : defaultValue;
+    }
+
+    float GetFloat(const std::string& key, float defaultValue) const
+    {
+        auto it = m_options.find(key);
+        return it != m_options.end() ? std::stof(it->second) : defaultValue;
+    }
+
+    // Comma separated list, e.g. "-threads 1,4,16".
+    std::vector<UINT> GetUIntList(const std::string& key, const std::vector<UINT>& defaultValue) const
+    {
+        auto it = m_options.find(key);
+        if (it == m_options.end())
+        {
+            return defaultValue;
+        }
+        std::vector<UINT> values;
+        size_t start = 0;
+        while (start <= it->second.size())
+        {
+            size_t end = it->second.find(',', start);
+            if (end == std::string::npos)
+            {
+                end = it->second.size();
+            }
+            if (end > start)
+            {
+                values.push_back(static_cast<UINT>(std::stoul(it->second.substr(start, end - start))));
+            }
+            start = end + 1;
+        }
+        return values;
+    }
+
+private:
+    std::map<std::string, std::string> m_options;
+};
+
+typedef int (*BenchmarkFunc)(const BenchmarkArgs& args);
+
+struct BenchmarkDesc
+{
+    const char* name;
+    const char* description;
+    BenchmarkFunc func;
+};
+
+std::vector<BenchmarkDesc>& GetBenchmarks();
+
+struct BenchmarkRegistration
+{
+    BenchmarkRegistration(const char* name, const char* description, BenchmarkFunc func)
+    {
+        GetBenchmarks().push_back({ name, description, func });
+    }
+};
+
+#define REGISTER_BENCHMARK(name, description, func) \
+    static BenchmarkRegistration s_registration_##func(name, description, func)
+
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer() : m_start(std::chrono::high_resolution_clock::now()) {}
+    void Reset() { m_start = std::chrono::high_resolution_clock::now(); }
+    double GetElapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::high_resolution_clock::time_point m_start;
+};
@@ -0,0 +1,391 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+using namespace CpuRT;
+
+CpuTriangleGeometryDesc BenchmarkMesh::GetGeometryDesc() const
+{
+    CpuTriangleGeometryDesc desc = {};
+    desc.vertexData = vertices.data();
+    desc.vertexCount = static_cast<UINT>(vertices.size());
+    desc.vertexStrideInBytes = sizeof(BenchmarkVertex);
+    desc.indexData = indices.data();
+    desc.indexCount = static_cast<UINT>(indices.size());
+    desc.indexFormat = CpuIndexFormat::R32_UINT;
+    return desc;
+}
+
+void GenerateCubeField(UINT triangleCount, float extent, UINT seed, BenchmarkMesh* mesh)
+{
+    // Cube indices and vertices from D3D12RaytracingSimpleLighting::BuildGeometry().
+    static const UINT16 cubeIndices[] =
+    {
+        3,1,0, 2,1,3,
+        6,4,5, 7,4,6,
+        11,9,8, 10,9,11,
+        14,12,13, 15,12,14,
+        19,17,16, 18,17,19,
+        22,20,21, 23,20,22
+    };
+    static const BenchmarkVertex cubeVertices[] =
+    {
+        { float3(-1.0f, 1.0f, -1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(1.0f, 1.0f, -1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(1.0f, 1.0f, 1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(-1.0f, 1.0f, 1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, -1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(1.0f, -1.0f, -1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(1.0f, -1.0f, 1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, 1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, 1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, -1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, 1.0f, -1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, 1.0f, 1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, -1.0f, 1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, -1.0f, -1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, 1.0f, -1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, 1.0f, 1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(1.0f, -1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(1.0f, 1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(-1.0f, 1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(-1.0f, -1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+        { float3(1.0f, -1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+        { float3(1.0f, 1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+        { float3(-1.0f, 1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+    };
+    const UINT cubeVertexCount = sizeof(cubeVertices) / sizeof(cubeVertices[0]);
+    const UINT cubeIndexCount = sizeof(cubeIndices) / sizeof(cubeIndices[0]);
+
+    UINT cubeCount = (std::max)(1u, triangleCount / (cubeIndexCount / 3));
+    mesh->vertices.resize(static_cast<size_t>(cubeCount) * cubeVertexCount);
+    mesh->indices.resize(static_cast<size_t>(cubeCount) * cubeIndexCount);
+
+    // Cube size shrinks with count so density stays comparable across sizes.
+    float baseScale = extent / std::cbrt(static_cast<float>(cubeCount));
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-extent, extent);
+    std::uniform_real_distribution<float> scale(0.1f * baseScale, 0.5f * baseScale);
+
+    for (UINT c = 0; c < cubeCount; c++)
+    {
+        float3 center(position(rng), position(rng), position(rng));
+        float3 size(scale(rng), scale(rng), scale(rng));
+        for (UINT v = 0; v < cubeVertexCount; v++)
+        {
+            BenchmarkVertex& vertex = mesh->vertices[static_cast<size_t>(c) * cubeVertexCount + v];
+            vertex.position = center + cubeVertices[v].position * size;
+            vertex.normal = cubeVertices[v].normal;
+        }
+        for (UINT i = 0; i < cubeIndexCount; i++)
+        {
+            mesh->indices[static_cast<size_t>(c) * cubeIndexCount + i] = c * cubeVertexCount + cubeIndices[i];
+        }
+    }
+}
+
+void GenerateTerrain(UINT triangleCount, float extent, BenchmarkMesh* mesh)
+{
+    // Each grid cell is HelloWorld's square: vertices {-,-} {-,+} {+,+} {+,-} with indices 0,1,2,3,0,2.
+    UINT cells = (std::max)(1u, static_cast<UINT>(std::sqrt(triangleCount / 2.0f)));
+    UINT rowVertices = cells + 1;
+    mesh->vertices.resize(static_cast<size_t>(rowVertices) * rowVertices);
+    mesh->indices.resize(static_cast<size_t>(cells) * cells * 6);
+
+    auto Height = [&](float x, float z)
+    {
+        float fx = x / extent * 6.0f;
+        float fz = z / extent * 6.0f;
+        return extent * 0.1f * (std::sin(fx) * std::cos(fz) + 0.5f * std::sin(2.3f * fx + 1.7f * fz));
+    };
+
+    for (UINT z = 0; z < rowVertices; z++)
+    {
+        for (UINT x = 0; x < rowVertices; x++)
+        {
+            float px = lerp(-extent, extent, static_cast<float>(x) / cells);
+            float pz = lerp(-extent, extent, static_cast<float>(z) / cells);
+            BenchmarkVertex& vertex = mesh->vertices[static_cast<size_t>(z) * rowVertices + x];
+            vertex.position = float3(px, Height(px, pz), pz);
+            vertex.normal = float3(0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    size_t i = 0;
+    for (UINT z = 0; z < cells; z++)
+    {
+        for (UINT x = 0; x < cells; x++)
+        {
+            UINT corner[4] =
+            {
+                z * rowVertices + x,
+                (z + 1) * rowVertices + x,
+                (z + 1) * rowVertices + x + 1,
+                z * rowVertices + x + 1
+            };
+            const UINT sqIndices[] = { 0, 1, 2, 3, 0, 2 };
+            for (UINT k = 0; k < 6; k++)
+            {
+                mesh->indices[i++] = corner[sqIndices[k]];
+            }
+        }
+    }
+}
+
+void GenerateBenchmarkMesh(const std::string& meshType, UINT triangleCount, UINT seed, BenchmarkMesh* mesh)
+{
+    if (meshType == "cubes")
+    {
+        GenerateCubeField(triangleCount, 100.0f, seed, mesh);
+    }
+    else if (meshType == "terrain")
+    {
+        GenerateTerrain(triangleCount, 100.0f, mesh);
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown mesh type " + meshType);
+    }
+}
+
+void GenerateMetaballField(const std::string& fieldType, UINT metaballCount, UINT seed, std::vector<Metaball>* metaballs)
+{
+    if (fieldType != "random" && fieldType != "fluid")
+    {
+        throw std::invalid_argument("Unknown metaball field '" + fieldType + "', expected random or fluid.");
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float radius = 0.5f * std::cbrt(3.0f / (std::max)(metaballCount, 1u));
+    metaballs->resize(metaballCount);
+    for (UINT i = 0; i < metaballCount; i++)
+    {
+        Metaball& blob = (*metaballs)[i];
+        blob.radius = radius * (0.75f + 0.5f * unit(rng));
+        float extent = 1.0f - blob.radius;
+        float x = extent * (2.0f * unit(rng) - 1.0f);
+        float y = extent * (2.0f * unit(rng) - 1.0f);
+        float z = extent * (2.0f * unit(rng) - 1.0f);
+        if (fieldType == "fluid" && i % 10 != 0)
+        {
+            y = -extent + 0.8f * (y + extent) * 0.5f;
+        }
+        blob.center = float3(x, y, z);
+    }
+}
+
+namespace
+{
+    // Material coefficients and step scale per primitive type, as InitializeScene() sets them up.
+    struct ProceduralPrimitiveMaterialDesc
+    {
+        float diffuseCoef;
+        float specularCoef;
+        float specularPower;
+        float stepScale;
+    };
+
+    const ProceduralPrimitiveMaterialDesc c_proceduralMaterials[CpuIntersectionShaderType::TotalPrimitiveCount] =
+    {
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // AABB
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // Spheres
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // Metaballs
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // MiniSpheres
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // IntersectedRoundCube
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // SquareTorus
+        { 1.0f, 0.7f, 50.0f, 0.5f },    // TwistedTorus
+        { 1.0f, 0.1f, 2.0f, 1.0f },     // Cog
+        { 0.9f, 0.7f, 50.0f, 1.0f },    // Cylinder
+        { 1.0f, 0.1f, 4.0f, 0.8f },     // FractalPyramid
+    };
+
+    const float c_proceduralAabbWidth = 2.0f;       // Primitive AABB width.
+    const float c_proceduralAabbDistance = 2.0f;    // Distance between AABBs.
+    const UINT c_proceduralBlockSize = 4096;        // Primitives generated per task.
+}
+
+void GenerateProceduralStressScene(UINT primitiveCount, UINT seed, CpuThreadPool* pool, ProceduralStressScene* scene)
+{
+    scene->aabbs.resize(primitiveCount);
+    scene->instances.resize(primitiveCount);
+    scene->materials.resize(primitiveCount);
+    scene->transformParameters.Resize(primitiveCount);
+    scene->attributes.resize(primitiveCount);
+    scene->extent = 0.0f;
+    if (primitiveCount == 0)
+    {
+        return;
+    }
+
+    const UINT cellsPerAxis = static_cast<UINT>(std::ceil(std::cbrt(static_cast<double>(primitiveCount))));
+    const float stride = c_proceduralAabbWidth + c_proceduralAabbDistance;
+    const float base = -0.5f * stride * (cellsPerAxis - 1);
+    const float4 chromiumReflectance(0.549f, 0.556f, 0.554f, 1.0f);
+
+    auto GenerateBlock = [&](UINT block, UINT)
+    {
+        std::seed_seq seq = { seed, block };
+        std::mt19937 rng(seq);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_int_distribution<UINT> primitiveTypes(0, CpuIntersectionShaderType::TotalPrimitiveCount - 1);
+
+        UINT end = (std::min)(primitiveCount, (block + 1) * c_proceduralBlockSize);
+        for (UINT i = block * c_proceduralBlockSize; i < end; i++)
+        {
+            // Primitive types are numbered as the sample's hit groups: analytic, volumetric, then signed distance.
+            UINT type = primitiveTypes(rng);
+            ProceduralPrimitiveInstance& instance = scene->instances[i];
+            instance.instanceIndex = i;
+            if (type < CpuAnalyticPrimitive::Count)
+            {
+                instance.intersectionShaderType = CpuIntersectionShaderType::AnalyticPrimitive;
+                instance.primitiveType = type;
+            }
+            else if (type < CpuAnalyticPrimitive::Count + CpuVolumetricPrimitive::Count)
+            {
+                instance.intersectionShaderType = CpuIntersectionShaderType::VolumetricPrimitive;
+                instance.primitiveType = type - CpuAnalyticPrimitive::Count;
+            }
+            else
+            {
+                instance.intersectionShaderType = CpuIntersectionShaderType::SignedDistancePrimitive;
+                instance.primitiveType = type - CpuAnalyticPrimitive::Count - CpuVolumetricPrimitive::Count;
+            }
+
+            // Scale, rotation and translation as in UpdateAABBPrimitiveAttributes(). Signed distance primitives
+            // are scaled uniformly so their distance bounds hold in local space.
+            float3 scale;
+            scale.x = 1.0f + 0.5f * unit(rng);
+            if (instance.intersectionShaderType == CpuIntersectionShaderType::SignedDistancePrimitive)
+            {
+                scale.y = scale.z = scale.x;
+            }
+            else
+            {
+                scale.y = 1.0f + 0.5f * unit(rng);
+                scale.z = 1.0f + 0.5f * unit(rng);
+            }
+            float angle = 6.28318531f * unit(rng);
+            UINT cell[3] = { i % cellsPerAxis, (i / cellsPerAxis) % cellsPerAxis, i / (cellsPerAxis * cellsPerAxis) };
+            float3 translation;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                translation[axis] = base + stride * cell[axis] + 0.5f * (unit(rng) - 0.5f);
+            }
+
+            scene->transformParameters.Set(i, scale, angle, translation);
+
+            // One in five primitives is chromium, as the sample's reflective primitives; the rest get a random albedo.
+            const ProceduralPrimitiveMaterialDesc& materialDesc = c_proceduralMaterials[type];
+            ProceduralPrimitiveMaterial& material = scene->materials[i];
+            bool reflective = unit(rng) < 0.2f;
+            float4 albedo(unit(rng), unit(rng), unit(rng), 1.0f);
+            material.albedo = reflective ? chromiumReflectance : albedo;
+            material.reflectanceCoef = reflective ? 1.0f : 0.0f;
+            material.diffuseCoef = materialDesc.diffuseCoef;
+            material.specularCoef = materialDesc.specularCoef;
+            material.specularPower = materialDesc.specularPower;
+            material.stepScale = materialDesc.stepScale;
+            material.padding = float3(0.0f);
+        }
+    };
+
+    // Bound the transformed <-1,1> local space, which holds every primitive.
+    auto BoundBlock = [&](UINT block, UINT)
+    {
+        UINT end = (std::min)(primitiveCount, (block + 1) * c_proceduralBlockSize);
+        for (UINT i = block * c_proceduralBlockSize; i < end; i++)
+        {
+            const float4x4& transform = scene->attributes[i].localSpaceToBottomLevelAS;
+            float3 halfExtent(
+                std::abs(transform.m[0][0]) + std::abs(transform.m[1][0]) + std::abs(transform.m[2][0]),
+                std::abs(transform.m[0][1]) + std::abs(transform.m[1][1]) + std::abs(transform.m[2][1]),
+                std::abs(transform.m[0][2]) + std::abs(transform.m[1][2]) + std::abs(transform.m[2][2]));
+            D3D12_RAYTRACING_AABB& aabb = scene->aabbs[i];
+            aabb.MinX = transform.m[3][0] - halfExtent.x;
+            aabb.MinY = transform.m[3][1] - halfExtent.y;
+            aabb.MinZ = transform.m[3][2] - halfExtent.z;
+            aabb.MaxX = transform.m[3][0] + halfExtent.x;
+            aabb.MaxY = transform.m[3][1] + halfExtent.y;
+            aabb.MaxZ = transform.m[3][2] + halfExtent.z;
+        }
+    };
+
+    UINT blockCount = (primitiveCount + c_proceduralBlockSize - 1) / c_proceduralBlockSize;
+    if (pool)
+    {
+        pool->Run(blockCount, GenerateBlock);
+    }
+    else
+    {
+        for (UINT block = 0; block < blockCount; block++)
+        {
+            GenerateBlock(block, 0);
+        }
+    }
+    UpdatePrimitiveTransforms(GetDefaultPrimitiveTransformKernel(), scene->transformParameters, scene->attributes.data(), pool);
+    if (pool)
+    {
+        pool->Run(blockCount, BoundBlock);
+    }
+    else
+    {
+        for (UINT block = 0; block < blockCount; block++)
+        {
+            BoundBlock(block, 0);
+        }
+    }
+
+    // Translations are jittered by at most a quarter unit and local space is scaled by at most 1.5 and rotated
+    // about Y, which bounds every AABB.
+    scene->extent = -base + 0.25f + 1.5f * std::sqrt(2.0f);
+}
+
+std::string GenerateTestCasesXml(UINT numCases)
+{
+    static const char* const c_models[] = { "tri", "square", "aabb", "aabb" };
+    std::string text = "<?xml version=\"1.0\"?>\n<testcases>\n";
+    char buffer[256];
+    for (UINT testCase = 0; testCase < numCases; testCase++)
+    {
+        snprintf(buffer, sizeof(buffer), "<testcase>\n<name>Generated %u</name>\n", testCase);
+        text += buffer;
+        for (UINT i = 0; i < 4; i++)
+        {
+            snprintf(buffer, sizeof(buffer), "<geometry>\n<name>geometry_%u</name>\n<model>%s</model>\n<index>%u</index>\n</geometry>\n",
+                i, c_models[i], i % 2);
+            text += buffer;
+        }
+        for (UINT i = 0; i < 4; i++)
+        {
+            snprintf(buffer, sizeof(buffer), "<blas>\n<name>blas_%u</name>\n<geoptr>geometry_%u</geoptr>\n</blas>\n", i, i);
+            text += buffer;
+        }
+        for (UINT i = 0; i < 4; i++)
+        {
+            snprintf(buffer, sizeof(buffer), "<tlas>\n<instanceDesc>\n<scale>1.0f</scale>\n<translateX>%u.0f</translateX>\n"
+                "<translateY>0.0f</translateY>\n<translateZ>0.0f</translateZ>\n</instanceDesc>\n"
+                "<blasptr>blas_%u</blasptr>\n<hitIndexContribution>%u</hitIndexContribution>\n</tlas>\n", testCase % 4, 3 - i, i);
+            text += buffer;
+        }
+        text += "</testcase>\n";
+    }
+    text += "</testcases>\n";
+    return text;
+}
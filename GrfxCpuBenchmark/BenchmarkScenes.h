@@ -0,0 +1,99 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Procedural benchmark content built from the samples' geometry:
+// SimpleLighting's cube (BuildGeometry()) and HelloWorld's square (GetGeometryIndicesAndVertices()),
+// and ProceduralGeometry's AABB primitives.
+
+#include "CpuGeometry.h"
+#include "PrimitiveTransforms.h"
+#include "ProceduralPrimitivesLibrary.h"
+#include <string>
+
+// Same layout as the SimpleLighting Vertex.
+struct BenchmarkVertex
+{
+    CpuRT::float3 position;
+    CpuRT::float3 normal;
+};
+
+struct BenchmarkMesh
+{
+    std::vector<BenchmarkVertex> vertices;
+    std::vector<UINT> indices;
+
+    UINT GetTriangleCount() const { return static_cast<UINT>(indices.size() / 3); }
+    CpuRT::CpuTriangleGeometryDesc GetGeometryDesc() const;
+};
+
+// Randomly placed, scaled copies of the SimpleLighting cube (12 triangles each) inside [-extent, extent]^3.
+void GenerateCubeField(UINT triangleCount, float extent, UINT seed, BenchmarkMesh* mesh);
+
+// HelloWorld's square tessellated into a grid and displaced into rolling terrain in the XZ plane.
+void GenerateTerrain(UINT triangleCount, float extent, BenchmarkMesh* mesh);
+
+// Dispatches on "-mesh cubes|terrain".
+void GenerateBenchmarkMesh(const std::string& meshType, UINT triangleCount, UINT seed, BenchmarkMesh* mesh);
+
+// Random metaballs inside the <-1,1> AABB with the total volume of D3D12RaytracingProceduralGeometry's three.
+// "random" spreads them over the AABB, "fluid" settles 90% into the bottom 40% of it and scatters the rest as droplets.
+void GenerateMetaballField(const std::string& fieldType, UINT metaballCount, UINT seed, std::vector<CpuRT::Metaball>* metaballs);
+
+// Same layout as the ProceduralGeometry PrimitiveConstantBuffer (m_aabbMaterialCB).
+struct ProceduralPrimitiveMaterial
+{
+    CpuRT::float4 albedo;
+    float reflectanceCoef;
+    float diffuseCoef;
+    float specularCoef;
+    float specularPower;
+    float stepScale;        // Step scale for ray marching of signed distance primitives.
+    CpuRT::float3 padding;
+};
+
+// The ProceduralGeometry PrimitiveInstanceConstantBuffer, plus the intersection shader its hit group uses.
+struct ProceduralPrimitiveInstance
+{
+    UINT instanceIndex;
+    UINT primitiveType;     // Procedural primitive type within intersectionShaderType.
+    CpuRT::CpuIntersectionShaderType::Enum intersectionShaderType;
+};
+
+// The AABB geometry of a ProceduralGeometry bottom-level AS and the per primitive buffers its shaders read,
+// indexed by primitive index.
+struct ProceduralStressScene
+{
+    std::vector<D3D12_RAYTRACING_AABB> aabbs;
+    std::vector<ProceduralPrimitiveInstance> instances;
+    std::vector<ProceduralPrimitiveMaterial> materials;
+    CpuRT::PrimitiveTransformBatch transformParameters;     // Scale, rotation and translation of each primitive.
+    std::vector<CpuRT::PrimitiveInstancePerFrameBuffer> attributes;
+    float extent;           // The AABBs lie inside [-extent, extent]^3.
+
+    UINT GetPrimitiveCount() const { return static_cast<UINT>(aabbs.size()); }
+    size_t GetSizeInBytes() const
+    {
+        return aabbs.size() * (sizeof(D3D12_RAYTRACING_AABB) + sizeof(ProceduralPrimitiveInstance)
+            + sizeof(ProceduralPrimitiveMaterial) + sizeof(CpuRT::PrimitiveInstancePerFrameBuffer));
+    }
+};
+
+// BuildProceduralGeometryAABBs() and UpdateAABBPrimitiveAttributes() scaled up: primitiveCount AABBs on a jittered
+// cubic grid with the sample's 2 unit AABBs and spacing, each with a random primitive type, scale, rotation about Y
+// and material. Generated in blocks on pool; every block seeds its own generator from seed, so the scene does not
+// depend on the thread count.
+void GenerateProceduralStressScene(UINT primitiveCount, UINT seed, CpuRT::CpuThreadPool* pool, ProceduralStressScene* scene);
+
+// A testcases.xml suite of numCases test cases laid out as the HelloWorld sample's file: four geometries, BLASes
+// and instances each, with BLASes and instances referring to them by name. Instance i uses BLAS 3 - i.
+std::string GenerateTestCasesXml(UINT numCases);
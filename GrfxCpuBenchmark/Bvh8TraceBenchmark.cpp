@@ -0,0 +1,145 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// BVH8 traversal benchmark: primary rays from a pinhole camera against a generated mesh, traversed with
+// the binary BVH and with both BVH8 layouts under the scalar and AVX2 kernels. Image hashes are printed
+// so the kernels can be checked against each other.
+//
+// Options: -triangles <n> (1000000) -mesh cubes|terrain (cubes) -width <n> (1024) -height <n> (1024)
+//          -threads <n> (0 = hardware threads) -iterations <n> (3)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "BinnedSahBuilder.h"
+#include "Bvh8.h"
+#include "CpuReferenceRenderer.h"
+#include "CpuScene.h"
+#include <cstdio>
+#include <functional>
+
+using namespace CpuRT;
+
+struct BenchmarkTriangle
+{
+    float3 v0;
+    float3 v1;
+    float3 v2;
+};
+
+static int Bvh8TraceBenchmark(const BenchmarkArgs& args)
+{
+    UINT triangleCount = args.GetUInt("triangles", 1000000);
+    std::string meshType = args.GetString("mesh", "cubes");
+    UINT width = args.GetUInt("width", 1024);
+    UINT height = args.GetUInt("height", 1024);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+
+    BenchmarkMesh mesh;
+    GenerateBenchmarkMesh(meshType, triangleCount, 1, &mesh);
+    CpuTriangleGeometryDesc geometry = mesh.GetGeometryDesc();
+
+    std::vector<BenchmarkTriangle> triangles(GetTriangleCount(geometry));
+    for (UINT i = 0; i < static_cast<UINT>(triangles.size()); i++)
+    {
+        LoadTriangle(geometry, i, &triangles[i].v0, &triangles[i].v1, &triangles[i].v2);
+    }
+
+    Bvh bvh;
+    BuildBvhBinnedSah(geometry, BinnedSahBuildSettings(), &bvh);
+    Bvh8 bvh8;
+    Bvh8 bvh8Quantized;
+    CollapseBvh8(bvh, Bvh8Layout::Float, &bvh8);
+    CollapseBvh8(bvh, Bvh8Layout::Quantized, &bvh8Quantized);
+
+    // Look at the mesh from outside its bounds, slightly from above.
+    const AABB& bounds = bvh.Bounds();
+    float3 center = bounds.Center();
+    float radius = 0.5f * length(bounds.Extent());
+    float3 eye = center + float3(0.3f, 0.5f, -1.2f) * (2.0f * radius);
+    float4x4 view = float4x4::LookAtLH(eye, center, float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+
+    auto IntersectTriangle = [&](const Ray& ray, UINT primIndex, float& tMax)
+    {
+        const BenchmarkTriangle& triangle = triangles[primIndex];
+        float t, det;
+        float2 barycentrics;
+        if (IntersectRayTriangle(ray, triangle.v0, triangle.v1, triangle.v2, tMax, &t, &barycentrics, &det))
+        {
+            tMax = t;
+        }
+        return false;
+    };
+
+    printf("BVH8 trace: %zu triangles (%s), %ux%u primary rays, best of %u, AVX2 %s\n",
+        triangles.size(), meshType.c_str(), width, height, iterations, CpuSupportsAvx2() ? "supported" : "not supported");
+    printf("%-18s %10s %10s %12s %10s  %s\n", "traversal", "nodes", "MB", "trace (ms)", "Mrays/s", "hash");
+
+    auto Run = [&](const char* name, size_t nodeCount, size_t nodeSize, const std::function<void(const Ray&, float&)>& trace)
+    {
+        auto RayGen = [&](UINT x, UINT y)
+        {
+            Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye, 0.0f, 4.0f * radius);
+            float tMax = ray.tMax;
+            trace(ray, tMax);
+            float shade = (tMax < ray.tMax) ? 1.0f - tMax / ray.tMax : 0.0f;
+            return float4(shade, shade, shade, 1.0f);
+        };
+
+        CpuImage image;
+        double bestMs = 1e30;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            DispatchRaysReference(width, height, RayGen, &image, numThreads);
+            bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+        }
+        printf("%-18s %10zu %10.2f %12.2f %10.2f  %016llx\n", name, nodeCount, nodeCount * nodeSize / (1024.0 * 1024.0),
+            bestMs, static_cast<double>(width) * height / (bestMs * 1000.0), static_cast<unsigned long long>(image.Hash()));
+    };
+
+    Run("binary", bvh.nodes.size(), sizeof(BvhNode), [&](const Ray& ray, float& tMax)
+    {
+        TraverseBvh(bvh, ray, tMax, [&](UINT primIndex, float& currentTMax) { return IntersectTriangle(ray, primIndex, currentTMax); });
+    });
+
+    struct Variant
+    {
+        const char* name;
+        const Bvh8* bvh;
+        Bvh8Kernel::Enum kernel;
+    };
+    const Variant variants[] =
+    {
+        { "bvh8 scalar", &bvh8, Bvh8Kernel::Scalar },
+        { "bvh8 avx2", &bvh8, Bvh8Kernel::Avx2 },
+        { "bvh8 quant scalar", &bvh8Quantized, Bvh8Kernel::Scalar },
+        { "bvh8 quant avx2", &bvh8Quantized, Bvh8Kernel::Avx2 },
+    };
+    for (const Variant& variant : variants)
+    {
+        if (variant.kernel == Bvh8Kernel::Avx2 && !CpuSupportsAvx2())
+        {
+            printf("%-18s skipped\n", variant.name);
+            continue;
+        }
+        Run(variant.name, variant.bvh->GetNodeCount(), variant.bvh->GetNodeSizeInBytes(), [&](const Ray& ray, float& tMax)
+        {
+            TraverseBvh8(*variant.bvh, ray, tMax, variant.kernel,
+                [&](UINT primIndex, float& currentTMax) { return IntersectTriangle(ray, primIndex, currentTMax); });
+        });
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("bvh8trace", "Binary vs BVH8 scalar/AVX2 primary ray throughput", Bvh8TraceBenchmark);
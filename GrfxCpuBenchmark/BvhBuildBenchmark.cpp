@@ -0,0 +1,95 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// BVH build benchmark: binned SAH and Morton builders at several thread counts against the median split reference builder.
+//
+// Options: -triangles <n> (1000000) -mesh cubes|terrain (cubes) -bins <n> (16) -leaf <n> (4)
+//          -threads <list> (1,<hardware threads>) -iterations <n> (3)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "BinnedSahBuilder.h"
+#include "MortonBuilder.h"
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+using namespace CpuRT;
+
+static int BvhBuildBenchmark(const BenchmarkArgs& args)
+{
+    UINT triangleCount = args.GetUInt("triangles", 1000000);
+    std::string meshType = args.GetString("mesh", "cubes");
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+    std::vector<UINT> threadCounts = { 1 };
+    if (std::thread::hardware_concurrency() > 1)
+    {
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    }
+    threadCounts = args.GetUIntList("threads", threadCounts);
+
+    BinnedSahBuildSettings settings;
+    settings.binCount = args.GetUInt("bins", settings.binCount);
+    settings.maxLeafSize = args.GetUInt("leaf", settings.maxLeafSize);
+
+    BenchmarkMesh mesh;
+    GenerateBenchmarkMesh(meshType, triangleCount, 1, &mesh);
+
+    std::vector<AABB> primBounds;
+    ComputeTriangleBounds(mesh.GetGeometryDesc(), &primBounds);
+    UINT primCount = static_cast<UINT>(primBounds.size());
+
+    printf("BVH build: %u triangles (%s), %u bins, leaf size %u, best of %u\n",
+        primCount, meshType.c_str(), settings.binCount, settings.maxLeafSize, iterations);
+    printf("%-12s %8s %12s %10s %6s %10s\n", "builder", "threads", "build (ms)", "nodes", "depth", "SAH cost");
+
+    auto Report = [&](const char* name, UINT threads, double bestMs, const Bvh& bvh)
+    {
+        printf("%-12s %8u %12.2f %10zu %6u %10.2f\n", name, threads, bestMs, bvh.nodes.size(), bvh.Depth(), bvh.SahCost());
+    };
+
+    Bvh bvh;
+    auto TimeBuild = [&](const char* name, UINT threads, const std::function<void()>& build)
+    {
+        double bestMs = 1e30;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            build();
+            bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+        }
+        Report(name, threads, bestMs, bvh);
+    };
+
+    TimeBuild("median", 1, [&]() { BuildBvhMedianSplit(primBounds.data(), primCount, settings.maxLeafSize, &bvh); });
+
+    for (UINT threads : threadCounts)
+    {
+        settings.numThreads = threads;
+        TimeBuild("binned SAH", threads, [&]() { BuildBvhBinnedSah(primBounds.data(), primCount, settings, &bvh); });
+    }
+
+    MortonBuildSettings mortonSettings;
+    mortonSettings.maxLeafSize = settings.maxLeafSize;
+    for (UINT mortonBits : { 30u, 63u })
+    {
+        mortonSettings.mortonBits = mortonBits;
+        for (UINT threads : threadCounts)
+        {
+            mortonSettings.numThreads = threads;
+            TimeBuild((mortonBits == 30) ? "morton 30" : "morton 63", threads,
+                [&]() { BuildBvhMorton(primBounds.data(), primCount, mortonSettings, &bvh); });
+        }
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("bvhbuild", "Binned SAH and Morton vs median BVH build time and quality", BvhBuildBenchmark);
@@ -0,0 +1,181 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// DispatchRays scheduling benchmark on a deliberately unbalanced image: pixels inside a small square
+// sphere trace a Sierpinski pyramid distance field, the stand-in for FractalPyramid, while the rest only
+// write a background color. Compares static row bands, one per thread, against DispatchRaysTiled() on
+// the work-stealing pool. Balance is the mean over the maximum per-thread busy time.
+//
+// Options: -width <n> (1024) -height <n> (1024) -tile <n> (16) -threads <list> (1,<hardware threads>)
+//          -steps <n> (64 sphere tracing steps) -iterations <n> (3) -tiletimes <file>
+
+#include "Benchmark.h"
+#include "CpuDispatchRays.h"
+#include "CpuReferenceRenderer.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace CpuRT;
+
+namespace
+{
+    // Distance to a Sierpinski pyramid of the given fold count, by folding space towards one corner.
+    float SierpinskiPyramidDistance(float3 p, UINT folds)
+    {
+        const float scale = 2.0f;
+        for (UINT i = 0; i < folds; i++)
+        {
+            if (p.x + p.y < 0.0f) { float t = -p.y; p.y = -p.x; p.x = t; }
+            if (p.x + p.z < 0.0f) { float t = -p.z; p.z = -p.x; p.x = t; }
+            if (p.y + p.z < 0.0f) { float t = -p.z; p.z = -p.y; p.y = t; }
+            p = p * scale - float3(scale - 1.0f, scale - 1.0f, scale - 1.0f);
+        }
+        return length(p) * powf(scale, -static_cast<float>(folds));
+    }
+
+    float4 UnbalancedRaygen(UINT x, UINT y, UINT width, UINT height, UINT steps)
+    {
+        float2 uv(static_cast<float>(x) / width, static_cast<float>(y) / height);
+        if (uv.x < 0.6f || uv.x > 0.85f || uv.y < 0.6f || uv.y > 0.85f)
+        {
+            return float4(uv.x, uv.y, 0.2f, 1.0f);
+        }
+
+        // Orthographic ray through the square, looking down +Z at the pyramid.
+        float3 origin((uv.x - 0.725f) * 8.0f, (uv.y - 0.725f) * 8.0f, -3.0f);
+        float t = 0.0f;
+        UINT step = 0;
+        for (; step < steps; step++)
+        {
+            float d = SierpinskiPyramidDistance(origin + float3(0, 0, t), 8);
+            if (d < 1e-4f || t > 6.0f)
+            {
+                break;
+            }
+            t += d;
+        }
+        float shade = 1.0f - static_cast<float>(step) / steps;
+        return float4(shade, shade, shade, 1.0f);
+    }
+}
+
+static int DispatchBenchmark(const BenchmarkArgs& args)
+{
+    UINT width = args.GetUInt("width", 1024);
+    UINT height = args.GetUInt("height", 1024);
+    UINT tileSize = (std::max)(1u, args.GetUInt("tile", 16));
+    UINT steps = (std::max)(1u, args.GetUInt("steps", 64));
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+    std::string tileTimesFile = args.GetString("tiletimes", "");
+    std::vector<UINT> threadCounts = { 1 };
+    if (std::thread::hardware_concurrency() > 1)
+    {
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    }
+    threadCounts = args.GetUIntList("threads", threadCounts);
+
+    CpuImage image(width, height);
+    auto Raygen = [&](UINT x, UINT y, UINT) { image.SetPixel(x, y, UnbalancedRaygen(x, y, width, height, steps)); };
+
+    printf("DispatchRays: %ux%u, %ux%u tiles, %u steps, best of %u\n", width, height, tileSize, tileSize, steps, iterations);
+    printf("%-14s %8s %12s %8s %8s %18s\n", "scheduler", "threads", "time (ms)", "speedup", "balance", "hash");
+
+    double serialMs = 0.0;
+    auto Report = [&](const char* name, UINT threads, double bestMs, const std::vector<double>& busyMs)
+    {
+        if (serialMs == 0.0)
+        {
+            serialMs = bestMs;
+        }
+        double maxBusy = 0.0;
+        double totalBusy = 0.0;
+        for (double busy : busyMs)
+        {
+            maxBusy = (std::max)(maxBusy, busy);
+            totalBusy += busy;
+        }
+        double balance = maxBusy > 0.0 ? totalBusy / busyMs.size() / maxBusy : 1.0;
+        printf("%-14s %8u %12.2f %8.2f %8.2f   %016llx\n", name, threads, bestMs, serialMs / bestMs, balance,
+            static_cast<unsigned long long>(image.Hash()));
+    };
+
+    for (UINT threads : threadCounts)
+    {
+        threads = (std::max)(1u, (std::min)(threads, height));
+
+        // Static partitioning: thread i renders rows [i * height / threads, (i + 1) * height / threads).
+        double bestMs = 1e30;
+        std::vector<double> busyMs(threads);
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            std::vector<std::thread> workers;
+            auto RenderBand = [&](UINT band)
+            {
+                BenchmarkTimer bandTimer;
+                for (UINT y = band * height / threads; y < (band + 1) * height / threads; y++)
+                {
+                    for (UINT x = 0; x < width; x++)
+                    {
+                        Raygen(x, y, 0);
+                    }
+                }
+                busyMs[band] = bandTimer.GetElapsedMs();
+            };
+            for (UINT band = 1; band < threads; band++)
+            {
+                workers.emplace_back(RenderBand, band);
+            }
+            RenderBand(0);
+            for (std::thread& worker : workers)
+            {
+                worker.join();
+            }
+            bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+        }
+        Report("static rows", threads, bestMs, busyMs);
+    }
+
+    CpuDispatchRaysDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.tileWidth = tileSize;
+    desc.tileHeight = tileSize;
+    std::vector<CpuTileTiming> tileTimings;
+    for (UINT threads : threadCounts)
+    {
+        CpuThreadPool pool(threads);
+        double bestMs = 1e30;
+        std::vector<double> busyMs(pool.GetThreadCount());
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            DispatchRaysTiled(desc, Raygen, &pool, &tileTimings);
+            bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+        }
+        std::fill(busyMs.begin(), busyMs.end(), 0.0);
+        for (const CpuTileTiming& timing : tileTimings)
+        {
+            busyMs[timing.threadIndex] += timing.durationUs / 1000.0;
+        }
+        Report("work stealing", pool.GetThreadCount(), bestMs, busyMs);
+    }
+
+    if (!tileTimesFile.empty() && !SaveTileTimingsCsv(tileTimesFile.c_str(), tileTimings))
+    {
+        fprintf(stderr, "Failed to write %s\n", tileTimesFile.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("dispatch", "Static row bands vs work-stealing tiled DispatchRays on an unbalanced image", DispatchBenchmark);
@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Two-level traversal benchmark: a TLAS over many instances of a few cube-field BLASes, rendered with a
+// pinhole camera. Instance i gets InstanceMask 1 << (i % 8) so -mask exercises TLAS mask pruning.
+//
+// Options: -instances <n> (100000) -blas <n> (4) -triangles <n> (1200 per BLAS) -mask <n> (255)
+//          -width <n> (512) -height <n> (512) -threads <n> (0 = hardware threads) -iterations <n> (3)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CpuReferenceRenderer.h"
+#include "CpuScene.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace CpuRT;
+
+static int InstanceTraceBenchmark(const BenchmarkArgs& args)
+{
+    UINT instanceCount = (std::max)(1u, args.GetUInt("instances", 100000));
+    UINT blasCount = (std::max)(1u, args.GetUInt("blas", 4));
+    UINT triangleCount = args.GetUInt("triangles", 1200);
+    UINT inclusionMask = args.GetUInt("mask", 0xFF);
+    UINT width = args.GetUInt("width", 512);
+    UINT height = args.GetUInt("height", 512);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+
+    std::vector<BenchmarkMesh> meshes(blasCount);
+    std::vector<GeomDesc> geomDescs;
+    std::vector<DxBlasDesc> blasDescs;
+    CpuScene scene;
+    for (UINT i = 0; i < blasCount; i++)
+    {
+        GenerateCubeField(triangleCount, 1.0f, i + 1, &meshes[i]);
+        scene.SetTriangleGeometry(i, meshes[i].GetGeometryDesc());
+        geomDescs.push_back({ static_cast<int>(i), D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE });
+        blasDescs.push_back({ { static_cast<int>(i) }, D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES });
+    }
+
+    // Instances fill a cube that grows with the instance count, about one instance per 4^3 units.
+    float extent = 2.0f * std::cbrt(static_cast<float>(instanceCount));
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-extent, extent);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+    std::vector<DxTlasDesc> tlasDescs(instanceCount);
+    for (UINT i = 0; i < instanceCount; i++)
+    {
+        float s = scale(random);
+        tlasDescs[i].blasIndex = i % blasCount;
+        tlasDescs[i].instanceContributionToHitIndex = 0;
+        GetTransform3x4Matrix(&tlasDescs[i].transformMatrix, s, s, s, position(random), position(random), position(random));
+    }
+
+    BenchmarkTimer timer;
+    scene.Build(geomDescs, blasDescs, tlasDescs);
+    double buildMs = timer.GetElapsedMs();
+
+    for (UINT i = 0; i < instanceCount; i++)
+    {
+        scene.SetInstanceMask(i, 1u << (i % 8));
+    }
+    timer.Reset();
+    scene.UpdateTlas();
+    double refitMs = timer.GetElapsedMs();
+
+    float3 eye(0.0f, 0.5f * extent, -3.0f * extent);
+    float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+
+    std::atomic<UINT> hitCount(0);
+    auto RayGen = [&](UINT x, UINT y)
+    {
+        Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye, 0.0f, 10.0f * extent);
+        CpuHit hit;
+        if (scene.TraceRay(ray, RAY_FLAG_NONE, inclusionMask, 0, 1, &hit))
+        {
+            hitCount++;
+            return float4(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        return float4(0.0f, 0.0f, 0.0f, 1.0f);
+    };
+
+    CpuImage image;
+    double bestMs = 1e30;
+    for (UINT i = 0; i < iterations; i++)
+    {
+        hitCount = 0;
+        timer.Reset();
+        DispatchRaysReference(width, height, RayGen, &image, numThreads);
+        bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+    }
+
+    const Bvh& tlas = scene.GetTlas().GetBvh();
+    double rayCount = static_cast<double>(width) * height;
+    printf("Instance trace: %u instances of %u BLASes (%u triangles each), mask 0x%02X, %ux%u, best of %u\n",
+        instanceCount, blasCount, meshes[0].GetTriangleCount(), inclusionMask, width, height, iterations);
+    printf("scene build    %10.2f ms\n", buildMs);
+    printf("TLAS refit     %10.2f ms (%zu nodes, depth %u)\n", refitMs, tlas.nodes.size(), tlas.Depth());
+    printf("trace          %10.2f ms, %.2f Mrays/s, %.1f%% hit\n",
+        bestMs, rayCount / (bestMs * 1000.0), 100.0 * hitCount / rayCount);
+    return 0;
+}
+
+REGISTER_BENCHMARK("instancetrace", "TLAS traversal over many instances with mask filtering", InstanceTraceBenchmark);
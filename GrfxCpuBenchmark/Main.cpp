@@ -0,0 +1,76 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Benchmark driver for the CPU raytracer.
+//
+// Usage: GrfxCpuBenchmark <benchmark> [-option value]...
+//        GrfxCpuBenchmark -list
+
+#include "Benchmark.h"
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+std::vector<BenchmarkDesc>& GetBenchmarks()
+{
+    static std::vector<BenchmarkDesc> benchmarks;
+    return benchmarks;
+}
+
+static void PrintBenchmarks()
+{
+    printf("Benchmarks:\n");
+    for (const BenchmarkDesc& desc : GetBenchmarks())
+    {
+        printf("  %-20s %s\n", desc.name, desc.description);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || strcmp(argv[1], "-list") == 0)
+    {
+        PrintBenchmarks();
+        return argc < 2 ? 2 : 0;
+    }
+
+    BenchmarkArgs args;
+    for (int i = 2; i < argc; i++)
+    {
+        if (argv[i][0] != '-' || i + 1 >= argc)
+        {
+            fprintf(stderr, "Expected -option value pairs, got %s\n", argv[i]);
+            return 2;
+        }
+        args.Set(argv[i] + 1, argv[i + 1]);
+        i++;
+    }
+
+    for (const BenchmarkDesc& desc : GetBenchmarks())
+    {
+        if (strcmp(desc.name, argv[1]) == 0)
+        {
+            try
+            {
+                return desc.func(args);
+            }
+            catch (const std::exception& e)
+            {
+                fprintf(stderr, "%s failed: %s\n", desc.name, e.what());
+                return 1;
+            }
+        }
+    }
+
+    fprintf(stderr, "Unknown benchmark %s\n", argv[1]);
+    PrintBenchmarks();
+    return 2;
+}
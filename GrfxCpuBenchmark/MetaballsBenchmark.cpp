@@ -0,0 +1,165 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Metaballs benchmark: traces the same pinhole camera rays through metaball fields with the sample's 128 uniform
+// steps ("uniform") and with interval bounds and Newton refinement ("interval"). 3 and 5 metaballs are the
+// sample's animated sets at -time; other counts are random metaballs of the same total volume. Reports the field
+// evaluations per ray (potentials and bounds, each over the metaballs the ray intersects), the trace time, the
+// rays whose hit differs from the uniform march and the largest hit distance difference in uniform steps.
+//
+// Options: -counts <list> (3,5,64,256,1024) -time <seconds> (3) -seed <n> (1) -width <n> (512) -height <n> (512)
+//          -threads <n> (0 = hardware threads) -iterations <n> (3)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CpuReferenceRenderer.h"
+#include "VolumetricPrimitives.h"
+#include <cmath>
+#include <cstdio>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct MetaballHit
+    {
+        bool hit;
+        float t;
+        UINT steps;
+    };
+}
+
+static int MetaballsBenchmark(const BenchmarkArgs& args)
+{
+    std::vector<UINT> counts = args.GetUIntList("counts", { 3, 5, 64, 256, 1024 });
+    float elapsedTime = args.GetFloat("time", 3.0f);
+    UINT seed = args.GetUInt("seed", 1);
+    UINT width = args.GetUInt("width", 512);
+    UINT height = args.GetUInt("height", 512);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+
+    // The sample's view of the AABB; rays that miss it never reach the intersection shader.
+    const float3 eye(1.8f, 1.6f, -3.2f);
+    float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+    const AABB box(float3(-1.0f), float3(1.0f));
+
+    std::vector<Ray> rays;
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++)
+        {
+            Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye);
+            float tEntry;
+            if (IntersectRayAABB(ray.origin, rcp(ray.direction), box, ray.tMin, ray.tMax, &tEntry))
+            {
+                rays.push_back(ray);
+            }
+        }
+    }
+
+    printf("Metaballs: %zu rays through the AABB, time %.2f s, best of %u\n", rays.size(), elapsedTime, iterations);
+    printf("%-10s %-9s %11s %9s %9s %11s %8s %8s %9s %10s\n", "metaballs", "march", "steps/ray", "max", "ms",
+        "speedup", "hits", "hit diff", "t diff", "");
+
+    CpuThreadPool pool(numThreads);
+    CpuDispatchRaysDesc desc;
+    desc.width = static_cast<UINT>(rays.size());
+    desc.height = 1;
+    desc.tileWidth = 256;
+    desc.tileHeight = 1;
+    std::vector<MetaballHit> uniformHits(rays.size());
+    std::vector<MetaballHit> intervalHits(rays.size());
+
+    for (UINT count : counts)
+    {
+        std::vector<Metaball> blobs;
+        if (count == 3 || count == 5)
+        {
+            blobs.resize(count);
+            InitializeAnimatedMetaballs(blobs.data(), count, elapsedTime, 12.0f);
+        }
+        else
+        {
+            GenerateMetaballField("random", count, seed, &blobs);
+        }
+
+        auto Run = [&](bool interval, std::vector<MetaballHit>& hits)
+        {
+            double bestMs = 1e30;
+            for (UINT i = 0; i < iterations; i++)
+            {
+                BenchmarkTimer timer;
+                DispatchRaysTiled(desc, [&](UINT x, UINT, UINT)
+                {
+                    // The ray tests reorder the metaballs they are given, as the shaders do with their local copy.
+                    thread_local std::vector<Metaball> localBlobs;
+                    localBlobs.assign(blobs.begin(), blobs.end());
+                    MetaballHit& hit = hits[x];
+                    float3 normal;
+                    hit.hit = interval
+                        ? RayMetaballsIntervalIntersectionTest(rays[x], RAY_FLAG_NONE, localBlobs.data(), static_cast<UINT>(localBlobs.size()), &hit.t, &normal, &hit.steps)
+                        : RayMetaballsIntersectionTest(rays[x], RAY_FLAG_NONE, localBlobs.data(), static_cast<UINT>(localBlobs.size()), &hit.t, &normal, &hit.steps);
+                }, &pool);
+                bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+            }
+            return bestMs;
+        };
+        double uniformMs = Run(false, uniformHits);
+        double intervalMs = Run(true, intervalHits);
+
+        UINT64 uniformSteps = 0;
+        UINT64 intervalSteps = 0;
+        UINT uniformMaxSteps = 0;
+        UINT intervalMaxSteps = 0;
+        size_t uniformHitCount = 0;
+        size_t intervalHitCount = 0;
+        size_t hitDifferences = 0;
+        double tDifferenceMax = 0.0;
+        for (size_t i = 0; i < rays.size(); i++)
+        {
+            const MetaballHit& u = uniformHits[i];
+            const MetaballHit& v = intervalHits[i];
+            uniformSteps += u.steps;
+            intervalSteps += v.steps;
+            uniformMaxSteps = (std::max)(uniformMaxSteps, u.steps);
+            intervalMaxSteps = (std::max)(intervalMaxSteps, v.steps);
+            uniformHitCount += u.hit;
+            intervalHitCount += v.hit;
+            if (u.hit != v.hit)
+            {
+                hitDifferences++;
+            }
+            else if (u.hit)
+            {
+                // The uniform march returns the first step inside, up to one step past the crossing.
+                float tmin, tmax;
+                UINT nActiveMetaballs;
+                std::vector<Metaball> localBlobs(blobs);
+                FindIntersectingMetaballs(rays[i], &tmin, &tmax, localBlobs.data(), static_cast<UINT>(localBlobs.size()), &nActiveMetaballs);
+                double uniformStep = (tmax - tmin) / c_metaballMaxSteps;
+                tDifferenceMax = (std::max)(tDifferenceMax, std::abs(u.t - v.t) / uniformStep);
+            }
+        }
+
+        double rayCount = (std::max)(static_cast<double>(rays.size()), 1.0);
+        printf("%-10u %-9s %11.2f %9u %9.2f %11s %8zu %8s %9s\n", count, "uniform", uniformSteps / rayCount, uniformMaxSteps,
+            uniformMs, "", uniformHitCount, "", "");
+        printf("%-10s %-9s %11.2f %9u %9.2f %10.2fx %8zu %7.2f%% %9.2f\n", "", "interval", intervalSteps / rayCount, intervalMaxSteps,
+            intervalMs, uniformMs / intervalMs, intervalHitCount, 100.0 * hitDifferences / rayCount, tDifferenceMax);
+    }
+    printf("t diff is the largest hit distance difference of rays both hit, in uniform steps.\n");
+    return 0;
+}
+
+REGISTER_BENCHMARK("metaballs", "Uniform vs interval bounded ray marching of metaball fields", MetaballsBenchmark);
@@ -0,0 +1,149 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Packet traversal benchmark: primary rays of a HelloWorld style orthographic camera and a SimpleLighting
+// style pinhole camera against a generated mesh, traced one by one with TraceRay() and as 8x8 packets with
+// TraceRayPacket(). Rays whose hit distance differs between the two paths are counted and must be 0.
+//
+// Options: -triangles <n> (1000000) -mesh cubes|terrain (cubes) -width <n> (1024) -height <n> (1024)
+//          -threads <n> (0 = hardware threads) -iterations <n> (3)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CpuReferenceRenderer.h"
+#include "CpuScene.h"
+#include <cstdio>
+#include <functional>
+
+using namespace CpuRT;
+
+static int PacketTraceBenchmark(const BenchmarkArgs& args)
+{
+    UINT triangleCount = args.GetUInt("triangles", 1000000);
+    std::string meshType = args.GetString("mesh", "cubes");
+    UINT width = args.GetUInt("width", 1024);
+    UINT height = args.GetUInt("height", 1024);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+
+    BenchmarkMesh mesh;
+    GenerateBenchmarkMesh(meshType, triangleCount, 1, &mesh);
+    CpuScene scene;
+    scene.SetTriangleGeometry(0, mesh.GetGeometryDesc());
+    std::vector<GeomDesc> geomDescs = { { 0, D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE } };
+    std::vector<DxBlasDesc> blasDescs = { { { 0 }, D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES } };
+    std::vector<DxTlasDesc> tlasDescs(1);
+    tlasDescs[0].blasIndex = 0;
+    tlasDescs[0].instanceContributionToHitIndex = 0;
+    GetTransform3x4Matrix(&tlasDescs[0].transformMatrix, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+    scene.Build(geomDescs, blasDescs, tlasDescs);
+
+    // The orthographic camera looks down +Z from z = 0 like MyRaygenShader, so move the mesh in front of it.
+    const AABB& bounds = scene.GetBlas(0).bounds;
+    GetTransform3x4Matrix(&tlasDescs[0].transformMatrix, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f - bounds.minimum.z);
+    scene.SetInstanceTransform(0, tlasDescs[0].transformMatrix);
+    scene.UpdateTlas();
+    const AABB worldBounds = scene.GetInstance(0).worldBounds;
+
+    float3 center = worldBounds.Center();
+    float radius = 0.5f * length(worldBounds.Extent());
+    float3 eye = center + float3(0.3f, 0.5f, -1.2f) * (2.0f * radius);
+    float4x4 view = float4x4::LookAtLH(eye, center, float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+
+    struct Camera
+    {
+        const char* name;
+        std::function<Ray(UINT x, UINT y)> generateRay;
+        std::function<void(UINT x, UINT y, RayPacket* packet)> generatePacket;
+    };
+    const Camera cameras[] =
+    {
+        {
+            "orthographic",
+            [&](UINT x, UINT y) { return GenerateOrthographicRay(x, y, width, height,
+                worldBounds.minimum.x, worldBounds.maximum.y, worldBounds.maximum.x, worldBounds.minimum.y); },
+            [&](UINT x, UINT y, RayPacket* packet) { GenerateOrthographicRayPacket(x, y, width, height,
+                worldBounds.minimum.x, worldBounds.maximum.y, worldBounds.maximum.x, worldBounds.minimum.y, packet); }
+        },
+        {
+            "pinhole",
+            [&](UINT x, UINT y) { return GeneratePinholeRay(x, y, width, height, projectionToWorld, eye); },
+            [&](UINT x, UINT y, RayPacket* packet) { GeneratePinholeRayPacket(x, y, width, height, projectionToWorld, eye, packet); }
+        },
+    };
+
+    printf("Packet trace: %u triangles (%s), %ux%u primary rays, best of %u\n",
+        mesh.GetTriangleCount(), meshType.c_str(), width, height, iterations);
+    printf("%-14s %-8s %12s %10s %8s %10s\n", "camera", "mode", "trace (ms)", "Mrays/s", "speedup", "mismatch");
+
+    CpuThreadPool pool(numThreads);
+    CpuDispatchRaysDesc desc;
+    desc.width = width;
+    desc.height = height;
+    std::vector<float> singleT(static_cast<size_t>(width) * height);
+    std::vector<float> packetT(singleT.size());
+    const double rayCount = static_cast<double>(width) * height;
+
+    for (const Camera& camera : cameras)
+    {
+        double singleMs = 1e30;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            DispatchRaysTiled(desc, [&](UINT x, UINT y, UINT)
+            {
+                CpuHit hit;
+                bool hasHit = scene.TraceRay(camera.generateRay(x, y), RAY_FLAG_NONE, ~0u, 0, 1, &hit);
+                singleT[static_cast<size_t>(y) * width + x] = hasHit ? hit.t : -1.0f;
+            }, &pool);
+            singleMs = (std::min)(singleMs, timer.GetElapsedMs());
+        }
+        printf("%-14s %-8s %12.2f %10.2f %8.2f %10s\n", camera.name, "single", singleMs, rayCount / (singleMs * 1000.0), 1.0, "");
+
+        double packetMs = 1e30;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            DispatchRayTiles(desc, [&](const CpuDispatchTile& tile)
+            {
+                RayPacket packet;
+                CpuHit hits[c_rayPacketSize];
+                for (UINT y = tile.y; y < tile.y + tile.height; y += c_rayPacketHeight)
+                {
+                    for (UINT x = tile.x; x < tile.x + tile.width; x += c_rayPacketWidth)
+                    {
+                        camera.generatePacket(x, y, &packet);
+                        UINT64 hitMask = scene.TraceRayPacket(packet, RAY_FLAG_NONE, ~0u, 0, 1, hits);
+                        for (UINT r = 0; r < packet.GetRayCount(); r++)
+                        {
+                            size_t pixel = static_cast<size_t>(y + r / packet.width) * width + x + r % packet.width;
+                            packetT[pixel] = ((hitMask >> r) & 1) ? hits[r].t : -1.0f;
+                        }
+                    }
+                }
+            }, &pool);
+            packetMs = (std::min)(packetMs, timer.GetElapsedMs());
+        }
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < singleT.size(); i++)
+        {
+            mismatches += (singleT[i] != packetT[i]) ? 1 : 0;
+        }
+        printf("%-14s %-8s %12.2f %10.2f %8.2f %10zu\n", camera.name, "packet", packetMs, rayCount / (packetMs * 1000.0),
+            singleMs / packetMs, mismatches);
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("packettrace", "Single ray vs 8x8 packet traversal for orthographic and pinhole primary rays", PacketTraceBenchmark);
@@ -0,0 +1,150 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Primitive transforms benchmark: computes the per-frame transforms of the primitives of a procedural stress scene
+// as UpdateAABBPrimitiveAttributes() does ("general": scale * rotation * translation matrix products and a general
+// inverse, one primitive at a time) and with the closed-form inverse of PrimitiveTransforms.h, scalar and AVX2 on
+// one thread and AVX2 over the thread pool. Reports the time per frame and per primitive, the largest element
+// difference to the general inverse and the primitives whose transforms differ from the scalar closed form.
+//
+// Options: -counts <list> (10000,100000,1000000) -seed <n> (1) -threads <n> (0 = hardware threads) -iterations <n> (10)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+using namespace CpuRT;
+
+static int PrimitiveTransformsBenchmark(const BenchmarkArgs& args)
+{
+    std::vector<UINT> counts = args.GetUIntList("counts", { 10000, 100000, 1000000 });
+    UINT seed = args.GetUInt("seed", 1);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 10));
+
+    CpuThreadPool pool(numThreads);
+    printf("Primitive transforms: %u threads, best of %u\n", pool.GetThreadCount(), iterations);
+    printf("%-10s %-16s %10s %10s %8s %10s %9s\n", "primitives", "update", "frame (ms)", "ns/prim", "speedup", "max diff", "bit diff");
+
+    for (UINT count : counts)
+    {
+        ProceduralStressScene scene;
+        GenerateProceduralStressScene(count, seed, &pool, &scene);
+        const PrimitiveTransformBatch& batch = scene.transformParameters;
+
+        auto Time = [&](const std::function<void(PrimitiveInstancePerFrameBuffer*)>& update, std::vector<PrimitiveInstancePerFrameBuffer>* transforms)
+        {
+            transforms->resize(count);
+            double bestMs = 1e30;
+            for (UINT i = 0; i < iterations; i++)
+            {
+                BenchmarkTimer timer;
+                update(transforms->data());
+                bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+            }
+            return bestMs;
+        };
+
+        // UpdateAABBPrimitiveAttributes(): mScale * mRotation * mTranslation and XMMatrixInverse() per primitive.
+        std::vector<PrimitiveInstancePerFrameBuffer> general;
+        double generalMs = Time([&](PrimitiveInstancePerFrameBuffer* transforms)
+        {
+            for (UINT i = 0; i < count; i++)
+            {
+                float4x4 scale, rotation, translation;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    scale.m[axis][axis] = batch.scale[axis][i];
+                    translation.m[3][axis] = batch.translation[axis][i];
+                }
+                float sinAngle, cosAngle;
+                ScalarSinCos(batch.rotationY[i], &sinAngle, &cosAngle);
+                rotation.m[0][0] = cosAngle;
+                rotation.m[0][2] = -sinAngle;
+                rotation.m[2][0] = sinAngle;
+                rotation.m[2][2] = cosAngle;
+
+                float4x4 transform = scale * rotation * translation;
+                transforms[i].localSpaceToBottomLevelAS = transform;
+                transforms[i].bottomLevelASToLocalSpace = transform.Inverse();
+            }
+        }, &general);
+
+        std::vector<PrimitiveInstancePerFrameBuffer> scalar;
+        double scalarMs = Time([&](PrimitiveInstancePerFrameBuffer* transforms)
+        {
+            UpdatePrimitiveTransformsScalar(batch, 0, count, transforms);
+        }, &scalar);
+
+        bool avx2 = CpuSupportsAvx2();
+        std::vector<PrimitiveInstancePerFrameBuffer> avx2Serial;
+        std::vector<PrimitiveInstancePerFrameBuffer> avx2Pool;
+        double avx2SerialMs = 0.0;
+        double avx2PoolMs = 0.0;
+        if (avx2)
+        {
+            avx2SerialMs = Time([&](PrimitiveInstancePerFrameBuffer* transforms)
+            {
+                UpdatePrimitiveTransformsAvx2(batch, 0, count, transforms);
+            }, &avx2Serial);
+            avx2PoolMs = Time([&](PrimitiveInstancePerFrameBuffer* transforms)
+            {
+                UpdatePrimitiveTransforms(PrimitiveTransformKernel::Avx2, batch, transforms, &pool);
+            }, &avx2Pool);
+        }
+
+        auto MaxDifference = [&](const std::vector<PrimitiveInstancePerFrameBuffer>& transforms)
+        {
+            double maxDifference = 0.0;
+            for (UINT i = 0; i < count; i++)
+            {
+                const float* a = &general[i].localSpaceToBottomLevelAS.m[0][0];
+                const float* b = &transforms[i].localSpaceToBottomLevelAS.m[0][0];
+                for (int e = 0; e < 32; e++)
+                {
+                    maxDifference = (std::max)(maxDifference, std::abs(static_cast<double>(a[e]) - b[e]));
+                }
+            }
+            return maxDifference;
+        };
+        auto BitDifferences = [&](const std::vector<PrimitiveInstancePerFrameBuffer>& transforms)
+        {
+            UINT differences = 0;
+            for (UINT i = 0; i < count; i++)
+            {
+                differences += std::memcmp(&scalar[i], &transforms[i], sizeof(PrimitiveInstancePerFrameBuffer)) != 0;
+            }
+            return differences;
+        };
+
+        double rcpCount = 1e6 / (std::max)(count, 1u);
+        printf("%-10u %-16s %10.2f %10.2f %8s %10s %9s\n", count, "general", generalMs, generalMs * rcpCount, "", "", "");
+        printf("%-10s %-16s %10.2f %10.2f %7.2fx %10.2e %9s\n", "", "scalar", scalarMs, scalarMs * rcpCount,
+            generalMs / scalarMs, MaxDifference(scalar), "");
+        if (avx2)
+        {
+            printf("%-10s %-16s %10.2f %10.2f %7.2fx %10.2e %9u\n", "", "AVX2", avx2SerialMs, avx2SerialMs * rcpCount,
+                generalMs / avx2SerialMs, MaxDifference(avx2Serial), BitDifferences(avx2Serial));
+            printf("%-10s %-16s %10.2f %10.2f %7.2fx %10.2e %9u\n", "", "AVX2 threaded", avx2PoolMs, avx2PoolMs * rcpCount,
+                generalMs / avx2PoolMs, MaxDifference(avx2Pool), BitDifferences(avx2Pool));
+        }
+    }
+    if (!CpuSupportsAvx2())
+    {
+        printf("AVX2 is not supported on this CPU; only the scalar update was run.\n");
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("primtransforms", "General vs closed-form, SoA AVX2 per-frame AABB primitive transforms", PrimitiveTransformsBenchmark);
@@ -0,0 +1,174 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Procedural AABB stress benchmark: generates ProceduralGeometry scenes of increasing primitive count
+// (GenerateProceduralStressScene()), builds their bottom-level AS and renders them with a pinhole camera. The
+// intersection function transforms the object ray into primitive local space with bottomLevelASToLocalSpace and
+// runs the primitive's intersection test, as the sample's intersection shaders do. Reports the generation and
+// build times, the size of the per primitive buffers and of the BVH, and the trace time.
+//
+// Options: -counts <list> (1000,10000,100000,1000000) -seed <n> (1) -fast <0|1> (0 = binned SAH, 1 = Morton)
+//          -width <n> (256) -height <n> (256) -threads <n> (0 = hardware threads) -iterations <n> (3)
+//          -time <seconds> (3) for the metaballs
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CpuReferenceRenderer.h"
+#include "CpuScene.h"
+#include <atomic>
+#include <cstdio>
+
+using namespace CpuRT;
+
+namespace
+{
+    size_t GetBlasSizeInBytes(const CpuBlas& blas)
+    {
+        return blas.primitives.size() * sizeof(CpuBlas::Primitive)
+            + blas.bvh.nodes.size() * sizeof(BvhNode) + blas.bvh.primIndices.size() * sizeof(UINT)
+            + blas.bvh8.GetNodeCount() * blas.bvh8.GetNodeSizeInBytes() + blas.bvh8.primIndices.size() * sizeof(UINT);
+    }
+}
+
+static int ProceduralStressBenchmark(const BenchmarkArgs& args)
+{
+    std::vector<UINT> counts = args.GetUIntList("counts", { 1000, 10000, 100000, 1000000 });
+    UINT seed = args.GetUInt("seed", 1);
+    bool fastBuild = args.GetUInt("fast", 0) != 0;
+    UINT width = args.GetUInt("width", 256);
+    UINT height = args.GetUInt("height", 256);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+    float elapsedTime = args.GetFloat("time", 3.0f);
+
+    Metaball metaballs[3];
+    InitializeAnimatedMetaballs(metaballs, 3, elapsedTime, 12.0f);
+
+    printf("Procedural AABB stress: %s build, %ux%u, best of %u\n", fastBuild ? "Morton" : "binned SAH", width, height, iterations);
+    printf("%-10s %9s %10s %10s %9s %9s %10s %8s %7s\n", "AABBs", "gen (ms)", "build (ms)", "data (MB)", "BVH (MB)",
+        "nodes", "trace (ms)", "Mrays/s", "hit");
+
+    CpuThreadPool pool(numThreads);
+    for (UINT count : counts)
+    {
+        ProceduralStressScene stressScene;
+        BenchmarkTimer timer;
+        GenerateProceduralStressScene(count, seed, &pool, &stressScene);
+        double generateMs = timer.GetElapsedMs();
+
+        // One AABB geometry in one BLAS and one instance with an identity transform, as the sample's AABB BLAS.
+        CpuScene scene;
+        BinnedSahBuildSettings settings;
+        settings.numThreads = numThreads;
+        scene.SetBuildSettings(settings);
+        MortonBuildSettings fastSettings;
+        fastSettings.numThreads = numThreads;
+        scene.SetFastBuildSettings(fastSettings);
+        if (fastBuild)
+        {
+            scene.SetBuildFlags(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD);
+        }
+        scene.SetAABBGeometry(0, { stressScene.aabbs.data(), count, sizeof(D3D12_RAYTRACING_AABB) });
+        scene.SetIntersectionFunction([&](const CpuIntersectionInput& input, float* tHit, UINT* hitKind, float* attributes)
+        {
+            const ProceduralPrimitiveInstance& instance = stressScene.instances[input.primitiveIndex];
+            const PrimitiveInstancePerFrameBuffer& primitiveAttributes = stressScene.attributes[input.primitiveIndex];
+
+            // GetRayInAABBPrimitiveLocalSpace().
+            Ray localRay = input.objectRay;
+            localRay.origin = primitiveAttributes.bottomLevelASToLocalSpace.TransformRowVector(float4(input.objectRay.origin, 1.0f)).xyz();
+            localRay.direction = primitiveAttributes.bottomLevelASToLocalSpace.TransformRowVector(float4(input.objectRay.direction, 0.0f)).xyz();
+
+            float3 normal;
+            bool hit = false;
+            switch (instance.intersectionShaderType)
+            {
+            case CpuIntersectionShaderType::AnalyticPrimitive:
+                hit = RayAnalyticGeometryIntersectionTest(localRay, RAY_FLAG_NONE,
+                    static_cast<CpuAnalyticPrimitive::Enum>(instance.primitiveType), tHit, &normal);
+                break;
+            case CpuIntersectionShaderType::VolumetricPrimitive:
+            {
+                // The test reorders the metaballs it is given, as the shader does with its local copy.
+                Metaball localBlobs[3] = { metaballs[0], metaballs[1], metaballs[2] };
+                hit = RayVolumetricGeometryIntersectionTest(localRay, RAY_FLAG_NONE,
+                    static_cast<CpuVolumetricPrimitive::Enum>(instance.primitiveType), localBlobs, 3, tHit, &normal);
+                break;
+            }
+            default:
+                hit = RaySignedDistanceGeometryIntersectionTest(localRay, RAY_FLAG_NONE,
+                    static_cast<CpuSignedDistancePrimitive::Enum>(instance.primitiveType), tHit, &normal,
+                    stressScene.materials[input.primitiveIndex].stepScale);
+                break;
+            }
+            if (hit)
+            {
+                // ProceduralPrimitiveAttributes: the local space normal.
+                *hitKind = 0;
+                attributes[0] = normal.x;
+                attributes[1] = normal.y;
+                attributes[2] = normal.z;
+            }
+            return hit;
+        });
+
+        std::vector<GeomDesc> geomDescs = { { 0, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS, D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE } };
+        std::vector<DxBlasDesc> blasDescs = { { { 0 }, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS } };
+        std::vector<DxTlasDesc> tlasDescs(1);
+        tlasDescs[0].blasIndex = 0;
+        tlasDescs[0].instanceContributionToHitIndex = 0;
+        GetTransform3x4Matrix(&tlasDescs[0].transformMatrix, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+
+        timer.Reset();
+        scene.Build(geomDescs, blasDescs, tlasDescs);
+        double buildMs = timer.GetElapsedMs();
+
+        // The whole grid in view from above and in front, as the sample's camera sees its ten AABBs.
+        float extent = stressScene.extent;
+        float3 eye(0.5f * extent, 0.6f * extent, -2.5f * extent);
+        float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+        float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+        float4x4 projectionToWorld = (view * proj).Inverse();
+
+        std::atomic<UINT> hitCount(0);
+        auto RayGen = [&](UINT x, UINT y)
+        {
+            Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye, 0.0f, 10.0f * extent);
+            CpuHit hit;
+            if (scene.TraceRay(ray, RAY_FLAG_NONE, 0xFF, 0, 1, &hit))
+            {
+                hitCount++;
+                return float4(1.0f, 1.0f, 1.0f, 1.0f);
+            }
+            return float4(0.0f, 0.0f, 0.0f, 1.0f);
+        };
+
+        CpuImage image;
+        double traceMs = 1e30;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            hitCount = 0;
+            timer.Reset();
+            DispatchRaysReference(width, height, RayGen, &image, numThreads);
+            traceMs = (std::min)(traceMs, timer.GetElapsedMs());
+        }
+
+        const CpuBlas& blas = scene.GetBlas(0);
+        double rayCount = static_cast<double>(width) * height;
+        printf("%-10u %9.2f %10.2f %10.2f %9.2f %9zu %10.2f %8.2f %6.1f%%\n", count, generateMs, buildMs,
+            stressScene.GetSizeInBytes() / (1024.0 * 1024.0), GetBlasSizeInBytes(blas) / (1024.0 * 1024.0),
+            blas.bvh8.GetNodeCount(), traceMs, rayCount / (traceMs * 1000.0), 100.0 * hitCount / rayCount);
+    }
+    printf("data is the AABB, instance, material and transform buffers; BVH is the BLAS primitives, BVH and BVH8.\n");
+    return 0;
+}
+
+REGISTER_BENCHMARK("aabbstress", "BLAS build, memory and trace scaling with procedural AABB primitive count", ProceduralStressBenchmark);
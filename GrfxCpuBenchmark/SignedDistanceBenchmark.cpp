@@ -0,0 +1,170 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Signed distance primitive benchmark: pinhole camera rays through the <-1,1> AABB of each primitive of
+// D3D12RaytracingProceduralGeometry are sphere traced in batches of eight rays, one batch per 8x1 pixel
+// block, with the scalar and the AVX2 kernel. Rays that miss the AABB are skipped as they would never reach
+// the intersection shader. Rays whose hit, distance or normal differ between the kernels are counted and
+// must be 0.
+//
+// Options: -width <n> (512) -height <n> (512) -threads <n> (0 = hardware threads) -iterations <n> (3)
+//          -primitive <name> (all)
+
+#include "Benchmark.h"
+#include "CpuReferenceRenderer.h"
+#include "SignedDistancePrimitives.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct SignedDistancePrimitiveDesc
+    {
+        const char* name;
+        CpuSignedDistancePrimitive::Enum primitive;
+        float stepScale;            // As set up by the sample's UpdateAABBPrimitiveAttributes().
+    };
+
+    const SignedDistancePrimitiveDesc c_primitives[] =
+    {
+        { "MiniSpheres", CpuSignedDistancePrimitive::MiniSpheres, 1.0f },
+        { "IntersectedRoundCube", CpuSignedDistancePrimitive::IntersectedRoundCube, 1.0f },
+        { "SquareTorus", CpuSignedDistancePrimitive::SquareTorus, 1.0f },
+        { "TwistedTorus", CpuSignedDistancePrimitive::TwistedTorus, 0.5f },
+        { "Cog", CpuSignedDistancePrimitive::Cog, 1.0f },
+        { "Cylinder", CpuSignedDistancePrimitive::Cylinder, 1.0f },
+        { "FractalPyramid", CpuSignedDistancePrimitive::FractalPyramid, 0.8f },
+    };
+
+    struct BatchResult
+    {
+        UINT hitMask;
+        SignedDistanceBatchHits hits;
+    };
+}
+
+static int SignedDistanceBenchmark(const BenchmarkArgs& args)
+{
+    UINT width = args.GetUInt("width", 512);
+    UINT height = args.GetUInt("height", 512);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+    std::string primitiveName = args.GetString("primitive", "all");
+
+    if (!CpuSupportsAvx2())
+    {
+        printf("AVX2 is not supported on this CPU; the avx2 rows run the scalar kernel.\n");
+    }
+
+    // Camera in front of and above the AABB, like the sample's default view of a single primitive.
+    const float3 eye(1.8f, 1.6f, -3.2f);
+    float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+    const AABB box(float3(-1.0f), float3(1.0f));
+
+    // One batch per 8x1 block of pixels.
+    const UINT batchesPerRow = (width + c_signedDistanceRayBatchWidth - 1) / c_signedDistanceRayBatchWidth;
+    std::vector<SignedDistanceRayBatch> batches(static_cast<size_t>(batchesPerRow) * height);
+    size_t rayCount = 0;
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT bx = 0; bx < batchesPerRow; bx++)
+        {
+            SignedDistanceRayBatch& batch = batches[static_cast<size_t>(y) * batchesPerRow + bx];
+            batch = {};
+            for (UINT x = bx * c_signedDistanceRayBatchWidth; x < (std::min)(width, (bx + 1) * c_signedDistanceRayBatchWidth); x++)
+            {
+                Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye);
+                float tEntry;
+                if (IntersectRayAABB(ray.origin, rcp(ray.direction), box, ray.tMin, ray.tMax, &tEntry))
+                {
+                    batch.Set(batch.count++, ray);
+                }
+            }
+            rayCount += batch.count;
+        }
+    }
+
+    printf("Signed distance primitives: %ux%u pixels, %zu rays through the AABB, batches of %u, best of %u\n",
+        width, height, rayCount, c_signedDistanceRayBatchWidth, iterations);
+    printf("%-22s %-7s %12s %10s %8s %8s %10s\n", "primitive", "kernel", "trace (ms)", "Mrays/s", "speedup", "hits", "mismatch");
+
+    CpuThreadPool pool(numThreads);
+    CpuDispatchRaysDesc desc;
+    desc.width = batchesPerRow;
+    desc.height = height;
+    std::vector<BatchResult> scalarResults(batches.size());
+    std::vector<BatchResult> avx2Results(batches.size());
+
+    for (const SignedDistancePrimitiveDesc& primitive : c_primitives)
+    {
+        if (primitiveName != "all" && primitiveName != primitive.name)
+        {
+            continue;
+        }
+
+        auto Run = [&](SignedDistanceKernel::Enum kernel, std::vector<BatchResult>* results)
+        {
+            double bestMs = 1e30;
+            for (UINT i = 0; i < iterations; i++)
+            {
+                BenchmarkTimer timer;
+                DispatchRaysTiled(desc, [&](UINT x, UINT y, UINT)
+                {
+                    size_t index = static_cast<size_t>(y) * batchesPerRow + x;
+                    BatchResult& result = (*results)[index];
+                    result.hitMask = RaySignedDistancePrimitiveTest8(kernel, batches[index], RAY_FLAG_NONE,
+                        primitive.primitive, primitive.stepScale, &result.hits);
+                }, &pool);
+                bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+            }
+            return bestMs;
+        };
+
+        double scalarMs = Run(SignedDistanceKernel::Scalar, &scalarResults);
+        double avx2Ms = Run(GetDefaultSignedDistanceKernel(), &avx2Results);
+
+        size_t hitCount = 0;
+        size_t mismatches = 0;
+        for (size_t b = 0; b < batches.size(); b++)
+        {
+            const BatchResult& s = scalarResults[b];
+            const BatchResult& v = avx2Results[b];
+            for (UINT lane = 0; lane < batches[b].count; lane++)
+            {
+                bool scalarHit = ((s.hitMask >> lane) & 1) != 0;
+                bool avx2Hit = ((v.hitMask >> lane) & 1) != 0;
+                hitCount += scalarHit ? 1 : 0;
+                bool same = (scalarHit == avx2Hit);
+                if (same && scalarHit)
+                {
+                    same = memcmp(&s.hits.t[lane], &v.hits.t[lane], sizeof(float)) == 0;
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        same = same && memcmp(&s.hits.normal[axis][lane], &v.hits.normal[axis][lane], sizeof(float)) == 0;
+                    }
+                }
+                mismatches += same ? 0 : 1;
+            }
+        }
+
+        printf("%-22s %-7s %12.2f %10.2f %8.2f %8zu %10s\n", primitive.name, "scalar", scalarMs, rayCount / (scalarMs * 1000.0),
+            1.0, hitCount, "");
+        printf("%-22s %-7s %12.2f %10.2f %8.2f %8zu %10zu\n", primitive.name, "avx2", avx2Ms, rayCount / (avx2Ms * 1000.0),
+            scalarMs / avx2Ms, hitCount, mismatches);
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("sdf", "Scalar vs 8-wide AVX2 sphere tracing of the signed distance primitives", SignedDistanceBenchmark);
@@ -0,0 +1,173 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Signed distance grid benchmark: bakes a narrow band brick grid for each signed distance primitive and
+// sphere traces the same pinhole camera rays through the analytic distance function and through the grid.
+// Reports the bake cost, the grid size, both trace times and the grid's error: rays whose hit differs,
+// the distance error in voxels and the normal error in degrees. "mode" suggests the grid for a primitive
+// when it is faster and at most -tolerance percent of the rays change their hit.
+//
+// Options: -width <n> (512) -height <n> (512) -threads <n> (0 = hardware threads) -iterations <n> (3)
+//          -bricks <n> bricks per axis (16) -band <voxels> (2) -tolerance <percent> (0.5) -primitive <name> (all)
+
+#include "Benchmark.h"
+#include "CpuReferenceRenderer.h"
+#include "SignedDistanceGrid.h"
+#include <cmath>
+#include <cstdio>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct SignedDistanceGridPrimitiveDesc
+    {
+        const char* name;
+        CpuSignedDistancePrimitive::Enum primitive;
+        float stepScale;            // As set up by the sample's UpdateAABBPrimitiveAttributes().
+    };
+
+    const SignedDistanceGridPrimitiveDesc c_primitives[] =
+    {
+        { "MiniSpheres", CpuSignedDistancePrimitive::MiniSpheres, 1.0f },
+        { "IntersectedRoundCube", CpuSignedDistancePrimitive::IntersectedRoundCube, 1.0f },
+        { "SquareTorus", CpuSignedDistancePrimitive::SquareTorus, 1.0f },
+        { "TwistedTorus", CpuSignedDistancePrimitive::TwistedTorus, 0.5f },
+        { "Cog", CpuSignedDistancePrimitive::Cog, 1.0f },
+        { "Cylinder", CpuSignedDistancePrimitive::Cylinder, 1.0f },
+        { "FractalPyramid", CpuSignedDistancePrimitive::FractalPyramid, 0.8f },
+    };
+
+    struct GridHit
+    {
+        bool hit;
+        float t;
+        float3 normal;
+    };
+}
+
+static int SignedDistanceGridBenchmark(const BenchmarkArgs& args)
+{
+    UINT width = args.GetUInt("width", 512);
+    UINT height = args.GetUInt("height", 512);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+    UINT bricksPerAxis = (std::max)(1u, args.GetUInt("bricks", 16));
+    float band = args.GetFloat("band", 2.0f);
+    float tolerance = args.GetFloat("tolerance", 0.5f);
+    std::string primitiveName = args.GetString("primitive", "all");
+
+    // Same view of the AABB as the "sdf" benchmark; rays that miss the AABB never reach the intersection shader.
+    const float3 eye(1.8f, 1.6f, -3.2f);
+    float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+    const AABB box(float3(-1.0f), float3(1.0f));
+
+    std::vector<Ray> rays;
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++)
+        {
+            Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye);
+            float tEntry;
+            if (IntersectRayAABB(ray.origin, rcp(ray.direction), box, ray.tMin, ray.tMax, &tEntry))
+            {
+                rays.push_back(ray);
+            }
+        }
+    }
+
+    const UINT voxelsPerAxis = bricksPerAxis * c_signedDistanceGridBrickSize;
+    printf("Signed distance grids: %u^3 voxels in %u^3 bricks, band %.1f voxels, %zu rays through the AABB, best of %u\n",
+        voxelsPerAxis, bricksPerAxis, (std::max)(band, 2.0f), rays.size(), iterations);
+    printf("%-22s %9s %8s %9s %13s %13s %8s %9s %10s %10s %10s %8s\n", "primitive", "bake (ms)", "bricks", "size (MB)",
+        "analytic (ms)", "grid (ms)", "speedup", "hit diff", "t mean", "t max", "normal max", "mode");
+
+    CpuThreadPool pool(numThreads);
+    CpuDispatchRaysDesc desc;
+    desc.width = static_cast<UINT>(rays.size());
+    desc.height = 1;
+    desc.tileWidth = 256;
+    desc.tileHeight = 1;
+    std::vector<GridHit> analyticHits(rays.size());
+    std::vector<GridHit> gridHits(rays.size());
+
+    for (const SignedDistanceGridPrimitiveDesc& primitive : c_primitives)
+    {
+        if (primitiveName != "all" && primitiveName != primitive.name)
+        {
+            continue;
+        }
+
+        CpuSignedDistanceGrid grid;
+        BenchmarkTimer bakeTimer;
+        grid.Bake(primitive.primitive, bricksPerAxis, band, &pool);
+        double bakeMs = bakeTimer.GetElapsedMs();
+
+        auto Run = [&](const CpuDispatchRaygenFunc& raygen)
+        {
+            double bestMs = 1e30;
+            for (UINT i = 0; i < iterations; i++)
+            {
+                BenchmarkTimer timer;
+                DispatchRaysTiled(desc, raygen, &pool);
+                bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+            }
+            return bestMs;
+        };
+
+        double analyticMs = Run([&](UINT x, UINT, UINT)
+        {
+            GridHit& hit = analyticHits[x];
+            hit.hit = RaySignedDistancePrimitiveTest(rays[x], RAY_FLAG_NONE, primitive.primitive, &hit.t, &hit.normal, primitive.stepScale);
+        });
+        double gridMs = Run([&](UINT x, UINT, UINT)
+        {
+            GridHit& hit = gridHits[x];
+            hit.hit = grid.RayTest(rays[x], RAY_FLAG_NONE, &hit.t, &hit.normal, primitive.stepScale);
+        });
+
+        size_t hitDifferences = 0;
+        size_t bothHit = 0;
+        double tErrorSum = 0.0;
+        double tErrorMax = 0.0;
+        double normalErrorMax = 0.0;
+        for (size_t i = 0; i < rays.size(); i++)
+        {
+            const GridHit& a = analyticHits[i];
+            const GridHit& g = gridHits[i];
+            if (a.hit != g.hit)
+            {
+                hitDifferences++;
+            }
+            else if (a.hit)
+            {
+                double tError = std::abs(a.t - g.t) / grid.GetDesc().voxelSize;
+                double cosAngle = (std::min)(1.0f, (std::max)(-1.0f, dot(a.normal, g.normal)));
+                tErrorSum += tError;
+                tErrorMax = (std::max)(tErrorMax, tError);
+                normalErrorMax = (std::max)(normalErrorMax, std::acos(cosAngle) * 180.0 / 3.14159265358979);
+                bothHit++;
+            }
+        }
+
+        double hitDifferencePercent = rays.empty() ? 0.0 : 100.0 * hitDifferences / rays.size();
+        bool useGrid = gridMs < analyticMs && hitDifferencePercent <= tolerance;
+        printf("%-22s %9.1f %8u %9.2f %13.2f %13.2f %8.2f %8.2f%% %10.3f %10.3f %10.2f %8s\n", primitive.name, bakeMs,
+            grid.GetStoredBrickCount(), grid.GetSizeInBytes() / (1024.0 * 1024.0), analyticMs, gridMs, analyticMs / gridMs,
+            hitDifferencePercent, bothHit ? tErrorSum / bothHit : 0.0, tErrorMax, normalErrorMax, useGrid ? "grid" : "analytic");
+    }
+    printf("t errors are in voxels, normal errors in degrees.\n");
+    return 0;
+}
+
+REGISTER_BENCHMARK("sdfgrid", "Analytic vs baked narrow band grid sphere tracing of the signed distance primitives", SignedDistanceGridBenchmark);
@@ -0,0 +1,174 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Sphere tracing step benchmark: traces the same pinhole camera rays through each signed distance primitive
+// with the sample's sphere tracer ("baseline"), the AABB-clipped tracer without relaxation ("clipped") and
+// with over-relaxation ("relaxed"). Reports the average number of distance evaluations per ray, the
+// reduction against the baseline, the trace time, the rays whose hit differs from the baseline and the
+// step histogram: the column "<2^b" counts rays with [2^(b-1), 2^b) steps and "max" rays that used all steps.
+//
+// Options: -width <n> (512) -height <n> (512) -threads <n> (0 = hardware threads) -iterations <n> (3)
+//          -relaxation <omega> (1.6) -primitive <name> (all)
+
+#include "Benchmark.h"
+#include "CpuReferenceRenderer.h"
+#include "SignedDistancePrimitives.h"
+#include <cstdio>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct SignedDistanceStepsPrimitiveDesc
+    {
+        const char* name;
+        CpuSignedDistancePrimitive::Enum primitive;
+        float stepScale;            // As set up by the sample's UpdateAABBPrimitiveAttributes().
+    };
+
+    const SignedDistanceStepsPrimitiveDesc c_primitives[] =
+    {
+        { "MiniSpheres", CpuSignedDistancePrimitive::MiniSpheres, 1.0f },
+        { "IntersectedRoundCube", CpuSignedDistancePrimitive::IntersectedRoundCube, 1.0f },
+        { "SquareTorus", CpuSignedDistancePrimitive::SquareTorus, 1.0f },
+        { "TwistedTorus", CpuSignedDistancePrimitive::TwistedTorus, 0.5f },
+        { "Cog", CpuSignedDistancePrimitive::Cog, 1.0f },
+        { "Cylinder", CpuSignedDistancePrimitive::Cylinder, 1.0f },
+        { "FractalPyramid", CpuSignedDistancePrimitive::FractalPyramid, 0.8f },
+    };
+
+    struct StepHit
+    {
+        bool hit;
+        float t;
+        UINT steps;
+    };
+}
+
+static int SignedDistanceStepsBenchmark(const BenchmarkArgs& args)
+{
+    UINT width = args.GetUInt("width", 512);
+    UINT height = args.GetUInt("height", 512);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 3));
+    float relaxation = args.GetFloat("relaxation", c_sphereTracingRelaxation);
+    std::string primitiveName = args.GetString("primitive", "all");
+
+    // Same view of the AABB as the "sdf" benchmark; rays that miss the AABB never reach the intersection shader.
+    const float3 eye(1.8f, 1.6f, -3.2f);
+    float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+    const AABB box(float3(-1.0f), float3(1.0f));
+
+    std::vector<Ray> rays;
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++)
+        {
+            Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye);
+            float tEntry;
+            if (IntersectRayAABB(ray.origin, rcp(ray.direction), box, ray.tMin, ray.tMax, &tEntry))
+            {
+                rays.push_back(ray);
+            }
+        }
+    }
+
+    printf("Signed distance sphere tracing steps: %zu rays through the AABB, relaxation %.2f, best of %u\n",
+        rays.size(), relaxation, iterations);
+    printf("%-22s %-9s %9s %9s %9s %9s", "primitive", "tracer", "steps", "reduction", "ms", "hit diff");
+    for (UINT b = 0; b < c_signedDistanceStepHistogramBins; b++)
+    {
+        char label[16];
+        if (b == 0)
+        {
+            snprintf(label, sizeof(label), "0");
+        }
+        else if (b + 1 == c_signedDistanceStepHistogramBins)
+        {
+            snprintf(label, sizeof(label), ">=%u", 1u << (b - 1));
+        }
+        else
+        {
+            snprintf(label, sizeof(label), "<%u", 1u << b);
+        }
+        printf(" %7s", label);
+    }
+    printf("\n");
+
+    CpuThreadPool pool(numThreads);
+    CpuDispatchRaysDesc desc;
+    desc.width = static_cast<UINT>(rays.size());
+    desc.height = 1;
+    desc.tileWidth = 256;
+    desc.tileHeight = 1;
+    std::vector<StepHit> baselineHits(rays.size());
+    std::vector<StepHit> hits(rays.size());
+
+    for (const SignedDistanceStepsPrimitiveDesc& primitive : c_primitives)
+    {
+        if (primitiveName != "all" && primitiveName != primitive.name)
+        {
+            continue;
+        }
+
+        double baselineSteps = 0.0;
+        for (int tracer = 0; tracer < 3; tracer++)
+        {
+            static const char* const c_tracerNames[] = { "baseline", "clipped", "relaxed" };
+            std::vector<StepHit>& tracerHits = tracer == 0 ? baselineHits : hits;
+            float omega = tracer == 2 ? relaxation : 1.0f;
+
+            double bestMs = 1e30;
+            for (UINT i = 0; i < iterations; i++)
+            {
+                BenchmarkTimer timer;
+                DispatchRaysTiled(desc, [&](UINT x, UINT, UINT)
+                {
+                    StepHit& hit = tracerHits[x];
+                    float3 normal;
+                    hit.hit = tracer == 0
+                        ? RaySignedDistancePrimitiveTest(rays[x], RAY_FLAG_NONE, primitive.primitive, &hit.t, &normal,
+                            primitive.stepScale, &hit.steps)
+                        : RaySignedDistancePrimitiveTestRelaxed(rays[x], RAY_FLAG_NONE, primitive.primitive, &hit.t, &normal,
+                            primitive.stepScale, omega, &hit.steps);
+                }, &pool);
+                bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+            }
+
+            SignedDistanceStepHistogram histogram = {};
+            size_t hitDifferences = 0;
+            for (size_t i = 0; i < rays.size(); i++)
+            {
+                histogram.Add(tracerHits[i].steps);
+                hitDifferences += tracerHits[i].hit != baselineHits[i].hit;
+            }
+
+            double averageSteps = histogram.GetAverageSteps();
+            if (tracer == 0)
+            {
+                baselineSteps = averageSteps;
+            }
+            double reduction = baselineSteps > 0.0 ? 100.0 * (1.0 - averageSteps / baselineSteps) : 0.0;
+            printf("%-22s %-9s %9.2f %8.1f%% %9.2f %8.2f%%", tracer == 0 ? primitive.name : "", c_tracerNames[tracer],
+                averageSteps, reduction, bestMs, rays.empty() ? 0.0 : 100.0 * hitDifferences / rays.size());
+            for (UINT b = 0; b < c_signedDistanceStepHistogramBins; b++)
+            {
+                printf(" %7llu", static_cast<unsigned long long>(histogram.bins[b]));
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("sdfsteps", "Sphere tracing step counts of the baseline, AABB-clipped and over-relaxed signed distance tracers", SignedDistanceStepsBenchmark);
@@ -0,0 +1,219 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Specialized intersection benchmark: traces the same pinhole camera rays through each procedural primitive with
+// the tests switching on the primitive type as the shaders do ("runtime": at every sphere tracing step for
+// signed distance primitives) and with the per-type specializations of ProceduralPrimitivesLibrary.h, dispatched
+// once per ray ("specialized"). The "Mixed" row assigns the signed distance primitives to the rays in turn, as
+// neighbouring rays hitting different AABBs would. Reports both trace times, the speedup, the distance
+// evaluations per ray and the rays whose hit, distance or normal is not bit identical.
+//
+// Options: -width <n> (512) -height <n> (512) -threads <n> (0 = hardware threads) -iterations <n> (5)
+//          -time <seconds> (3) for the metaballs -primitive <name> (all)
+
+#include "Benchmark.h"
+#include "CpuReferenceRenderer.h"
+#include "ProceduralPrimitivesLibrary.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace CpuRT;
+
+namespace
+{
+    namespace SpecializedPrimitiveClass
+    {
+        enum Enum
+        {
+            Analytic = 0,
+            Volumetric,
+            SignedDistance,
+            Mixed,      // Signed distance primitives in turn.
+        };
+    }
+
+    struct SpecializedPrimitiveDesc
+    {
+        const char* name;
+        SpecializedPrimitiveClass::Enum primitiveClass;
+        UINT primitive;
+    };
+
+    const SpecializedPrimitiveDesc c_primitives[] =
+    {
+        { "AABB", SpecializedPrimitiveClass::Analytic, CpuAnalyticPrimitive::AABB },
+        { "Spheres", SpecializedPrimitiveClass::Analytic, CpuAnalyticPrimitive::Spheres },
+        { "Metaballs", SpecializedPrimitiveClass::Volumetric, CpuVolumetricPrimitive::Metaballs },
+        { "MiniSpheres", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::MiniSpheres },
+        { "IntersectedRoundCube", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::IntersectedRoundCube },
+        { "SquareTorus", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::SquareTorus },
+        { "TwistedTorus", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::TwistedTorus },
+        { "Cog", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::Cog },
+        { "Cylinder", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::Cylinder },
+        { "FractalPyramid", SpecializedPrimitiveClass::SignedDistance, CpuSignedDistancePrimitive::FractalPyramid },
+        { "Mixed", SpecializedPrimitiveClass::Mixed, 0 },
+    };
+
+    // Step scales as set up by the sample's UpdateAABBPrimitiveAttributes().
+    float GetStepScale(CpuSignedDistancePrimitive::Enum primitive)
+    {
+        switch (primitive)
+        {
+        case CpuSignedDistancePrimitive::TwistedTorus: return 0.5f;
+        case CpuSignedDistancePrimitive::FractalPyramid: return 0.8f;
+        default: return 1.0f;
+        }
+    }
+
+    struct SpecializedHit
+    {
+        bool hit;
+        float t;
+        float3 normal;
+        UINT steps;
+    };
+}
+
+static int SpecializedIntersectionBenchmark(const BenchmarkArgs& args)
+{
+    UINT width = args.GetUInt("width", 512);
+    UINT height = args.GetUInt("height", 512);
+    UINT numThreads = args.GetUInt("threads", 0);
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 5));
+    float elapsedTime = args.GetFloat("time", 3.0f);
+    std::string primitiveName = args.GetString("primitive", "all");
+
+    // The sample's view of the AABB; rays that miss it never reach the intersection shader.
+    const float3 eye(1.8f, 1.6f, -3.2f);
+    float4x4 view = float4x4::LookAtLH(eye, float3(0.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f));
+    float4x4 proj = float4x4::PerspectiveFovLH(0.8f, static_cast<float>(width) / height, 1.0f, 125.0f);
+    float4x4 projectionToWorld = (view * proj).Inverse();
+    const AABB box(float3(-1.0f), float3(1.0f));
+
+    std::vector<Ray> rays;
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++)
+        {
+            Ray ray = GeneratePinholeRay(x, y, width, height, projectionToWorld, eye);
+            float tEntry;
+            if (IntersectRayAABB(ray.origin, rcp(ray.direction), box, ray.tMin, ray.tMax, &tEntry))
+            {
+                rays.push_back(ray);
+            }
+        }
+    }
+
+    Metaball metaballs[3];
+    InitializeAnimatedMetaballs(metaballs, 3, elapsedTime, 12.0f);
+
+    printf("Specialized intersection tests: %zu rays through the AABB, best of %u\n", rays.size(), iterations);
+    printf("%-22s %12s %16s %8s %10s %9s\n", "primitive", "runtime (ms)", "specialized (ms)", "speedup", "steps/ray", "hit diff");
+
+    CpuThreadPool pool(numThreads);
+    CpuDispatchRaysDesc desc;
+    desc.width = static_cast<UINT>(rays.size());
+    desc.height = 1;
+    desc.tileWidth = 256;
+    desc.tileHeight = 1;
+    std::vector<SpecializedHit> runtimeHits(rays.size());
+    std::vector<SpecializedHit> specializedHits(rays.size());
+
+    for (const SpecializedPrimitiveDesc& primitive : c_primitives)
+    {
+        if (primitiveName != "all" && primitiveName != primitive.name)
+        {
+            continue;
+        }
+
+        auto Run = [&](bool specialized, std::vector<SpecializedHit>& hits)
+        {
+            double bestMs = 1e30;
+            for (UINT i = 0; i < iterations; i++)
+            {
+                BenchmarkTimer timer;
+                DispatchRaysTiled(desc, [&](UINT x, UINT, UINT)
+                {
+                    SpecializedHit& hit = hits[x];
+                    hit.normal = float3(0.0f);
+                    hit.steps = 0;
+                    switch (primitive.primitiveClass)
+                    {
+                    case SpecializedPrimitiveClass::Analytic:
+                    {
+                        // The analytic tests don't loop over the type; the specialization only skips one switch.
+                        auto analyticPrimitive = static_cast<CpuAnalyticPrimitive::Enum>(primitive.primitive);
+                        hit.hit = specialized
+                            ? (analyticPrimitive == CpuAnalyticPrimitive::AABB
+                                ? RayAnalyticGeometryIntersectionTest<CpuAnalyticPrimitive::AABB>(rays[x], RAY_FLAG_NONE, &hit.t, &hit.normal)
+                                : RayAnalyticGeometryIntersectionTest<CpuAnalyticPrimitive::Spheres>(rays[x], RAY_FLAG_NONE, &hit.t, &hit.normal))
+                            : RayAnalyticGeometryIntersectionTest(rays[x], RAY_FLAG_NONE, analyticPrimitive, &hit.t, &hit.normal);
+                        break;
+                    }
+                    case SpecializedPrimitiveClass::Volumetric:
+                    {
+                        // The tests reorder the metaballs they are given, as the shaders do with their local copy.
+                        Metaball localBlobs[3] = { metaballs[0], metaballs[1], metaballs[2] };
+                        hit.hit = specialized
+                            ? RayVolumetricGeometryIntersectionTest<CpuVolumetricPrimitive::Metaballs>(rays[x], RAY_FLAG_NONE, localBlobs, 3, &hit.t, &hit.normal)
+                            : RayVolumetricGeometryIntersectionTest(rays[x], RAY_FLAG_NONE,
+                                static_cast<CpuVolumetricPrimitive::Enum>(primitive.primitive), localBlobs, 3, &hit.t, &hit.normal);
+                        break;
+                    }
+                    default:
+                    {
+                        auto sdPrimitive = static_cast<CpuSignedDistancePrimitive::Enum>(primitive.primitiveClass == SpecializedPrimitiveClass::Mixed
+                            ? x % CpuSignedDistancePrimitive::Count
+                            : primitive.primitive);
+                        float stepScale = GetStepScale(sdPrimitive);
+                        hit.hit = specialized
+                            ? RaySignedDistanceGeometryIntersectionTest(rays[x], RAY_FLAG_NONE, sdPrimitive, &hit.t, &hit.normal, stepScale, &hit.steps)
+                            : RaySignedDistancePrimitiveTest(rays[x], RAY_FLAG_NONE, sdPrimitive, &hit.t, &hit.normal, stepScale, &hit.steps);
+                        break;
+                    }
+                    }
+                }, &pool);
+                bestMs = (std::min)(bestMs, timer.GetElapsedMs());
+            }
+            return bestMs;
+        };
+        double runtimeMs = Run(false, runtimeHits);
+        double specializedMs = Run(true, specializedHits);
+
+        UINT64 steps = 0;
+        size_t hitDifferences = 0;
+        for (size_t i = 0; i < rays.size(); i++)
+        {
+            const SpecializedHit& a = runtimeHits[i];
+            const SpecializedHit& b = specializedHits[i];
+            steps += b.steps;
+            bool identical = a.hit == b.hit && a.steps == b.steps
+                && (!a.hit || (std::memcmp(&a.t, &b.t, sizeof(float)) == 0 && std::memcmp(&a.normal, &b.normal, sizeof(float3)) == 0));
+            hitDifferences += !identical;
+        }
+
+        double rayCount = (std::max)(static_cast<double>(rays.size()), 1.0);
+        char stepText[16];
+        if (primitive.primitiveClass == SpecializedPrimitiveClass::SignedDistance || primitive.primitiveClass == SpecializedPrimitiveClass::Mixed)
+        {
+            snprintf(stepText, sizeof(stepText), "%.2f", steps / rayCount);
+        }
+        else
+        {
+            snprintf(stepText, sizeof(stepText), "-");
+        }
+        printf("%-22s %12.2f %16.2f %7.2fx %10s %8.2f%%\n", primitive.name, runtimeMs, specializedMs, runtimeMs / specializedMs,
+            stepText, 100.0 * hitDifferences / rayCount);
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("specialized", "Procedural intersection tests switching on the primitive type per step vs specialized per type", SpecializedIntersectionBenchmark);
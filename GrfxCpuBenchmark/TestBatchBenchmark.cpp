@@ -0,0 +1,212 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Test batch benchmark: runs a generated suite (GenerateTestCasesXml()) through TestBatchRunner on a fake backend
+// that spins for the given device, pipeline, load and render times, so the scheduling can be exercised without a
+// GPU. Compares one device and pipeline per test case, as one process per test case pays, with one per batch.
+// Every -fail'th test case throws while loading and every -lose'th loses the device while rendering; the
+// results of both modes must agree and every loaded test case must be released.
+//
+// Options: -cases <n> (100) -device <ms> (20) -pipeline <ms> (10) -load <ms> (0.2) -render <ms> (0.5)
+//          -fail <n> (0 = never) -lose <n> (0 = never) -maxlosses <n> (3)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "TestBatch.h"
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    void Spin(double milliseconds)
+    {
+        BenchmarkTimer timer;
+        while (timer.GetElapsedMs() < milliseconds)
+        {
+        }
+    }
+
+    class FakeBatchBackend : public TestBatchBackend
+    {
+    public:
+        struct Settings
+        {
+            double deviceMs;
+            double pipelineMs;
+            double loadMs;
+            double renderMs;
+            UINT failEvery;
+            UINT loseEvery;
+        };
+
+        explicit FakeBatchBackend(const Settings& settings) :
+            m_settings(settings), m_loadCount(0), m_liveTestCases(0), m_hasDevice(false), m_hasPipeline(false), m_deviceLost(false), m_hash(0) {}
+
+        void CreateDevice() override
+        {
+            Spin(m_settings.deviceMs);
+            m_hasDevice = true;
+            m_deviceLost = false;
+        }
+
+        void CreatePipeline() override
+        {
+            Check(m_hasDevice && !m_hasPipeline, "pipeline created without a device");
+            Spin(m_settings.pipelineMs);
+            m_hasPipeline = true;
+        }
+
+        // The test case number is taken from its name, so failures land on the same test cases in both modes.
+        void LoadTestCase(const TestCaseDescs& descs) override
+        {
+            Check(m_hasPipeline && m_liveTestCases == 0, "test case loaded without a pipeline or over another one");
+            m_loadCount++;
+            m_liveTestCases++;
+            m_testCaseNumber = static_cast<UINT>(strtoul(descs.name.c_str() + descs.name.find_last_of(' ') + 1, nullptr, 10)) + 1;
+            Spin(m_settings.loadMs);
+            if (m_settings.failEvery && m_testCaseNumber % m_settings.failEvery == 0)
+            {
+                throw std::runtime_error("simulated load failure");
+            }
+
+            // FNV-1a over the descs stands in for the image hash.
+            m_hash = 14695981039346656037ull;
+            auto HashBytes = [&](const void* data, size_t size)
+            {
+                for (size_t i = 0; i < size; i++)
+                {
+                    m_hash = (m_hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+                }
+            };
+            HashBytes(descs.geomDescs.data(), descs.geomDescs.size() * sizeof(GeomDesc));
+            HashBytes(descs.tlasDescs.data(), descs.tlasDescs.size() * sizeof(DxTlasDesc));
+            for (const DxBlasDesc& blasDesc : descs.blasDescs)
+            {
+                HashBytes(blasDesc.geomIndices.data(), blasDesc.geomIndices.size() * sizeof(int));
+            }
+        }
+
+        UINT64 Render() override
+        {
+            Spin(m_settings.renderMs);
+            if (m_settings.loseEvery && m_testCaseNumber % m_settings.loseEvery == 0)
+            {
+                m_deviceLost = true;
+                throw std::runtime_error("simulated device removal");
+            }
+            return m_hash;
+        }
+
+        void ReleaseTestCase() override { m_liveTestCases--; }
+        bool IsDeviceLost() const override { return m_deviceLost; }
+
+        void DestroyDevice() override
+        {
+            Check(m_liveTestCases == 0, "device destroyed with a test case loaded");
+            m_hasDevice = false;
+            m_hasPipeline = false;
+        }
+
+        int GetLiveTestCases() const { return m_liveTestCases; }
+
+    private:
+        static void Check(bool condition, const char* message)
+        {
+            if (!condition)
+            {
+                throw std::logic_error(message);
+            }
+        }
+
+        Settings m_settings;
+        UINT m_loadCount;
+        UINT m_testCaseNumber;
+        int m_liveTestCases;
+        bool m_hasDevice;
+        bool m_hasPipeline;
+        bool m_deviceLost;
+        UINT64 m_hash;
+    };
+}
+
+static int TestBatchBenchmark(const BenchmarkArgs& args)
+{
+    UINT numCases = (std::max)(1u, args.GetUInt("cases", 100));
+    FakeBatchBackend::Settings settings;
+    settings.deviceMs = args.GetFloat("device", 20.0f);
+    settings.pipelineMs = args.GetFloat("pipeline", 10.0f);
+    settings.loadMs = args.GetFloat("load", 0.2f);
+    settings.renderMs = args.GetFloat("render", 0.5f);
+    settings.failEvery = args.GetUInt("fail", 0);
+    settings.loseEvery = args.GetUInt("lose", 0);
+    UINT maxLosses = args.GetUInt("maxlosses", 3);
+
+    std::vector<TestCaseDescs> testCases = ParseTestCasesXml(GenerateTestCasesXml(numCases), "generated");
+
+    printf("Test batches: %u test cases, fake backend with device %.1f ms, pipeline %.1f ms, load %.2f ms, render %.2f ms\n",
+        numCases, settings.deviceMs, settings.pipelineMs, settings.loadMs, settings.renderMs);
+    printf("%-12s %10s %10s %9s %9s %9s %8s %8s %8s\n", "mode", "total (ms)", "per case", "devices", "pipelines",
+        "failures", "skipped", "losses", "leaked");
+
+    std::vector<TestBatchResult> results[2];
+    for (int batched = 0; batched < 2; batched++)
+    {
+        FakeBatchBackend backend(settings);
+        TestBatchStatistics statistics = {};
+        auto Accumulate = [&](const TestBatchStatistics& s)
+        {
+            statistics.testCases += s.testCases;
+            statistics.failures += s.failures;
+            statistics.skipped += s.skipped;
+            statistics.deviceCreations += s.deviceCreations;
+            statistics.pipelineCreations += s.pipelineCreations;
+            statistics.deviceLosses += s.deviceLosses;
+        };
+        auto OnResult = [&](const TestBatchResult& result) { results[batched].push_back(result); };
+
+        BenchmarkTimer timer;
+        if (batched)
+        {
+            TestBatchRunner runner(&backend, maxLosses);
+            Accumulate(runner.Run(testCases, OnResult));
+        }
+        else
+        {
+            // A runner per test case releases its device when it goes away, as a process exiting does.
+            for (const TestCaseDescs& testCase : testCases)
+            {
+                TestBatchRunner runner(&backend, maxLosses);
+                Accumulate(runner.Run(1, [&](UINT, TestCaseDescs* descs) { *descs = testCase; }, OnResult));
+            }
+        }
+        double totalMs = timer.GetElapsedMs();
+
+        printf("%-12s %10.1f %10.3f %9u %9u %9u %8u %8u %8d\n", batched ? "batch" : "per case", totalMs, totalMs / numCases,
+            statistics.deviceCreations, statistics.pipelineCreations, statistics.failures, statistics.skipped,
+            statistics.deviceLosses, backend.GetLiveTestCases());
+    }
+
+    // Skipped test cases aside, both modes must pass and fail the same test cases with the same hashes.
+    UINT mismatches = 0;
+    for (UINT i = 0; i < numCases; i++)
+    {
+        const TestBatchResult& single = results[0][i];
+        const TestBatchResult& batch = results[1][i];
+        if (!batch.skipped && (single.passed != batch.passed || single.imageHash != batch.imageHash || single.name != batch.name))
+        {
+            mismatches++;
+        }
+    }
+    printf("Results differing between modes: %u\n", mismatches);
+    return mismatches ? 1 : 0;
+}
+
+REGISTER_BENCHMARK("batch", "Test case batches reusing one device and pipeline, on a fake backend", TestBatchBenchmark);
@@ -0,0 +1,67 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Test case XML benchmark: generates testcases.xml suites with the layout of the HelloWorld sample's file (four
+// geometries, BLASes and instances per test case, references by name) and times ParseTestCasesXml() on them.
+// Reports the suite size, the parse time and the throughput in MB and test cases per second.
+//
+// Options: -cases <list> (1000,10000,100000) -iterations <n> (5)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "TestCaseXml.h"
+#include <cstdio>
+#include <stdexcept>
+
+static int TestCaseXmlBenchmark(const BenchmarkArgs& args)
+{
+    std::vector<UINT> counts = args.GetUIntList("cases", { 1000, 10000, 100000 });
+    for (UINT& count : counts)
+    {
+        count = (std::max)(1u, count);
+    }
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 5));
+
+    printf("Test case XML parsing: 4 geometries, BLASes and instances per test case, best of %u\n", iterations);
+    printf("%-10s %10s %11s %9s %12s\n", "cases", "size (MB)", "parse (ms)", "MB/s", "cases/s");
+
+    for (UINT count : counts)
+    {
+        std::string text = GenerateTestCasesXml(count);
+
+        double parseMs = 1e30;
+        size_t parsedCount = 0;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            BenchmarkTimer timer;
+            std::vector<TestCaseDescs> testCases = ParseTestCasesXml(text, "generated");
+            parseMs = (std::min)(parseMs, timer.GetElapsedMs());
+            parsedCount = testCases.size();
+
+            // The last instance of every test case refers to the first BLAS and so the first geometry.
+            if (testCases.back().tlasDescs.back().blasIndex != 0 || testCases.back().blasDescs[0].geomIndices[0] != 0)
+            {
+                throw std::runtime_error("Generated test cases resolved to the wrong descs.");
+            }
+        }
+        if (parsedCount != count)
+        {
+            throw std::runtime_error("Parsed " + std::to_string(parsedCount) + " test cases, expected " + std::to_string(count) + ".");
+        }
+
+        double megabytes = text.size() / (1024.0 * 1024.0);
+        printf("%-10u %10.2f %11.3f %9.1f %12.0f\n", count, megabytes, parseMs, megabytes / (parseMs * 0.001),
+            count / (parseMs * 0.001));
+    }
+    return 0;
+}
+
+REGISTER_BENCHMARK("testcasexml", "testcases.xml parsing throughput on generated suites", TestCaseXmlBenchmark);
@@ -0,0 +1,128 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Test suite startup benchmark: writes a generated suite (GenerateTestCasesXml()) as testcases.xml and as a
+// compiled binary suite, then times what a runner pays at startup to get at its test cases: reading and parsing
+// the XML, or mapping and validating the binary suite. Also times copying every test case out of the binary
+// suite into TestCaseDescs, as the runner does one test case at a time, and checks the copies match the XML.
+//
+// Options: -cases <list> (100000) -iterations <n> (5) -directory <dir> for the suite files (.)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "TestSuiteBinary.h"
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    bool DescsEqual(const TestCaseDescs& a, const TestCaseDescs& b)
+    {
+        if (a.name != b.name || a.models != b.models || a.geomDescs.size() != b.geomDescs.size()
+            || a.blasDescs.size() != b.blasDescs.size() || a.tlasDescs.size() != b.tlasDescs.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.blasDescs.size(); i++)
+        {
+            if (a.blasDescs[i].geomIndices != b.blasDescs[i].geomIndices || a.blasDescs[i].geomType != b.blasDescs[i].geomType)
+            {
+                return false;
+            }
+        }
+        return (a.geomDescs.empty() || memcmp(a.geomDescs.data(), b.geomDescs.data(), a.geomDescs.size() * sizeof(GeomDesc)) == 0)
+            && (a.tlasDescs.empty() || memcmp(a.tlasDescs.data(), b.tlasDescs.data(), a.tlasDescs.size() * sizeof(DxTlasDesc)) == 0);
+    }
+
+    void WriteFile(const std::string& path, const std::string& text)
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        bool written = file && fwrite(text.data(), 1, text.size(), file) == text.size();
+        if (file && fclose(file) != 0)
+        {
+            written = false;
+        }
+        if (!written)
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+}
+
+static int TestSuiteBenchmark(const BenchmarkArgs& args)
+{
+    std::vector<UINT> counts = args.GetUIntList("cases", { 100000 });
+    UINT iterations = (std::max)(1u, args.GetUInt("iterations", 5));
+    std::string directory = args.GetString("directory", ".");
+    std::string xmlPath = directory + "/testsuite_benchmark.xml";
+    std::string binaryPath = directory + "/testsuite_benchmark.bin";
+
+    printf("Test suite startup: XML vs binary suites, best of %u\n", iterations);
+    printf("%-10s %9s %9s %11s %12s %11s %12s %9s %9s\n", "cases", "XML (MB)", "bin (MB)", "compile (ms)", "XML load (ms)",
+        "open (ms)", "copy all (ms)", "speedup", "mismatch");
+
+    for (UINT count : counts)
+    {
+        std::string text = GenerateTestCasesXml((std::max)(1u, count));
+        WriteFile(xmlPath, text);
+        std::vector<TestCaseDescs> reference = ParseTestCasesXml(text, xmlPath.c_str());
+
+        BenchmarkTimer timer;
+        SaveTestSuite(reference, binaryPath.c_str());
+        double compileMs = timer.GetElapsedMs();
+
+        double xmlMs = 1e30;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            timer.Reset();
+            std::vector<TestCaseDescs> testCases = LoadTestCasesXml(xmlPath.c_str());
+            xmlMs = (std::min)(xmlMs, timer.GetElapsedMs());
+        }
+
+        // Opening maps the file and validates every range and index; the first test case is read to count its
+        // page faults in.
+        double openMs = 1e30;
+        double copyMs = 1e30;
+        bool mismatch = false;
+        for (UINT i = 0; i < iterations; i++)
+        {
+            timer.Reset();
+            TestSuiteView suite;
+            suite.Open(binaryPath.c_str());
+            volatile UINT firstTlasCount = suite.GetTestCase(0).numTlasDescs;
+            (void)firstTlasCount;
+            openMs = (std::min)(openMs, timer.GetElapsedMs());
+
+            timer.Reset();
+            TestCaseDescs descs;
+            for (UINT testCase = 0; testCase < suite.GetTestCaseCount(); testCase++)
+            {
+                suite.GetTestCase(testCase).ToDescs(&descs);
+                mismatch |= (i == 0) && !DescsEqual(descs, reference[testCase]);
+            }
+            copyMs = (std::min)(copyMs, timer.GetElapsedMs());
+            mismatch |= suite.GetTestCaseCount() != reference.size();
+        }
+        MappedFile file;
+        file.Open(binaryPath.c_str());
+        size_t binarySize = file.GetSize();
+        file.Close();
+
+        printf("%-10zu %9.2f %9.2f %11.2f %12.2f %11.3f %12.2f %8.0fx %9s\n", reference.size(), text.size() / (1024.0 * 1024.0),
+            binarySize / (1024.0 * 1024.0), compileMs, xmlMs, openMs, copyMs, xmlMs / openMs, mismatch ? "yes" : "no");
+    }
+    remove(xmlPath.c_str());
+    remove(binaryPath.c_str());
+    printf("speedup is XML load over open. The copy into TestCaseDescs is paid one test case at a time as they run.\n");
+    return 0;
+}
+
+REGISTER_BENCHMARK("testsuite", "Startup cost of testcases.xml vs memory mapped binary test suites", TestSuiteBenchmark);
@@ -0,0 +1,229 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Ray-triangle benchmark in two parts:
+//  - Leak test: rays aimed at points on the shared edges and corners of closed cubes from BuildGeometry(),
+//    counting rays that hit none of the cube's triangles with the Moller-Trumbore and watertight tests.
+//  - Throughput: random rays against random triangle blocks with the scalar, 4-wide SSE and 8-wide AVX2
+//    watertight kernels. The hit counts must match between kernels.
+//
+// Options: -cubes <n> (100) -edgerays <n> (10000 per cube) -distance <cube sizes> (10000)
+//          -blocks <n> (4096) -rays <n> (2000) -seed <n> (1)
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CpuFeatures.h"
+#include "CpuScene.h"
+#include "WatertightTriangle.h"
+#include <cstdio>
+#include <functional>
+#include <random>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct Triangle
+    {
+        float3 v0;
+        float3 v1;
+        float3 v2;
+    };
+
+    void RunLeakTest(UINT cubeCount, UINT raysPerCube, float distance, UINT seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+
+        UINT64 rayCount = 0;
+        UINT64 leaksMollerTrumbore = 0;
+        UINT64 leaksWatertight = 0;
+        for (UINT cube = 0; cube < cubeCount; cube++)
+        {
+            BenchmarkMesh mesh;
+            GenerateCubeField(12, 1.0f, seed + cube, &mesh);
+            CpuTriangleGeometryDesc geometry = mesh.GetGeometryDesc();
+            std::vector<Triangle> triangles(mesh.GetTriangleCount());
+            AABB bounds;
+            for (UINT i = 0; i < static_cast<UINT>(triangles.size()); i++)
+            {
+                LoadTriangle(geometry, i, &triangles[i].v0, &triangles[i].v1, &triangles[i].v2);
+                bounds.Grow(triangles[i].v0);
+                bounds.Grow(triangles[i].v1);
+                bounds.Grow(triangles[i].v2);
+            }
+            float3 center = (bounds.minimum + bounds.maximum) * 0.5f;
+            float3 halfExtent = (bounds.maximum - bounds.minimum) * 0.5f;
+
+            for (UINT i = 0; i < raysPerCube; i++)
+            {
+                // Alternate between a point on a triangle edge, which the closed cube always shares, and a corner.
+                const Triangle& triangle = triangles[i % triangles.size()];
+                const float3 corners[3] = { triangle.v0, triangle.v1, triangle.v2 };
+                UINT edge = (i / static_cast<UINT>(triangles.size())) % 3;
+                float f = (i & 1) ? unit(rng) : 0.0f;
+                float3 target = lerp(corners[edge], corners[(edge + 1) % 3], f);
+
+                // Aim through the target at a point inside the cube so the ray must enter it, never just graze an edge.
+                float3 inside = center + float3(signedUnit(rng), signedUnit(rng), signedUnit(rng)) * (0.9f * halfExtent);
+                float3 direction = (inside - target) * (0.5f + unit(rng));
+                Ray ray(target - normalize(direction) * (distance * length(halfExtent)), direction);
+                WatertightRay watertightRay(ray);
+
+                bool hitMollerTrumbore = false;
+                bool hitWatertight = false;
+                for (const Triangle& candidate : triangles)
+                {
+                    float t, det;
+                    float2 barycentrics;
+                    hitMollerTrumbore = hitMollerTrumbore ||
+                        IntersectRayTriangle(ray, candidate.v0, candidate.v1, candidate.v2, ray.tMax, &t, &barycentrics, &det);
+                    hitWatertight = hitWatertight ||
+                        IntersectRayTriangleWatertight(watertightRay, candidate.v0, candidate.v1, candidate.v2, ray.tMax, &t, &barycentrics, &det);
+                }
+                rayCount++;
+                leaksMollerTrumbore += hitMollerTrumbore ? 0 : 1;
+                leaksWatertight += hitWatertight ? 0 : 1;
+            }
+        }
+
+        printf("Leak test: %llu rays at shared cube edges and corners from %g cube sizes away\n",
+            static_cast<unsigned long long>(rayCount), distance);
+        printf("%-20s %10llu leaked\n", "moller-trumbore", static_cast<unsigned long long>(leaksMollerTrumbore));
+        printf("%-20s %10llu leaked\n", "watertight", static_cast<unsigned long long>(leaksWatertight));
+    }
+
+    UINT64 CountBits(UINT mask)
+    {
+        UINT64 count = 0;
+        for (; mask; mask &= mask - 1)
+        {
+            count++;
+        }
+        return count;
+    }
+
+    void RunThroughputTest(UINT blockCount, UINT rayCount, UINT seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+
+        // Small triangles spread through a 2x2x2 box, grouped in blocks of eight and, for SSE, of four.
+        std::vector<Triangle> triangles(static_cast<size_t>(blockCount) * c_triangleBlockWidth);
+        for (Triangle& triangle : triangles)
+        {
+            float3 center(position(rng), position(rng), position(rng));
+            triangle.v0 = center + float3(position(rng), position(rng), position(rng)) * 0.2f;
+            triangle.v1 = center + float3(position(rng), position(rng), position(rng)) * 0.2f;
+            triangle.v2 = center + float3(position(rng), position(rng), position(rng)) * 0.2f;
+        }
+
+        std::vector<TriangleBlock> blocks8(blockCount);
+        std::vector<TriangleBlock> blocks4(2 * static_cast<size_t>(blockCount));
+        for (UINT i = 0; i < static_cast<UINT>(triangles.size()); i++)
+        {
+            const Triangle& triangle = triangles[i];
+            TriangleBlock& block8 = blocks8[i / 8];
+            TriangleBlock& block4 = blocks4[i / 4];
+            block8.Set(i % 8, triangle.v0, triangle.v1, triangle.v2, i);
+            block8.count = i % 8 + 1;
+            block4.Set(i % 4, triangle.v0, triangle.v1, triangle.v2, i);
+            block4.count = i % 4 + 1;
+        }
+
+        std::vector<Ray> rays(rayCount);
+        for (Ray& ray : rays)
+        {
+            ray = Ray(float3(position(rng), position(rng), position(rng)) * 2.0f,
+                float3(position(rng), position(rng), position(rng)));
+        }
+
+        printf("Throughput: %u rays x %zu triangles\n", rayCount, triangles.size());
+        printf("%-20s %12s %12s %10s\n", "kernel", "time (ms)", "Mtests/s", "hits");
+        auto Run = [&](const char* name, const std::function<UINT64(const Ray&)>& intersectAll)
+        {
+            BenchmarkTimer timer;
+            UINT64 hitCount = 0;
+            for (const Ray& ray : rays)
+            {
+                hitCount += intersectAll(ray);
+            }
+            double ms = timer.GetElapsedMs();
+            double tests = static_cast<double>(rays.size()) * triangles.size();
+            printf("%-20s %12.2f %12.2f %10llu\n", name, ms, tests / (ms * 1000.0), static_cast<unsigned long long>(hitCount));
+        };
+
+        Run("moller-trumbore", [&](const Ray& ray)
+        {
+            UINT64 hits = 0;
+            for (const Triangle& triangle : triangles)
+            {
+                float t, det;
+                float2 barycentrics;
+                hits += IntersectRayTriangle(ray, triangle.v0, triangle.v1, triangle.v2, ray.tMax, &t, &barycentrics, &det) ? 1 : 0;
+            }
+            return hits;
+        });
+
+        Run("watertight scalar", [&](const Ray& ray)
+        {
+            WatertightRay watertightRay(ray);
+            TriangleBlockHits blockHits;
+            UINT64 hits = 0;
+            for (const TriangleBlock& block : blocks8)
+            {
+                hits += CountBits(IntersectTriangleBlockScalar(block, watertightRay, ray.tMax, &blockHits));
+            }
+            return hits;
+        });
+
+        Run("watertight sse x4", [&](const Ray& ray)
+        {
+            WatertightRay watertightRay(ray);
+            TriangleBlockHits blockHits;
+            UINT64 hits = 0;
+            for (const TriangleBlock& block : blocks4)
+            {
+                hits += CountBits(IntersectTriangleBlock4Sse(block, watertightRay, ray.tMax, &blockHits));
+            }
+            return hits;
+        });
+
+        if (!CpuSupportsAvx2())
+        {
+            printf("%-20s skipped, AVX2 not supported\n", "watertight avx2 x8");
+            return;
+        }
+        Run("watertight avx2 x8", [&](const Ray& ray)
+        {
+            WatertightRay watertightRay(ray);
+            TriangleBlockHits blockHits;
+            UINT64 hits = 0;
+            for (const TriangleBlock& block : blocks8)
+            {
+                hits += CountBits(IntersectTriangleBlock8Avx2(block, watertightRay, ray.tMax, &blockHits));
+            }
+            return hits;
+        });
+    }
+}
+
+static int TriangleBenchmark(const BenchmarkArgs& args)
+{
+    UINT seed = args.GetUInt("seed", 1);
+    RunLeakTest(args.GetUInt("cubes", 100), args.GetUInt("edgerays", 10000), args.GetFloat("distance", 10000.0f), seed);
+    printf("\n");
+    RunThroughputTest((std::max)(1u, args.GetUInt("blocks", 4096)), args.GetUInt("rays", 2000), seed);
+    return 0;
+}
+
+REGISTER_BENCHMARK("triangle", "Watertight vs Moller-Trumbore edge leaks and SIMD kernel throughput", TriangleBenchmark);
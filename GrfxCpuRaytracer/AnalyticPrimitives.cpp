@@ -0,0 +1,60 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "AnalyticPrimitives.h"
+#include "CpuFeatures.h"
+
+namespace CpuRT
+{
+    AnalyticKernel::Enum GetDefaultAnalyticKernel()
+    {
+        return CpuSupportsAvx2() ? AnalyticKernel::Avx2 : AnalyticKernel::Scalar;
+    }
+
+    UINT RayAnalyticPrimitiveTest8Scalar(const RayBatch& rays, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        RayBatchHits* hits)
+    {
+        UINT hitMask = 0;
+        const UINT count = (std::min)(rays.count, c_rayBatchWidth);
+        for (UINT lane = 0; lane < count; lane++)
+        {
+            AnalyticRay<float> ray;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                ray.origin[axis] = rays.origin[axis][lane];
+                ray.direction[axis] = rays.direction[axis][lane];
+            }
+            ray.tMin = rays.tMin[lane];
+            ray.tMax = rays.tMax[lane];
+
+            float normal[3];
+            if (RayAnalyticPrimitiveTestRobust(ray, rayFlags, analyticPrimitive, &hits->t[lane], normal))
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    hits->normal[axis][lane] = normal[axis];
+                }
+                hitMask |= 1u << lane;
+            }
+        }
+        return hitMask;
+    }
+
+#if !GRFX_CPU_X86
+    // No AVX2 on this architecture; CpuSupportsAvx2() is false so this is never selected.
+    UINT RayAnalyticPrimitiveTest8Avx2(const RayBatch& rays, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        RayBatchHits* hits)
+    {
+        return RayAnalyticPrimitiveTest8Scalar(rays, rayFlags, analyticPrimitive, hits);
+    }
+#endif
+}
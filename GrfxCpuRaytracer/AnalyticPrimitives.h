@@ -0,0 +1,510 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// C++ port of AnalyticPrimitives.hlsli in D3D12RaytracingProceduralGeometry and the hit validation of
+// RaytracingShaderHelper.hlsli. Functions keep their HLSL names and operation order. RayTMin(), RayTCurrent()
+// and RayFlags() become ray.tMin, ray.tMax and a parameter.
+//
+// The *Robust() tests below are reformulations of the same tests without catastrophic cancellation, templated on
+// the precision: the float versions back the 8-ray batch kernels and the double versions are their reference.
+// AnalyticPrimitives.hlsli has the same tests, used when USE_ROBUST_ANALYTIC_PRIMITIVES is set.
+
+#include "CpuMath.h"
+#include "CpuScene.h"
+#include <limits>
+
+namespace CpuRT
+{
+    // AnalyticPrimitive::Enum of RayTracingHlslCompat.h.
+    namespace CpuAnalyticPrimitive
+    {
+        enum Enum
+        {
+            AABB = 0,
+            Spheres,
+            Count
+        };
+    }
+
+    // IsCulled() of RaytracingShaderHelper.hlsli: procedural hits honor the triangle culling flags.
+    inline bool IsCulled(const float3& rayDirection, const float3& hitSurfaceNormal, UINT rayFlags)
+    {
+        float rayDirectionNormalDot = dot(rayDirection, hitSurfaceNormal);
+        return ((rayFlags & RAY_FLAG_CULL_BACK_FACING_TRIANGLES) && (rayDirectionNormalDot > 0))
+            || ((rayFlags & RAY_FLAG_CULL_FRONT_FACING_TRIANGLES) && (rayDirectionNormalDot < 0));
+    }
+
+    // IsAValidHit() of RaytracingShaderHelper.hlsli.
+    inline bool IsAValidHit(const Ray& ray, UINT rayFlags, float thit, const float3& hitSurfaceNormal)
+    {
+        return thit >= ray.tMin && thit <= ray.tMax && !IsCulled(ray.direction, hitSurfaceNormal, rayFlags);
+    }
+
+    // Solve a quadratic equation.
+    inline bool SolveQuadraticEqn(float a, float b, float c, float* x0, float* x1)
+    {
+        float discr = b * b - 4 * a * c;
+        if (discr < 0) return false;
+        else if (discr == 0) *x0 = *x1 = -0.5f * b / a;
+        else {
+            float q = (b > 0) ?
+                -0.5f * (b + std::sqrt(discr)) :
+                -0.5f * (b - std::sqrt(discr));
+            *x0 = q / a;
+            *x1 = c / q;
+        }
+        if (*x0 > *x1) std::swap(*x0, *x1);
+
+        return true;
+    }
+
+    // Calculate a normal for a hit point on a sphere.
+    inline float3 CalculateNormalForARaySphereHit(const Ray& ray, float thit, const float3& center)
+    {
+        float3 hitPosition = ray.origin + ray.direction * thit;
+        return normalize(hitPosition - center);
+    }
+
+    // Analytic solution of an unbounded ray sphere intersection points.
+    inline bool SolveRaySphereIntersectionEquation(const Ray& ray, float* tmin, float* tmax, const float3& center, float radius)
+    {
+        float3 L = ray.origin - center;
+        float a = dot(ray.direction, ray.direction);
+        float b = 2 * dot(ray.direction, L);
+        float c = dot(L, L) - radius * radius;
+        return SolveQuadraticEqn(a, b, c, tmin, tmax);
+    }
+
+    // Test if a ray with rayFlags and segment <ray.tMin, ray.tMax> intersects a hollow sphere.
+    inline bool RaySphereIntersectionTest(const Ray& ray, UINT rayFlags, float* thit, float* tmax, float3* normal,
+        const float3& center = float3(0.0f), float radius = 1.0f)
+    {
+        float t0, t1; // solutions for t if the ray intersects
+
+        if (!SolveRaySphereIntersectionEquation(ray, &t0, &t1, center, radius)) return false;
+        *tmax = t1;
+
+        if (t0 < ray.tMin)
+        {
+            // t0 is before ray.tMin, use t1 instead.
+            if (t1 < ray.tMin) return false;
+
+            *normal = CalculateNormalForARaySphereHit(ray, t1, center);
+            if (IsAValidHit(ray, rayFlags, t1, *normal))
+            {
+                *thit = t1;
+                return true;
+            }
+        }
+        else
+        {
+            *normal = CalculateNormalForARaySphereHit(ray, t0, center);
+            if (IsAValidHit(ray, rayFlags, t0, *normal))
+            {
+                *thit = t0;
+                return true;
+            }
+
+            *normal = CalculateNormalForARaySphereHit(ray, t1, center);
+            if (IsAValidHit(ray, rayFlags, t1, *normal))
+            {
+                *thit = t1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Test if a ray segment <ray.tMin, ray.tMax> intersects a solid sphere.
+    // Limitation: this test does not take ray flags into consideration and does not calculate a surface normal.
+    inline bool RaySolidSphereIntersectionTest(const Ray& ray, float* thit, float* tmax, const float3& center, float radius)
+    {
+        float t0, t1; // solutions for t if the ray intersects
+
+        if (!SolveRaySphereIntersectionEquation(ray, &t0, &t1, center, radius))
+            return false;
+
+        // Since it's a solid sphere, clip intersection points to ray extents.
+        *thit = (std::max)(t0, ray.tMin);
+        *tmax = (std::min)(t1, ray.tMax);
+
+        return true;
+    }
+
+    // Test if a ray with rayFlags and segment <ray.tMin, ray.tMax> intersects the sample's three hollow spheres.
+    inline bool RaySpheresIntersectionTest(const Ray& ray, UINT rayFlags, float* thit, float3* normal)
+    {
+        const int N = 3;
+        const float3 centers[N] =
+        {
+            float3(-0.3f, -0.3f, -0.3f),
+            float3(0.1f, 0.1f, 0.4f),
+            float3(0.35f, 0.35f, 0.0f)
+        };
+        const float radii[N] = { 0.6f, 0.3f, 0.15f };
+        bool hitFound = false;
+
+        // Test for intersection against all spheres and take the closest hit.
+        *thit = ray.tMax;
+        for (int i = 0; i < N; i++)
+        {
+            float _thit;
+            float _tmax;
+            float3 _normal(0.0f);
+            if (RaySphereIntersectionTest(ray, rayFlags, &_thit, &_tmax, &_normal, centers[i], radii[i]))
+            {
+                if (_thit < *thit)
+                {
+                    *thit = _thit;
+                    *normal = _normal;
+                    hitFound = true;
+                }
+            }
+        }
+        return hitFound;
+    }
+
+    // Test if a ray segment <ray.tMin, ray.tMax> intersects an AABB: the distances at which the ray enters and
+    // exits aabb, and whether that segment overlaps the ray's.
+    inline bool RayAABBIntersectionTest(const Ray& ray, const float3 aabb[2], float* tmin, float* tmax)
+    {
+        float tmin3[3], tmax3[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int sign = ray.direction[axis] > 0 ? 1 : 0;
+            float invRayDirection = (ray.direction[axis] != 0)
+                ? 1 / ray.direction[axis]
+                : ((ray.direction[axis] > 0) ? c_infinity : -c_infinity);
+            tmin3[axis] = (aabb[1 - sign][axis] - ray.origin[axis]) * invRayDirection;
+            tmax3[axis] = (aabb[sign][axis] - ray.origin[axis]) * invRayDirection;
+        }
+        *tmin = (std::max)((std::max)(tmin3[0], tmin3[1]), tmin3[2]);
+        *tmax = (std::min)((std::min)(tmax3[0], tmax3[1]), tmax3[2]);
+        return *tmax > *tmin && *tmax >= ray.tMin && *tmin <= ray.tMax;
+    }
+
+    // Test if a ray with rayFlags and segment <ray.tMin, ray.tMax> intersects a hollow AABB.
+    inline bool RayAABBIntersectionTest(const Ray& ray, UINT rayFlags, const float3 aabb[2], float* thit, float3* normal)
+    {
+        float tmin, tmax;
+        if (RayAABBIntersectionTest(ray, aabb, &tmin, &tmax))
+        {
+            // Only consider intersections crossing the surface from the outside.
+            if (tmin < ray.tMin || tmin > ray.tMax)
+                return false;
+
+            *thit = tmin;
+
+            // Set a normal to the normal of a face the hit point lays on.
+            float3 hitPosition = ray.origin + ray.direction * *thit;
+            float3 distanceToBounds[2] = {
+                abs(aabb[0] - hitPosition),
+                abs(aabb[1] - hitPosition)
+            };
+            const float eps = 0.0001f;
+            if (distanceToBounds[0].x < eps) *normal = float3(-1, 0, 0);
+            else if (distanceToBounds[0].y < eps) *normal = float3(0, -1, 0);
+            else if (distanceToBounds[0].z < eps) *normal = float3(0, 0, -1);
+            else if (distanceToBounds[1].x < eps) *normal = float3(1, 0, 0);
+            else if (distanceToBounds[1].y < eps) *normal = float3(0, 1, 0);
+            else if (distanceToBounds[1].z < eps) *normal = float3(0, 0, 1);
+
+            return IsAValidHit(ray, rayFlags, *thit, *normal);
+        }
+        return false;
+    }
+
+    //------------------------------------------------------------------
+
+    // A ray with components of Real, float or double.
+    template <typename Real>
+    struct AnalyticRay
+    {
+        Real origin[3];
+        Real direction[3];
+        Real tMin;
+        Real tMax;
+
+        AnalyticRay() {}
+        explicit AnalyticRay(const Ray& ray)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                origin[axis] = static_cast<Real>(ray.origin[axis]);
+                direction[axis] = static_cast<Real>(ray.direction[axis]);
+            }
+            tMin = static_cast<Real>(ray.tMin);
+            tMax = static_cast<Real>(ray.tMax);
+        }
+    };
+
+    template <typename Real>
+    inline Real Dot3(const Real a[3], const Real b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    template <typename Real>
+    inline void Normalize3(const Real a[3], Real result[3])
+    {
+        Real invLength = Real(1) / std::sqrt(Dot3(a, a));
+        for (int axis = 0; axis < 3; axis++)
+        {
+            result[axis] = a[axis] * invLength;
+        }
+    }
+
+    template <typename Real>
+    inline bool IsCulledRobust(const Real rayDirection[3], const Real hitSurfaceNormal[3], UINT rayFlags)
+    {
+        Real rayDirectionNormalDot = Dot3(rayDirection, hitSurfaceNormal);
+        return ((rayFlags & RAY_FLAG_CULL_BACK_FACING_TRIANGLES) && (rayDirectionNormalDot > 0))
+            || ((rayFlags & RAY_FLAG_CULL_FRONT_FACING_TRIANGLES) && (rayDirectionNormalDot < 0));
+    }
+
+    template <typename Real>
+    inline bool IsAValidHitRobust(const AnalyticRay<Real>& ray, UINT rayFlags, Real thit, const Real hitSurfaceNormal[3])
+    {
+        return thit >= ray.tMin && thit <= ray.tMax && !IsCulledRobust(ray.direction, hitSurfaceNormal, rayFlags);
+    }
+
+    // Both intersections of a ray with a sphere, near and far along the ray.
+    //
+    // b * b - 4 * a * c loses all precision once the origin is many radii away, as both terms grow with the
+    // squared distance. Instead the discriminant comes from l, the vector from the center to the point of the
+    // line closest to it, which stays as small as the sphere (Haines et al., Precision Improvements for Ray/Sphere
+    // Intersection, Ray Tracing Gems). The roots are q / a and c / q, with q = b + sign(b) * sqrt(discriminant)
+    // free of cancellation. The hit points relative to the center are l -/+ offset * direction.
+    template <typename Real>
+    inline bool SolveRaySphereIntersectionEquationRobust(const AnalyticRay<Real>& ray, const Real center[3], Real radius,
+        Real* tNear, Real* tFar, Real l[3], Real* offset)
+    {
+        Real f[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            f[axis] = ray.origin[axis] - center[axis];
+        }
+        Real a = Dot3(ray.direction, ray.direction);
+        Real b = -Dot3(ray.direction, f);       // -b / 2 of the textbook equation.
+        Real s = b / a;                         // Parameter of the closest point.
+        for (int axis = 0; axis < 3; axis++)
+        {
+            l[axis] = f[axis] + ray.direction[axis] * s;
+        }
+        Real radius2 = radius * radius;
+        Real discr = radius2 - Dot3(l, l);      // Divided by a.
+        if (!(discr >= 0)) return false;
+
+        Real root = std::sqrt(a * discr);
+        Real q = (b >= 0) ? b + root : b - root;
+        Real c = Dot3(f, f) - radius2;
+        Real qOverA = q / a;
+        Real cOverQ = (q != 0) ? c / q : s;
+        *tNear = (b >= 0) ? cOverQ : qOverA;
+        *tFar = (b >= 0) ? qOverA : cOverQ;
+        *offset = root / a;
+        return true;
+    }
+
+    // Normal at l + offset * direction, with the offset negated for the near hit.
+    template <typename Real>
+    inline void CalculateNormalForARaySphereHitRobust(const AnalyticRay<Real>& ray, const Real l[3], Real offset, Real normal[3])
+    {
+        Real hitPosition[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            hitPosition[axis] = l[axis] + ray.direction[axis] * offset;
+        }
+        Normalize3(hitPosition, normal);
+    }
+
+    // RaySphereIntersectionTest(): the near hit if it is valid, the far hit otherwise.
+    template <typename Real>
+    inline bool RaySphereIntersectionTestRobust(const AnalyticRay<Real>& ray, UINT rayFlags, const Real center[3], Real radius,
+        Real* thit, Real normal[3])
+    {
+        Real tNear, tFar, l[3], offset;
+        if (!SolveRaySphereIntersectionEquationRobust(ray, center, radius, &tNear, &tFar, l, &offset)) return false;
+
+        CalculateNormalForARaySphereHitRobust(ray, l, -offset, normal);
+        if (IsAValidHitRobust(ray, rayFlags, tNear, normal))
+        {
+            *thit = tNear;
+            return true;
+        }
+
+        CalculateNormalForARaySphereHitRobust(ray, l, offset, normal);
+        if (IsAValidHitRobust(ray, rayFlags, tFar, normal))
+        {
+            *thit = tFar;
+            return true;
+        }
+        return false;
+    }
+
+    // The spheres of RaySpheresIntersectionTest().
+    static const UINT c_analyticSphereCount = 3;
+    static const float c_analyticSphereCenters[c_analyticSphereCount][3] =
+    {
+        { -0.3f, -0.3f, -0.3f },
+        { 0.1f, 0.1f, 0.4f },
+        { 0.35f, 0.35f, 0.0f }
+    };
+    static const float c_analyticSphereRadii[c_analyticSphereCount] = { 0.6f, 0.3f, 0.15f };
+
+    template <typename Real>
+    inline bool RaySpheresIntersectionTestRobust(const AnalyticRay<Real>& ray, UINT rayFlags, Real* thit, Real normal[3])
+    {
+        bool hitFound = false;
+        *thit = ray.tMax;
+        for (UINT i = 0; i < c_analyticSphereCount; i++)
+        {
+            const Real center[3] = { c_analyticSphereCenters[i][0], c_analyticSphereCenters[i][1], c_analyticSphereCenters[i][2] };
+            Real _thit;
+            Real _normal[3];
+            if (RaySphereIntersectionTestRobust(ray, rayFlags, center, static_cast<Real>(c_analyticSphereRadii[i]), &_thit, _normal)
+                && _thit < *thit)
+            {
+                *thit = _thit;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    normal[axis] = _normal[axis];
+                }
+                hitFound = true;
+            }
+        }
+        return hitFound;
+    }
+
+    // RayAABBIntersectionTest() of a hollow AABB. A direction component of zero gives an infinite reciprocal
+    // and a ray in the plane of a slab gives 0 * inf = NaN, which the comparisons skip, so no case needs a
+    // branch. The normal is the face of the slab the ray enters last, rather than found from the hit position
+    // with an absolute epsilon that stops working far from the origin.
+    template <typename Real>
+    inline bool RayAABBIntersectionTestRobust(const AnalyticRay<Real>& ray, UINT rayFlags, const Real aabbMin[3], const Real aabbMax[3],
+        Real* thit, Real normal[3])
+    {
+        Real tEnter = -std::numeric_limits<Real>::infinity();
+        Real tExit = std::numeric_limits<Real>::infinity();
+        Real enterNormal[3] = { 0, 0, 0 };
+        for (int axis = 0; axis < 3; axis++)
+        {
+            Real invRayDirection = Real(1) / ray.direction[axis];
+            bool positive = invRayDirection >= 0;
+            Real tNear = ((positive ? aabbMin[axis] : aabbMax[axis]) - ray.origin[axis]) * invRayDirection;
+            Real tFar = ((positive ? aabbMax[axis] : aabbMin[axis]) - ray.origin[axis]) * invRayDirection;
+            if (tNear > tEnter)
+            {
+                tEnter = tNear;
+                for (int k = 0; k < 3; k++)
+                {
+                    enterNormal[k] = (k == axis) ? (positive ? Real(-1) : Real(1)) : Real(0);
+                }
+            }
+            if (tFar < tExit)
+            {
+                tExit = tFar;
+            }
+        }
+
+        // Only consider intersections crossing the surface from the outside.
+        if (!(tEnter <= tExit) || !IsAValidHitRobust(ray, rayFlags, tEnter, enterNormal)) return false;
+
+        *thit = tEnter;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            normal[axis] = enterNormal[axis];
+        }
+        return true;
+    }
+
+    // RayAnalyticGeometryIntersectionTest() with the robust tests. AABB local space dimensions: <-1,1>.
+    template <typename Real>
+    inline bool RayAnalyticPrimitiveTestRobust(const AnalyticRay<Real>& ray, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        Real* thit, Real normal[3])
+    {
+        switch (analyticPrimitive)
+        {
+        case CpuAnalyticPrimitive::AABB:
+        {
+            const Real aabbMin[3] = { -1, -1, -1 };
+            const Real aabbMax[3] = { 1, 1, 1 };
+            return RayAABBIntersectionTestRobust(ray, rayFlags, aabbMin, aabbMax, thit, normal);
+        }
+        case CpuAnalyticPrimitive::Spheres:
+            return RaySpheresIntersectionTestRobust(ray, rayFlags, thit, normal);
+        default:
+            return false;
+        }
+    }
+
+    //------------------------------------------------------------------
+
+    static const UINT c_rayBatchWidth = 8;
+
+    // Up to eight rays in structure-of-arrays layout. Lanes [count, 8) are ignored but should be
+    // zero-initialized, e.g. RayBatch batch = {}, as the SIMD kernels still evaluate them.
+    struct alignas(32) RayBatch
+    {
+        float origin[3][c_rayBatchWidth];
+        float direction[3][c_rayBatchWidth];
+        float tMin[c_rayBatchWidth];
+        float tMax[c_rayBatchWidth];
+        UINT count;
+
+        void Set(UINT lane, const Ray& ray)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                origin[axis][lane] = ray.origin[axis];
+                direction[axis][lane] = ray.direction[axis];
+            }
+            tMin[lane] = ray.tMin;
+            tMax[lane] = ray.tMax;
+        }
+    };
+
+    // Per-lane results; only lanes set in the returned hit mask are valid.
+    struct RayBatchHits
+    {
+        float t[c_rayBatchWidth];
+        float normal[3][c_rayBatchWidth];
+    };
+
+    namespace AnalyticKernel
+    {
+        enum Enum
+        {
+            Scalar,
+            Avx2
+        };
+    }
+
+    // Avx2 when CpuSupportsAvx2(), Scalar otherwise.
+    AnalyticKernel::Enum GetDefaultAnalyticKernel();
+
+    // RayAnalyticPrimitiveTestRobust<float>() for the rays of a batch; returns the mask of lanes that hit. Both
+    // kernels match it bit for bit; the AVX2 kernel requires CpuSupportsAvx2().
+    UINT RayAnalyticPrimitiveTest8Scalar(const RayBatch& rays, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        RayBatchHits* hits);
+    UINT RayAnalyticPrimitiveTest8Avx2(const RayBatch& rays, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        RayBatchHits* hits);
+
+    inline UINT RayAnalyticPrimitiveTest8(AnalyticKernel::Enum kernel, const RayBatch& rays, UINT rayFlags,
+        CpuAnalyticPrimitive::Enum analyticPrimitive, RayBatchHits* hits)
+    {
+        return (kernel == AnalyticKernel::Avx2)
+            ? RayAnalyticPrimitiveTest8Avx2(rays, rayFlags, analyticPrimitive, hits)
+            : RayAnalyticPrimitiveTest8Scalar(rays, rayFlags, analyticPrimitive, hits);
+    }
+}
@@ -0,0 +1,42 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+// 8-wide AVX2 analytic sphere and AABB tests for AnalyticPrimitives.h. Only this translation unit runs AVX2 code.
+
+#include "AnalyticPrimitivesAvx2.h"
+
+#if GRFX_CPU_X86
+namespace CpuRT
+{
+    // RayAnalyticPrimitiveTestRobust() with one lane per ray. The tests have no loops, so all lanes run every
+    // instruction and lanes past rays.count are dropped from the hit mask.
+    GRFX_TARGET_AVX2 UINT RayAnalyticPrimitiveTest8Avx2(const RayBatch& rays, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        RayBatchHits* hits)
+    {
+        const float3x8 origin = Load8(rays.origin);
+        const float3x8 direction = Load8(rays.direction);
+        const float8 tMin = Load8(rays.tMin);
+        const float8 tMax = Load8(rays.tMax);
+        const UINT active = (rays.count >= c_rayBatchWidth) ? 0xFF : (1u << rays.count) - 1;
+
+        float8 hitT;
+        float3x8 hitNormal;
+        float8 hit = RayAnalyticPrimitiveTestRobust(origin, direction, tMin, tMax, rayFlags, analyticPrimitive, &hitT, &hitNormal);
+
+        _mm256_storeu_ps(hits->t, hitT.v);
+        _mm256_storeu_ps(hits->normal[0], hitNormal.x.v);
+        _mm256_storeu_ps(hits->normal[1], hitNormal.y.v);
+        _mm256_storeu_ps(hits->normal[2], hitNormal.z.v);
+        return active & MoveMask(hit);
+    }
+}
+#endif
@@ -0,0 +1,157 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+// The robust tests of AnalyticPrimitives.h for eight rays at a time, on the float8 types of CpuMathAvx2.h. Every
+// function mirrors the float instantiation of its template operation by operation, with branches turned into
+// lane selects, so each lane matches it bit for bit.
+//
+// Only for translation units that run AVX2 code: every function is GRFX_INLINE_AVX2 and callers must
+// check CpuSupportsAvx2().
+
+#include "AnalyticPrimitives.h"
+#include "CpuMathAvx2.h"
+
+#if GRFX_CPU_X86
+namespace CpuRT
+{
+    // Lane mask of IsCulled().
+    GRFX_INLINE_AVX2 float8 IsCulled(const float3x8& rayDirection, const float3x8& hitSurfaceNormal, UINT rayFlags)
+    {
+        float8 rayDirectionNormalDot = dot(rayDirection, hitSurfaceNormal);
+        float8 culled = Splat(0.0f);
+        if (rayFlags & RAY_FLAG_CULL_BACK_FACING_TRIANGLES)
+        {
+            culled = culled | (rayDirectionNormalDot > Splat(0.0f));
+        }
+        if (rayFlags & RAY_FLAG_CULL_FRONT_FACING_TRIANGLES)
+        {
+            culled = culled | (rayDirectionNormalDot < Splat(0.0f));
+        }
+        return culled;
+    }
+
+    // Lane mask of IsAValidHit().
+    GRFX_INLINE_AVX2 float8 IsAValidHit(const float3x8& rayDirection, const float8& tMin, const float8& tMax, UINT rayFlags,
+        const float8& thit, const float3x8& hitSurfaceNormal)
+    {
+        return AndNot(IsCulled(rayDirection, hitSurfaceNormal, rayFlags), (thit >= tMin) & (thit <= tMax));
+    }
+
+    // Lane mask of SolveRaySphereIntersectionEquationRobust(). Lanes that miss get unspecified results.
+    GRFX_INLINE_AVX2 float8 SolveRaySphereIntersectionEquationRobust(const float3x8& origin, const float3x8& direction,
+        const float3& center, float radius, float8* tNear, float8* tFar, float3x8* l, float8* offset)
+    {
+        float3x8 f = origin - center;
+        float8 a = dot(direction, direction);
+        float8 b = -dot(direction, f);
+        float8 s = b / a;
+        *l = f + direction * s;
+        float radius2 = radius * radius;
+        float8 discr = Splat(radius2) - dot(*l, *l);
+        float8 hit = discr >= Splat(0.0f);
+
+        float8 root = sqrt(a * discr);
+        float8 bPositive = b >= Splat(0.0f);
+        float8 q = Select(bPositive, b + root, b - root);
+        float8 c = dot(f, f) - radius2;
+        float8 qOverA = q / a;
+        float8 cOverQ = Select(q != Splat(0.0f), c / q, s);
+        *tNear = Select(bPositive, cOverQ, qOverA);
+        *tFar = Select(bPositive, qOverA, cOverQ);
+        *offset = root / a;
+        return hit;
+    }
+
+    // Both hits are evaluated in every lane; the far one is used where the near one is not valid.
+    GRFX_INLINE_AVX2 float8 RaySphereIntersectionTestRobust(const float3x8& origin, const float3x8& direction, const float8& tMin,
+        const float8& tMax, UINT rayFlags, const float3& center, float radius, float8* thit, float3x8* normal)
+    {
+        float8 tNear, tFar, offset;
+        float3x8 l;
+        float8 hit = SolveRaySphereIntersectionEquationRobust(origin, direction, center, radius, &tNear, &tFar, &l, &offset);
+        float3x8 nearNormal = normalize(l + direction * -offset);
+        float3x8 farNormal = normalize(l + direction * offset);
+        float8 nearValid = hit & IsAValidHit(direction, tMin, tMax, rayFlags, tNear, nearNormal);
+        float8 farValid = AndNot(nearValid, hit & IsAValidHit(direction, tMin, tMax, rayFlags, tFar, farNormal));
+        *thit = Select(nearValid, tNear, tFar);
+        *normal = Select(nearValid, nearNormal, farNormal);
+        return nearValid | farValid;
+    }
+
+    GRFX_INLINE_AVX2 float8 RaySpheresIntersectionTestRobust(const float3x8& origin, const float3x8& direction, const float8& tMin,
+        const float8& tMax, UINT rayFlags, float8* thit, float3x8* normal)
+    {
+        float8 hitFound = Splat(0.0f);
+        *thit = tMax;
+        *normal = Splat(float3(0.0f));
+        for (UINT i = 0; i < c_analyticSphereCount; i++)
+        {
+            const float3 center(c_analyticSphereCenters[i][0], c_analyticSphereCenters[i][1], c_analyticSphereCenters[i][2]);
+            float8 _thit;
+            float3x8 _normal;
+            float8 hit = RaySphereIntersectionTestRobust(origin, direction, tMin, tMax, rayFlags, center, c_analyticSphereRadii[i], &_thit, &_normal);
+            float8 closer = hit & (_thit < *thit);
+            *thit = Select(closer, _thit, *thit);
+            *normal = Select(closer, _normal, *normal);
+            hitFound = hitFound | closer;
+        }
+        return hitFound;
+    }
+
+    GRFX_INLINE_AVX2 float8 RayAABBIntersectionTestRobust(const float3x8& origin, const float3x8& direction, const float8& tMin,
+        const float8& tMax, UINT rayFlags, const float3& aabbMin, const float3& aabbMax, float8* thit, float3x8* normal)
+    {
+        const float8* rayOrigin[3] = { &origin.x, &origin.y, &origin.z };
+        const float8* rayDirection[3] = { &direction.x, &direction.y, &direction.z };
+        float8 tEnter = Splat(-c_infinity);
+        float8 tExit = Splat(c_infinity);
+        float8 enterNormal[3] = { Splat(0.0f), Splat(0.0f), Splat(0.0f) };
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float8 invRayDirection = Splat(1.0f) / *rayDirection[axis];
+            float8 positive = invRayDirection >= Splat(0.0f);
+            float8 tNear = (Select(positive, Splat(aabbMin[axis]), Splat(aabbMax[axis])) - *rayOrigin[axis]) * invRayDirection;
+            float8 tFar = (Select(positive, Splat(aabbMax[axis]), Splat(aabbMin[axis])) - *rayOrigin[axis]) * invRayDirection;
+            float8 enter = tNear > tEnter;
+            tEnter = Select(enter, tNear, tEnter);
+            for (int k = 0; k < 3; k++)
+            {
+                float8 faceNormal = (k == axis) ? Select(positive, Splat(-1.0f), Splat(1.0f)) : Splat(0.0f);
+                enterNormal[k] = Select(enter, faceNormal, enterNormal[k]);
+            }
+            tExit = Select(tFar < tExit, tFar, tExit);
+        }
+
+        *thit = tEnter;
+        *normal = { enterNormal[0], enterNormal[1], enterNormal[2] };
+        return (tEnter <= tExit) & IsAValidHit(direction, tMin, tMax, rayFlags, tEnter, *normal);
+    }
+
+    GRFX_INLINE_AVX2 float8 RayAnalyticPrimitiveTestRobust(const float3x8& origin, const float3x8& direction, const float8& tMin,
+        const float8& tMax, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive, float8* thit, float3x8* normal)
+    {
+        switch (analyticPrimitive)
+        {
+        case CpuAnalyticPrimitive::AABB:
+            return RayAABBIntersectionTestRobust(origin, direction, tMin, tMax, rayFlags, float3(-1.0f), float3(1.0f), thit, normal);
+        case CpuAnalyticPrimitive::Spheres:
+            return RaySpheresIntersectionTestRobust(origin, direction, tMin, tMax, rayFlags, thit, normal);
+        default:
+            *thit = Splat(0.0f);
+            *normal = Splat(float3(0.0f));
+            return Splat(0.0f);
+        }
+    }
+}
+#endif
@@ -0,0 +1,359 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "BinnedSahBuilder.h"
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace CpuRT
+{
+    namespace
+    {
+        struct BuildRange
+        {
+            UINT first = 0;
+            UINT count = 0;
+            AABB bounds;
+            AABB centroidBounds;
+        };
+
+        class BinnedSahBuilder
+        {
+        public:
+            BinnedSahBuilder(const AABB* primBounds, UINT primCount, const BinnedSahBuildSettings& settings, UINT* primIndices) :
+                m_primBounds(primBounds),
+                m_settings(settings),
+                m_primIndices(primIndices),
+                m_centroids(primCount)
+            {
+                m_settings.binCount = (std::min)((std::max)(m_settings.binCount, 2u), c_maxSahBins);
+                m_settings.maxLeafSize = (std::max)(m_settings.maxLeafSize, 1u);
+
+                UINT numThreads = m_settings.numThreads ? m_settings.numThreads : std::thread::hardware_concurrency();
+                m_freeThreads = static_cast<int>((std::max)(numThreads, 1u)) - 1;
+
+                for (UINT i = 0; i < primCount; i++)
+                {
+                    m_centroids[i] = primBounds[i].Center();
+                }
+            }
+
+            // Builds the subtree over primIndices[first, first + count) into nodes, rooted at nodes[nodeIndex].
+            void BuildSubtree(std::vector<BvhNode>& nodes, UINT nodeIndex, const BuildRange& range, UINT depth)
+            {
+                nodes[nodeIndex].bounds = range.bounds;
+
+                BuildRange left, right;
+                if (depth + 1 >= c_maxBvhDepth || range.count <= 1 || !Split(range, &left, &right))
+                {
+                    nodes[nodeIndex].leftOrFirst = range.first;
+                    nodes[nodeIndex].primCount = range.count;
+                    return;
+                }
+
+                if (range.count <= m_settings.parallelThreshold)
+                {
+                    UINT leftIndex = static_cast<UINT>(nodes.size());
+                    nodes.push_back(BvhNode());
+                    nodes.push_back(BvhNode());
+                    nodes[nodeIndex].leftOrFirst = leftIndex;
+                    nodes[nodeIndex].primCount = 0;
+                    BuildSubtree(nodes, leftIndex, left, depth + 1);
+                    BuildSubtree(nodes, leftIndex + 1, right, depth + 1);
+                    return;
+                }
+
+                // Large subtrees are built into their own node arrays, possibly on another thread,
+                // then spliced in left-to-right so the layout is identical for any thread count.
+                std::vector<BvhNode> leftNodes(1);
+                std::vector<BvhNode> rightNodes(1);
+                std::future<void> leftTask;
+                if (AcquireThread())
+                {
+                    leftTask = std::async(std::launch::async, [&]()
+                    {
+                        BuildSubtree(leftNodes, 0, left, depth + 1);
+                        ReleaseThread();
+                    });
+                }
+                else
+                {
+                    BuildSubtree(leftNodes, 0, left, depth + 1);
+                }
+                BuildSubtree(rightNodes, 0, right, depth + 1);
+                if (leftTask.valid())
+                {
+                    leftTask.get();
+                }
+
+                UINT leftIndex = static_cast<UINT>(nodes.size());
+                nodes[nodeIndex].leftOrFirst = leftIndex;
+                nodes[nodeIndex].primCount = 0;
+                nodes.push_back(leftNodes[0]);
+                nodes.push_back(rightNodes[0]);
+                SpliceBvhSubtree(&nodes, leftIndex, leftNodes);
+                SpliceBvhSubtree(&nodes, leftIndex + 1, rightNodes);
+            }
+
+            BuildRange GetRootRange(UINT primCount) const
+            {
+                BuildRange range;
+                range.first = 0;
+                range.count = primCount;
+                for (UINT i = 0; i < primCount; i++)
+                {
+                    range.bounds.Grow(m_primBounds[i]);
+                    range.centroidBounds.Grow(m_centroids[i]);
+                }
+                return range;
+            }
+
+        private:
+            // Plain storage so only the bins in use are initialized per node.
+            struct Bin
+            {
+                float minimum[3];
+                float maximum[3];
+                UINT count;
+
+                void Reset()
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        minimum[i] = c_infinity;
+                        maximum[i] = -c_infinity;
+                    }
+                    count = 0;
+                }
+
+                void Grow(const AABB& box)
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        minimum[i] = (std::min)(minimum[i], box.minimum[i]);
+                        maximum[i] = (std::max)(maximum[i], box.maximum[i]);
+                    }
+                    count++;
+                }
+
+                AABB Bounds() const
+                {
+                    return AABB(float3(minimum[0], minimum[1], minimum[2]), float3(maximum[0], maximum[1], maximum[2]));
+                }
+            };
+
+            bool AcquireThread()
+            {
+                int available = m_freeThreads.load();
+                while (available > 0)
+                {
+                    if (m_freeThreads.compare_exchange_weak(available, available - 1))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void ReleaseThread()
+            {
+                m_freeThreads++;
+            }
+
+            // Partitions primIndices in place so the first count entries satisfy goesLeft, accumulating child bounds.
+            template <typename GoesLeftFunc>
+            void Partition(const BuildRange& range, BuildRange* left, BuildRange* right, GoesLeftFunc&& goesLeft)
+            {
+                *left = BuildRange();
+                *right = BuildRange();
+                UINT* begin = m_primIndices + range.first;
+                UINT* end = begin + range.count;
+                while (begin < end)
+                {
+                    UINT prim = *begin;
+                    if (goesLeft(prim))
+                    {
+                        left->bounds.Grow(m_primBounds[prim]);
+                        left->centroidBounds.Grow(m_centroids[prim]);
+                        begin++;
+                    }
+                    else
+                    {
+                        right->bounds.Grow(m_primBounds[prim]);
+                        right->centroidBounds.Grow(m_centroids[prim]);
+                        std::swap(*begin, *--end);
+                    }
+                }
+                left->first = range.first;
+                left->count = static_cast<UINT>(begin - (m_primIndices + range.first));
+                right->first = left->first + left->count;
+                right->count = range.count - left->count;
+            }
+
+            // Chooses the best SAH plane over all three axes and partitions the range.
+            // Returns false if the range should become a leaf.
+            bool Split(const BuildRange& range, BuildRange* left, BuildRange* right)
+            {
+                const UINT binCount = m_settings.binCount;
+                const AABB& centroidBounds = range.centroidBounds;
+
+                float scale[3];
+                bool anyAxis = false;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    float extent = centroidBounds.maximum[axis] - centroidBounds.minimum[axis];
+                    scale[axis] = (extent > 0.0f) ? binCount / extent : 0.0f;
+                    anyAxis = anyAxis || extent > 0.0f;
+                }
+
+                if (!anyAxis)
+                {
+                    // All centroids coincide: fall back to an even split of oversized leaves.
+                    if (range.count <= m_settings.maxLeafSize)
+                    {
+                        return false;
+                    }
+                    UINT half = range.count / 2;
+                    UINT index = 0;
+                    Partition(range, left, right, [&](UINT) { return index++ < half; });
+                    return true;
+                }
+
+                // One pass over the primitives bins all three axes.
+                Bin bins[3][c_maxSahBins];
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    for (UINT b = 0; b < binCount; b++)
+                    {
+                        bins[axis][b].Reset();
+                    }
+                }
+
+                for (UINT i = range.first; i < range.first + range.count; i++)
+                {
+                    UINT prim = m_primIndices[i];
+                    const float3& centroid = m_centroids[prim];
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        UINT b = (std::min)(binCount - 1, static_cast<UINT>((centroid[axis] - centroidBounds.minimum[axis]) * scale[axis]));
+                        bins[axis][b].Grow(m_primBounds[prim]);
+                    }
+                }
+
+                float bestCost = c_infinity;
+                int bestAxis = -1;
+                UINT bestBin = 0;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    if (scale[axis] == 0.0f)
+                    {
+                        continue;
+                    }
+
+                    // Sweep from the right to collect suffix areas, then from the left to evaluate each plane.
+                    float rightArea[c_maxSahBins];
+                    UINT rightCount[c_maxSahBins];
+                    AABB accumulated;
+                    UINT accumulatedCount = 0;
+                    for (UINT b = binCount - 1; b > 0; b--)
+                    {
+                        accumulated.Grow(bins[axis][b].Bounds());
+                        accumulatedCount += bins[axis][b].count;
+                        rightArea[b] = accumulated.SurfaceArea();
+                        rightCount[b] = accumulatedCount;
+                    }
+
+                    accumulated = AABB();
+                    accumulatedCount = 0;
+                    for (UINT b = 0; b + 1 < binCount; b++)
+                    {
+                        accumulated.Grow(bins[axis][b].Bounds());
+                        accumulatedCount += bins[axis][b].count;
+                        if (accumulatedCount == 0 || rightCount[b + 1] == 0)
+                        {
+                            continue;
+                        }
+                        float cost = accumulated.SurfaceArea() * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+                        if (cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestBin = b;
+                        }
+                    }
+                }
+
+                if (bestAxis < 0)
+                {
+                    return false;
+                }
+
+                float area = range.bounds.SurfaceArea();
+                float leafCost = m_settings.intersectionCost * range.count;
+                float splitCost = m_settings.traversalCost + m_settings.intersectionCost * bestCost / (area > 0.0f ? area : 1.0f);
+                if (range.count <= m_settings.maxLeafSize && leafCost <= splitCost)
+                {
+                    return false;
+                }
+
+                const float axisScale = scale[bestAxis];
+                const float axisMinimum = centroidBounds.minimum[bestAxis];
+                Partition(range, left, right, [&](UINT prim)
+                {
+                    UINT b = (std::min)(binCount - 1, static_cast<UINT>((m_centroids[prim][bestAxis] - axisMinimum) * axisScale));
+                    return b <= bestBin;
+                });
+                return true;
+            }
+
+            const AABB* m_primBounds;
+            BinnedSahBuildSettings m_settings;
+            UINT* m_primIndices;
+            std::vector<float3> m_centroids;
+            std::atomic<int> m_freeThreads;
+        };
+    }
+
+    void BuildBvhBinnedSah(const AABB* primBounds, UINT primCount, const BinnedSahBuildSettings& settings, Bvh* bvh)
+    {
+        bvh->nodes.clear();
+        bvh->primIndices.resize(primCount);
+        if (primCount == 0)
+        {
+            return;
+        }
+
+        for (UINT i = 0; i < primCount; i++)
+        {
+            bvh->primIndices[i] = i;
+        }
+
+        BinnedSahBuilder builder(primBounds, primCount, settings, bvh->primIndices.data());
+        bvh->nodes.reserve(2 * static_cast<size_t>(primCount));
+        bvh->nodes.resize(1);
+        builder.BuildSubtree(bvh->nodes, 0, builder.GetRootRange(primCount), 0);
+    }
+
+    void BuildBvhBinnedSah(const CpuTriangleGeometryDesc& geometry, const BinnedSahBuildSettings& settings, Bvh* bvh)
+    {
+        std::vector<AABB> primBounds;
+        ComputeTriangleBounds(geometry, &primBounds);
+        BuildBvhBinnedSah(primBounds.data(), static_cast<UINT>(primBounds.size()), settings, bvh);
+    }
+
+    void BuildBvhBinnedSah(const CpuAABBGeometryDesc& geometry, const BinnedSahBuildSettings& settings, Bvh* bvh)
+    {
+        std::vector<AABB> primBounds;
+        ComputeAABBBounds(geometry, &primBounds);
+        BuildBvhBinnedSah(primBounds.data(), static_cast<UINT>(primBounds.size()), settings, bvh);
+    }
+}
@@ -0,0 +1,40 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Binned surface area heuristic BVH builder, the CPU analog of
+// D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE.
+
+#include "CpuBvh.h"
+#include "CpuGeometry.h"
+
+namespace CpuRT
+{
+    struct BinnedSahBuildSettings
+    {
+        UINT binCount = 16;             // Bins per axis, clamped to [2, c_maxSahBins].
+        UINT maxLeafSize = 4;           // Nodes with more primitives are always split.
+        float traversalCost = 1.0f;
+        float intersectionCost = 1.0f;
+        UINT numThreads = 0;            // 0 selects the hardware thread count, 1 builds serially.
+        UINT parallelThreshold = 16384; // Subtrees above this primitive count are built as separate tasks.
+    };
+
+    static const UINT c_maxSahBins = 256;
+
+    // Output is deterministic: it does not depend on numThreads.
+    void BuildBvhBinnedSah(const AABB* primBounds, UINT primCount, const BinnedSahBuildSettings& settings, Bvh* bvh);
+
+    // Convenience overloads over the framework's vertex/index or AABB buffers.
+    void BuildBvhBinnedSah(const CpuTriangleGeometryDesc& geometry, const BinnedSahBuildSettings& settings, Bvh* bvh);
+    void BuildBvhBinnedSah(const CpuAABBGeometryDesc& geometry, const BinnedSahBuildSettings& settings, Bvh* bvh);
+}
@@ -0,0 +1,235 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Bvh8.h"
+#include <cmath>
+
+namespace CpuRT
+{
+    namespace
+    {
+        inline float DecodeBound(float origin, UINT q, float scale)
+        {
+            return origin + static_cast<float>(q) * scale;
+        }
+
+        // Smallest power of two such that 255 steps cover extent.
+        float GetQuantizationScale(float extent)
+        {
+            int exponent;
+            std::frexp(extent / 255.0f, &exponent);
+            return std::ldexp(1.0f, exponent);
+        }
+
+        void QuantizeBounds(float minimum, float maximum, float origin, float scale, UINT8* qMin, UINT8* qMax)
+        {
+            // Start from the arithmetic estimate, then step outwards until the decoded values are conservative.
+            int lo = static_cast<int>(std::floor((minimum - origin) / scale));
+            int hi = static_cast<int>(std::ceil((maximum - origin) / scale));
+            lo = (std::min)((std::max)(lo, 0), 255);
+            hi = (std::min)((std::max)(hi, 0), 255);
+            while (lo > 0 && DecodeBound(origin, lo, scale) > minimum)
+            {
+                lo--;
+            }
+            while (hi < 255 && DecodeBound(origin, hi, scale) < maximum)
+            {
+                hi++;
+            }
+            *qMin = static_cast<UINT8>(lo);
+            *qMax = static_cast<UINT8>(hi);
+        }
+
+        void WriteNode(const Bvh& bvh, const UINT* children, UINT childCount, Bvh8Node* node)
+        {
+            for (UINT i = 0; i < c_bvh8Width; i++)
+            {
+                AABB bounds = (i < childCount) ? bvh.nodes[children[i]].bounds : AABB();
+                node->minX[i] = bounds.minimum.x;
+                node->minY[i] = bounds.minimum.y;
+                node->minZ[i] = bounds.minimum.z;
+                node->maxX[i] = bounds.maximum.x;
+                node->maxY[i] = bounds.maximum.y;
+                node->maxZ[i] = bounds.maximum.z;
+            }
+        }
+
+        void WriteNode(const Bvh& bvh, const UINT* children, UINT childCount, Bvh8QuantizedNode* node)
+        {
+            AABB nodeBounds;
+            for (UINT i = 0; i < childCount; i++)
+            {
+                nodeBounds.Grow(bvh.nodes[children[i]].bounds);
+            }
+            float3 extent = nodeBounds.Extent();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                node->origin[axis] = nodeBounds.minimum[axis];
+                node->scale[axis] = GetQuantizationScale(extent[axis]);
+            }
+
+            UINT8* qMin[3] = { node->qMinX, node->qMinY, node->qMinZ };
+            UINT8* qMax[3] = { node->qMaxX, node->qMaxY, node->qMaxZ };
+            for (UINT i = 0; i < c_bvh8Width; i++)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    if (i < childCount)
+                    {
+                        const AABB& bounds = bvh.nodes[children[i]].bounds;
+                        QuantizeBounds(bounds.minimum[axis], bounds.maximum[axis], node->origin[axis], node->scale[axis],
+                            &qMin[axis][i], &qMax[axis][i]);
+                    }
+                    else
+                    {
+                        qMin[axis][i] = 255;
+                        qMax[axis][i] = 0;
+                    }
+                }
+            }
+        }
+
+        template <typename Node>
+        void Collapse(const Bvh& bvh, std::vector<Node>* nodes)
+        {
+            // Binary node each BVH8 node was collapsed from, appended as nodes are discovered.
+            std::vector<UINT> sources(1, 0);
+            for (size_t n = 0; n < sources.size(); n++)
+            {
+                UINT children[c_bvh8Width];
+                UINT childCount = 0;
+                const BvhNode& source = bvh.nodes[sources[n]];
+                if (source.IsLeaf())
+                {
+                    children[childCount++] = sources[n];
+                }
+                else
+                {
+                    children[childCount++] = source.leftOrFirst;
+                    children[childCount++] = source.leftOrFirst + 1;
+                }
+
+                while (childCount < c_bvh8Width)
+                {
+                    int largest = -1;
+                    float largestArea = -1.0f;
+                    for (UINT i = 0; i < childCount; i++)
+                    {
+                        const BvhNode& child = bvh.nodes[children[i]];
+                        if (!child.IsLeaf() && child.bounds.SurfaceArea() > largestArea)
+                        {
+                            largest = static_cast<int>(i);
+                            largestArea = child.bounds.SurfaceArea();
+                        }
+                    }
+                    if (largest < 0)
+                    {
+                        break;
+                    }
+                    UINT opened = children[largest];
+                    children[largest] = bvh.nodes[opened].leftOrFirst;
+                    children[childCount++] = bvh.nodes[opened].leftOrFirst + 1;
+                }
+
+                Node node = {};
+                node.childCount = childCount;
+                for (UINT i = 0; i < childCount; i++)
+                {
+                    const BvhNode& child = bvh.nodes[children[i]];
+                    if (child.IsLeaf())
+                    {
+                        node.child[i] = child.leftOrFirst;
+                        node.primCount[i] = child.primCount;
+                    }
+                    else
+                    {
+                        node.child[i] = static_cast<UINT>(sources.size());
+                        sources.push_back(children[i]);
+                    }
+                }
+                WriteNode(bvh, children, childCount, &node);
+                nodes->push_back(node);
+            }
+        }
+    }
+
+    void CollapseBvh8(const Bvh& bvh, Bvh8Layout::Enum layout, Bvh8* bvh8)
+    {
+        bvh8->nodes.clear();
+        bvh8->quantizedNodes.clear();
+        bvh8->primIndices = bvh.primIndices;
+        if (bvh.IsEmpty())
+        {
+            return;
+        }
+
+        if (layout == Bvh8Layout::Quantized)
+        {
+            Collapse(bvh, &bvh8->quantizedNodes);
+        }
+        else
+        {
+            Collapse(bvh, &bvh8->nodes);
+        }
+    }
+
+    Bvh8Kernel::Enum GetDefaultBvh8Kernel()
+    {
+        return CpuSupportsAvx2() ? Bvh8Kernel::Avx2 : Bvh8Kernel::Scalar;
+    }
+
+    // Same operand order as IntersectRayAABB() so NaNs resolve identically.
+    UINT IntersectBvh8NodeScalar(const Bvh8Node& node, const Bvh8Ray& ray, float tMax, float* tEntries)
+    {
+        UINT hitMask = 0;
+        for (UINT i = 0; i < node.childCount; i++)
+        {
+            AABB box(float3(node.minX[i], node.minY[i], node.minZ[i]), float3(node.maxX[i], node.maxY[i], node.maxZ[i]));
+            if (IntersectRayAABB(ray.origin, ray.invDir, box, ray.tMin, tMax, &tEntries[i]))
+            {
+                hitMask |= 1u << i;
+            }
+        }
+        return hitMask;
+    }
+
+    UINT IntersectBvh8NodeScalar(const Bvh8QuantizedNode& node, const Bvh8Ray& ray, float tMax, float* tEntries)
+    {
+        UINT hitMask = 0;
+        for (UINT i = 0; i < node.childCount; i++)
+        {
+            AABB box(float3(DecodeBound(node.origin[0], node.qMinX[i], node.scale[0]),
+                    DecodeBound(node.origin[1], node.qMinY[i], node.scale[1]),
+                    DecodeBound(node.origin[2], node.qMinZ[i], node.scale[2])),
+                float3(DecodeBound(node.origin[0], node.qMaxX[i], node.scale[0]),
+                    DecodeBound(node.origin[1], node.qMaxY[i], node.scale[1]),
+                    DecodeBound(node.origin[2], node.qMaxZ[i], node.scale[2])));
+            if (IntersectRayAABB(ray.origin, ray.invDir, box, ray.tMin, tMax, &tEntries[i]))
+            {
+                hitMask |= 1u << i;
+            }
+        }
+        return hitMask;
+    }
+
+#if !GRFX_CPU_X86
+    // No AVX2 on this architecture; CpuSupportsAvx2() is false so these are never selected.
+    UINT IntersectBvh8NodeAvx2(const Bvh8Node& node, const Bvh8Ray& ray, float tMax, float* tEntries)
+    {
+        return IntersectBvh8NodeScalar(node, ray, tMax, tEntries);
+    }
+
+    UINT IntersectBvh8NodeAvx2(const Bvh8QuantizedNode& node, const Bvh8Ray& ray, float tMax, float* tEntries)
+    {
+        return IntersectBvh8NodeScalar(node, ray, tMax, tEntries);
+    }
+#endif
+}
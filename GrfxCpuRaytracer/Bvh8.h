@@ -0,0 +1,221 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// 8-wide BVH collapsed from a binary BVH. Child bounds are stored as structure of arrays so a ray is
+// tested against all children of a node with one 8-wide slab test. Nodes come in a float layout and a
+// quantized layout that stores child bounds as 8-bit offsets on a per-node power-of-two grid.
+
+#include "CpuBvh.h"
+#include "CpuFeatures.h"
+
+namespace CpuRT
+{
+    static const UINT c_bvh8Width = 8;
+
+    // Child slots [0, childCount) are valid. Leaf children store the first entry into Bvh8::primIndices
+    // and a non-zero primitive count, interior children a node index and a zero count.
+    struct alignas(32) Bvh8Node
+    {
+        float minX[c_bvh8Width];
+        float maxX[c_bvh8Width];
+        float minY[c_bvh8Width];
+        float maxY[c_bvh8Width];
+        float minZ[c_bvh8Width];
+        float maxZ[c_bvh8Width];
+        UINT child[c_bvh8Width];
+        UINT primCount[c_bvh8Width];
+        UINT childCount;
+    };
+
+    // Child bounds decode as origin + q * scale, rounded outwards when quantized so they stay conservative.
+    struct alignas(16) Bvh8QuantizedNode
+    {
+        float origin[3];
+        float scale[3];
+        UINT8 qMinX[c_bvh8Width];
+        UINT8 qMaxX[c_bvh8Width];
+        UINT8 qMinY[c_bvh8Width];
+        UINT8 qMaxY[c_bvh8Width];
+        UINT8 qMinZ[c_bvh8Width];
+        UINT8 qMaxZ[c_bvh8Width];
+        UINT child[c_bvh8Width];
+        UINT primCount[c_bvh8Width];
+        UINT childCount;
+    };
+
+    namespace Bvh8Layout
+    {
+        enum Enum
+        {
+            Float,
+            Quantized
+        };
+    }
+
+    namespace Bvh8Kernel
+    {
+        enum Enum
+        {
+            Scalar,
+            Avx2
+        };
+    }
+
+    // Only the node array of the chosen layout is populated.
+    struct Bvh8
+    {
+        std::vector<Bvh8Node> nodes;
+        std::vector<Bvh8QuantizedNode> quantizedNodes;
+        std::vector<UINT> primIndices;
+
+        bool IsEmpty() const { return nodes.empty() && quantizedNodes.empty(); }
+        bool IsQuantized() const { return !quantizedNodes.empty(); }
+        size_t GetNodeCount() const { return IsQuantized() ? quantizedNodes.size() : nodes.size(); }
+        size_t GetNodeSizeInBytes() const { return IsQuantized() ? sizeof(Bvh8QuantizedNode) : sizeof(Bvh8Node); }
+    };
+
+    // Each node takes up to eight children by repeatedly opening the interior child with the largest
+    // surface area. Leaves and primIndices are taken over from the binary BVH unchanged.
+    void CollapseBvh8(const Bvh& bvh, Bvh8Layout::Enum layout, Bvh8* bvh8);
+
+    // Avx2 when CpuSupportsAvx2(), Scalar otherwise.
+    Bvh8Kernel::Enum GetDefaultBvh8Kernel();
+
+    struct Bvh8Ray
+    {
+        float3 origin;
+        float3 invDir;
+        float tMin;
+    };
+
+    // Slab tests of a ray against all children of a node. Return a bit mask of the children entered
+    // before tMax and write their entry distances. Both kernels give bit-identical results, including
+    // the NaN handling of IntersectRayAABB(). The Avx2 kernels require CpuSupportsAvx2().
+    UINT IntersectBvh8NodeScalar(const Bvh8Node& node, const Bvh8Ray& ray, float tMax, float* tEntries);
+    UINT IntersectBvh8NodeScalar(const Bvh8QuantizedNode& node, const Bvh8Ray& ray, float tMax, float* tEntries);
+    UINT IntersectBvh8NodeAvx2(const Bvh8Node& node, const Bvh8Ray& ray, float tMax, float* tEntries);
+    UINT IntersectBvh8NodeAvx2(const Bvh8QuantizedNode& node, const Bvh8Ray& ray, float tMax, float* tEntries);
+
+    typedef UINT (*Bvh8IntersectNodeFunc)(const Bvh8Node&, const Bvh8Ray&, float, float*);
+    typedef UINT (*Bvh8IntersectQuantizedNodeFunc)(const Bvh8QuantizedNode&, const Bvh8Ray&, float, float*);
+
+    // Closest-first traversal over one node layout from the child slot rootChild/rootPrimCount (0/0 for the root
+    // node), see TraverseBvh().
+    template <typename Node, typename IntersectPrimitiveFunc>
+    bool TraverseBvh8Nodes(const std::vector<Node>& nodes,
+        const std::vector<UINT>& primIndices,
+        UINT rootChild,
+        UINT rootPrimCount,
+        const Ray& ray,
+        float& tMax,
+        UINT (*intersectNode)(const Node&, const Bvh8Ray&, float, float*),
+        IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        struct StackEntry
+        {
+            UINT child;
+            UINT primCount;
+            float tEntry;
+        };
+
+        // Every node visit replaces one entry with at most eight.
+        const UINT c_stackSize = c_bvh8Width * c_maxBvhDepth;
+        StackEntry stack[c_stackSize];
+        UINT stackSize = 0;
+        stack[stackSize++] = { rootChild, rootPrimCount, ray.tMin };
+
+        const Bvh8Ray nodeRay = { ray.origin, rcp(ray.direction), ray.tMin };
+
+        while (stackSize > 0)
+        {
+            StackEntry entry = stack[--stackSize];
+            if (entry.tEntry > tMax * c_slabFarScale)
+            {
+                continue;
+            }
+
+            if (entry.primCount != 0)
+            {
+                for (UINT i = 0; i < entry.primCount; i++)
+                {
+                    if (intersectPrimitive(primIndices[entry.child + i], tMax))
+                    {
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            const Node& node = nodes[entry.child];
+            float tEntries[c_bvh8Width];
+            UINT hitMask = intersectNode(node, nodeRay, tMax, tEntries);
+
+            // Sort the entered children far to near so the nearest is popped next.
+            StackEntry hits[c_bvh8Width];
+            UINT hitCount = 0;
+            for (UINT i = 0; i < c_bvh8Width; i++)
+            {
+                if (hitMask & (1u << i))
+                {
+                    StackEntry hit = { node.child[i], node.primCount[i], tEntries[i] };
+                    UINT j = hitCount++;
+                    while (j > 0 && hits[j - 1].tEntry < hit.tEntry)
+                    {
+                        hits[j] = hits[j - 1];
+                        j--;
+                    }
+                    hits[j] = hit;
+                }
+            }
+            for (UINT i = 0; i < hitCount; i++)
+            {
+                stack[stackSize++] = hits[i];
+            }
+        }
+        return false;
+    }
+
+    // Traversal of the subtree in the child slot rootChild/rootPrimCount of a node, which the caller has entered.
+    template <typename IntersectPrimitiveFunc>
+    bool TraverseBvh8Subtree(const Bvh8& bvh, UINT rootChild, UINT rootPrimCount, const Ray& ray, float& tMax,
+        Bvh8Kernel::Enum kernel, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        if (bvh.IsQuantized())
+        {
+            Bvh8IntersectQuantizedNodeFunc intersectNode = IntersectBvh8NodeScalar;
+            if (kernel == Bvh8Kernel::Avx2)
+            {
+                intersectNode = IntersectBvh8NodeAvx2;
+            }
+            return TraverseBvh8Nodes(bvh.quantizedNodes, bvh.primIndices, rootChild, rootPrimCount, ray, tMax, intersectNode,
+                intersectPrimitive);
+        }
+
+        Bvh8IntersectNodeFunc intersectNode = IntersectBvh8NodeScalar;
+        if (kernel == Bvh8Kernel::Avx2)
+        {
+            intersectNode = IntersectBvh8NodeAvx2;
+        }
+        return TraverseBvh8Nodes(bvh.nodes, bvh.primIndices, rootChild, rootPrimCount, ray, tMax, intersectNode, intersectPrimitive);
+    }
+
+    template <typename IntersectPrimitiveFunc>
+    bool TraverseBvh8(const Bvh8& bvh, const Ray& ray, float& tMax, Bvh8Kernel::Enum kernel, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        if (bvh.IsEmpty())
+        {
+            return false;
+        }
+        return TraverseBvh8Subtree(bvh, 0, 0, ray, tMax, kernel, intersectPrimitive);
+    }
+}
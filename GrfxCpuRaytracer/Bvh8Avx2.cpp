@@ -0,0 +1,78 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// AVX2 kernels for Bvh8.h. Only this translation unit uses AVX2 instructions; callers select it at
+// runtime through GetDefaultBvh8Kernel().
+
+#include "Bvh8.h"
+
+#if GRFX_CPU_X86
+#include <immintrin.h>
+
+namespace CpuRT
+{
+    namespace
+    {
+        // Operand order of the min/max intrinsics mirrors IntersectRayAABB(): _mm256_min_ps(a, b) and
+        // _mm256_max_ps(a, b) return b when a comparison involves NaN, as (std::min) and (std::max) do.
+        GRFX_TARGET_AVX2 inline void SlabAxis(__m256 lo, __m256 hi, __m256 origin, __m256 invDir, __m256& tNear, __m256& tFar)
+        {
+            __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(lo, origin), invDir);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(hi, origin), invDir);
+            tNear = _mm256_max_ps(_mm256_min_ps(t1, t0), tNear);
+            tFar = _mm256_min_ps(_mm256_max_ps(t1, t0), tFar);
+        }
+
+        GRFX_TARGET_AVX2 inline UINT FinishSlabs(__m256 tNear, __m256 tFar, UINT childCount, float* tEntries)
+        {
+            _mm256_storeu_ps(tEntries, tNear);
+            tFar = _mm256_mul_ps(tFar, _mm256_set1_ps(c_slabFarScale));
+            UINT hitMask = static_cast<UINT>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+            return hitMask & ((1u << childCount) - 1);
+        }
+
+        // Decodes origin + q * scale for eight 8-bit offsets. Multiply and add stay separate to match the scalar decode.
+        GRFX_TARGET_AVX2 inline __m256 DecodeBounds(const UINT8* q, __m256 origin, __m256 scale)
+        {
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(q));
+            __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+            return _mm256_add_ps(origin, _mm256_mul_ps(values, scale));
+        }
+    }
+
+    GRFX_TARGET_AVX2 UINT IntersectBvh8NodeAvx2(const Bvh8Node& node, const Bvh8Ray& ray, float tMax, float* tEntries)
+    {
+        __m256 tNear = _mm256_set1_ps(ray.tMin);
+        __m256 tFar = _mm256_set1_ps(tMax);
+        SlabAxis(_mm256_load_ps(node.minX), _mm256_load_ps(node.maxX), _mm256_set1_ps(ray.origin.x), _mm256_set1_ps(ray.invDir.x), tNear, tFar);
+        SlabAxis(_mm256_load_ps(node.minY), _mm256_load_ps(node.maxY), _mm256_set1_ps(ray.origin.y), _mm256_set1_ps(ray.invDir.y), tNear, tFar);
+        SlabAxis(_mm256_load_ps(node.minZ), _mm256_load_ps(node.maxZ), _mm256_set1_ps(ray.origin.z), _mm256_set1_ps(ray.invDir.z), tNear, tFar);
+        return FinishSlabs(tNear, tFar, node.childCount, tEntries);
+    }
+
+    GRFX_TARGET_AVX2 UINT IntersectBvh8NodeAvx2(const Bvh8QuantizedNode& node, const Bvh8Ray& ray, float tMax, float* tEntries)
+    {
+        __m256 tNear = _mm256_set1_ps(ray.tMin);
+        __m256 tFar = _mm256_set1_ps(tMax);
+
+        const UINT8* qMin[3] = { node.qMinX, node.qMinY, node.qMinZ };
+        const UINT8* qMax[3] = { node.qMaxX, node.qMaxY, node.qMaxZ };
+        for (int axis = 0; axis < 3; axis++)
+        {
+            __m256 origin = _mm256_set1_ps(node.origin[axis]);
+            __m256 scale = _mm256_set1_ps(node.scale[axis]);
+            SlabAxis(DecodeBounds(qMin[axis], origin, scale), DecodeBounds(qMax[axis], origin, scale),
+                _mm256_set1_ps(ray.origin[axis]), _mm256_set1_ps(ray.invDir[axis]), tNear, tFar);
+        }
+        return FinishSlabs(tNear, tFar, node.childCount, tEntries);
+    }
+}
+#endif
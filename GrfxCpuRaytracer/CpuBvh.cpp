@@ -0,0 +1,150 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuBvh.h"
+
+namespace CpuRT
+{
+    float Bvh::SahCost(float traversalCost, float intersectionCost) const
+    {
+        if (IsEmpty())
+        {
+            return 0.0f;
+        }
+
+        float rootArea = nodes[0].bounds.SurfaceArea();
+        if (rootArea <= 0.0f)
+        {
+            return intersectionCost * static_cast<float>(primIndices.size());
+        }
+
+        double cost = 0.0;
+        for (const BvhNode& node : nodes)
+        {
+            double area = node.bounds.SurfaceArea();
+            cost += node.IsLeaf() ? area * intersectionCost * node.primCount : area * traversalCost;
+        }
+        return static_cast<float>(cost / rootArea);
+    }
+
+    UINT Bvh::Depth() const
+    {
+        if (IsEmpty())
+        {
+            return 0;
+        }
+
+        UINT maxDepth = 0;
+        std::vector<std::pair<UINT, UINT>> stack;
+        stack.push_back({ 0, 1 });
+        while (!stack.empty())
+        {
+            auto entry = stack.back();
+            stack.pop_back();
+            const BvhNode& node = nodes[entry.first];
+            maxDepth = (std::max)(maxDepth, entry.second);
+            if (!node.IsLeaf())
+            {
+                stack.push_back({ node.leftOrFirst, entry.second + 1 });
+                stack.push_back({ node.leftOrFirst + 1, entry.second + 1 });
+            }
+        }
+        return maxDepth;
+    }
+
+    void SpliceBvhSubtree(std::vector<BvhNode>* nodes, UINT rootIndex, const std::vector<BvhNode>& subtree)
+    {
+        // Subtree-local index i >= 1 maps to offset + i - 1.
+        UINT offset = static_cast<UINT>(nodes->size());
+        for (size_t i = 1; i < subtree.size(); i++)
+        {
+            BvhNode node = subtree[i];
+            if (!node.IsLeaf())
+            {
+                node.leftOrFirst = offset + node.leftOrFirst - 1;
+            }
+            nodes->push_back(node);
+        }
+        BvhNode& root = (*nodes)[rootIndex];
+        if (!root.IsLeaf())
+        {
+            root.leftOrFirst = offset + root.leftOrFirst - 1;
+        }
+    }
+
+    void BuildBvhMedianSplit(const AABB* primBounds, UINT primCount, UINT maxLeafSize, Bvh* bvh)
+    {
+        bvh->nodes.clear();
+        bvh->primIndices.resize(primCount);
+        if (primCount == 0)
+        {
+            return;
+        }
+        maxLeafSize = (std::max)(maxLeafSize, 1u);
+
+        std::vector<float3> centroids(primCount);
+        for (UINT i = 0; i < primCount; i++)
+        {
+            bvh->primIndices[i] = i;
+            centroids[i] = primBounds[i].Center();
+        }
+
+        bvh->nodes.reserve(2 * primCount);
+        bvh->nodes.push_back(BvhNode());
+
+        struct BuildTask
+        {
+            UINT nodeIndex;
+            UINT first;
+            UINT count;
+        };
+        std::vector<BuildTask> tasks;
+        tasks.push_back({ 0, 0, primCount });
+
+        while (!tasks.empty())
+        {
+            BuildTask task = tasks.back();
+            tasks.pop_back();
+
+            AABB bounds;
+            AABB centroidBounds;
+            for (UINT i = task.first; i < task.first + task.count; i++)
+            {
+                UINT prim = bvh->primIndices[i];
+                bounds.Grow(primBounds[prim]);
+                centroidBounds.Grow(centroids[prim]);
+            }
+            bvh->nodes[task.nodeIndex].bounds = bounds;
+
+            int axis = centroidBounds.LargestAxis();
+            if (task.count <= maxLeafSize || centroidBounds.Extent()[axis] <= 0.0f)
+            {
+                bvh->nodes[task.nodeIndex].leftOrFirst = task.first;
+                bvh->nodes[task.nodeIndex].primCount = task.count;
+                continue;
+            }
+
+            UINT half = task.count / 2;
+            auto begin = bvh->primIndices.begin() + task.first;
+            std::nth_element(begin, begin + half, begin + task.count,
+                [&](UINT a, UINT b) { return centroids[a][axis] < centroids[b][axis]; });
+
+            UINT left = static_cast<UINT>(bvh->nodes.size());
+            bvh->nodes.push_back(BvhNode());
+            bvh->nodes.push_back(BvhNode());
+            bvh->nodes[task.nodeIndex].leftOrFirst = left;
+            bvh->nodes[task.nodeIndex].primCount = 0;
+
+            tasks.push_back({ left, task.first, half });
+            tasks.push_back({ left + 1, task.first + half, task.count - half });
+        }
+    }
+}
@@ -0,0 +1,157 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "CpuMath.h"
+#include <vector>
+
+namespace CpuRT
+{
+    // Builders stop splitting at this depth so traversal stacks stay bounded.
+    static const UINT c_maxBvhDepth = 64;
+
+    // Binary BVH node. Interior nodes store the index of their left child, the right child follows it.
+    // Leaves store the first entry into Bvh::primIndices and a non-zero primitive count.
+    // All builders store children after their parent, so a reverse sweep visits children first.
+    struct BvhNode
+    {
+        AABB bounds;
+        UINT leftOrFirst;
+        UINT primCount;
+
+        bool IsLeaf() const { return primCount != 0; }
+    };
+
+    struct Bvh
+    {
+        std::vector<BvhNode> nodes;
+        std::vector<UINT> primIndices;
+
+        bool IsEmpty() const { return nodes.empty(); }
+        const AABB& Bounds() const { return nodes[0].bounds; }
+
+        // Expected cost of a random ray under the surface area heuristic, normalized by the root area.
+        float SahCost(float traversalCost = 1.0f, float intersectionCost = 1.0f) const;
+        UINT Depth() const;
+    };
+
+    // Appends a subtree built into its own node array (root at subtree[0]) to nodes. The root itself must
+    // already be copied to nodes[rootIndex]; its child link is rebased along with those of subtree[1..].
+    // Used by the parallel builders to merge independently built subtrees.
+    void SpliceBvhSubtree(std::vector<BvhNode>* nodes, UINT rootIndex, const std::vector<BvhNode>& subtree);
+
+    // Reference builder: splits at the object median of the largest centroid axis.
+    void BuildBvhMedianSplit(const AABB* primBounds, UINT primCount, UINT maxLeafSize, Bvh* bvh);
+
+    // Far distances are scaled by 1 + 2 * gamma(3) before the slab comparison so rounding never rejects
+    // a primitive lying on a box face, e.g. the axis aligned faces of the samples' cube (Ize 2013,
+    // "Robust BVH Ray Traversal").
+    static const float c_slabFarScale = 1.0000004f;
+
+    // Slab test. NaNs from 0 * inf are ignored by the min/max argument order.
+    inline bool IntersectRayAABB(const float3& origin, const float3& invDir, const AABB& box, float tMin, float tMax, float* tEntry)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float t0 = (box.minimum[axis] - origin[axis]) * invDir[axis];
+            float t1 = (box.maximum[axis] - origin[axis]) * invDir[axis];
+            tMin = (std::max)(tMin, (std::min)(t0, t1));
+            tMax = (std::min)(tMax, (std::max)(t0, t1));
+        }
+        *tEntry = tMin;
+        return tMin <= tMax * c_slabFarScale;
+    }
+
+    // Closest-first traversal of the subtree at rootIndex, which the caller has not culled. cullNode(nodeIndex)
+    // returns true to skip a node and its subtree before its bounds are tested. intersectPrimitive(primIndex, tMax)
+    // tests one primitive, shrinks tMax on a committed hit and returns true to terminate the search (e.g. accept
+    // first hit). Returns true if traversal was terminated early.
+    template <typename CullNodeFunc, typename IntersectPrimitiveFunc>
+    bool TraverseBvhSubtree(const Bvh& bvh, UINT rootIndex, const float3& origin, const float3& invDir, float tMin, float& tMax,
+        CullNodeFunc&& cullNode, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        const UINT c_stackSize = 2 * c_maxBvhDepth;
+        UINT stack[c_stackSize];
+        UINT stackSize = 0;
+
+        float tEntry;
+        if (!IntersectRayAABB(origin, invDir, bvh.nodes[rootIndex].bounds, tMin, tMax, &tEntry))
+        {
+            return false;
+        }
+        stack[stackSize++] = rootIndex;
+
+        while (stackSize > 0)
+        {
+            const BvhNode& node = bvh.nodes[stack[--stackSize]];
+
+            if (node.IsLeaf())
+            {
+                for (UINT i = 0; i < node.primCount; i++)
+                {
+                    if (intersectPrimitive(bvh.primIndices[node.leftOrFirst + i], tMax))
+                    {
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            UINT left = node.leftOrFirst;
+            UINT right = left + 1;
+            float tLeft, tRight;
+            bool hitLeft = !cullNode(left) && IntersectRayAABB(origin, invDir, bvh.nodes[left].bounds, tMin, tMax, &tLeft);
+            bool hitRight = !cullNode(right) && IntersectRayAABB(origin, invDir, bvh.nodes[right].bounds, tMin, tMax, &tRight);
+
+            // Push the farther child first so the nearer one is visited next.
+            if (hitLeft && hitRight)
+            {
+                if (tLeft <= tRight)
+                {
+                    stack[stackSize++] = right;
+                    stack[stackSize++] = left;
+                }
+                else
+                {
+                    stack[stackSize++] = left;
+                    stack[stackSize++] = right;
+                }
+            }
+            else if (hitLeft)
+            {
+                stack[stackSize++] = left;
+            }
+            else if (hitRight)
+            {
+                stack[stackSize++] = right;
+            }
+        }
+        return false;
+    }
+
+    // Closest-first traversal of the whole BVH, see TraverseBvhSubtree().
+    template <typename CullNodeFunc, typename IntersectPrimitiveFunc>
+    bool TraverseBvh(const Bvh& bvh, const Ray& ray, float& tMax, CullNodeFunc&& cullNode, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        if (bvh.IsEmpty() || cullNode(0u))
+        {
+            return false;
+        }
+        return TraverseBvhSubtree(bvh, 0, ray.origin, rcp(ray.direction), ray.tMin, tMax, cullNode, intersectPrimitive);
+    }
+
+    template <typename IntersectPrimitiveFunc>
+    bool TraverseBvh(const Bvh& bvh, const Ray& ray, float& tMax, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        return TraverseBvh(bvh, ray, tMax, [](UINT) { return false; }, intersectPrimitive);
+    }
+}
@@ -0,0 +1,126 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuDispatchRays.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <stdexcept>
+
+namespace CpuRT
+{
+    namespace
+    {
+        UINT DivideRoundUp(UINT a, UINT b) { return (a + b - 1) / b; }
+    }
+
+    UINT GetDispatchTileCount(const CpuDispatchRaysDesc& desc)
+    {
+        if (desc.tileWidth == 0 || desc.tileHeight == 0)
+        {
+            throw std::invalid_argument("DispatchRays tile size must be non-zero");
+        }
+        UINT64 tileCount = static_cast<UINT64>(DivideRoundUp(desc.width, desc.tileWidth)) *
+            DivideRoundUp(desc.height, desc.tileHeight) * desc.depth;
+        if (tileCount > UINT_MAX)
+        {
+            throw std::invalid_argument("DispatchRays grid has too many tiles");
+        }
+        return static_cast<UINT>(tileCount);
+    }
+
+    void DispatchRayTiles(const CpuDispatchRaysDesc& desc, const CpuDispatchTileFunc& tileFunc, CpuThreadPool* pool,
+        std::vector<CpuTileTiming>* tileTimings)
+    {
+        const UINT tileCount = GetDispatchTileCount(desc);
+        const UINT tilesX = DivideRoundUp(desc.width, desc.tileWidth);
+        const UINT tilesY = DivideRoundUp(desc.height, desc.tileHeight);
+        if (tileTimings)
+        {
+            tileTimings->resize(tileCount);
+        }
+
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point dispatchStart = Clock::now();
+        auto ToUs = [](Clock::duration duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+
+        pool->Run(tileCount, [&](UINT tileIndex, UINT threadIndex)
+        {
+            const UINT tileX = tileIndex % tilesX;
+            const UINT tileY = (tileIndex / tilesX) % tilesY;
+            const UINT z = tileIndex / (tilesX * tilesY);
+            const UINT x0 = tileX * desc.tileWidth;
+            const UINT y0 = tileY * desc.tileHeight;
+            const UINT x1 = (std::min)(x0 + desc.tileWidth, desc.width);
+            const UINT y1 = (std::min)(y0 + desc.tileHeight, desc.height);
+
+            Clock::time_point tileStart;
+            if (tileTimings)
+            {
+                tileStart = Clock::now();
+            }
+
+            tileFunc({ x0, y0, z, x1 - x0, y1 - y0 });
+
+            if (tileTimings)
+            {
+                // Each tile owns its entry, so no synchronization is needed.
+                Clock::time_point tileEnd = Clock::now();
+                CpuTileTiming& timing = (*tileTimings)[tileIndex];
+                timing.x = x0;
+                timing.y = y0;
+                timing.z = z;
+                timing.width = x1 - x0;
+                timing.height = y1 - y0;
+                timing.threadIndex = threadIndex;
+                timing.startUs = ToUs(tileStart - dispatchStart);
+                timing.durationUs = ToUs(tileEnd - tileStart);
+            }
+        });
+    }
+
+    void DispatchRaysTiled(const CpuDispatchRaysDesc& desc, const CpuDispatchRaygenFunc& raygen, CpuThreadPool* pool,
+        std::vector<CpuTileTiming>* tileTimings)
+    {
+        DispatchRayTiles(desc, [&](const CpuDispatchTile& tile)
+        {
+            for (UINT y = tile.y; y < tile.y + tile.height; y++)
+            {
+                for (UINT x = tile.x; x < tile.x + tile.width; x++)
+                {
+                    raygen(x, y, tile.z);
+                }
+            }
+        }, pool, tileTimings);
+    }
+
+    bool SaveTileTimingsCsv(const char* fileName, const std::vector<CpuTileTiming>& tileTimings)
+    {
+        FILE* file = fopen(fileName, "w");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        bool success = fprintf(file, "x,y,z,width,height,thread,start_us,duration_us\n") > 0;
+        for (const CpuTileTiming& timing : tileTimings)
+        {
+            if (!success)
+            {
+                break;
+            }
+            success = fprintf(file, "%u,%u,%u,%u,%u,%u,%.1f,%.1f\n", timing.x, timing.y, timing.z,
+                timing.width, timing.height, timing.threadIndex, timing.startUs, timing.durationUs) > 0;
+        }
+
+        return (fclose(file) == 0) && success;
+    }
+}
@@ -0,0 +1,76 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Tiled DispatchRays() emulation. The Width x Height x Depth grid of D3D12_DISPATCH_RAYS_DESC is cut
+// into tiles that run on a work-stealing CpuThreadPool, so expensive tiles (e.g. ones covering SDF
+// procedural primitives) are balanced across threads. Per-tile timings can be recorded and dumped.
+
+#include "CpuThreadPool.h"
+#include <vector>
+
+namespace CpuRT
+{
+    struct CpuDispatchRaysDesc
+    {
+        UINT width = 0;
+        UINT height = 0;
+        UINT depth = 1;
+        UINT tileWidth = 16;
+        UINT tileHeight = 16;
+    };
+
+    // Raygen stand-in invoked once per DispatchRaysIndex(). Like a raygen shader it writes its
+    // results itself, e.g. into a CpuImage standing in for the output UAV.
+    typedef std::function<void(UINT x, UINT y, UINT z)> CpuDispatchRaygenFunc;
+
+    // Region of the grid handed to a tile callback.
+    struct CpuDispatchTile
+    {
+        UINT x;
+        UINT y;
+        UINT z;
+        UINT width;             // Smaller than the tile size at the right and bottom edges.
+        UINT height;
+    };
+
+    // Invoked once per tile, e.g. to trace the tile's rays as packets.
+    typedef std::function<void(const CpuDispatchTile& tile)> CpuDispatchTileFunc;
+
+    struct CpuTileTiming
+    {
+        UINT x;                 // First DispatchRaysIndex() of the tile.
+        UINT y;
+        UINT z;
+        UINT width;             // Tile size, smaller at the right and bottom edges.
+        UINT height;
+        UINT threadIndex;       // Pool thread that ran the tile.
+        double startUs;         // Start time relative to the start of the dispatch.
+        double durationUs;
+    };
+
+    // Number of tiles DispatchRaysTiled() splits desc into, the size of its timing output.
+    UINT GetDispatchTileCount(const CpuDispatchRaysDesc& desc);
+
+    // Runs raygen for every index of the grid and returns when all tiles have finished. Tiles are
+    // numbered row-major within each depth slice. If tileTimings is not null it is resized to
+    // GetDispatchTileCount(desc) and filled in tile order. Exceptions from raygen are rethrown.
+    void DispatchRaysTiled(const CpuDispatchRaysDesc& desc, const CpuDispatchRaygenFunc& raygen, CpuThreadPool* pool,
+        std::vector<CpuTileTiming>* tileTimings = nullptr);
+
+    // DispatchRaysTiled() with a callback per tile instead of per DispatchRaysIndex().
+    void DispatchRayTiles(const CpuDispatchRaysDesc& desc, const CpuDispatchTileFunc& tileFunc, CpuThreadPool* pool,
+        std::vector<CpuTileTiming>* tileTimings = nullptr);
+
+    // Writes the timings as CSV, one row per tile. Returns false if the file cannot be written.
+    bool SaveTileTimingsCsv(const char* fileName, const std::vector<CpuTileTiming>& tileTimings);
+}
@@ -0,0 +1,92 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuFeatures.h"
+
+#if GRFX_CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace CpuRT
+{
+    namespace
+    {
+#if GRFX_CPU_X86
+        void CpuId(UINT leaf, UINT subleaf, UINT registers[4])
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; i++)
+            {
+                registers[i] = static_cast<UINT>(info[i]);
+            }
+#else
+            __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+        }
+
+        UINT64 GetXcr0()
+        {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            UINT eax, edx;
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<UINT64>(edx) << 32) | eax;
+#endif
+        }
+
+        bool DetectAvx2()
+        {
+            UINT registers[4];
+            CpuId(0, 0, registers);
+            if (registers[0] < 7)
+            {
+                return false;
+            }
+
+            // Leaf 1 ECX: OSXSAVE (27), AVX (28).
+            CpuId(1, 0, registers);
+            const UINT c_leaf1Bits = (1u << 27) | (1u << 28);
+            if ((registers[2] & c_leaf1Bits) != c_leaf1Bits)
+            {
+                return false;
+            }
+
+            // The OS must save XMM and YMM state.
+            if ((GetXcr0() & 0x6) != 0x6)
+            {
+                return false;
+            }
+
+            // Leaf 7 EBX: AVX2 (5).
+            CpuId(7, 0, registers);
+            return (registers[1] & (1u << 5)) != 0;
+        }
+#else
+        bool DetectAvx2()
+        {
+            return false;
+        }
+#endif
+    }
+
+    bool CpuSupportsAvx2()
+    {
+        static const bool s_supported = DetectAvx2();
+        return s_supported;
+    }
+}
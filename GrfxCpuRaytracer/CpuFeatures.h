@@ -0,0 +1,57 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Runtime CPU feature detection for the SIMD kernels.
+//
+// SIMD kernels live in their own translation units and mark each function with the matching
+// GRFX_TARGET_* attribute, so the rest of the library builds for the baseline instruction set
+// and callers pick a kernel at runtime.
+
+#include "D3D12Compat.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GRFX_CPU_X86 1
+#else
+#define GRFX_CPU_X86 0
+#endif
+
+// MSVC accepts AVX2 intrinsics in any function, GCC and Clang need the target attribute.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GRFX_TARGET_AVX2
+#else
+#define GRFX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// AVX2 helpers that return 256-bit vectors by value. Without -mavx, GCC clears the upper halves of
+// the YMM registers before an out-of-line AVX2 function returns, which loses half of the result, so
+// these helpers are always inlined into their AVX2 callers.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GRFX_INLINE_AVX2 __forceinline
+#else
+#define GRFX_INLINE_AVX2 inline __attribute__((always_inline, target("avx2")))
+#endif
+
+// Functions whose inlining decides whether their callers fold constants through them, e.g. the per-type
+// distance functions of the specialized sphere tracers.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GRFX_FORCEINLINE __forceinline
+#else
+#define GRFX_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+namespace CpuRT
+{
+    // True if the CPU and OS support AVX2 (CPUID leaves 1 and 7 plus XGETBV for YMM state).
+    // Evaluated once; always false on non-x86 hosts.
+    bool CpuSupportsAvx2();
+}
@@ -0,0 +1,44 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuGeometry.h"
+#include <stdexcept>
+
+namespace CpuRT
+{
+    void ComputeTriangleBounds(const CpuTriangleGeometryDesc& desc, std::vector<AABB>* primBounds)
+    {
+        UINT triangleCount = GetTriangleCount(desc);
+        primBounds->resize(triangleCount);
+        for (UINT i = 0; i < triangleCount; i++)
+        {
+            float3 v0, v1, v2;
+            if (!LoadTriangle(desc, i, &v0, &v1, &v2))
+            {
+                throw std::out_of_range("Vertex index out of range.");
+            }
+            AABB& box = (*primBounds)[i];
+            box = AABB();
+            box.Grow(v0);
+            box.Grow(v1);
+            box.Grow(v2);
+        }
+    }
+
+    void ComputeAABBBounds(const CpuAABBGeometryDesc& desc, std::vector<AABB>* primBounds)
+    {
+        primBounds->resize(desc.aabbCount);
+        for (UINT i = 0; i < desc.aabbCount; i++)
+        {
+            (*primBounds)[i] = AABB(LoadAABB(desc, i));
+        }
+    }
+}
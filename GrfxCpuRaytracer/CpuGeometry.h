@@ -0,0 +1,98 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// CPU views of the geometry buffers a sample passes to BuildAccelerationStructures().
+
+#include "CpuMath.h"
+#include <cstring>
+#include <vector>
+
+namespace CpuRT
+{
+    enum class CpuIndexFormat
+    {
+        None,
+        R16_UINT,
+        R32_UINT
+    };
+
+    // Equivalent of D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC with CPU pointers.
+    // Vertices are read as three floats at the start of each stride (DXGI_FORMAT_R32G32B32_FLOAT).
+    struct CpuTriangleGeometryDesc
+    {
+        const void* vertexData;
+        UINT vertexCount;
+        UINT vertexStrideInBytes;
+        const void* indexData;
+        UINT indexCount;
+        CpuIndexFormat indexFormat;
+    };
+
+    // Equivalent of D3D12_RAYTRACING_GEOMETRY_AABBS_DESC with CPU pointers.
+    struct CpuAABBGeometryDesc
+    {
+        const D3D12_RAYTRACING_AABB* aabbs;
+        UINT aabbCount;
+        UINT strideInBytes;
+    };
+
+    inline UINT GetTriangleCount(const CpuTriangleGeometryDesc& desc)
+    {
+        return ((desc.indexFormat == CpuIndexFormat::None) ? desc.vertexCount : desc.indexCount) / 3;
+    }
+
+    inline float3 LoadVertex(const CpuTriangleGeometryDesc& desc, UINT index)
+    {
+        float v[3];
+        memcpy(v, static_cast<const UINT8*>(desc.vertexData) + static_cast<size_t>(index) * desc.vertexStrideInBytes, sizeof(v));
+        return float3(v[0], v[1], v[2]);
+    }
+
+    inline UINT LoadIndex(const CpuTriangleGeometryDesc& desc, UINT i)
+    {
+        switch (desc.indexFormat)
+        {
+        case CpuIndexFormat::R16_UINT: return static_cast<const UINT16*>(desc.indexData)[i];
+        case CpuIndexFormat::R32_UINT: return static_cast<const UINT*>(desc.indexData)[i];
+        default: return i;
+        }
+    }
+
+    // Returns false if an index references a vertex past vertexCount.
+    inline bool LoadTriangle(const CpuTriangleGeometryDesc& desc, UINT triangleIndex, float3* v0, float3* v1, float3* v2)
+    {
+        UINT i0 = LoadIndex(desc, triangleIndex * 3);
+        UINT i1 = LoadIndex(desc, triangleIndex * 3 + 1);
+        UINT i2 = LoadIndex(desc, triangleIndex * 3 + 2);
+        if (i0 >= desc.vertexCount || i1 >= desc.vertexCount || i2 >= desc.vertexCount)
+        {
+            return false;
+        }
+        *v0 = LoadVertex(desc, i0);
+        *v1 = LoadVertex(desc, i1);
+        *v2 = LoadVertex(desc, i2);
+        return true;
+    }
+
+    inline D3D12_RAYTRACING_AABB LoadAABB(const CpuAABBGeometryDesc& desc, UINT index)
+    {
+        UINT stride = desc.strideInBytes ? desc.strideInBytes : sizeof(D3D12_RAYTRACING_AABB);
+        D3D12_RAYTRACING_AABB box;
+        memcpy(&box, reinterpret_cast<const UINT8*>(desc.aabbs) + static_cast<size_t>(index) * stride, sizeof(box));
+        return box;
+    }
+
+    // Per-primitive bounds, the input of the BVH builders.
+    void ComputeTriangleBounds(const CpuTriangleGeometryDesc& desc, std::vector<AABB>* primBounds);
+    void ComputeAABBBounds(const CpuAABBGeometryDesc& desc, std::vector<AABB>* primBounds);
+}
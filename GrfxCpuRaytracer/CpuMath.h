@@ -0,0 +1,420 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// HLSL-flavoured vector math for the CPU raytracer.
+// Type and function names follow HLSL so shader code can be ported with minimal edits.
+
+#include "D3D12Compat.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace CpuRT
+{
+    static const float c_infinity = std::numeric_limits<float>::infinity();
+
+    struct float2
+    {
+        float x, y;
+
+        float2() : x(0), y(0) {}
+        explicit float2(float s) : x(s), y(s) {}
+        float2(float _x, float _y) : x(_x), y(_y) {}
+
+        float  operator[](int i) const { return (&x)[i]; }
+        float& operator[](int i) { return (&x)[i]; }
+    };
+
+    struct float3
+    {
+        float x, y, z;
+
+        float3() : x(0), y(0), z(0) {}
+        explicit float3(float s) : x(s), y(s), z(s) {}
+        float3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+
+        float  operator[](int i) const { return (&x)[i]; }
+        float& operator[](int i) { return (&x)[i]; }
+
+        float3& operator+=(const float3& b) { x += b.x; y += b.y; z += b.z; return *this; }
+        float3& operator-=(const float3& b) { x -= b.x; y -= b.y; z -= b.z; return *this; }
+        float3& operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+    };
+
+    struct float4
+    {
+        float x, y, z, w;
+
+        float4() : x(0), y(0), z(0), w(0) {}
+        explicit float4(float s) : x(s), y(s), z(s), w(s) {}
+        float4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+        float4(const float3& v, float _w) : x(v.x), y(v.y), z(v.z), w(_w) {}
+
+        float3 xyz() const { return float3(x, y, z); }
+        float  operator[](int i) const { return (&x)[i]; }
+        float& operator[](int i) { return (&x)[i]; }
+    };
+
+    struct uint3
+    {
+        UINT x, y, z;
+
+        uint3() : x(0), y(0), z(0) {}
+        uint3(UINT _x, UINT _y, UINT _z) : x(_x), y(_y), z(_z) {}
+    };
+
+    inline float2 operator+(const float2& a, const float2& b) { return float2(a.x + b.x, a.y + b.y); }
+    inline float2 operator-(const float2& a, const float2& b) { return float2(a.x - b.x, a.y - b.y); }
+    inline float2 operator*(const float2& a, float s) { return float2(a.x * s, a.y * s); }
+    inline float2 operator*(const float2& a, const float2& b) { return float2(a.x * b.x, a.y * b.y); }
+
+    inline float3 operator-(const float3& a) { return float3(-a.x, -a.y, -a.z); }
+    inline float3 operator+(const float3& a, const float3& b) { return float3(a.x + b.x, a.y + b.y, a.z + b.z); }
+    inline float3 operator-(const float3& a, const float3& b) { return float3(a.x - b.x, a.y - b.y, a.z - b.z); }
+    inline float3 operator*(const float3& a, const float3& b) { return float3(a.x * b.x, a.y * b.y, a.z * b.z); }
+    inline float3 operator/(const float3& a, const float3& b) { return float3(a.x / b.x, a.y / b.y, a.z / b.z); }
+    inline float3 operator*(const float3& a, float s) { return float3(a.x * s, a.y * s, a.z * s); }
+    inline float3 operator*(float s, const float3& a) { return float3(a.x * s, a.y * s, a.z * s); }
+    inline float3 operator/(const float3& a, float s) { return a * (1.0f / s); }
+    inline float3 operator+(const float3& a, float s) { return float3(a.x + s, a.y + s, a.z + s); }
+    inline float3 operator-(const float3& a, float s) { return float3(a.x - s, a.y - s, a.z - s); }
+
+    inline float4 operator+(const float4& a, const float4& b) { return float4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); }
+    inline float4 operator-(const float4& a, const float4& b) { return float4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w); }
+    inline float4 operator*(const float4& a, const float4& b) { return float4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w); }
+    inline float4 operator*(const float4& a, float s) { return float4(a.x * s, a.y * s, a.z * s, a.w * s); }
+    inline float4 operator*(float s, const float4& a) { return a * s; }
+
+    inline float dot(const float3& a, const float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline float3 cross(const float3& a, const float3& b)
+    {
+        return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+    inline float length(const float3& a) { return std::sqrt(dot(a, a)); }
+    inline float dot(const float2& a, const float2& b) { return a.x * b.x + a.y * b.y; }
+    inline float length(const float2& a) { return std::sqrt(dot(a, a)); }
+    inline float2 abs(const float2& a) { return float2(std::fabs(a.x), std::fabs(a.y)); }
+    inline float2 max(const float2& a, const float2& b) { return float2((std::max)(a.x, b.x), (std::max)(a.y, b.y)); }
+    inline float3 normalize(const float3& a) { return a * (1.0f / length(a)); }
+    inline float3 abs(const float3& a) { return float3(std::fabs(a.x), std::fabs(a.y), std::fabs(a.z)); }
+    inline float3 min(const float3& a, const float3& b) { return float3((std::min)(a.x, b.x), (std::min)(a.y, b.y), (std::min)(a.z, b.z)); }
+    inline float3 max(const float3& a, const float3& b) { return float3((std::max)(a.x, b.x), (std::max)(a.y, b.y), (std::max)(a.z, b.z)); }
+    inline float3 rcp(const float3& a) { return float3(1.0f / a.x, 1.0f / a.y, 1.0f / a.z); }
+    inline float min3(const float3& a) { return (std::min)((std::min)(a.x, a.y), a.z); }
+    inline float max3(const float3& a) { return (std::max)((std::max)(a.x, a.y), a.z); }
+    inline float saturate(float a) { return (std::min)((std::max)(a, 0.0f), 1.0f); }
+    inline float smoothstep(float a, float b, float x) { float t = saturate((x - a) / (b - a)); return t * t * (3.0f - 2.0f * t); }
+    inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
+    inline float2 lerp(const float2& a, const float2& b, const float2& t) { return float2(lerp(a.x, b.x, t.x), lerp(a.y, b.y, t.y)); }
+    inline float3 lerp(const float3& a, const float3& b, float t) { return a + (b - a) * t; }
+    inline float4 lerp(const float4& a, const float4& b, float t) { return a + (b - a) * t; }
+
+    // Axis aligned bounding box.
+    struct AABB
+    {
+        float3 minimum;
+        float3 maximum;
+
+        AABB() : minimum(c_infinity), maximum(-c_infinity) {}
+        AABB(const float3& mn, const float3& mx) : minimum(mn), maximum(mx) {}
+        explicit AABB(const D3D12_RAYTRACING_AABB& box) :
+            minimum(box.MinX, box.MinY, box.MinZ),
+            maximum(box.MaxX, box.MaxY, box.MaxZ) {}
+
+        void Grow(const float3& p) { minimum = min(minimum, p); maximum = max(maximum, p); }
+        void Grow(const AABB& b) { minimum = min(minimum, b.minimum); maximum = max(maximum, b.maximum); }
+        bool IsEmpty() const { return minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z; }
+        float3 Center() const { return (minimum + maximum) * 0.5f; }
+        float3 Extent() const { return maximum - minimum; }
+        int LargestAxis() const
+        {
+            float3 e = Extent();
+            return (e.x >= e.y && e.x >= e.z) ? 0 : (e.y >= e.z ? 1 : 2);
+        }
+        float SurfaceArea() const
+        {
+            if (IsEmpty())
+            {
+                return 0.0f;
+            }
+            float3 e = Extent();
+            return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+    };
+
+    // Ray as described by HLSL's RayDesc.
+    struct Ray
+    {
+        float3 origin;
+        float tMin;
+        float3 direction;
+        float tMax;
+
+        Ray() : tMin(0.0f), tMax(c_infinity) {}
+        Ray(const float3& o, const float3& d, float _tMin = 0.0f, float _tMax = c_infinity) :
+            origin(o), tMin(_tMin), direction(d), tMax(_tMax) {}
+    };
+
+    // Row-major 3x4 affine transform with the same layout as D3D12_RAYTRACING_INSTANCE_DESC::Transform,
+    // i.e. column vectors: p' = M * float4(p, 1).
+    struct Transform3x4
+    {
+        float m[3][4];
+
+        Transform3x4()
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    m[r][c] = (r == c) ? 1.0f : 0.0f;
+                }
+            }
+        }
+
+        explicit Transform3x4(const DirectX::XMFLOAT3X4& t)
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    m[r][c] = t.m[r][c];
+                }
+            }
+        }
+
+        float3 TransformPoint(const float3& p) const
+        {
+            return float3(
+                m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+        }
+
+        float3 TransformVector(const float3& v) const
+        {
+            return float3(
+                m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+        }
+
+        float Determinant() const
+        {
+            return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                 - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                 + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        }
+
+        // General affine inverse. Singular transforms return a zero linear part.
+        Transform3x4 Inverse() const
+        {
+            Transform3x4 inv;
+            float det = Determinant();
+            float invDet = (det != 0.0f) ? 1.0f / det : 0.0f;
+
+            inv.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * invDet;
+            inv.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+            inv.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+            inv.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * invDet;
+            inv.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+            inv.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+            inv.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * invDet;
+            inv.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+            inv.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
+            float3 t(m[0][3], m[1][3], m[2][3]);
+            float3 it = inv.TransformVector(t);
+            inv.m[0][3] = -it.x;
+            inv.m[1][3] = -it.y;
+            inv.m[2][3] = -it.z;
+            return inv;
+        }
+
+        // Bounds of the transformed box (Arvo's method).
+        AABB TransformBounds(const AABB& box) const
+        {
+            AABB result;
+            for (int r = 0; r < 3; r++)
+            {
+                float lo = m[r][3];
+                float hi = m[r][3];
+                for (int c = 0; c < 3; c++)
+                {
+                    float a = m[r][c] * box.minimum[c];
+                    float b = m[r][c] * box.maximum[c];
+                    lo += (std::min)(a, b);
+                    hi += (std::max)(a, b);
+                }
+                result.minimum[r] = lo;
+                result.maximum[r] = hi;
+            }
+            return result;
+        }
+    };
+
+    // Row-major 4x4 matrix using DirectXMath's row-vector convention: p' = p * M.
+    struct float4x4
+    {
+        float m[4][4];
+
+        float4x4()
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    m[r][c] = (r == c) ? 1.0f : 0.0f;
+                }
+            }
+        }
+
+        float4 TransformRowVector(const float4& v) const
+        {
+            float4 result;
+            for (int c = 0; c < 4; c++)
+            {
+                result[c] = v.x * m[0][c] + v.y * m[1][c] + v.z * m[2][c] + v.w * m[3][c];
+            }
+            return result;
+        }
+
+        float4x4 Transpose() const
+        {
+            float4x4 t;
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    t.m[r][c] = m[c][r];
+                }
+            }
+            return t;
+        }
+
+        friend float4x4 operator*(const float4x4& a, const float4x4& b)
+        {
+            float4x4 result;
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+                }
+            }
+            return result;
+        }
+
+        // Gauss-Jordan inverse with partial pivoting. Singular matrices return identity.
+        float4x4 Inverse() const
+        {
+            double a[4][8];
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    a[r][c] = m[r][c];
+                    a[r][c + 4] = (r == c) ? 1.0 : 0.0;
+                }
+            }
+
+            for (int col = 0; col < 4; col++)
+            {
+                int pivot = col;
+                for (int r = col + 1; r < 4; r++)
+                {
+                    if (std::fabs(a[r][col]) > std::fabs(a[pivot][col]))
+                    {
+                        pivot = r;
+                    }
+                }
+                if (a[pivot][col] == 0.0)
+                {
+                    return float4x4();
+                }
+                if (pivot != col)
+                {
+                    for (int c = 0; c < 8; c++)
+                    {
+                        std::swap(a[pivot][c], a[col][c]);
+                    }
+                }
+                double invPivot = 1.0 / a[col][col];
+                for (int c = 0; c < 8; c++)
+                {
+                    a[col][c] *= invPivot;
+                }
+                for (int r = 0; r < 4; r++)
+                {
+                    if (r != col)
+                    {
+                        double f = a[r][col];
+                        for (int c = 0; c < 8; c++)
+                        {
+                            a[r][c] -= f * a[col][c];
+                        }
+                    }
+                }
+            }
+
+            float4x4 inv;
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    inv.m[r][c] = static_cast<float>(a[r][c + 4]);
+                }
+            }
+            return inv;
+        }
+
+        // Equivalent of XMMatrixLookAtLH.
+        static float4x4 LookAtLH(const float3& eye, const float3& at, const float3& up)
+        {
+            float3 zAxis = normalize(at - eye);
+            float3 xAxis = normalize(cross(up, zAxis));
+            float3 yAxis = cross(zAxis, xAxis);
+
+            float4x4 view;
+            for (int i = 0; i < 3; i++)
+            {
+                view.m[i][0] = xAxis[i];
+                view.m[i][1] = yAxis[i];
+                view.m[i][2] = zAxis[i];
+                view.m[i][3] = 0.0f;
+            }
+            view.m[3][0] = -dot(xAxis, eye);
+            view.m[3][1] = -dot(yAxis, eye);
+            view.m[3][2] = -dot(zAxis, eye);
+            view.m[3][3] = 1.0f;
+            return view;
+        }
+
+        // Equivalent of XMMatrixPerspectiveFovLH.
+        static float4x4 PerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+        {
+            float height = 1.0f / std::tan(0.5f * fovAngleY);
+            float width = height / aspectRatio;
+            float range = farZ / (farZ - nearZ);
+
+            float4x4 proj;
+            proj.m[0][0] = width;
+            proj.m[1][1] = height;
+            proj.m[2][2] = range;
+            proj.m[2][3] = 1.0f;
+            proj.m[3][2] = -range * nearZ;
+            proj.m[3][3] = 0.0f;
+            return proj;
+        }
+    };
+}
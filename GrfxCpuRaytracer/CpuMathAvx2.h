@@ -0,0 +1,159 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Eight float lanes in AVX2 registers, with the operators and functions of CpuMath.h the SIMD kernels need.
+// Every function rounds like its scalar counterpart, so a kernel written with them operation by operation matches
+// its scalar version bit for bit. min and max keep the operand order of std::min and std::max. cos, sin, atan2
+// and pow have no AVX2 instruction and are evaluated per lane with the same library calls as scalar code.
+//
+// Only for translation units that run AVX2 code: every function is GRFX_INLINE_AVX2 and callers must
+// check CpuSupportsAvx2().
+
+#include "CpuMath.h"
+#include "CpuFeatures.h"
+
+#if GRFX_CPU_X86
+#include <immintrin.h>
+
+namespace CpuRT
+{
+    // Eight float lanes. Comparisons return lane masks, all bits set where true.
+    struct float8
+    {
+        __m256 v;
+    };
+
+    // float2 and float3 of eight lanes in structure-of-arrays layout.
+    struct float2x8
+    {
+        float8 x, y;
+    };
+
+    struct float3x8
+    {
+        float8 x, y, z;
+    };
+
+    GRFX_INLINE_AVX2 float8 Splat(float s) { return { _mm256_set1_ps(s) }; }
+    GRFX_INLINE_AVX2 float8 Load8(const float* p) { return { _mm256_load_ps(p) }; }
+    GRFX_INLINE_AVX2 void Store8(float* p, const float8& a) { _mm256_store_ps(p, a.v); }
+    GRFX_INLINE_AVX2 float3x8 Load8(const float (*p)[8]) { return { Load8(p[0]), Load8(p[1]), Load8(p[2]) }; }
+    GRFX_INLINE_AVX2 float3x8 Splat(const float3& a) { return { Splat(a.x), Splat(a.y), Splat(a.z) }; }
+    GRFX_INLINE_AVX2 UINT MoveMask(const float8& mask) { return static_cast<UINT>(_mm256_movemask_ps(mask.v)); }
+
+    // Lane mask with lane i set where bit i of bits is set.
+    GRFX_INLINE_AVX2 float8 LaneMask(UINT bits)
+    {
+        const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), laneBits), laneBits)) };
+    }
+
+    // mask ? a : b per lane.
+    GRFX_INLINE_AVX2 float8 Select(const float8& mask, const float8& a, const float8& b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+    GRFX_INLINE_AVX2 float3x8 Select(const float8& mask, const float3x8& a, const float3x8& b)
+    {
+        return { Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z) };
+    }
+
+    GRFX_INLINE_AVX2 float8 operator+(const float8& a, const float8& b) { return { _mm256_add_ps(a.v, b.v) }; }
+    GRFX_INLINE_AVX2 float8 operator-(const float8& a, const float8& b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    GRFX_INLINE_AVX2 float8 operator*(const float8& a, const float8& b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    GRFX_INLINE_AVX2 float8 operator/(const float8& a, const float8& b) { return { _mm256_div_ps(a.v, b.v) }; }
+    GRFX_INLINE_AVX2 float8 operator+(const float8& a, float s) { return a + Splat(s); }
+    GRFX_INLINE_AVX2 float8 operator-(const float8& a, float s) { return a - Splat(s); }
+    GRFX_INLINE_AVX2 float8 operator*(const float8& a, float s) { return a * Splat(s); }
+    GRFX_INLINE_AVX2 float8 operator/(const float8& a, float s) { return a / Splat(s); }
+    GRFX_INLINE_AVX2 float8 operator+(float s, const float8& a) { return Splat(s) + a; }
+    GRFX_INLINE_AVX2 float8 operator-(float s, const float8& a) { return Splat(s) - a; }
+    GRFX_INLINE_AVX2 float8 operator*(float s, const float8& a) { return Splat(s) * a; }
+    GRFX_INLINE_AVX2 float8 operator-(const float8& a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+
+    GRFX_INLINE_AVX2 float8 operator<(const float8& a, const float8& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    GRFX_INLINE_AVX2 float8 operator<=(const float8& a, const float8& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+    GRFX_INLINE_AVX2 float8 operator>(const float8& a, const float8& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    GRFX_INLINE_AVX2 float8 operator>=(const float8& a, const float8& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+    GRFX_INLINE_AVX2 float8 operator==(const float8& a, const float8& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+    GRFX_INLINE_AVX2 float8 operator!=(const float8& a, const float8& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ) }; }
+    GRFX_INLINE_AVX2 float8 operator&(const float8& a, const float8& b) { return { _mm256_and_ps(a.v, b.v) }; }
+    GRFX_INLINE_AVX2 float8 operator|(const float8& a, const float8& b) { return { _mm256_or_ps(a.v, b.v) }; }
+    GRFX_INLINE_AVX2 float8 AndNot(const float8& mask, const float8& a) { return { _mm256_andnot_ps(mask.v, a.v) }; }
+
+    // (std::min)(a, b) and (std::max)(a, b).
+    GRFX_INLINE_AVX2 float8 min(const float8& a, const float8& b) { return { _mm256_min_ps(b.v, a.v) }; }
+    GRFX_INLINE_AVX2 float8 max(const float8& a, const float8& b) { return { _mm256_max_ps(b.v, a.v) }; }
+    GRFX_INLINE_AVX2 float8 min(const float8& a, float s) { return min(a, Splat(s)); }
+    GRFX_INLINE_AVX2 float8 max(const float8& a, float s) { return max(a, Splat(s)); }
+    GRFX_INLINE_AVX2 float8 abs(const float8& a) { return AndNot(Splat(-0.0f), a); }
+    GRFX_INLINE_AVX2 float8 sqrt(const float8& a) { return { _mm256_sqrt_ps(a.v) }; }
+    GRFX_INLINE_AVX2 float8 floor(const float8& a) { return { _mm256_floor_ps(a.v) }; }
+    GRFX_INLINE_AVX2 float8 clamp(const float8& x, float minimum, float maximum) { return min(max(x, minimum), maximum); }
+    GRFX_INLINE_AVX2 float8 sign(const float8& x)
+    {
+        return Select(x > Splat(0.0f), Splat(1.0f), Select(x < Splat(0.0f), Splat(-1.0f), Splat(0.0f)));
+    }
+    GRFX_INLINE_AVX2 float8 lerp(const float8& a, const float8& b, const float8& t) { return a + (b - a) * t; }
+
+    // Library functions without an AVX2 instruction, evaluated lane by lane.
+    template <typename Func>
+    GRFX_INLINE_AVX2 float8 PerLane(const float8& a, Func func)
+    {
+        alignas(32) float lanes[8];
+        Store8(lanes, a);
+        for (float& lane : lanes)
+        {
+            lane = func(lane);
+        }
+        return Load8(lanes);
+    }
+
+    GRFX_INLINE_AVX2 float8 cos(const float8& a) { return PerLane(a, [](float x) { return std::cos(x); }); }
+    GRFX_INLINE_AVX2 float8 sin(const float8& a) { return PerLane(a, [](float x) { return std::sin(x); }); }
+    GRFX_INLINE_AVX2 float8 pow(const float8& a, float e) { return PerLane(a, [e](float x) { return std::pow(x, e); }); }
+    GRFX_INLINE_AVX2 float8 atan2(const float8& y, const float8& x)
+    {
+        alignas(32) float yLanes[8], xLanes[8];
+        Store8(yLanes, y);
+        Store8(xLanes, x);
+        for (int i = 0; i < 8; i++)
+        {
+            yLanes[i] = std::atan2(yLanes[i], xLanes[i]);
+        }
+        return Load8(yLanes);
+    }
+
+    GRFX_INLINE_AVX2 float2x8 operator*(const float2x8& a, const float2x8& b) { return { a.x * b.x, a.y * b.y }; }
+    GRFX_INLINE_AVX2 float2x8 operator-(const float2x8& a, const float2& b) { return { a.x - b.x, a.y - b.y }; }
+    GRFX_INLINE_AVX2 float8 dot(const float2x8& a, const float2x8& b) { return a.x * b.x + a.y * b.y; }
+    GRFX_INLINE_AVX2 float8 dot(const float2x8& a, const float2& b) { return a.x * b.x + a.y * b.y; }
+    GRFX_INLINE_AVX2 float8 length(const float2x8& a) { return sqrt(dot(a, a)); }
+    GRFX_INLINE_AVX2 float2x8 abs(const float2x8& a) { return { abs(a.x), abs(a.y) }; }
+    GRFX_INLINE_AVX2 float2x8 max(const float2x8& a, float s) { return { max(a.x, s), max(a.y, s) }; }
+
+    GRFX_INLINE_AVX2 float3x8 operator+(const float3x8& a, const float3x8& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    GRFX_INLINE_AVX2 float3x8 operator-(const float3x8& a, const float3x8& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    GRFX_INLINE_AVX2 float3x8 operator+(const float3x8& a, const float3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    GRFX_INLINE_AVX2 float3x8 operator-(const float3x8& a, const float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    GRFX_INLINE_AVX2 float3x8 operator*(const float3x8& a, const float3& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+    GRFX_INLINE_AVX2 float3x8 operator/(const float3x8& a, const float3& b) { return { a.x / Splat(b.x), a.y / Splat(b.y), a.z / Splat(b.z) }; }
+    GRFX_INLINE_AVX2 float3x8 operator+(const float3x8& a, float s) { return { a.x + s, a.y + s, a.z + s }; }
+    GRFX_INLINE_AVX2 float3x8 operator*(const float3x8& a, const float8& s) { return { a.x * s, a.y * s, a.z * s }; }
+    GRFX_INLINE_AVX2 float3x8 operator*(const float3x8& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    GRFX_INLINE_AVX2 float3x8 operator*(const float3& a, const float8& s) { return { a.x * s, a.y * s, a.z * s }; }
+    GRFX_INLINE_AVX2 float8 dot(const float3x8& a, const float3x8& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    GRFX_INLINE_AVX2 float8 dot(const float3x8& a, const float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    GRFX_INLINE_AVX2 float8 length(const float3x8& a) { return sqrt(dot(a, a)); }
+    GRFX_INLINE_AVX2 float3x8 normalize(const float3x8& a) { return a * (Splat(1.0f) / length(a)); }
+    GRFX_INLINE_AVX2 float3x8 abs(const float3x8& a) { return { abs(a.x), abs(a.y), abs(a.z) }; }
+    GRFX_INLINE_AVX2 float3x8 max(const float3x8& a, float s) { return { max(a.x, s), max(a.y, s), max(a.z, s) }; }
+}
+#endif
@@ -0,0 +1,134 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuRayPacket.h"
+
+namespace CpuRT
+{
+    void PacketTraversalRays::ComputeBounds()
+    {
+        m_originBounds = AABB();
+        m_invDirectionMin = float3(c_infinity, c_infinity, c_infinity);
+        m_invDirectionMax = float3(-c_infinity, -c_infinity, -c_infinity);
+        m_minTMin = c_infinity;
+
+        int positive[3] = {};
+        int negative[3] = {};
+        int zero[3] = {};
+        int rayCount = 0;
+        for (UINT64 mask = activeMask; mask; mask &= mask - 1)
+        {
+            const UINT i = LowestSetBit(mask);
+            m_originBounds.Grow(GetOrigin(i));
+            m_invDirectionMin = min(m_invDirectionMin, GetInvDirection(i));
+            m_invDirectionMax = max(m_invDirectionMax, GetInvDirection(i));
+            m_minTMin = (std::min)(m_minTMin, tMin[i]);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                // Directions small enough for an infinite reciprocal cannot be bounded by intervals.
+                float d = direction[axis][i];
+                float inv = invDirection[axis][i];
+                positive[axis] += (d > 0.0f && inv < c_infinity) ? 1 : 0;
+                negative[axis] += (d < 0.0f && inv > -c_infinity) ? 1 : 0;
+                zero[axis] += (d == 0.0f) ? 1 : 0;
+            }
+            rayCount++;
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            m_axisClass[axis] = (positive[axis] == rayCount) ? 1 :
+                (negative[axis] == rayCount) ? -1 :
+                (zero[axis] == rayCount) ? 2 : 0;
+        }
+    }
+
+    float PacketTraversalRays::MaxTMax() const
+    {
+        float packetTMax = -c_infinity;
+        for (UINT64 mask = activeMask; mask; mask &= mask - 1)
+        {
+            packetTMax = (std::max)(packetTMax, tMax[LowestSetBit(mask)]);
+        }
+        return packetTMax;
+    }
+
+    UINT64 PacketTraversalRays::IntersectBox(const AABB& box, UINT64 rayMask) const
+    {
+        // IntersectRayAABB() for every ray with the same operations and min/max operand order, written
+        // without branches so the loop vectorizes.
+        bool hit[c_rayPacketSize];
+        for (UINT i = 0; i < count; i++)
+        {
+            float entry = tMin[i];
+            float exit = tMax[i];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float t0 = (box.minimum[axis] - origin[axis][i]) * invDirection[axis][i];
+                float t1 = (box.maximum[axis] - origin[axis][i]) * invDirection[axis][i];
+                float tNear = (t1 < t0) ? t1 : t0;
+                float tFar = (t0 < t1) ? t1 : t0;
+                entry = (entry < tNear) ? tNear : entry;
+                exit = (tFar < exit) ? tFar : exit;
+            }
+            hit[i] = entry <= exit * c_slabFarScale;
+        }
+
+        UINT64 hitMask = 0;
+        for (UINT64 mask = rayMask; mask; mask &= mask - 1)
+        {
+            const UINT i = LowestSetBit(mask);
+            hitMask |= static_cast<UINT64>(hit[i]) << i;
+        }
+        return hitMask;
+    }
+
+    bool PacketTraversalRays::CullBox(const AABB& box, float packetTMax) const
+    {
+        // Float subtraction and multiplication round monotonically, so the extremes of the products over
+        // the corners of the origin and reciprocal direction intervals bound every ray's slab distances.
+        float entry = m_minTMin;
+        float exit = packetTMax;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const int axisClass = m_axisClass[axis];
+            if (axisClass == 0)
+            {
+                continue;
+            }
+            if (axisClass == 2)
+            {
+                // Rays parallel to the slab only enter it if their origin lies within it.
+                if (m_originBounds.maximum[axis] < box.minimum[axis] || m_originBounds.minimum[axis] > box.maximum[axis])
+                {
+                    return true;
+                }
+                continue;
+            }
+
+            const float nearPlane = (axisClass > 0) ? box.minimum[axis] : box.maximum[axis];
+            const float farPlane = (axisClass > 0) ? box.maximum[axis] : box.minimum[axis];
+            const float invMin = m_invDirectionMin[axis];
+            const float invMax = m_invDirectionMax[axis];
+
+            float nearLow = nearPlane - m_originBounds.maximum[axis];
+            float nearHigh = nearPlane - m_originBounds.minimum[axis];
+            float farLow = farPlane - m_originBounds.maximum[axis];
+            float farHigh = farPlane - m_originBounds.minimum[axis];
+
+            float entryLow = (std::min)((std::min)(nearLow * invMin, nearLow * invMax), (std::min)(nearHigh * invMin, nearHigh * invMax));
+            float exitHigh = (std::max)((std::max)(farLow * invMin, farLow * invMax), (std::max)(farHigh * invMin, farHigh * invMax));
+            entry = (std::max)(entry, entryLow);
+            exit = (std::min)(exit, exitHigh);
+        }
+        return entry > exit * c_slabFarScale;
+    }
+}
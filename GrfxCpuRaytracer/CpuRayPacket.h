@@ -0,0 +1,379 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Packet traversal for coherent rays, e.g. the primary rays of an 8x8 pixel tile.
+//
+// A packet descends a BVH as long as any of its rays enters a node. Each node is first tested against
+// the first active ray, then culled for the whole packet with interval arithmetic over the ray origins
+// and reciprocal directions, and only then tested ray by ray. Once few rays are left in a subtree they
+// finish it as single rays, which is also how divergent rays end up being traced. TraverseBvhPacket()
+// walks a binary BVH such as the TLAS, TraverseBvh8Packet() the 8-wide BLAS BVHs.
+
+#include "Bvh8.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace CpuRT
+{
+    static const UINT c_rayPacketWidth = 8;
+    static const UINT c_rayPacketHeight = 8;
+    static const UINT c_rayPacketSize = c_rayPacketWidth * c_rayPacketHeight;
+
+    // Subtrees entered by fewer rays than this are traversed one ray at a time.
+    static const UINT c_rayPacketMinActiveRays = 4;
+
+    // BLASes with more primitives than this are traversed one ray at a time. Their leaves are small against the
+    // footprint of a packet, which splits up below the top levels and then only adds overhead (packettrace
+    // benchmark: packets win up to about 100k triangles and lose 0.6x at 300k and 1M).
+    static const size_t c_rayPacketMaxBlasPrimitives = 1 << 17;
+
+    inline UINT LowestSetBit(UINT64 mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<UINT>(index);
+#else
+        return static_cast<UINT>(__builtin_ctzll(mask));
+#endif
+    }
+
+    inline UINT CountSetBits(UINT64 mask)
+    {
+        UINT count = 0;
+        for (; mask; mask &= mask - 1)
+        {
+            count++;
+        }
+        return count;
+    }
+
+    // Rays of a tile of up to 8x8 pixels starting at DispatchRaysIndex() (x, y). Ray i belongs to pixel
+    // (x + i % width, y + i / width).
+    struct RayPacket
+    {
+        UINT x;
+        UINT y;
+        UINT width;
+        UINT height;
+        Ray rays[c_rayPacketSize];
+
+        UINT GetRayCount() const { return width * height; }
+    };
+
+    // Rays of a packet in the space of the BVH being traversed, in structure-of-arrays form so the per-ray
+    // loops vectorize, plus conservative bounds of the packet for culling.
+    struct alignas(32) PacketTraversalRays
+    {
+        float origin[3][c_rayPacketSize];
+        float direction[3][c_rayPacketSize];
+        float invDirection[3][c_rayPacketSize];
+        float tMin[c_rayPacketSize];
+        float tMax[c_rayPacketSize];
+        UINT count;
+        UINT64 activeMask;      // Rays still searching; cleared when a ray terminates.
+
+        void SetRay(UINT index, const float3& rayOrigin, const float3& rayDirection, float rayTMin, float rayTMax)
+        {
+            const float3 rayInvDirection = rcp(rayDirection);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                origin[axis][index] = rayOrigin[axis];
+                direction[axis][index] = rayDirection[axis];
+                invDirection[axis][index] = rayInvDirection[axis];
+            }
+            tMin[index] = rayTMin;
+            tMax[index] = rayTMax;
+        }
+
+        float3 GetOrigin(UINT index) const { return float3(origin[0][index], origin[1][index], origin[2][index]); }
+        float3 GetDirection(UINT index) const { return float3(direction[0][index], direction[1][index], direction[2][index]); }
+        float3 GetInvDirection(UINT index) const { return float3(invDirection[0][index], invDirection[1][index], invDirection[2][index]); }
+
+        // Computes the culling bounds over the active rays. Call after the rays are set.
+        void ComputeBounds();
+
+        // Largest tMax of the active rays, refreshed by the traversal as hits shrink them.
+        float MaxTMax() const;
+
+        bool RayIntersectsBox(UINT index, const AABB& box) const
+        {
+            float tEntry;
+            return IntersectRayAABB(GetOrigin(index), GetInvDirection(index), box, tMin[index], tMax[index], &tEntry);
+        }
+
+        // Mask of the rays in rayMask for which RayIntersectsBox() is true, computed for all rays at once.
+        UINT64 IntersectBox(const AABB& box, UINT64 rayMask) const;
+
+        // False if no axis separates the rays by direction sign, in which case CullBox() never culls.
+        bool HasCullingBounds() const { return m_axisClass[0] != 0 || m_axisClass[1] != 0 || m_axisClass[2] != 0; }
+
+        // True if no active ray can enter the box. Conservative: never culls a box that RayIntersectsBox()
+        // accepts for any active ray whose tMax is at most packetTMax.
+        bool CullBox(const AABB& box, float packetTMax) const;
+
+    private:
+        // Per axis: 1 if every direction is positive, -1 if every direction is negative, 2 if every direction
+        // is zero and 0 otherwise, in which case the axis does not contribute to culling.
+        int m_axisClass[3];
+        AABB m_originBounds;
+        float3 m_invDirectionMin;
+        float3 m_invDirectionMax;
+        float m_minTMin;
+    };
+
+    // Closest-first packet traversal. cullNode(nodeIndex) follows the TraverseBvh() contract.
+    // intersectPrimitive(primIndex, rayMask) tests the primitive against the rays in rayMask, shrinks
+    // rays->tMax of rays with a committed hit and returns the mask of rays whose search terminates.
+    template <typename CullNodeFunc, typename IntersectPrimitiveFunc>
+    void TraverseBvhPacket(const Bvh& bvh, PacketTraversalRays* rays, CullNodeFunc&& cullNode, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        if (bvh.IsEmpty() || rays->activeMask == 0 || cullNode(0u))
+        {
+            return;
+        }
+
+        // Each entry holds the lowest ray that may still enter the node; rays below it are known to miss.
+        struct StackEntry
+        {
+            UINT nodeIndex;
+            UINT firstRay;
+        };
+        const UINT c_stackSize = 2 * c_maxBvhDepth;
+        StackEntry stack[c_stackSize];
+        UINT stackSize = 0;
+        stack[stackSize++] = { 0, 0 };
+        float packetTMax = rays->MaxTMax();
+
+        while (stackSize > 0)
+        {
+            const StackEntry entry = stack[--stackSize];
+            const BvhNode& node = bvh.nodes[entry.nodeIndex];
+
+            UINT64 candidates = entry.firstRay < 64 ? (rays->activeMask >> entry.firstRay) << entry.firstRay : 0;
+            if (candidates == 0)
+            {
+                continue;
+            }
+
+            // First active ray, then the whole packet, then the remaining rays one by one.
+            UINT firstRay = LowestSetBit(candidates);
+            if (!rays->RayIntersectsBox(firstRay, node.bounds))
+            {
+                if (rays->CullBox(node.bounds, packetTMax))
+                {
+                    continue;
+                }
+                candidates &= candidates - 1;
+                while (candidates && !rays->RayIntersectsBox(LowestSetBit(candidates), node.bounds))
+                {
+                    candidates &= candidates - 1;
+                }
+                if (candidates == 0)
+                {
+                    continue;
+                }
+                firstRay = LowestSetBit(candidates);
+            }
+
+            if (CountSetBits(candidates) < c_rayPacketMinActiveRays)
+            {
+                for (; candidates; candidates &= candidates - 1)
+                {
+                    const UINT rayIndex = LowestSetBit(candidates);
+                    const UINT64 rayBit = 1ull << rayIndex;
+                    if (TraverseBvhSubtree(bvh, entry.nodeIndex, rays->GetOrigin(rayIndex), rays->GetInvDirection(rayIndex),
+                        rays->tMin[rayIndex], rays->tMax[rayIndex], cullNode,
+                        [&](UINT primIndex, float&) { return (intersectPrimitive(primIndex, rayBit) & rayBit) != 0; }))
+                    {
+                        rays->activeMask &= ~rayBit;
+                    }
+                }
+                packetTMax = rays->MaxTMax();
+                continue;
+            }
+
+            if (node.IsLeaf())
+            {
+                // Only rays that enter the leaf test its primitives.
+                UINT64 leafRays = rays->IntersectBox(node.bounds, candidates);
+                for (UINT i = 0; i < node.primCount && leafRays; i++)
+                {
+                    UINT64 terminated = intersectPrimitive(bvh.primIndices[node.leftOrFirst + i], leafRays);
+                    rays->activeMask &= ~terminated;
+                    leafRays &= ~terminated;
+                }
+                packetTMax = rays->MaxTMax();
+                continue;
+            }
+
+            // Visit the child nearer along the first ray first.
+            UINT left = node.leftOrFirst;
+            UINT right = left + 1;
+            float3 centerDelta = bvh.nodes[right].bounds.Center() - bvh.nodes[left].bounds.Center();
+            bool rightFirst = dot(centerDelta, rays->GetDirection(firstRay)) < 0.0f;
+            UINT nearChild = rightFirst ? right : left;
+            UINT farChild = rightFirst ? left : right;
+            if (!cullNode(farChild))
+            {
+                stack[stackSize++] = { farChild, firstRay };
+            }
+            if (!cullNode(nearChild))
+            {
+                stack[stackSize++] = { nearChild, firstRay };
+            }
+        }
+    }
+
+    // Packet version of TraverseBvh8(). At each node the first ray that may enter it is tested against all children
+    // with the single-ray kernel. A child it misses is culled for the whole packet if the interval bounds show no
+    // ray can reach it, and otherwise entered from the first ray that does. Leaves are tested only by the rays that
+    // enter them. intersectPrimitive follows the TraverseBvhPacket() contract. The quantized layout is traversed
+    // one ray at a time.
+    template <typename IntersectPrimitiveFunc>
+    void TraverseBvh8Packet(const Bvh8& bvh, Bvh8Kernel::Enum kernel, PacketTraversalRays* rays, IntersectPrimitiveFunc&& intersectPrimitive)
+    {
+        if (bvh.IsEmpty() || rays->activeMask == 0)
+        {
+            return;
+        }
+
+        auto traverseRays = [&](UINT child, UINT primCount, UINT64 rayMask)
+        {
+            for (; rayMask; rayMask &= rayMask - 1)
+            {
+                const UINT rayIndex = LowestSetBit(rayMask);
+                const UINT64 rayBit = 1ull << rayIndex;
+                const Ray ray(rays->GetOrigin(rayIndex), rays->GetDirection(rayIndex), rays->tMin[rayIndex], rays->tMax[rayIndex]);
+                if (TraverseBvh8Subtree(bvh, child, primCount, ray, rays->tMax[rayIndex], kernel,
+                    [&](UINT primIndex, float&) { return (intersectPrimitive(primIndex, rayBit) & rayBit) != 0; }))
+                {
+                    rays->activeMask &= ~rayBit;
+                }
+            }
+        };
+
+        if (bvh.IsQuantized())
+        {
+            traverseRays(0, 0, rays->activeMask);
+            return;
+        }
+
+        Bvh8IntersectNodeFunc intersectNode = IntersectBvh8NodeScalar;
+        if (kernel == Bvh8Kernel::Avx2)
+        {
+            intersectNode = IntersectBvh8NodeAvx2;
+        }
+
+        // Each entry holds the rays that may enter the child; leaf entries hold exactly those that do.
+        struct StackEntry
+        {
+            UINT child;
+            UINT primCount;
+            UINT64 rayMask;
+        };
+        const UINT c_stackSize = c_bvh8Width * c_maxBvhDepth;
+        StackEntry stack[c_stackSize];
+        UINT stackSize = 0;
+        stack[stackSize++] = { 0, 0, rays->activeMask };
+        float packetTMax = rays->MaxTMax();
+
+        while (stackSize > 0)
+        {
+            const StackEntry entry = stack[--stackSize];
+            UINT64 candidates = entry.rayMask & rays->activeMask;
+            if (candidates == 0)
+            {
+                continue;
+            }
+
+            if (CountSetBits(candidates) < c_rayPacketMinActiveRays)
+            {
+                traverseRays(entry.child, entry.primCount, candidates);
+                packetTMax = rays->MaxTMax();
+                continue;
+            }
+
+            if (entry.primCount != 0)
+            {
+                UINT64 leafRays = candidates;
+                for (UINT i = 0; i < entry.primCount && leafRays; i++)
+                {
+                    UINT64 terminated = intersectPrimitive(bvh.primIndices[entry.child + i], leafRays);
+                    rays->activeMask &= ~terminated;
+                    leafRays &= ~terminated;
+                }
+                packetTMax = rays->MaxTMax();
+                continue;
+            }
+
+            const Bvh8Node& node = bvh.nodes[entry.child];
+            const UINT firstRay = LowestSetBit(candidates);
+            const Bvh8Ray firstNodeRay = { rays->GetOrigin(firstRay), rays->GetInvDirection(firstRay), rays->tMin[firstRay] };
+            float tEntries[c_bvh8Width];
+            const UINT firstRayHits = intersectNode(node, firstNodeRay, rays->tMax[firstRay], tEntries);
+
+            // Sort the entered children far to near along the ray that entered them first.
+            StackEntry hits[c_bvh8Width];
+            float hitTEntries[c_bvh8Width];
+            UINT hitCount = 0;
+            for (UINT c = 0; c < node.childCount; c++)
+            {
+                const AABB box(float3(node.minX[c], node.minY[c], node.minZ[c]), float3(node.maxX[c], node.maxY[c], node.maxZ[c]));
+                UINT64 childRays = candidates;
+                float tEntry = tEntries[c];
+                if (!(firstRayHits & (1u << c)))
+                {
+                    if (rays->CullBox(box, packetTMax))
+                    {
+                        continue;
+                    }
+                    for (childRays &= childRays - 1; childRays; childRays &= childRays - 1)
+                    {
+                        const UINT rayIndex = LowestSetBit(childRays);
+                        if (IntersectRayAABB(rays->GetOrigin(rayIndex), rays->GetInvDirection(rayIndex), box,
+                            rays->tMin[rayIndex], rays->tMax[rayIndex], &tEntry))
+                        {
+                            break;
+                        }
+                    }
+                }
+                if (node.primCount[c] != 0 && childRays)
+                {
+                    childRays = rays->IntersectBox(box, childRays);
+                }
+                if (childRays == 0)
+                {
+                    continue;
+                }
+
+                StackEntry hit = { node.child[c], node.primCount[c], childRays };
+                UINT j = hitCount++;
+                while (j > 0 && hitTEntries[j - 1] < tEntry)
+                {
+                    hits[j] = hits[j - 1];
+                    hitTEntries[j] = hitTEntries[j - 1];
+                    j--;
+                }
+                hits[j] = hit;
+                hitTEntries[j] = tEntry;
+            }
+            for (UINT i = 0; i < hitCount; i++)
+            {
+                stack[stackSize++] = hits[i];
+            }
+        }
+    }
+}
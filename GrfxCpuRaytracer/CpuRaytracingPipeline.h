@@ -0,0 +1,522 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// CPU counterpart of the raytracing pipeline state object a sample creates in CreateRaytracingPipelineStateObject().
+// Each HLSL entry point is a C++ function registered under the same export name, and hit groups combine them
+// like D3D12_HIT_GROUP_DESC. DispatchRays() and TraceRay() find shaders through the records of the shader
+// tables (see CpuShaderTable.h), so a sample's tables and shader logic run together without a GPU.
+//
+// Shaders are plain function pointers and the payload and attribute types are template parameters, so
+// invoking a shader is a direct call through a pointer, with no virtual dispatch or type erasure.
+
+#include "CpuScene.h"
+#include "CpuShaderTable.h"
+#include "CpuDispatchRays.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace CpuRT
+{
+    namespace CpuShaderStage
+    {
+        enum Enum
+        {
+            RayGeneration,
+            Intersection,
+            AnyHit,
+            ClosestHit,
+            Miss
+        };
+    }
+
+    // BuiltInTriangleIntersectionAttributes; triangle hits pass their barycentrics in the first 8 bytes of the
+    // pipeline's Attributes type.
+    struct CpuBuiltInTriangleIntersectionAttributes
+    {
+        float2 barycentrics;
+    };
+
+    // Payload is the ray payload of every TraceRay() and Attributes the attribute struct hit shaders receive.
+    template <typename Payload, typename Attributes>
+    class CpuRaytracingPipeline
+    {
+        static_assert(std::is_trivially_copyable<Attributes>::value && sizeof(Attributes) <= sizeof(CpuHit::attributes),
+            "Attributes must be trivially copyable and fit D3D12_RAYTRACING_MAX_ATTRIBUTE_SIZE_IN_BYTES.");
+
+    public:
+        class ShaderContext;
+
+        typedef void (*RayGenerationShader)(ShaderContext& context);
+        typedef void (*IntersectionShader)(ShaderContext& context);
+        typedef void (*AnyHitShader)(ShaderContext& context, Payload& payload, const Attributes& attributes);
+        typedef void (*ClosestHitShader)(ShaderContext& context, Payload& payload, const Attributes& attributes);
+        typedef void (*MissShader)(ShaderContext& context, Payload& payload);
+
+        // Values above D3D12_RAYTRACING_MAX_DECLARABLE_TRACE_RECURSION_DEPTH are rejected, as by CreateStateObject().
+        explicit CpuRaytracingPipeline(UINT maxTraceRecursionDepth = 1) :
+            m_maxTraceRecursionDepth(maxTraceRecursionDepth)
+        {
+            if (maxTraceRecursionDepth > D3D12_RAYTRACING_MAX_DECLARABLE_TRACE_RECURSION_DEPTH)
+            {
+                throw std::invalid_argument("MaxTraceRecursionDepth exceeds D3D12_RAYTRACING_MAX_DECLARABLE_TRACE_RECURSION_DEPTH.");
+            }
+        }
+
+        // DXIL library exports. Export names are unique across shaders and hit groups.
+        void AddRayGenerationShader(const char* exportName, RayGenerationShader shader)
+        {
+            AddProgram(exportName).rayGeneration = shader;
+        }
+        void AddMissShader(const char* exportName, MissShader shader)
+        {
+            AddProgram(exportName).miss = shader;
+        }
+        void AddIntersectionShader(const char* exportName, IntersectionShader shader)
+        {
+            AddExportName(exportName);
+            m_intersectionShaders[exportName] = shader;
+        }
+        void AddAnyHitShader(const char* exportName, AnyHitShader shader)
+        {
+            AddExportName(exportName);
+            m_anyHitShaders[exportName] = shader;
+        }
+        void AddClosestHitShader(const char* exportName, ClosestHitShader shader)
+        {
+            AddExportName(exportName);
+            m_closestHitShaders[exportName] = shader;
+        }
+
+        // D3D12_HIT_GROUP_DESC. Imports name shaders added above; null for none.
+        void AddHitGroup(const char* hitGroupExport,
+            const char* closestHitShaderImport,
+            const char* anyHitShaderImport = nullptr,
+            const char* intersectionShaderImport = nullptr)
+        {
+            ClosestHitShader closestHit = FindImport(m_closestHitShaders, closestHitShaderImport);
+            AnyHitShader anyHit = FindImport(m_anyHitShaders, anyHitShaderImport);
+            IntersectionShader intersection = FindImport(m_intersectionShaders, intersectionShaderImport);
+
+            ShaderProgram& program = AddProgram(hitGroupExport);
+            program.isHitGroup = true;
+            program.closestHit = closestHit;
+            program.anyHit = anyHit;
+            program.intersection = intersection;
+            m_hasAnyHitShaders = m_hasAnyHitShaders || anyHit != nullptr;
+        }
+
+        // ID3D12StateObjectProperties::GetShaderIdentifier(): the identifier shader records use for a ray
+        // generation shader, miss shader or hit group. Null for other names.
+        const CpuShaderIdentifier* GetShaderIdentifier(const char* exportName) const
+        {
+            for (const ShaderProgram& program : m_programs)
+            {
+                if (program.name == exportName)
+                {
+                    return &program.identifier;
+                }
+            }
+            return nullptr;
+        }
+
+        UINT GetMaxTraceRecursionDepth() const { return m_maxTraceRecursionDepth; }
+
+        // DispatchRays(): runs the ray generation shader of bindings.rayGenerationShaderRecord once per
+        // DispatchRaysIndex() on the pool. globalRootArguments stands in for the bindings of the global root
+        // signature and is available to every shader.
+        void DispatchRays(const CpuShaderTableBindings& bindings,
+            const CpuDispatchRaysDesc& desc,
+            CpuThreadPool* pool,
+            const void* globalRootArguments = nullptr,
+            std::vector<CpuTileTiming>* tileTimings = nullptr) const
+        {
+            ShaderContext rayGenContext;
+            rayGenContext.m_pipeline = this;
+            rayGenContext.m_bindings = &bindings;
+            rayGenContext.m_globalRootArguments = globalRootArguments;
+            rayGenContext.m_dispatchRaysDimensions = uint3(desc.width, desc.height, desc.depth);
+            rayGenContext.m_stage = CpuShaderStage::RayGeneration;
+
+            const ShaderProgram* program = FindProgram(bindings.rayGenerationShaderRecord, 0, "RayGenerationShaderRecord",
+                &rayGenContext.m_record);
+            if (program == nullptr || program->rayGeneration == nullptr)
+            {
+                throw std::invalid_argument("RayGenerationShaderRecord does not hold a ray generation shader.");
+            }
+
+            DispatchRaysTiled(desc, [&](UINT x, UINT y, UINT z)
+            {
+                ShaderContext context = rayGenContext;
+                context.m_dispatchRaysIndex = uint3(x, y, z);
+                program->rayGeneration(context);
+            }, pool, tileTimings);
+        }
+
+        // Everything a shader invocation can reach: HLSL system value intrinsics, root arguments and the
+        // TraceRay(), ReportHit(), IgnoreHit() and AcceptHitAndEndSearch() calls. Intrinsics that are not
+        // available in the current stage throw std::logic_error, as the HLSL compiler would reject them.
+        class ShaderContext
+        {
+        public:
+            CpuShaderStage::Enum GetStage() const { return m_stage; }
+
+            const uint3& DispatchRaysIndex() const { return m_dispatchRaysIndex; }
+            const uint3& DispatchRaysDimensions() const { return m_dispatchRaysDimensions; }
+
+            template <typename T>
+            const T& GetGlobalRootArguments() const { return *static_cast<const T*>(m_globalRootArguments); }
+
+            // Arguments of the shader record this shader was found through.
+            template <typename T>
+            const T& GetLocalRootArguments() const { return m_record.GetLocalRootArguments<T>(); }
+            const CpuShaderRecord& GetShaderRecord() const { return m_record; }
+
+            // Ray system values, available in intersection, any hit, closest hit and miss shaders.
+            float3 WorldRayOrigin() const { return GetRay().origin; }
+            float3 WorldRayDirection() const { return GetRay().direction; }
+            float RayTMin() const { return GetRay().tMin; }
+            UINT RayFlags() const { GetRay(); return m_rayFlags; }
+            float RayTCurrent() const
+            {
+                switch (m_stage)
+                {
+                case CpuShaderStage::Intersection:
+                    return m_reporter->RayTCurrent();
+                case CpuShaderStage::AnyHit:
+                case CpuShaderStage::ClosestHit:
+                    return m_hit->t;
+                default:
+                    return GetRay().tMax;
+                }
+            }
+
+            // Primitive system values, available in intersection, any hit and closest hit shaders.
+            UINT InstanceIndex() const { return m_hit ? m_hit->instanceIndex : GetIntersectionInput().instanceIndex; }
+            UINT InstanceID() const { return m_hit ? m_hit->instanceID : GetIntersectionInput().instanceID; }
+            UINT GeometryIndex() const { return m_hit ? m_hit->geometryIndex : GetIntersectionInput().geometryIndex; }
+            UINT PrimitiveIndex() const { return m_hit ? m_hit->primitiveIndex : GetIntersectionInput().primitiveIndex; }
+            float3 ObjectRayOrigin() const { return m_hit ? m_hit->objectRayOrigin : GetIntersectionInput().objectRay.origin; }
+            float3 ObjectRayDirection() const { return m_hit ? m_hit->objectRayDirection : GetIntersectionInput().objectRay.direction; }
+
+            // Available in any hit and closest hit shaders.
+            UINT HitKind() const { return GetHit().hitKind; }
+
+            // Available in ray generation, closest hit and miss shaders. Runs the closest hit shader of the
+            // committed hit or the miss shader at missShaderIndex before returning. Throws std::logic_error
+            // when the call would exceed the pipeline's MaxTraceRecursionDepth.
+            void TraceRay(const CpuScene& scene,
+                UINT rayFlags,
+                UINT instanceInclusionMask,
+                UINT rayContributionToHitGroupIndex,
+                UINT multiplierForGeometryContributionToHitGroupIndex,
+                UINT missShaderIndex,
+                const Ray& ray,
+                Payload& payload) const
+            {
+                if (m_stage != CpuShaderStage::RayGeneration && m_stage != CpuShaderStage::ClosestHit && m_stage != CpuShaderStage::Miss)
+                {
+                    throw std::logic_error("TraceRay() is only available in ray generation, closest hit and miss shaders.");
+                }
+                if (m_recursionDepth >= m_pipeline->m_maxTraceRecursionDepth)
+                {
+                    throw std::logic_error("TraceRay() exceeds MaxTraceRecursionDepth "
+                        + std::to_string(m_pipeline->m_maxTraceRecursionDepth) + ".");
+                }
+
+                ShaderContext child;
+                child.m_pipeline = m_pipeline;
+                child.m_bindings = m_bindings;
+                child.m_globalRootArguments = m_globalRootArguments;
+                child.m_dispatchRaysIndex = m_dispatchRaysIndex;
+                child.m_dispatchRaysDimensions = m_dispatchRaysDimensions;
+                child.m_recursionDepth = m_recursionDepth + 1;
+                child.m_ray = &ray;
+                child.m_rayFlags = rayFlags;
+
+                TraceState trace = { &child, &payload };
+                CpuTraversalShaders shaders = { &trace, &IntersectionCallback, m_pipeline->m_hasAnyHitShaders ? &AnyHitCallback : nullptr };
+
+                CpuHit hit;
+                if (scene.TraceRay(ray, rayFlags, instanceInclusionMask, rayContributionToHitGroupIndex,
+                    multiplierForGeometryContributionToHitGroupIndex, &hit, &shaders))
+                {
+                    if (rayFlags & RAY_FLAG_SKIP_CLOSEST_HIT_SHADER)
+                    {
+                        return;
+                    }
+                    const ShaderProgram* program = m_pipeline->FindHitGroup(*m_bindings, hit.hitGroupIndex, &child.m_record);
+                    if (program && program->closestHit)
+                    {
+                        child.m_stage = CpuShaderStage::ClosestHit;
+                        child.m_hit = &hit;
+                        program->closestHit(child, payload, ToAttributes(hit));
+                    }
+                }
+                else
+                {
+                    const ShaderProgram* program = m_pipeline->FindProgram(m_bindings->missShaderTable, missShaderIndex & 0xFFFF,
+                        "MissShaderTable", &child.m_record);
+                    if (program && !program->miss)
+                    {
+                        throw std::invalid_argument("MissShaderTable record " + std::to_string(missShaderIndex & 0xFFFF)
+                            + " holds " + program->name + ", which is not a miss shader.");
+                    }
+                    if (program)
+                    {
+                        child.m_stage = CpuShaderStage::Miss;
+                        program->miss(child, payload);
+                    }
+                }
+            }
+
+            // Available in intersection shaders. Runs the any hit shader of non-opaque geometry and returns
+            // whether the hit was committed. Attributes of any type up to 32 bytes can be reported; hit shaders
+            // read them back as the pipeline's Attributes.
+            template <typename ReportedAttributes>
+            bool ReportHit(float tHit, UINT hitKind, const ReportedAttributes& attributes) const
+            {
+                static_assert(std::is_trivially_copyable<ReportedAttributes>::value && sizeof(ReportedAttributes) <= sizeof(CpuHit::attributes),
+                    "Attributes must be trivially copyable and fit D3D12_RAYTRACING_MAX_ATTRIBUTE_SIZE_IN_BYTES.");
+                if (m_stage != CpuShaderStage::Intersection)
+                {
+                    throw std::logic_error("ReportHit() is only available in intersection shaders.");
+                }
+                return m_reporter->ReportHit(tHit, hitKind, &attributes, sizeof(attributes));
+            }
+
+            // Available in any hit shaders. HLSL does not return from these calls; the C++ shader should
+            // return right after making one.
+            void IgnoreHit() { SetAnyHitResult(CpuAnyHitResult::IgnoreHit); }
+            void AcceptHitAndEndSearch() { SetAnyHitResult(CpuAnyHitResult::AcceptHitAndEndSearch); }
+
+        private:
+            friend class CpuRaytracingPipeline;
+
+            ShaderContext() :
+                m_pipeline(nullptr),
+                m_bindings(nullptr),
+                m_globalRootArguments(nullptr),
+                m_stage(CpuShaderStage::RayGeneration),
+                m_recursionDepth(0),
+                m_ray(nullptr),
+                m_rayFlags(0),
+                m_hit(nullptr),
+                m_intersectionInput(nullptr),
+                m_reporter(nullptr),
+                m_anyHitResult(CpuAnyHitResult::Accept)
+            {
+            }
+
+            const Ray& GetRay() const
+            {
+                if (m_ray == nullptr)
+                {
+                    throw std::logic_error("Ray system values are not available in ray generation shaders.");
+                }
+                return *m_ray;
+            }
+            const CpuHit& GetHit() const
+            {
+                if (m_hit == nullptr)
+                {
+                    throw std::logic_error("HitKind() is only available in any hit and closest hit shaders.");
+                }
+                return *m_hit;
+            }
+            const CpuIntersectionInput& GetIntersectionInput() const
+            {
+                if (m_intersectionInput == nullptr)
+                {
+                    throw std::logic_error("Primitive system values are only available in intersection, any hit and closest hit shaders.");
+                }
+                return *m_intersectionInput;
+            }
+            void SetAnyHitResult(CpuAnyHitResult::Enum result)
+            {
+                if (m_stage != CpuShaderStage::AnyHit)
+                {
+                    throw std::logic_error("IgnoreHit() and AcceptHitAndEndSearch() are only available in any hit shaders.");
+                }
+                m_anyHitResult = result;
+            }
+
+            const CpuRaytracingPipeline* m_pipeline;
+            const CpuShaderTableBindings* m_bindings;
+            const void* m_globalRootArguments;
+            uint3 m_dispatchRaysIndex;
+            uint3 m_dispatchRaysDimensions;
+            CpuShaderStage::Enum m_stage;
+            UINT m_recursionDepth;          // TraceRay() calls on the stack, 0 in the ray generation shader.
+            CpuShaderRecord m_record;
+            const Ray* m_ray;
+            UINT m_rayFlags;
+            const CpuHit* m_hit;            // Candidate in any hit shaders, committed hit in closest hit shaders.
+            const CpuIntersectionInput* m_intersectionInput;
+            CpuHitReporter* m_reporter;
+            CpuAnyHitResult::Enum m_anyHitResult;
+        };
+
+    private:
+        // A ray generation shader, miss shader or hit group: the exports a shader record can name.
+        struct ShaderProgram
+        {
+            std::string name;
+            CpuShaderIdentifier identifier;
+            bool isHitGroup;
+            RayGenerationShader rayGeneration;
+            MissShader miss;
+            ClosestHitShader closestHit;
+            AnyHitShader anyHit;
+            IntersectionShader intersection;
+        };
+
+        // State of one TraceRay() handed to the traversal callbacks.
+        struct TraceState
+        {
+            const ShaderContext* context;
+            Payload* payload;
+        };
+
+        static UINT64 IdentifierKey(const CpuShaderIdentifier& identifier)
+        {
+            UINT64 key;
+            memcpy(&key, identifier.bytes, sizeof(key));
+            return key;
+        }
+
+        void AddExportName(const char* exportName)
+        {
+            if (exportName == nullptr || !m_exportNames.insert(exportName).second)
+            {
+                throw std::invalid_argument(std::string("Duplicate or missing export name ") + (exportName ? exportName : "") + ".");
+            }
+        }
+
+        ShaderProgram& AddProgram(const char* exportName)
+        {
+            AddExportName(exportName);
+            ShaderProgram program = {};
+            program.name = exportName;
+            program.identifier = CpuShaderIdentifier::FromName(exportName);
+            if (!m_programIndices.emplace(IdentifierKey(program.identifier), static_cast<UINT>(m_programs.size())).second)
+            {
+                throw std::invalid_argument("Shader identifier of " + program.name + " collides with another export.");
+            }
+            m_programs.push_back(program);
+            return m_programs.back();
+        }
+
+        template <typename Shader>
+        static Shader FindImport(const std::unordered_map<std::string, Shader>& shaders, const char* importName)
+        {
+            if (importName == nullptr)
+            {
+                return nullptr;
+            }
+            auto it = shaders.find(importName);
+            if (it == shaders.end())
+            {
+                throw std::invalid_argument(std::string("Hit group imports unknown shader ") + importName + ".");
+            }
+            return it->second;
+        }
+
+        // Resolves a record and the program its identifier names in O(1). Returns null for a null shader
+        // identifier (all zeros), which runs no shader, as on the GPU. Records outside the table and unknown
+        // identifiers, undefined behavior on the GPU, throw.
+        const ShaderProgram* FindProgram(const CpuShaderTableRange& range, UINT recordIndex, const char* tableName,
+            CpuShaderRecord* record) const
+        {
+            if (!ResolveShaderRecord(range, recordIndex, record))
+            {
+                throw std::out_of_range(std::string(tableName) + " record " + std::to_string(recordIndex) + " is outside the table.");
+            }
+
+            static const CpuShaderIdentifier nullIdentifier = {};
+            const CpuShaderIdentifier& identifier = *record->shaderIdentifier;
+            if (identifier == nullIdentifier)
+            {
+                return nullptr;
+            }
+            auto it = m_programIndices.find(IdentifierKey(identifier));
+            if (it == m_programIndices.end() || m_programs[it->second].identifier != identifier)
+            {
+                throw std::invalid_argument(std::string(tableName) + " record " + std::to_string(recordIndex)
+                    + " holds a shader identifier that is not exported by the pipeline.");
+            }
+            return &m_programs[it->second];
+        }
+
+        const ShaderProgram* FindHitGroup(const CpuShaderTableBindings& bindings, UINT hitGroupIndex, CpuShaderRecord* record) const
+        {
+            const ShaderProgram* program = FindProgram(bindings.hitGroupTable, hitGroupIndex, "HitGroupTable", record);
+            if (program && !program->isHitGroup)
+            {
+                throw std::invalid_argument("HitGroupTable record " + std::to_string(hitGroupIndex) + " holds "
+                    + program->name + ", which is not a hit group.");
+            }
+            return program;
+        }
+
+        static Attributes ToAttributes(const CpuHit& hit)
+        {
+            Attributes attributes;
+            memcpy(&attributes, hit.attributes, sizeof(attributes));
+            return attributes;
+        }
+
+        // Procedural primitives of hit groups without an intersection shader report no hits.
+        static void IntersectionCallback(void* traceState, const CpuIntersectionInput& input, CpuHitReporter* reporter)
+        {
+            const TraceState* trace = static_cast<const TraceState*>(traceState);
+            ShaderContext context = *trace->context;
+            const ShaderProgram* program = context.m_pipeline->FindHitGroup(*context.m_bindings, input.hitGroupIndex, &context.m_record);
+            if (program && program->intersection)
+            {
+                context.m_stage = CpuShaderStage::Intersection;
+                context.m_intersectionInput = &input;
+                context.m_reporter = reporter;
+                program->intersection(context);
+            }
+        }
+
+        static CpuAnyHitResult::Enum AnyHitCallback(void* traceState, const CpuHit& candidate)
+        {
+            const TraceState* trace = static_cast<const TraceState*>(traceState);
+            ShaderContext context = *trace->context;
+            const ShaderProgram* program = context.m_pipeline->FindHitGroup(*context.m_bindings, candidate.hitGroupIndex, &context.m_record);
+            if (program == nullptr || program->anyHit == nullptr)
+            {
+                return CpuAnyHitResult::Accept;
+            }
+            context.m_stage = CpuShaderStage::AnyHit;
+            context.m_hit = &candidate;
+            program->anyHit(context, *trace->payload, ToAttributes(candidate));
+            return context.m_anyHitResult;
+        }
+
+        UINT m_maxTraceRecursionDepth;
+        bool m_hasAnyHitShaders = false;
+        std::vector<ShaderProgram> m_programs;
+        std::unordered_map<UINT64, UINT> m_programIndices;     // First 8 identifier bytes to index into m_programs.
+        std::unordered_map<std::string, IntersectionShader> m_intersectionShaders;
+        std::unordered_map<std::string, AnyHitShader> m_anyHitShaders;
+        std::unordered_map<std::string, ClosestHitShader> m_closestHitShaders;
+        std::unordered_set<std::string> m_exportNames;
+    };
+}
@@ -0,0 +1,112 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuReferenceRenderer.h"
+#include <cstdio>
+
+namespace CpuRT
+{
+    void CpuImage::Resize(UINT width, UINT height)
+    {
+        m_width = width;
+        m_height = height;
+        m_pixels.assign(static_cast<size_t>(width) * height, 0);
+    }
+
+    void CpuImage::SetPixel(UINT x, UINT y, const float4& color)
+    {
+        auto ToUnorm8 = [](float c) { return static_cast<UINT>(saturate(c) * 255.0f + 0.5f); };
+        m_pixels[static_cast<size_t>(y) * m_width + x] =
+            ToUnorm8(color.x) | (ToUnorm8(color.y) << 8) | (ToUnorm8(color.z) << 16) | (ToUnorm8(color.w) << 24);
+    }
+
+    UINT64 CpuImage::Hash() const
+    {
+        const UINT64 fnvPrime = 1099511628211ull;
+        UINT64 hash = 14695981039346656037ull;
+        auto HashBytes = [&](const void* data, size_t size)
+        {
+            const UINT8* bytes = static_cast<const UINT8*>(data);
+            for (size_t i = 0; i < size; i++)
+            {
+                hash = (hash ^ bytes[i]) * fnvPrime;
+            }
+        };
+        HashBytes(&m_width, sizeof(m_width));
+        HashBytes(&m_height, sizeof(m_height));
+        HashBytes(m_pixels.data(), m_pixels.size() * sizeof(UINT));
+        return hash;
+    }
+
+    bool CpuImage::SaveBmp(const char* fileName) const
+    {
+        FILE* file = fopen(fileName, "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        const UINT rowSize = (m_width * 3 + 3) & ~3u;
+        const UINT imageSize = rowSize * m_height;
+        const UINT headerSize = 14 + 40;
+
+        UINT8 header[headerSize] = {};
+        auto Write16 = [&](UINT offset, UINT value) { header[offset] = value & 0xFF; header[offset + 1] = (value >> 8) & 0xFF; };
+        auto Write32 = [&](UINT offset, UINT value) { Write16(offset, value & 0xFFFF); Write16(offset + 2, value >> 16); };
+
+        // BITMAPFILEHEADER
+        header[0] = 'B';
+        header[1] = 'M';
+        Write32(2, headerSize + imageSize);
+        Write32(10, headerSize);
+        // BITMAPINFOHEADER
+        Write32(14, 40);
+        Write32(18, m_width);
+        Write32(22, m_height);
+        Write16(26, 1);
+        Write16(28, 24);
+        Write32(34, imageSize);
+
+        bool success = fwrite(header, 1, headerSize, file) == headerSize;
+
+        std::vector<UINT8> row(rowSize, 0);
+        for (UINT y = 0; success && y < m_height; y++)
+        {
+            // Bottom-up rows, BGR pixels.
+            UINT srcY = m_height - 1 - y;
+            for (UINT x = 0; x < m_width; x++)
+            {
+                UINT pixel = GetPixel(x, srcY);
+                row[x * 3 + 0] = (pixel >> 16) & 0xFF;
+                row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+                row[x * 3 + 2] = pixel & 0xFF;
+            }
+            success = fwrite(row.data(), 1, rowSize, file) == rowSize;
+        }
+
+        fclose(file);
+        return success;
+    }
+
+    void DispatchRaysReference(UINT width, UINT height, const CpuRaygenFunc& raygen, CpuImage* output, UINT numThreads)
+    {
+        if (output->GetWidth() != width || output->GetHeight() != height)
+        {
+            output->Resize(width, height);
+        }
+
+        CpuDispatchRaysDesc desc;
+        desc.width = width;
+        desc.height = height;
+        CpuThreadPool pool(numThreads);
+        DispatchRaysTiled(desc, [&](UINT x, UINT y, UINT) { output->SetPixel(x, y, raygen(x, y)); }, &pool);
+    }
+}
@@ -0,0 +1,116 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "CpuDispatchRays.h"
+#include "CpuMath.h"
+#include "CpuRayPacket.h"
+#include <functional>
+#include <vector>
+
+namespace CpuRT
+{
+    // RGBA8 image, the CPU equivalent of the sample's raytracing output UAV.
+    class CpuImage
+    {
+    public:
+        CpuImage() : m_width(0), m_height(0) {}
+        CpuImage(UINT width, UINT height) { Resize(width, height); }
+
+        void Resize(UINT width, UINT height);
+        void SetPixel(UINT x, UINT y, const float4& color);
+        UINT GetPixel(UINT x, UINT y) const { return m_pixels[static_cast<size_t>(y) * m_width + x]; }
+
+        UINT GetWidth() const { return m_width; }
+        UINT GetHeight() const { return m_height; }
+        const UINT* GetData() const { return m_pixels.data(); }
+
+        // 64-bit FNV-1a of the dimensions and pixels, used to compare runs.
+        UINT64 Hash() const;
+
+        // Writes a 24bpp bottom-up BMP, the same format DeviceResources::SaveImage produces.
+        bool SaveBmp(const char* fileName) const;
+
+    private:
+        UINT m_width;
+        UINT m_height;
+        std::vector<UINT> m_pixels;
+    };
+
+    // Raygen stand-in invoked once per DispatchRaysIndex(); returns the color written to the output.
+    typedef std::function<float4(UINT x, UINT y)> CpuRaygenFunc;
+
+    // Equivalent of DispatchRays() for a Width x Height x 1 grid writing one color per pixel.
+    // Runs on a temporary pool of numThreads threads (0 selects the hardware thread count); use
+    // DispatchRaysTiled() to reuse a pool or record tile timings.
+    void DispatchRaysReference(UINT width, UINT height, const CpuRaygenFunc& raygen, CpuImage* output, UINT numThreads = 0);
+
+    // MyRaygenShader in D3D12RaytracingHelloWorld: orthographic ray through the viewport, looking down +Z.
+    inline Ray GenerateOrthographicRay(UINT x, UINT y, UINT width, UINT height,
+        float left, float top, float right, float bottom, float2* lerpValues = nullptr)
+    {
+        float2 t(static_cast<float>(x) / width, static_cast<float>(y) / height);
+        if (lerpValues)
+        {
+            *lerpValues = t;
+        }
+        float3 origin(lerp(left, right, t.x), lerp(top, bottom, t.y), 0.0f);
+        return Ray(origin, float3(0, 0, 1), 0.001f, 10000.0f);
+    }
+
+    // GenerateCameraRay in D3D12RaytracingSimpleLighting. projectionToWorld is the inverse view-projection
+    // matrix in DirectXMath's row-vector convention (i.e. before it is transposed for HLSL).
+    inline Ray GeneratePinholeRay(UINT x, UINT y, UINT width, UINT height,
+        const float4x4& projectionToWorld, const float3& cameraPosition, float tMin = 0.0f, float tMax = 10000.0f)
+    {
+        float2 xy(x + 0.5f, y + 0.5f);
+        float2 screenPos(xy.x / width * 2.0f - 1.0f, xy.y / height * 2.0f - 1.0f);
+
+        // Invert Y for DirectX-style coordinates.
+        screenPos.y = -screenPos.y;
+
+        // Unproject the pixel coordinate into a ray.
+        float4 world = projectionToWorld.TransformRowVector(float4(screenPos.x, screenPos.y, 0.0f, 1.0f));
+        float3 worldPos = world.xyz() / world.w;
+        return Ray(cameraPosition, normalize(worldPos - cameraPosition), tMin, tMax);
+    }
+
+    // Packet versions of the camera models above for the tile of up to 8x8 pixels at (x, y). Each ray is
+    // bit-identical to the single ray of its pixel.
+    inline void GenerateOrthographicRayPacket(UINT x, UINT y, UINT width, UINT height,
+        float left, float top, float right, float bottom, RayPacket* packet)
+    {
+        packet->x = x;
+        packet->y = y;
+        packet->width = (std::min)(c_rayPacketWidth, width - x);
+        packet->height = (std::min)(c_rayPacketHeight, height - y);
+        for (UINT i = 0; i < packet->GetRayCount(); i++)
+        {
+            packet->rays[i] = GenerateOrthographicRay(x + i % packet->width, y + i / packet->width, width, height,
+                left, top, right, bottom);
+        }
+    }
+
+    inline void GeneratePinholeRayPacket(UINT x, UINT y, UINT width, UINT height,
+        const float4x4& projectionToWorld, const float3& cameraPosition, RayPacket* packet, float tMin = 0.0f, float tMax = 10000.0f)
+    {
+        packet->x = x;
+        packet->y = y;
+        packet->width = (std::min)(c_rayPacketWidth, width - x);
+        packet->height = (std::min)(c_rayPacketHeight, height - y);
+        for (UINT i = 0; i < packet->GetRayCount(); i++)
+        {
+            packet->rays[i] = GeneratePinholeRay(x + i % packet->width, y + i / packet->width, width, height,
+                projectionToWorld, cameraPosition, tMin, tMax);
+        }
+    }
+}
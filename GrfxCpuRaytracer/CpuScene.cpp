@@ -0,0 +1,566 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuScene.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace CpuRT
+{
+    CpuScene::CpuScene() :
+        m_buildFlags(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE),
+        m_bvh8Layout(Bvh8Layout::Float),
+        m_bvh8Kernel(GetDefaultBvh8Kernel()),
+        m_tlasDirty(false)
+    {
+    }
+
+    void CpuScene::SetTriangleGeometry(UINT slot, const CpuTriangleGeometryDesc& desc)
+    {
+        if (slot >= m_triangleGeometry.size())
+        {
+            m_triangleGeometry.resize(slot + 1, CpuTriangleGeometryDesc());
+        }
+        m_triangleGeometry[slot] = desc;
+    }
+
+    void CpuScene::SetAABBGeometry(UINT slot, const CpuAABBGeometryDesc& desc)
+    {
+        if (slot >= m_aabbGeometry.size())
+        {
+            m_aabbGeometry.resize(slot + 1, CpuAABBGeometryDesc());
+        }
+        m_aabbGeometry[slot] = desc;
+    }
+
+    void CpuScene::BuildBlas(const std::vector<GeomDesc>& geomDescs, const DxBlasDesc& blasDesc, CpuBlas* blas) const
+    {
+        blas->geometries.clear();
+        blas->primitives.clear();
+
+        for (int geomDescIndex : blasDesc.geomIndices)
+        {
+            if (geomDescIndex < 0 || static_cast<size_t>(geomDescIndex) >= geomDescs.size())
+            {
+                throw std::out_of_range("DxBlasDesc references a missing GeomDesc.");
+            }
+            const GeomDesc& geomDesc = geomDescs[geomDescIndex];
+            UINT geometryIndex = static_cast<UINT>(blas->geometries.size());
+            blas->geometries.push_back({ geomDesc.geomType, geomDesc.flags });
+
+            UINT slot = static_cast<UINT>(geomDesc.geomIndex);
+            if (geomDesc.geomType == D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+            {
+                if (slot >= m_triangleGeometry.size() || !m_triangleGeometry[slot].vertexData)
+                {
+                    throw std::out_of_range("GeomDesc references a missing triangle geometry slot.");
+                }
+                const CpuTriangleGeometryDesc& source = m_triangleGeometry[slot];
+                UINT triangleCount = GetTriangleCount(source);
+                for (UINT i = 0; i < triangleCount; i++)
+                {
+                    CpuBlas::Primitive prim;
+                    if (!LoadTriangle(source, i, &prim.v0, &prim.v1, &prim.v2))
+                    {
+                        throw std::out_of_range("Vertex index out of range.");
+                    }
+                    prim.geometryIndex = geometryIndex;
+                    prim.primitiveIndex = i;
+                    blas->primitives.push_back(prim);
+                }
+            }
+            else
+            {
+                if (slot >= m_aabbGeometry.size() || !m_aabbGeometry[slot].aabbs)
+                {
+                    throw std::out_of_range("GeomDesc references a missing AABB geometry slot.");
+                }
+                const CpuAABBGeometryDesc& source = m_aabbGeometry[slot];
+                for (UINT i = 0; i < source.aabbCount; i++)
+                {
+                    D3D12_RAYTRACING_AABB box = LoadAABB(source, i);
+
+                    CpuBlas::Primitive prim;
+                    prim.v0 = float3(box.MinX, box.MinY, box.MinZ);
+                    prim.v1 = float3(box.MaxX, box.MaxY, box.MaxZ);
+                    prim.geometryIndex = geometryIndex;
+                    prim.primitiveIndex = i;
+                    blas->primitives.push_back(prim);
+                }
+            }
+        }
+
+        std::vector<AABB> primBounds(blas->primitives.size());
+        blas->bounds = AABB();
+        for (size_t i = 0; i < blas->primitives.size(); i++)
+        {
+            const CpuBlas::Primitive& prim = blas->primitives[i];
+            AABB box;
+            box.Grow(prim.v0);
+            box.Grow(prim.v1);
+            if (blas->geometries[prim.geometryIndex].type == D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+            {
+                box.Grow(prim.v2);
+            }
+            primBounds[i] = box;
+            blas->bounds.Grow(box);
+        }
+        if (m_buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD)
+        {
+            BuildBvhMorton(primBounds.data(), static_cast<UINT>(primBounds.size()), m_fastBuildSettings, &blas->bvh);
+        }
+        else
+        {
+            BuildBvhBinnedSah(primBounds.data(), static_cast<UINT>(primBounds.size()), m_buildSettings, &blas->bvh);
+        }
+        CollapseBvh8(blas->bvh, m_bvh8Layout, &blas->bvh8);
+    }
+
+    void CpuScene::Build(const std::vector<GeomDesc>& geomDescs,
+        const std::vector<DxBlasDesc>& blasDescs,
+        const std::vector<DxTlasDesc>& tlasDescs)
+    {
+        m_blas.resize(blasDescs.size());
+        for (size_t i = 0; i < blasDescs.size(); i++)
+        {
+            BuildBlas(geomDescs, blasDescs[i], &m_blas[i]);
+        }
+
+        m_instances.resize(tlasDescs.size());
+        for (size_t i = 0; i < tlasDescs.size(); i++)
+        {
+            const DxTlasDesc& tlasDesc = tlasDescs[i];
+            if (tlasDesc.blasIndex >= m_blas.size())
+            {
+                throw std::out_of_range("DxTlasDesc references a missing BLAS.");
+            }
+
+            CpuInstance& instance = m_instances[i];
+            instance.objectToWorld = Transform3x4(tlasDesc.transformMatrix);
+            instance.worldToObject = instance.objectToWorld.Inverse();
+            instance.worldBounds = instance.objectToWorld.TransformBounds(m_blas[tlasDesc.blasIndex].bounds);
+            instance.blasIndex = tlasDesc.blasIndex;
+            instance.instanceID = 0;
+            instance.instanceMask = 0xFF;
+            instance.instanceContributionToHitGroupIndex = tlasDesc.instanceContributionToHitIndex;
+            instance.flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
+        }
+
+        m_tlas.Build(m_instances, m_buildFlags);
+        m_tlasDirty = false;
+    }
+
+    void CpuScene::SetInstanceMask(UINT instanceIndex, UINT instanceMask)
+    {
+        m_instances[instanceIndex].instanceMask = instanceMask;
+        m_tlasDirty = true;
+    }
+
+    void CpuScene::SetInstanceTransform(UINT instanceIndex, const DirectX::XMFLOAT3X4& transformMatrix)
+    {
+        CpuInstance& instance = m_instances[instanceIndex];
+        instance.objectToWorld = Transform3x4(transformMatrix);
+        instance.worldToObject = instance.objectToWorld.Inverse();
+        instance.worldBounds = instance.objectToWorld.TransformBounds(m_blas[instance.blasIndex].bounds);
+        m_tlasDirty = true;
+    }
+
+    void CpuScene::UpdateTlas()
+    {
+        m_tlas.Refit(m_instances);
+        m_tlasDirty = false;
+    }
+
+    CpuHitReporter::CpuHitReporter(const CpuTraversalShaders* shaders, bool opaque, bool acceptFirstHit, float tMin, float* tMax,
+        const CpuHit& candidate, CpuHit* hit) :
+        m_shaders(shaders),
+        m_candidate(candidate),
+        m_hit(hit),
+        m_tMin(tMin),
+        m_tMax(tMax),
+        m_opaque(opaque),
+        m_acceptFirstHit(acceptFirstHit),
+        m_committed(false),
+        m_endSearch(false)
+    {
+    }
+
+    bool CpuHitReporter::ReportHit(float tHit, UINT hitKind, const void* attributes, UINT attributesSize)
+    {
+        // Written so that NaN hit distances are rejected as well.
+        if (m_endSearch || !(tHit >= m_tMin && tHit <= *m_tMax))
+        {
+            return false;
+        }
+        if (attributesSize > sizeof(m_candidate.attributes))
+        {
+            throw std::invalid_argument("Hit attributes exceed D3D12_RAYTRACING_MAX_ATTRIBUTE_SIZE_IN_BYTES.");
+        }
+
+        m_candidate.t = tHit;
+        m_candidate.hitKind = hitKind;
+        memset(m_candidate.attributes, 0, sizeof(m_candidate.attributes));
+        if (attributesSize > 0)
+        {
+            memcpy(m_candidate.attributes, attributes, attributesSize);
+        }
+
+        if (!m_opaque && m_shaders && m_shaders->anyHit)
+        {
+            switch (m_shaders->anyHit(m_shaders->context, m_candidate))
+            {
+            case CpuAnyHitResult::IgnoreHit:
+                return false;
+            case CpuAnyHitResult::AcceptHitAndEndSearch:
+                m_endSearch = true;
+                break;
+            default:
+                break;
+            }
+        }
+
+        *m_tMax = tHit;
+        *m_hit = m_candidate;
+        m_committed = true;
+        m_endSearch = m_endSearch || m_acceptFirstHit;
+        return true;
+    }
+
+    bool CpuScene::IntersectPrimitive(UINT instanceIndex,
+        UINT primIndex,
+        const Ray& worldRay,
+        const Ray& objectRay,
+        const WatertightRay& watertightRay,
+        UINT rayFlags,
+        UINT rayContributionToHitGroupIndex,
+        UINT multiplierForGeometryContributionToHitGroupIndex,
+        const CpuTraversalShaders* shaders,
+        float& tMax,
+        CpuHit* hit,
+        bool* endSearch) const
+    {
+        const CpuInstance& instance = m_instances[instanceIndex];
+        const CpuBlas& blas = m_blas[instance.blasIndex];
+        const CpuBlas::Primitive& prim = blas.primitives[primIndex];
+        const CpuBlas::Geometry& geometry = blas.geometries[prim.geometryIndex];
+
+        auto IsOpaque = [&]()
+        {
+            if (rayFlags & RAY_FLAG_FORCE_OPAQUE)
+            {
+                return true;
+            }
+            if (rayFlags & RAY_FLAG_FORCE_NON_OPAQUE)
+            {
+                return false;
+            }
+            if (instance.flags & D3D12_RAYTRACING_INSTANCE_FLAG_FORCE_OPAQUE)
+            {
+                return true;
+            }
+            if (instance.flags & D3D12_RAYTRACING_INSTANCE_FLAG_FORCE_NON_OPAQUE)
+            {
+                return false;
+            }
+            return (geometry.flags & D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE) != 0;
+        };
+
+        bool opaque = IsOpaque();
+        if ((opaque && (rayFlags & RAY_FLAG_CULL_OPAQUE)) || (!opaque && (rayFlags & RAY_FLAG_CULL_NON_OPAQUE)))
+        {
+            return false;
+        }
+
+        const UINT hitGroupIndex = ComputeHitGroupIndex(rayContributionToHitGroupIndex,
+            multiplierForGeometryContributionToHitGroupIndex, prim.geometryIndex, instance.instanceContributionToHitGroupIndex);
+
+        // Filled only once the primitive is known to be a candidate, so misses stay cheap.
+        auto MakeReporter = [&]()
+        {
+            CpuHit candidate;
+            candidate.instanceIndex = instanceIndex;
+            candidate.instanceID = instance.instanceID;
+            candidate.geometryIndex = prim.geometryIndex;
+            candidate.primitiveIndex = prim.primitiveIndex;
+            candidate.hitGroupIndex = hitGroupIndex;
+            candidate.geometryType = geometry.type;
+            candidate.objectRayOrigin = objectRay.origin;
+            candidate.objectRayDirection = objectRay.direction;
+            return CpuHitReporter(shaders, opaque, (rayFlags & RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH) != 0,
+                objectRay.tMin, &tMax, candidate, hit);
+        };
+
+        if (geometry.type == D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+        {
+            float tHit;
+            float det;
+            float2 barycentrics;
+            if (!IntersectRayTriangleWatertight(watertightRay, prim.v0, prim.v1, prim.v2, tMax, &tHit, &barycentrics, &det))
+            {
+                return false;
+            }
+
+            bool cullDisable = (instance.flags & D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_CULL_DISABLE) != 0;
+            bool frontCounterClockwise = (instance.flags & D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE) != 0;
+            bool frontFace = frontCounterClockwise ? (det < 0.0f) : (det > 0.0f);
+            if (!cullDisable)
+            {
+                if ((frontFace && (rayFlags & RAY_FLAG_CULL_FRONT_FACING_TRIANGLES)) ||
+                    (!frontFace && (rayFlags & RAY_FLAG_CULL_BACK_FACING_TRIANGLES)))
+                {
+                    return false;
+                }
+            }
+
+            CpuHitReporter reporter = MakeReporter();
+            bool committed = reporter.ReportHit(tHit, frontFace ? HIT_KIND_TRIANGLE_FRONT_FACE : HIT_KIND_TRIANGLE_BACK_FACE,
+                &barycentrics, sizeof(barycentrics));
+            *endSearch = reporter.IsSearchEnded();
+            return committed;
+        }
+
+        AABB box(prim.v0, prim.v1);
+        float tEntry;
+        if (!IntersectRayAABB(objectRay.origin, rcp(objectRay.direction), box, objectRay.tMin, tMax, &tEntry))
+        {
+            return false;
+        }
+
+        CpuIntersectionInput input;
+        input.worldRay = worldRay;
+        input.objectRay = objectRay;
+        input.objectRay.tMax = tMax;
+        input.aabb = box;
+        input.instanceIndex = instanceIndex;
+        input.instanceID = instance.instanceID;
+        input.geometryIndex = prim.geometryIndex;
+        input.primitiveIndex = prim.primitiveIndex;
+        input.hitGroupIndex = hitGroupIndex;
+
+        CpuHitReporter reporter = MakeReporter();
+        if (shaders && shaders->intersection)
+        {
+            shaders->intersection(shaders->context, input, &reporter);
+        }
+        else
+        {
+            float attributes[c_maxAttributeSizeInFloats] = {};
+            float tHit = tEntry;
+            UINT hitKind = 0;
+            if (m_intersectionFunc && !m_intersectionFunc(input, &tHit, &hitKind, attributes))
+            {
+                return false;
+            }
+            reporter.ReportHit(tHit, hitKind, attributes, sizeof(attributes));
+        }
+        *endSearch = reporter.IsSearchEnded();
+        return reporter.HasCommittedHit();
+    }
+
+    bool CpuScene::IntersectInstance(UINT instanceIndex,
+        const Ray& worldRay,
+        UINT rayFlags,
+        UINT rayContributionToHitGroupIndex,
+        UINT multiplierForGeometryContributionToHitGroupIndex,
+        const CpuTraversalShaders* shaders,
+        float& tMax,
+        CpuHit* hit,
+        bool* endSearch) const
+    {
+        const CpuInstance& instance = m_instances[instanceIndex];
+        const CpuBlas& blas = m_blas[instance.blasIndex];
+
+        // Object space ray. The direction is not renormalized so t values are shared with world space.
+        Ray objectRay(instance.worldToObject.TransformPoint(worldRay.origin),
+            instance.worldToObject.TransformVector(worldRay.direction),
+            worldRay.tMin, worldRay.tMax);
+        const WatertightRay watertightRay(objectRay);
+
+        bool hasHit = false;
+        TraverseBvh8(blas.bvh8, objectRay, tMax, m_bvh8Kernel, [&](UINT primIndex, float& currentTMax)
+        {
+            if (!IntersectPrimitive(instanceIndex, primIndex, worldRay, objectRay, watertightRay, rayFlags,
+                rayContributionToHitGroupIndex, multiplierForGeometryContributionToHitGroupIndex, shaders, currentTMax, hit, endSearch))
+            {
+                return false;
+            }
+            hasHit = true;
+            return *endSearch;
+        });
+
+        return hasHit;
+    }
+
+    UINT64 CpuScene::IntersectInstancePacket(UINT instanceIndex,
+        const RayPacket& packet,
+        PacketTraversalRays* worldRays,
+        UINT64 rayMask,
+        UINT rayFlags,
+        UINT rayContributionToHitGroupIndex,
+        UINT multiplierForGeometryContributionToHitGroupIndex,
+        CpuHit* hits) const
+    {
+        const CpuInstance& instance = m_instances[instanceIndex];
+        const CpuBlas& blas = m_blas[instance.blasIndex];
+
+        UINT64 hitMask = 0;
+        if (CountSetBits(rayMask) < c_rayPacketMinActiveRays || blas.primitives.size() > c_rayPacketMaxBlasPrimitives)
+        {
+            for (; rayMask; rayMask &= rayMask - 1)
+            {
+                const UINT i = LowestSetBit(rayMask);
+                bool endSearch = false;
+                if (IntersectInstance(instanceIndex, packet.rays[i], rayFlags, rayContributionToHitGroupIndex,
+                    multiplierForGeometryContributionToHitGroupIndex, nullptr, worldRays->tMax[i], &hits[i], &endSearch))
+                {
+                    hitMask |= 1ull << i;
+                }
+            }
+            return hitMask;
+        }
+
+        // Same object space rays as IntersectInstance(), so both paths commit the same hits.
+        Ray objectRays[c_rayPacketSize];
+        WatertightRay watertightRays[c_rayPacketSize];
+        PacketTraversalRays objectPacket;
+        objectPacket.count = worldRays->count;
+        objectPacket.activeMask = rayMask;
+        for (UINT64 mask = rayMask; mask; mask &= mask - 1)
+        {
+            const UINT i = LowestSetBit(mask);
+            const Ray& worldRay = packet.rays[i];
+            objectRays[i] = Ray(instance.worldToObject.TransformPoint(worldRay.origin),
+                instance.worldToObject.TransformVector(worldRay.direction),
+                worldRay.tMin, worldRay.tMax);
+            watertightRays[i] = WatertightRay(objectRays[i]);
+            objectPacket.SetRay(i, objectRays[i].origin, objectRays[i].direction, objectRays[i].tMin, worldRays->tMax[i]);
+        }
+        objectPacket.ComputeBounds();
+
+        TraverseBvh8Packet(blas.bvh8, m_bvh8Kernel, &objectPacket, [&](UINT primIndex, UINT64 primRayMask) -> UINT64
+        {
+            UINT64 terminated = 0;
+            for (; primRayMask; primRayMask &= primRayMask - 1)
+            {
+                const UINT i = LowestSetBit(primRayMask);
+                bool endSearch = false;
+                if (IntersectPrimitive(instanceIndex, primIndex, packet.rays[i], objectRays[i], watertightRays[i], rayFlags,
+                    rayContributionToHitGroupIndex, multiplierForGeometryContributionToHitGroupIndex, nullptr,
+                    objectPacket.tMax[i], &hits[i], &endSearch))
+                {
+                    hitMask |= 1ull << i;
+                    terminated |= static_cast<UINT64>(endSearch) << i;
+                }
+            }
+            return terminated;
+        });
+
+        for (UINT64 mask = rayMask; mask; mask &= mask - 1)
+        {
+            const UINT i = LowestSetBit(mask);
+            worldRays->tMax[i] = objectPacket.tMax[i];
+        }
+        return hitMask;
+    }
+
+    bool CpuScene::TraceRay(const Ray& ray,
+        UINT rayFlags,
+        UINT instanceInclusionMask,
+        UINT rayContributionToHitGroupIndex,
+        UINT multiplierForGeometryContributionToHitGroupIndex,
+        CpuHit* hit,
+        const CpuTraversalShaders* shaders) const
+    {
+        if (m_tlasDirty)
+        {
+            throw std::logic_error("Instance masks or transforms changed without CpuScene::UpdateTlas().");
+        }
+
+        float tMax = ray.tMax;
+        bool hasHit = false;
+        m_tlas.Traverse(ray, instanceInclusionMask, tMax, [&](UINT instanceIndex, float& currentTMax)
+        {
+            if ((m_instances[instanceIndex].instanceMask & instanceInclusionMask & 0xFF) == 0)
+            {
+                return false;
+            }
+
+            bool endSearch = false;
+            if (!IntersectInstance(instanceIndex, ray, rayFlags, rayContributionToHitGroupIndex,
+                multiplierForGeometryContributionToHitGroupIndex, shaders, currentTMax, hit, &endSearch))
+            {
+                return false;
+            }
+            hasHit = true;
+            return endSearch;
+        });
+        return hasHit;
+    }
+
+    UINT64 CpuScene::TraceRayPacket(const RayPacket& packet,
+        UINT rayFlags,
+        UINT instanceInclusionMask,
+        UINT rayContributionToHitGroupIndex,
+        UINT multiplierForGeometryContributionToHitGroupIndex,
+        CpuHit* hits) const
+    {
+        if (m_tlasDirty)
+        {
+            throw std::logic_error("Instance masks or transforms changed without CpuScene::UpdateTlas().");
+        }
+
+        const UINT rayCount = packet.GetRayCount();
+        if (rayCount > c_rayPacketSize)
+        {
+            throw std::invalid_argument("Ray packets hold at most 8x8 rays.");
+        }
+
+        PacketTraversalRays worldRays;
+        worldRays.count = rayCount;
+        worldRays.activeMask = (rayCount == 64) ? ~0ull : (1ull << rayCount) - 1;
+        for (UINT i = 0; i < rayCount; i++)
+        {
+            const Ray& ray = packet.rays[i];
+            worldRays.SetRay(i, ray.origin, ray.direction, ray.tMin, ray.tMax);
+        }
+        worldRays.ComputeBounds();
+
+        UINT64 hitMask = 0;
+        if (!worldRays.HasCullingBounds())
+        {
+            // Divergent packet: nothing to share, trace the rays one by one.
+            for (UINT i = 0; i < rayCount; i++)
+            {
+                if (TraceRay(packet.rays[i], rayFlags, instanceInclusionMask, rayContributionToHitGroupIndex,
+                    multiplierForGeometryContributionToHitGroupIndex, &hits[i]))
+                {
+                    hitMask |= 1ull << i;
+                }
+            }
+            return hitMask;
+        }
+
+        const bool acceptFirstHit = (rayFlags & RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH) != 0;
+        m_tlas.TraversePacket(&worldRays, instanceInclusionMask, [&](UINT instanceIndex, UINT64 rayMask) -> UINT64
+        {
+            if ((m_instances[instanceIndex].instanceMask & instanceInclusionMask & 0xFF) == 0)
+            {
+                return 0;
+            }
+
+            UINT64 committed = IntersectInstancePacket(instanceIndex, packet, &worldRays, rayMask, rayFlags,
+                rayContributionToHitGroupIndex, multiplierForGeometryContributionToHitGroupIndex, hits);
+            hitMask |= committed;
+            return acceptFirstHit ? committed : 0;
+        });
+        return hitMask;
+    }
+}
@@ -0,0 +1,327 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// CPU counterpart of the acceleration structures a sample builds in BuildAccelerationStructures().
+// Consumes the same GeomDesc/DxBlasDesc/DxTlasDesc lists and follows DXR traversal rules
+// (instance masks, ray flags, triangle facing, hit group indexing) so images can be validated without a GPU.
+
+#include "TestCaseDesc.h"
+#include "CpuMath.h"
+#include "CpuBvh.h"
+#include "Bvh8.h"
+#include "WatertightTriangle.h"
+#include "CpuGeometry.h"
+#include "CpuTlas.h"
+#include "CpuRayPacket.h"
+#include "CpuShaderTable.h"
+#include "BinnedSahBuilder.h"
+#include "MortonBuilder.h"
+#include <functional>
+
+namespace CpuRT
+{
+    // Values match the HLSL RAY_FLAG enumeration.
+    enum RAY_FLAG : UINT
+    {
+        RAY_FLAG_NONE = 0x00,
+        RAY_FLAG_FORCE_OPAQUE = 0x01,
+        RAY_FLAG_FORCE_NON_OPAQUE = 0x02,
+        RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH = 0x04,
+        RAY_FLAG_SKIP_CLOSEST_HIT_SHADER = 0x08,
+        RAY_FLAG_CULL_BACK_FACING_TRIANGLES = 0x10,
+        RAY_FLAG_CULL_FRONT_FACING_TRIANGLES = 0x20,
+        RAY_FLAG_CULL_OPAQUE = 0x40,
+        RAY_FLAG_CULL_NON_OPAQUE = 0x80
+    };
+
+    // Values match the HLSL HIT_KIND enumeration.
+    enum HIT_KIND : UINT
+    {
+        HIT_KIND_TRIANGLE_FRONT_FACE = 0xFE,
+        HIT_KIND_TRIANGLE_BACK_FACE = 0xFF
+    };
+
+    static const UINT c_maxAttributeSizeInFloats = 8;
+
+    // Everything a closest hit shader can query about a committed hit.
+    struct CpuHit
+    {
+        float t;
+        UINT hitKind;
+        // BuiltInTriangleIntersectionAttributes.barycentrics for triangles, user attributes for procedural geometry.
+        float attributes[c_maxAttributeSizeInFloats];
+        UINT instanceIndex;
+        UINT instanceID;
+        UINT geometryIndex;
+        UINT primitiveIndex;
+        UINT hitGroupIndex;
+        D3D12_RAYTRACING_GEOMETRY_TYPE geometryType;
+        float3 objectRayOrigin;
+        float3 objectRayDirection;
+
+        float2 Barycentrics() const { return float2(attributes[0], attributes[1]); }
+    };
+
+    // Everything an intersection shader can query for a candidate AABB.
+    struct CpuIntersectionInput
+    {
+        Ray worldRay;
+        Ray objectRay;          // tMax holds RayTCurrent().
+        AABB aabb;              // Object space bounds of the procedural primitive.
+        UINT instanceIndex;
+        UINT instanceID;
+        UINT geometryIndex;
+        UINT primitiveIndex;
+        UINT hitGroupIndex;
+    };
+
+    // Intersection shader stand-in. Returns true to report a hit at *tHit with *hitKind and attributes.
+    // The hit is accepted only if tHit lies within [RayTMin(), RayTCurrent()], as with ReportHit().
+    typedef std::function<bool(const CpuIntersectionInput& input, float* tHit, UINT* hitKind, float* attributes)> CpuIntersectionFunc;
+
+    // How an any hit shader ended: returning normally accepts the candidate.
+    namespace CpuAnyHitResult
+    {
+        enum Enum
+        {
+            Accept,
+            IgnoreHit,
+            AcceptHitAndEndSearch
+        };
+    }
+
+    class CpuHitReporter;
+
+    // Shader stages a raytracing pipeline plugs into one TraceRay() call (see CpuRaytracingPipeline.h).
+    // Function pointers and a context keep traversal free of virtual calls.
+    struct CpuTraversalShaders
+    {
+        void* context;
+        // Intersection shader of a procedural primitive's hit group; replaces the scene's intersection function.
+        // Reports hits through reporter->ReportHit().
+        void (*intersection)(void* context, const CpuIntersectionInput& input, CpuHitReporter* reporter);
+        // Any hit shader, invoked for non-opaque candidates only. Null accepts every candidate.
+        CpuAnyHitResult::Enum (*anyHit)(void* context, const CpuHit& candidate);
+    };
+
+    // Commits the hits of one candidate primitive following DXR rules.
+    class CpuHitReporter
+    {
+    public:
+        CpuHitReporter(const CpuTraversalShaders* shaders, bool opaque, bool acceptFirstHit, float tMin, float* tMax,
+            const CpuHit& candidate, CpuHit* hit);
+
+        // Equivalent of HLSL ReportHit(): hits outside [RayTMin(), RayTCurrent()] and hits the any hit shader
+        // ignores return false, others are committed and shrink RayTCurrent(). After the search has ended,
+        // e.g. by AcceptHitAndEndSearch(), further hits are rejected.
+        bool ReportHit(float tHit, UINT hitKind, const void* attributes, UINT attributesSize);
+
+        float RayTCurrent() const { return *m_tMax; }
+        bool HasCommittedHit() const { return m_committed; }
+        bool IsSearchEnded() const { return m_endSearch; }
+
+    private:
+        const CpuTraversalShaders* m_shaders;
+        CpuHit m_candidate;
+        CpuHit* m_hit;
+        float m_tMin;
+        float* m_tMax;
+        bool m_opaque;
+        bool m_acceptFirstHit;
+        bool m_committed;
+        bool m_endSearch;
+    };
+
+    // Bottom level acceleration structure. Primitives keep their own copy of the source data,
+    // so geometry buffers only need to stay alive until CpuScene::Build returns.
+    struct CpuBlas
+    {
+        struct Geometry
+        {
+            D3D12_RAYTRACING_GEOMETRY_TYPE type;
+            D3D12_RAYTRACING_GEOMETRY_FLAGS flags;
+        };
+
+        // Triangles store their vertices, AABBs store min/max in v0/v1.
+        struct Primitive
+        {
+            float3 v0;
+            float3 v1;
+            float3 v2;
+            UINT geometryIndex;
+            UINT primitiveIndex;
+        };
+
+        std::vector<Geometry> geometries;
+        std::vector<Primitive> primitives;
+        Bvh bvh;
+        Bvh8 bvh8;              // Collapsed from bvh, used for traversal.
+        AABB bounds;
+    };
+
+    class CpuScene
+    {
+    public:
+        CpuScene();
+
+        // Geometry slots mirror the sample's vertex/index/AABB buffer arrays: GeomDesc::geomIndex selects
+        // the triangle slot for D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES and the AABB slot otherwise.
+        void SetTriangleGeometry(UINT slot, const CpuTriangleGeometryDesc& desc);
+        void SetAABBGeometry(UINT slot, const CpuAABBGeometryDesc& desc);
+        void SetIntersectionFunction(const CpuIntersectionFunc& intersectionFunc) { m_intersectionFunc = intersectionFunc; }
+        void SetBuildSettings(const BinnedSahBuildSettings& settings) { m_buildSettings = settings; }
+        void SetFastBuildSettings(const MortonBuildSettings& settings) { m_fastBuildSettings = settings; }
+
+        // D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD selects the Morton builder
+        // for BLAS and TLAS builds, anything else the binned SAH builder.
+        void SetBuildFlags(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags) { m_buildFlags = buildFlags; }
+
+        // BLAS traversal uses 8-wide nodes. The layout applies to the next Build(), the kernel defaults to
+        // the best one the CPU supports.
+        void SetBvh8Layout(Bvh8Layout::Enum layout) { m_bvh8Layout = layout; }
+        void SetBvh8Kernel(Bvh8Kernel::Enum kernel) { m_bvh8Kernel = kernel; }
+
+        // Builds one BLAS per DxBlasDesc, one instance per DxTlasDesc and the TLAS over them.
+        void Build(const std::vector<GeomDesc>& geomDescs,
+            const std::vector<DxBlasDesc>& blasDescs,
+            const std::vector<DxTlasDesc>& tlasDescs);
+
+        // Instances default to InstanceID 0, InstanceMask 0xFF and no flags, as in the samples.
+        // Mask and transform changes take effect after UpdateTlas(), as with instance desc changes on the GPU.
+        void SetInstanceID(UINT instanceIndex, UINT instanceID) { m_instances[instanceIndex].instanceID = instanceID; }
+        void SetInstanceFlags(UINT instanceIndex, UINT flags) { m_instances[instanceIndex].flags = flags; }
+        void SetInstanceMask(UINT instanceIndex, UINT instanceMask);
+        void SetInstanceTransform(UINT instanceIndex, const DirectX::XMFLOAT3X4& transformMatrix);
+
+        // Refits the TLAS to the current instance transforms and masks without rebuilding it.
+        void UpdateTlas();
+
+        // Equivalent of HLSL TraceRay() without closest hit or miss invocation: finds the closest (or first, with
+        // RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH) hit and resolves its hit group index. Intersection and any hit
+        // shaders run through shaders if given; otherwise non-opaque geometry commits like opaque geometry.
+        // Returns false on a miss; the caller runs its miss logic.
+        bool TraceRay(const Ray& ray,
+            UINT rayFlags,
+            UINT instanceInclusionMask,
+            UINT rayContributionToHitGroupIndex,
+            UINT multiplierForGeometryContributionToHitGroupIndex,
+            CpuHit* hit,
+            const CpuTraversalShaders* shaders = nullptr) const;
+
+        // TraceRay() for every ray of a packet with the same flags and hit group contributions. Coherent rays
+        // share traversal of the TLAS and of each instance's binary BVH; rays without a common direction sign
+        // on any axis are traced one by one. hits receives one entry per ray. Returns the mask of rays that hit.
+        // Each ray gets the same hit as from TraceRay(), except that among hits at exactly equal t a
+        // different one may be committed, as can happen on a GPU. Procedural geometry uses the scene's
+        // intersection function; pipeline shaders require TraceRay().
+        UINT64 TraceRayPacket(const RayPacket& packet,
+            UINT rayFlags,
+            UINT instanceInclusionMask,
+            UINT rayContributionToHitGroupIndex,
+            UINT multiplierForGeometryContributionToHitGroupIndex,
+            CpuHit* hits) const;
+
+        UINT GetBlasCount() const { return static_cast<UINT>(m_blas.size()); }
+        UINT GetInstanceCount() const { return static_cast<UINT>(m_instances.size()); }
+        const CpuBlas& GetBlas(UINT index) const { return m_blas[index]; }
+        const CpuInstance& GetInstance(UINT index) const { return m_instances[index]; }
+        const CpuTlas& GetTlas() const { return m_tlas; }
+
+    private:
+        void BuildBlas(const std::vector<GeomDesc>& geomDescs, const DxBlasDesc& blasDesc, CpuBlas* blas) const;
+        bool IntersectInstance(UINT instanceIndex,
+            const Ray& worldRay,
+            UINT rayFlags,
+            UINT rayContributionToHitGroupIndex,
+            UINT multiplierForGeometryContributionToHitGroupIndex,
+            const CpuTraversalShaders* shaders,
+            float& tMax,
+            CpuHit* hit,
+            bool* endSearch) const;
+        UINT64 IntersectInstancePacket(UINT instanceIndex,
+            const RayPacket& packet,
+            PacketTraversalRays* worldRays,
+            UINT64 rayMask,
+            UINT rayFlags,
+            UINT rayContributionToHitGroupIndex,
+            UINT multiplierForGeometryContributionToHitGroupIndex,
+            CpuHit* hits) const;
+        bool IntersectPrimitive(UINT instanceIndex,
+            UINT primIndex,
+            const Ray& worldRay,
+            const Ray& objectRay,
+            const WatertightRay& watertightRay,
+            UINT rayFlags,
+            UINT rayContributionToHitGroupIndex,
+            UINT multiplierForGeometryContributionToHitGroupIndex,
+            const CpuTraversalShaders* shaders,
+            float& tMax,
+            CpuHit* hit,
+            bool* endSearch) const;
+
+        std::vector<CpuTriangleGeometryDesc> m_triangleGeometry;
+        std::vector<CpuAABBGeometryDesc> m_aabbGeometry;
+        std::vector<CpuBlas> m_blas;
+        std::vector<CpuInstance> m_instances;
+        CpuTlas m_tlas;
+        CpuIntersectionFunc m_intersectionFunc;
+        BinnedSahBuildSettings m_buildSettings;
+        MortonBuildSettings m_fastBuildSettings;
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS m_buildFlags;
+        Bvh8Layout::Enum m_bvh8Layout;
+        Bvh8Kernel::Enum m_bvh8Kernel;
+        bool m_tlasDirty;
+    };
+
+    // Reference Moller-Trumbore test, not watertight; TraceRay() uses IntersectRayTriangleWatertight().
+    // Returns DXR barycentrics (weights of v1 and v2) and the signed determinant.
+    // A positive determinant means the triangle is clockwise as seen along the ray, i.e. front facing by default.
+    inline bool IntersectRayTriangle(const Ray& ray, const float3& v0, const float3& v1, const float3& v2,
+        float tMax, float* t, float2* barycentrics, float* determinant)
+    {
+        float3 e1 = v1 - v0;
+        float3 e2 = v2 - v0;
+        float3 p = cross(ray.direction, e2);
+        float det = dot(e1, p);
+        if (det == 0.0f)
+        {
+            return false;
+        }
+
+        float invDet = 1.0f / det;
+        float3 s = ray.origin - v0;
+        float u = dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+
+        float3 q = cross(s, e1);
+        float v = dot(ray.direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+
+        float tHit = dot(e2, q) * invDet;
+        if (tHit < ray.tMin || tHit > tMax)
+        {
+            return false;
+        }
+
+        *t = tHit;
+        *barycentrics = float2(u, v);
+        *determinant = det;
+        return true;
+    }
+}
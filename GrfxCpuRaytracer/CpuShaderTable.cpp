@@ -0,0 +1,194 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuShaderTable.h"
+#include "CpuScene.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace CpuRT
+{
+    namespace
+    {
+        UINT64 AlignUp(UINT64 value, UINT64 alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    CpuShaderIdentifier CpuShaderIdentifier::FromName(const char* exportName)
+    {
+        // 64-bit FNV-1a of the name, re-seeded per 8-byte word so every byte of the identifier depends on it.
+        CpuShaderIdentifier identifier;
+        for (UINT word = 0; word < sizeof(identifier.bytes) / 8; word++)
+        {
+            UINT64 hash = 14695981039346656037ull ^ word;
+            for (const char* c = exportName; *c; c++)
+            {
+                hash = (hash ^ static_cast<UINT8>(*c)) * 1099511628211ull;
+            }
+            for (UINT i = 0; i < 8; i++)
+            {
+                identifier.bytes[word * 8 + i] = static_cast<UINT8>(hash >> (8 * i));
+            }
+        }
+        return identifier;
+    }
+
+    bool CpuShaderIdentifier::operator==(const CpuShaderIdentifier& other) const
+    {
+        return memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+
+    CpuShaderTable::CpuShaderTable(UINT numShaderRecords, UINT shaderRecordSize, const char* name) :
+        m_shaderRecordSize(static_cast<UINT>(AlignUp(shaderRecordSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT))),
+        m_numShaderRecords(numShaderRecords),
+        m_recordCount(0),
+        m_name(name ? name : "")
+    {
+        m_storage.assign(GetSizeInBytes() + D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT, 0);
+        size_t address = reinterpret_cast<size_t>(m_storage.data());
+        m_data = m_storage.data() + (AlignUp(address, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT) - address);
+    }
+
+    void CpuShaderTable::push_back(const void* shaderIdentifier, UINT shaderIdentifierSize,
+        const void* localRootArguments, UINT localRootArgumentsSize)
+    {
+        if (m_recordCount >= m_numShaderRecords)
+        {
+            throw std::length_error("Shader table " + m_name + " is full.");
+        }
+        if (static_cast<UINT64>(shaderIdentifierSize) + localRootArgumentsSize > m_shaderRecordSize)
+        {
+            throw std::length_error("Shader record does not fit the record size of shader table " + m_name + ".");
+        }
+
+        UINT8* record = m_data + static_cast<size_t>(m_recordCount) * m_shaderRecordSize;
+        memcpy(record, shaderIdentifier, shaderIdentifierSize);
+        if (localRootArguments)
+        {
+            memcpy(record + shaderIdentifierSize, localRootArguments, localRootArgumentsSize);
+        }
+        m_recordCount++;
+    }
+
+    bool ResolveShaderRecord(const CpuShaderTableRange& range, UINT recordIndex, CpuShaderRecord* record)
+    {
+        const UINT64 byteOffset = range.strideInBytes * recordIndex;
+        if (range.startAddress == nullptr || byteOffset + sizeof(CpuShaderIdentifier) > range.sizeInBytes)
+        {
+            return false;
+        }
+
+        record->shaderIdentifier = reinterpret_cast<const CpuShaderIdentifier*>(range.startAddress + byteOffset);
+        record->localRootArguments = range.startAddress + byteOffset + sizeof(CpuShaderIdentifier);
+        record->recordIndex = recordIndex;
+        record->byteOffset = byteOffset;
+        return true;
+    }
+
+    namespace
+    {
+        void ValidateRange(const CpuShaderTableRange& range, const char* tableName, bool hasStride, UINT localRootArgumentsSize,
+            std::vector<std::string>* errors)
+        {
+            auto AddError = [&](const std::string& message)
+            {
+                errors->push_back(std::string(tableName) + ": " + message);
+            };
+
+            if (reinterpret_cast<size_t>(range.startAddress) % D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT != 0)
+            {
+                AddError("StartAddress is not aligned to D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT.");
+            }
+            if (!hasStride)
+            {
+                if (range.sizeInBytes < sizeof(CpuShaderIdentifier) + localRootArgumentsSize)
+                {
+                    AddError("SizeInBytes " + std::to_string(range.sizeInBytes) + " is smaller than the shader identifier and "
+                        + std::to_string(localRootArgumentsSize) + " bytes of local root arguments.");
+                }
+                return;
+            }
+
+            if (range.strideInBytes % D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT != 0)
+            {
+                AddError("StrideInBytes " + std::to_string(range.strideInBytes)
+                    + " is not a multiple of D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT.");
+            }
+            if (range.strideInBytes > c_maxShaderRecordStride)
+            {
+                AddError("StrideInBytes " + std::to_string(range.strideInBytes) + " exceeds D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE.");
+            }
+            // A zero stride makes every index read the first record, which is legal.
+            if (range.strideInBytes != 0 && range.strideInBytes < sizeof(CpuShaderIdentifier) + localRootArgumentsSize)
+            {
+                AddError("StrideInBytes " + std::to_string(range.strideInBytes) + " is smaller than the shader identifier and "
+                    + std::to_string(localRootArgumentsSize) + " bytes of local root arguments, so records overlap.");
+            }
+        }
+
+        void ValidateRecord(const CpuShaderTableRange& range, const char* tableName, UINT recordIndex, UINT localRootArgumentsSize,
+            const std::string& reachedBy, std::vector<std::string>* errors)
+        {
+            CpuShaderRecord record;
+            if (!ResolveShaderRecord(range, recordIndex, &record))
+            {
+                errors->push_back(std::string(tableName) + ": record " + std::to_string(recordIndex) + " at byte offset "
+                    + std::to_string(range.strideInBytes * recordIndex) + " lies outside SizeInBytes "
+                    + std::to_string(range.sizeInBytes) + ", reached by " + reachedBy + ".");
+            }
+            else if (record.byteOffset + sizeof(CpuShaderIdentifier) + localRootArgumentsSize > range.sizeInBytes)
+            {
+                errors->push_back(std::string(tableName) + ": local root arguments of record " + std::to_string(recordIndex)
+                    + " extend past SizeInBytes " + std::to_string(range.sizeInBytes) + ", reached by " + reachedBy + ".");
+            }
+        }
+    }
+
+    std::vector<std::string> ValidateShaderTables(const CpuShaderTableBindings& bindings,
+        const CpuScene& scene,
+        const CpuShaderTableUsage& usage)
+    {
+        std::vector<std::string> errors;
+        ValidateRange(bindings.rayGenerationShaderRecord, "RayGenerationShaderRecord", false, usage.rayGenerationLocalRootArgumentsSize, &errors);
+        ValidateRange(bindings.missShaderTable, "MissShaderTable", true, usage.missLocalRootArgumentsSize, &errors);
+        ValidateRange(bindings.hitGroupTable, "HitGroupTable", true, usage.hitGroupLocalRootArgumentsSize, &errors);
+
+        for (size_t callIndex = 0; callIndex < usage.traceRayCalls.size(); callIndex++)
+        {
+            const CpuShaderTableUsage::TraceRayCall& call = usage.traceRayCalls[callIndex];
+            const std::string callName = "TraceRay call " + std::to_string(callIndex);
+
+            ValidateRecord(bindings.missShaderTable, "MissShaderTable", call.missShaderIndex & 0xFFFF, usage.missLocalRootArgumentsSize,
+                callName, &errors);
+
+            // Instances that can never be hit (InstanceMask 0) do not reach any record.
+            for (UINT instanceIndex = 0; instanceIndex < scene.GetInstanceCount(); instanceIndex++)
+            {
+                const CpuInstance& instance = scene.GetInstance(instanceIndex);
+                if (instance.instanceMask == 0)
+                {
+                    continue;
+                }
+                const CpuBlas& blas = scene.GetBlas(instance.blasIndex);
+                for (UINT geometryIndex = 0; geometryIndex < static_cast<UINT>(blas.geometries.size()); geometryIndex++)
+                {
+                    UINT hitGroupIndex = ComputeHitGroupIndex(call.rayContributionToHitGroupIndex,
+                        call.multiplierForGeometryContributionToHitGroupIndex, geometryIndex, instance.instanceContributionToHitGroupIndex);
+                    ValidateRecord(bindings.hitGroupTable, "HitGroupTable", hitGroupIndex, usage.hitGroupLocalRootArgumentsSize,
+                        callName + " on instance " + std::to_string(instanceIndex) + " geometry " + std::to_string(geometryIndex), &errors);
+                }
+            }
+        }
+        return errors;
+    }
+}
@@ -0,0 +1,170 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// CPU model of the ShaderTable/ShaderRecord helpers in DirectXRaytracingHelper.h and of the shader table
+// ranges of D3D12_DISPATCH_RAYS_DESC. Records are laid out in a flat byte buffer exactly as the samples
+// upload them, and are looked up with the DXR addressing rules, so a table that a sample builds can be
+// rebuilt and checked on the CPU.
+
+#include "D3D12Compat.h"
+#include <string>
+#include <vector>
+
+namespace CpuRT
+{
+    class CpuScene;
+
+    // Largest stride D3D12 accepts for a shader table (D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE).
+    static const UINT c_maxShaderRecordStride = 4096;
+
+    // Shader identifiers are opaque on the GPU. On the CPU any 32 bytes work; FromName() derives them
+    // from the export name so records can be matched against the hit groups a test case defines.
+    struct CpuShaderIdentifier
+    {
+        UINT8 bytes[D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES];
+
+        static CpuShaderIdentifier FromName(const char* exportName);
+
+        bool operator==(const CpuShaderIdentifier& other) const;
+        bool operator!=(const CpuShaderIdentifier& other) const { return !(*this == other); }
+    };
+
+    // Counterpart of ShaderTable: records of shaderRecordSize rounded up to D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT,
+    // appended in order. The buffer starts on a D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT boundary, like the
+    // upload buffer the sample allocates, and is zero-filled where the GPU buffer would be uninitialized.
+    class CpuShaderTable
+    {
+    public:
+        CpuShaderTable(UINT numShaderRecords, UINT shaderRecordSize, const char* name = nullptr);
+        CpuShaderTable(const CpuShaderTable&) = delete;
+        CpuShaderTable& operator=(const CpuShaderTable&) = delete;
+        CpuShaderTable(CpuShaderTable&&) = default;
+        CpuShaderTable& operator=(CpuShaderTable&&) = default;
+
+        // Same arguments as ShaderRecord. A null localRootArguments leaves the argument bytes untouched, as
+        // ShaderRecord::CopyTo() does. Throws if the table is full or the record does not fit the record size,
+        // which ShaderTable would silently write past.
+        void push_back(const void* shaderIdentifier, UINT shaderIdentifierSize,
+            const void* localRootArguments = nullptr, UINT localRootArgumentsSize = 0);
+        void push_back(const CpuShaderIdentifier& shaderIdentifier,
+            const void* localRootArguments = nullptr, UINT localRootArgumentsSize = 0)
+        {
+            push_back(shaderIdentifier.bytes, sizeof(shaderIdentifier.bytes), localRootArguments, localRootArgumentsSize);
+        }
+
+        UINT GetShaderRecordSize() const { return m_shaderRecordSize; }
+        UINT GetNumShaderRecords() const { return m_numShaderRecords; }
+        UINT GetRecordCount() const { return m_recordCount; }
+        const std::string& GetName() const { return m_name; }
+
+        // Equivalents of GetGPUVirtualAddress() and GetDesc().Width of the table's resource.
+        const UINT8* GetStartAddress() const { return m_data; }
+        UINT64 GetSizeInBytes() const { return static_cast<UINT64>(m_numShaderRecords) * m_shaderRecordSize; }
+
+    private:
+        std::vector<UINT8> m_storage;
+        UINT8* m_data;
+        UINT m_shaderRecordSize;
+        UINT m_numShaderRecords;
+        UINT m_recordCount;
+        std::string m_name;
+    };
+
+    // D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE with CPU addresses. The ray generation record ignores the stride.
+    struct CpuShaderTableRange
+    {
+        const UINT8* startAddress;
+        UINT64 sizeInBytes;
+        UINT64 strideInBytes;
+
+        CpuShaderTableRange() : startAddress(nullptr), sizeInBytes(0), strideInBytes(0) {}
+        CpuShaderTableRange(const CpuShaderTable& table, UINT64 stride) :
+            startAddress(table.GetStartAddress()), sizeInBytes(table.GetSizeInBytes()), strideInBytes(stride) {}
+    };
+
+    // The shader table fields of D3D12_DISPATCH_RAYS_DESC.
+    struct CpuShaderTableBindings
+    {
+        CpuShaderTableRange rayGenerationShaderRecord;
+        CpuShaderTableRange missShaderTable;
+        CpuShaderTableRange hitGroupTable;
+        CpuShaderTableRange callableShaderTable;
+    };
+
+    // A record located in a table. localRootArguments points just past the identifier; how many argument
+    // bytes are valid depends on the local root signature, at most the stride minus the identifier size.
+    struct CpuShaderRecord
+    {
+        const CpuShaderIdentifier* shaderIdentifier;
+        const UINT8* localRootArguments;
+        UINT recordIndex;
+        UINT64 byteOffset;
+
+        template <typename T>
+        const T& GetLocalRootArguments() const { return *reinterpret_cast<const T*>(localRootArguments); }
+    };
+
+    // Hit group record index of DXR: only the low 4 bits of the ray contribution and the geometry multiplier
+    // and the low 24 bits of the instance contribution take part.
+    inline UINT ComputeHitGroupIndex(UINT rayContributionToHitGroupIndex,
+        UINT multiplierForGeometryContributionToHitGroupIndex,
+        UINT geometryIndex,
+        UINT instanceContributionToHitGroupIndex)
+    {
+        return (rayContributionToHitGroupIndex & 0xF)
+            + (multiplierForGeometryContributionToHitGroupIndex & 0xF) * geometryIndex
+            + (instanceContributionToHitGroupIndex & 0xFFFFFF);
+    }
+
+    // Record lookups in O(1): the address is StartAddress + StrideInBytes * index, as on the GPU. Out of range
+    // records, undefined behavior on the GPU, return false. A record is in range if its shader identifier lies
+    // within SizeInBytes.
+    bool ResolveShaderRecord(const CpuShaderTableRange& range, UINT recordIndex, CpuShaderRecord* record);
+    inline bool ResolveHitGroupRecord(const CpuShaderTableBindings& bindings, UINT hitGroupIndex, CpuShaderRecord* record)
+    {
+        return ResolveShaderRecord(bindings.hitGroupTable, hitGroupIndex, record);
+    }
+    // Only the low 16 bits of MissShaderIndex are used.
+    inline bool ResolveMissRecord(const CpuShaderTableBindings& bindings, UINT missShaderIndex, CpuShaderRecord* record)
+    {
+        return ResolveShaderRecord(bindings.missShaderTable, missShaderIndex & 0xFFFF, record);
+    }
+    inline bool ResolveRayGenerationRecord(const CpuShaderTableBindings& bindings, CpuShaderRecord* record)
+    {
+        return ResolveShaderRecord(bindings.rayGenerationShaderRecord, 0, record);
+    }
+
+    // How a sample's shaders index the tables: the RayContributionToHitGroupIndex, geometry multiplier and
+    // MissShaderIndex of each of its TraceRay() calls, and the local root argument sizes its records need.
+    struct CpuShaderTableUsage
+    {
+        struct TraceRayCall
+        {
+            UINT rayContributionToHitGroupIndex;
+            UINT multiplierForGeometryContributionToHitGroupIndex;
+            UINT missShaderIndex;
+        };
+
+        std::vector<TraceRayCall> traceRayCalls;
+        UINT rayGenerationLocalRootArgumentsSize = 0;
+        UINT missLocalRootArgumentsSize = 0;
+        UINT hitGroupLocalRootArgumentsSize = 0;
+    };
+
+    // Checks the ranges against the D3D12 alignment and stride rules and resolves every record the scene's
+    // instances and geometries can reach through the usage. Returns one message per problem, empty if the
+    // tables are valid.
+    std::vector<std::string> ValidateShaderTables(const CpuShaderTableBindings& bindings,
+        const CpuScene& scene,
+        const CpuShaderTableUsage& usage);
+}
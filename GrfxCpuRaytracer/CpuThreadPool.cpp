@@ -0,0 +1,199 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuThreadPool.h"
+
+namespace CpuRT
+{
+    namespace
+    {
+        UINT64 PackRange(UINT begin, UINT end) { return (static_cast<UINT64>(begin) << 32) | end; }
+        UINT RangeBegin(UINT64 range) { return static_cast<UINT>(range >> 32); }
+        UINT RangeEnd(UINT64 range) { return static_cast<UINT>(range); }
+        UINT RangeSize(UINT64 range) { return RangeEnd(range) > RangeBegin(range) ? RangeEnd(range) - RangeBegin(range) : 0; }
+    }
+
+    CpuThreadPool::CpuThreadPool(UINT numThreads) :
+        m_threadCount(numThreads ? numThreads : (std::max)(1u, std::thread::hardware_concurrency())),
+        m_slices(new Slice[m_threadCount]),
+        m_generation(0),
+        m_activeWorkers(0),
+        m_shutdown(false),
+        m_task(nullptr),
+        m_abort(false)
+    {
+        for (UINT i = 0; i < m_threadCount; i++)
+        {
+            m_slices[i].range.store(0, std::memory_order_relaxed);
+        }
+        for (UINT i = 1; i < m_threadCount; i++)
+        {
+            m_threads.emplace_back(&CpuThreadPool::WorkerMain, this, i);
+        }
+    }
+
+    CpuThreadPool::~CpuThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void CpuThreadPool::Run(UINT taskCount, const TaskFunc& task)
+    {
+        std::lock_guard<std::mutex> runLock(m_runMutex);
+        if (taskCount == 0)
+        {
+            return;
+        }
+
+        // Equal contiguous slices keep neighbouring tiles on one thread until stealing is needed.
+        for (UINT i = 0; i < m_threadCount; i++)
+        {
+            UINT begin = static_cast<UINT>(static_cast<UINT64>(taskCount) * i / m_threadCount);
+            UINT end = static_cast<UINT>(static_cast<UINT64>(taskCount) * (i + 1) / m_threadCount);
+            m_slices[i].range.store(PackRange(begin, end), std::memory_order_relaxed);
+        }
+        m_task = &task;
+        m_abort.store(false, std::memory_order_relaxed);
+        m_exception = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeWorkers = m_threadCount - 1;
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        Work(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_activeWorkers == 0; });
+        m_task = nullptr;
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+    void CpuThreadPool::WorkerMain(UINT threadIndex)
+    {
+        UINT64 generation = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&]() { return m_shutdown || m_generation != generation; });
+                if (m_shutdown)
+                {
+                    return;
+                }
+                generation = m_generation;
+            }
+
+            Work(threadIndex);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_activeWorkers == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    void CpuThreadPool::Work(UINT threadIndex)
+    {
+        UINT taskIndex;
+        while (!m_abort.load(std::memory_order_relaxed))
+        {
+            if (!PopTask(threadIndex, &taskIndex))
+            {
+                if (!Steal(threadIndex))
+                {
+                    // Every slice is empty. Tasks in flight between a victim and a thief are
+                    // finished by the thief.
+                    return;
+                }
+                continue;
+            }
+
+            try
+            {
+                (*m_task)(taskIndex, threadIndex);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_exception)
+                {
+                    m_exception = std::current_exception();
+                }
+                m_abort.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool CpuThreadPool::PopTask(UINT threadIndex, UINT* taskIndex)
+    {
+        std::atomic<UINT64>& slice = m_slices[threadIndex].range;
+        UINT64 range = slice.load(std::memory_order_acquire);
+        while (RangeSize(range) > 0)
+        {
+            if (slice.compare_exchange_weak(range, PackRange(RangeBegin(range) + 1, RangeEnd(range)), std::memory_order_acq_rel))
+            {
+                *taskIndex = RangeBegin(range);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool CpuThreadPool::Steal(UINT threadIndex)
+    {
+        for (;;)
+        {
+            // Steal from the largest slice so each theft moves as much work as possible.
+            UINT victim = threadIndex;
+            UINT64 victimRange = 0;
+            for (UINT i = 1; i < m_threadCount; i++)
+            {
+                UINT candidate = (threadIndex + i) % m_threadCount;
+                UINT64 range = m_slices[candidate].range.load(std::memory_order_acquire);
+                if (RangeSize(range) > RangeSize(victimRange))
+                {
+                    victim = candidate;
+                    victimRange = range;
+                }
+            }
+            if (victim == threadIndex)
+            {
+                return false;
+            }
+
+            // Take the back half, leaving the front to the owner, which pops from there.
+            UINT begin = RangeBegin(victimRange);
+            UINT end = RangeEnd(victimRange);
+            UINT split = end - (end - begin + 1) / 2;
+            if (m_slices[victim].range.compare_exchange_strong(victimRange, PackRange(begin, split), std::memory_order_acq_rel))
+            {
+                // Only this thread refills its own empty slice; thieves ignore it until then.
+                m_slices[threadIndex].range.store(PackRange(split, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Persistent work-stealing thread pool for data-parallel loops such as tiled DispatchRays.
+//
+// Each Run() hands every worker a contiguous slice of the task range. Workers take tasks from the
+// front of their own slice and, once it is empty, steal the back half of the largest remaining
+// slice, so a few expensive tasks do not leave the other threads idle.
+
+#include "D3D12Compat.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CpuRT
+{
+    class CpuThreadPool
+    {
+    public:
+        // Called once per task; threadIndex is in [0, GetThreadCount()) and unique among concurrent calls.
+        typedef std::function<void(UINT taskIndex, UINT threadIndex)> TaskFunc;
+
+        // numThreads includes the thread calling Run(); 0 selects the hardware thread count.
+        explicit CpuThreadPool(UINT numThreads = 0);
+        ~CpuThreadPool();
+
+        CpuThreadPool(const CpuThreadPool&) = delete;
+        CpuThreadPool& operator=(const CpuThreadPool&) = delete;
+
+        UINT GetThreadCount() const { return m_threadCount; }
+
+        // Runs task(i, threadIndex) for every i in [0, taskCount) and returns when all have finished.
+        // The calling thread works as thread 0. The first exception thrown by a task is rethrown here
+        // after the remaining tasks are abandoned. Tasks must not call Run() on the same pool.
+        void Run(UINT taskCount, const TaskFunc& task);
+
+    private:
+        // Remaining task range [begin, end) of one worker, packed as (begin << 32) | end so the owner
+        // and thieves can update it with a single compare-exchange.
+        struct alignas(64) Slice
+        {
+            std::atomic<UINT64> range;
+        };
+
+        void WorkerMain(UINT threadIndex);
+        void Work(UINT threadIndex);
+        bool PopTask(UINT threadIndex, UINT* taskIndex);
+        bool Steal(UINT threadIndex);
+
+        UINT m_threadCount;
+        std::unique_ptr<Slice[]> m_slices;
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_runMutex;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        UINT64 m_generation;
+        UINT m_activeWorkers;
+        bool m_shutdown;
+
+        const TaskFunc* m_task;
+        std::atomic<bool> m_abort;
+        std::exception_ptr m_exception;
+    };
+}
@@ -0,0 +1,71 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuTlas.h"
+#include "BinnedSahBuilder.h"
+#include "MortonBuilder.h"
+
+namespace CpuRT
+{
+    void CpuTlas::Build(const std::vector<CpuInstance>& instances, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+    {
+        std::vector<AABB> instanceBounds(instances.size());
+        for (size_t i = 0; i < instances.size(); i++)
+        {
+            instanceBounds[i] = instances[i].worldBounds;
+        }
+
+        // Instance tests transform the ray and traverse a BLAS, so leaves hold a single instance.
+        UINT instanceCount = static_cast<UINT>(instanceBounds.size());
+        if (buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD)
+        {
+            MortonBuildSettings settings;
+            settings.maxLeafSize = 1;
+            BuildBvhMorton(instanceBounds.data(), instanceCount, settings, &m_bvh);
+        }
+        else
+        {
+            BinnedSahBuildSettings settings;
+            settings.maxLeafSize = 1;
+            BuildBvhBinnedSah(instanceBounds.data(), instanceCount, settings, &m_bvh);
+        }
+
+        Refit(instances);
+    }
+
+    void CpuTlas::Refit(const std::vector<CpuInstance>& instances)
+    {
+        m_nodeMasks.resize(m_bvh.nodes.size());
+        for (size_t i = m_bvh.nodes.size(); i-- > 0;)
+        {
+            BvhNode& node = m_bvh.nodes[i];
+            AABB bounds;
+            UINT mask = 0;
+            if (node.IsLeaf())
+            {
+                for (UINT j = 0; j < node.primCount; j++)
+                {
+                    const CpuInstance& instance = instances[m_bvh.primIndices[node.leftOrFirst + j]];
+                    bounds.Grow(instance.worldBounds);
+                    mask |= instance.instanceMask;
+                }
+            }
+            else
+            {
+                bounds = m_bvh.nodes[node.leftOrFirst].bounds;
+                bounds.Grow(m_bvh.nodes[node.leftOrFirst + 1].bounds);
+                mask = m_nodeMasks[node.leftOrFirst] | m_nodeMasks[node.leftOrFirst + 1];
+            }
+            node.bounds = bounds;
+            m_nodeMasks[i] = mask;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Top level acceleration structure: a BVH over instance world bounds, the CPU counterpart of the
+// TLAS a sample builds from its D3D12_RAYTRACING_INSTANCE_DESCs.
+
+#include "CpuBvh.h"
+#include "CpuRayPacket.h"
+#include <vector>
+
+namespace CpuRT
+{
+    // CPU equivalent of D3D12_RAYTRACING_INSTANCE_DESC.
+    struct CpuInstance
+    {
+        Transform3x4 objectToWorld;
+        Transform3x4 worldToObject;
+        AABB worldBounds;
+        UINT blasIndex;
+        UINT instanceID;
+        UINT instanceMask;
+        UINT instanceContributionToHitGroupIndex;
+        UINT flags;             // D3D12_RAYTRACING_INSTANCE_FLAGS
+    };
+
+    class CpuTlas
+    {
+    public:
+        // Builds a BVH with one instance per leaf. Each node also keeps the union of the instance masks
+        // below it, so an InstanceInclusionMask prunes whole subtrees.
+        void Build(const std::vector<CpuInstance>& instances, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags);
+
+        // Recomputes node bounds and masks from the instances while keeping the tree topology,
+        // the equivalent of a TLAS build with D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE.
+        void Refit(const std::vector<CpuInstance>& instances);
+
+        // Visits instances whose world bounds the ray enters and whose mask passes the inclusion mask,
+        // nearest first. intersectInstance(instanceIndex, tMax) follows the TraverseBvh() contract.
+        template <typename IntersectInstanceFunc>
+        bool Traverse(const Ray& ray, UINT instanceInclusionMask, float& tMax, IntersectInstanceFunc&& intersectInstance) const
+        {
+            return TraverseBvh(m_bvh, ray, tMax,
+                [&](UINT nodeIndex) { return (m_nodeMasks[nodeIndex] & instanceInclusionMask & 0xFF) == 0; },
+                intersectInstance);
+        }
+
+        // Packet version of Traverse(). intersectInstance(instanceIndex, rayMask) follows the TraverseBvhPacket() contract.
+        template <typename IntersectInstanceFunc>
+        void TraversePacket(PacketTraversalRays* rays, UINT instanceInclusionMask, IntersectInstanceFunc&& intersectInstance) const
+        {
+            TraverseBvhPacket(m_bvh, rays,
+                [&](UINT nodeIndex) { return (m_nodeMasks[nodeIndex] & instanceInclusionMask & 0xFF) == 0; },
+                intersectInstance);
+        }
+
+        const Bvh& GetBvh() const { return m_bvh; }
+
+    private:
+        Bvh m_bvh;
+        std::vector<UINT> m_nodeMasks;
+    };
+}
@@ -0,0 +1,217 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "MetaballGrid.h"
+#include <stdexcept>
+
+namespace CpuRT
+{
+    namespace
+    {
+        // Widens the bounding spheres so positions rounded across a cell boundary and the central differences
+        // of the normal still see every metaball that reaches them.
+        const float c_metaballGridMargin = 0.0001f;
+
+        // Calls func with the index of every cell the metaball's bounding sphere overlaps.
+        template <typename Func>
+        void ForEachOverlappedCell(const Metaball& blob, UINT cellsPerAxis, float cellSize, Func func)
+        {
+            const float radius = blob.radius + c_metaballGridMargin;
+            int first[3], last[3];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (blob.center[axis] + radius < -1.0f || blob.center[axis] - radius > 1.0f)
+                {
+                    return;
+                }
+                int maxCell = static_cast<int>(cellsPerAxis) - 1;
+                first[axis] = (std::min)((std::max)(static_cast<int>(std::floor((blob.center[axis] - radius + 1.0f) / cellSize)), 0), maxCell);
+                last[axis] = (std::min)((std::max)(static_cast<int>(std::floor((blob.center[axis] + radius + 1.0f) / cellSize)), 0), maxCell);
+            }
+
+            for (int z = first[2]; z <= last[2]; z++)
+            {
+                for (int y = first[1]; y <= last[1]; y++)
+                {
+                    for (int x = first[0]; x <= last[0]; x++)
+                    {
+                        // Squared distance from the center to the cell.
+                        int cell[3] = { x, y, z };
+                        float distanceSquared = 0.0f;
+                        for (int axis = 0; axis < 3; axis++)
+                        {
+                            float cellMin = -1.0f + cell[axis] * cellSize;
+                            float d = (std::max)((std::max)(cellMin - blob.center[axis], blob.center[axis] - (cellMin + cellSize)), 0.0f);
+                            distanceSquared += d * d;
+                        }
+                        if (distanceSquared <= radius * radius)
+                        {
+                            func((static_cast<UINT>(z) * cellsPerAxis + y) * cellsPerAxis + x);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    CpuMetaballGrid::CpuMetaballGrid() :
+        m_desc()
+    {
+    }
+
+    void CpuMetaballGrid::Build(const Metaball* metaballs, UINT metaballCount, UINT cellsPerAxis)
+    {
+        if (cellsPerAxis == 0)
+        {
+            throw std::invalid_argument("A metaball grid needs at least one cell per axis.");
+        }
+
+        const UINT cellCount = cellsPerAxis * cellsPerAxis * cellsPerAxis;
+        const float cellSize = 2.0f / cellsPerAxis;
+
+        // Count the metaballs per cell, then list them.
+        m_cells.assign(cellCount + 1, 0);
+        for (UINT i = 0; i < metaballCount; i++)
+        {
+            ForEachOverlappedCell(metaballs[i], cellsPerAxis, cellSize, [&](UINT cell) { m_cells[cell + 1]++; });
+        }
+        for (UINT cell = 0; cell < cellCount; cell++)
+        {
+            m_cells[cell + 1] += m_cells[cell];
+        }
+
+        std::vector<UINT> cursors(m_cells.begin(), m_cells.end() - 1);
+        m_indices.resize(m_cells[cellCount]);
+        m_metaballs.clear();
+        float minRadius = c_infinity;
+        for (UINT i = 0; i < metaballCount; i++)
+        {
+            bool overlapsGrid = false;
+            UINT index = static_cast<UINT>(m_metaballs.size());
+            ForEachOverlappedCell(metaballs[i], cellsPerAxis, cellSize, [&](UINT cell)
+            {
+                m_indices[cursors[cell]++] = index;
+                overlapsGrid = true;
+            });
+            if (overlapsGrid)
+            {
+                m_metaballs.push_back(metaballs[i]);
+                minRadius = (std::min)(minRadius, metaballs[i].radius);
+            }
+        }
+
+        m_cellMetaballs.resize(m_indices.size());
+        for (size_t i = 0; i < m_indices.size(); i++)
+        {
+            m_cellMetaballs[i] = m_metaballs[m_indices[i]];
+        }
+
+        m_desc.cellsPerAxis = cellsPerAxis;
+        m_desc.cellOffset = 0;
+        m_desc.cellSize = cellSize;
+        m_desc.stepLength = (std::min)(2.0f / c_metaballMaxSteps, 0.25f * minRadius);
+    }
+
+    UINT CpuMetaballGrid::GetDefaultCellsPerAxis(UINT metaballCount)
+    {
+        return (std::max)(1u, (std::min)(128u, static_cast<UINT>(std::cbrt(0.5 * metaballCount) + 0.5)));
+    }
+
+    bool CpuMetaballGrid::RayTest(const Ray& ray, UINT rayFlags, float* tHit, float3* normal, UINT* stepCount) const
+    {
+        UINT iStep = 0;
+        bool hit = false;
+
+        const float3 aabb[2] = { float3(-1.0f), float3(1.0f) };
+        float tmin, tmax;
+        if (m_desc.cellsPerAxis > 0 && RayAABBIntersectionTest(ray, aabb, &tmin, &tmax))
+        {
+            float t = (std::max)(ray.tMin, tmin);
+            float tEnd = (std::min)(ray.tMax, tmax);
+            float minTStep = m_desc.stepLength / length(ray.direction);
+
+            // The cell the ray enters the grid in and the distances to the next cell boundary along each axis.
+            const int cellsPerAxis = static_cast<int>(m_desc.cellsPerAxis);
+            float3 entry = ray.origin + ray.direction * t;
+            int cell[3], cellStep[3];
+            float tNext[3], tDelta[3];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                cell[axis] = (std::min)((std::max)(static_cast<int>(std::floor((entry[axis] + 1) / m_desc.cellSize)), 0), cellsPerAxis - 1);
+                cellStep[axis] = ray.direction[axis] > 0 ? 1 : -1;
+                if (ray.direction[axis] != 0)
+                {
+                    float boundary = -1 + (cell[axis] + (cellStep[axis] > 0 ? 1 : 0)) * m_desc.cellSize;
+                    tNext[axis] = (boundary - ray.origin[axis]) / ray.direction[axis];
+                    tDelta[axis] = m_desc.cellSize / std::abs(ray.direction[axis]);
+                }
+                else
+                {
+                    tNext[axis] = c_infinity;
+                    tDelta[axis] = c_infinity;
+                }
+            }
+
+            while (iStep < c_metaballGridMaxSteps)
+            {
+                float tCellEnd = (std::min)((std::min)((std::min)(tNext[0], tNext[1]), tNext[2]), tEnd);
+                UINT cellIndex = (cell[2] * cellsPerAxis + cell[1]) * cellsPerAxis + cell[0];
+                UINT first = m_cells[cellIndex];
+                UINT last = m_cells[cellIndex + 1];
+                if (first < last && t <= tCellEnd
+                    && RayMetaballsIntervalSegmentTest(ray, rayFlags, &m_cellMetaballs[first], last - first, t, tCellEnd, minTStep,
+                        c_metaballGridMaxSteps, tHit, normal, &iStep))
+                {
+                    hit = true;
+                    break;
+                }
+                if (tCellEnd >= tEnd)
+                {
+                    break;
+                }
+
+                // Step into the neighbouring cell across the nearest boundary.
+                int axis = (tNext[0] <= tNext[1] && tNext[0] <= tNext[2]) ? 0 : ((tNext[1] <= tNext[2]) ? 1 : 2);
+                cell[axis] += cellStep[axis];
+                tNext[axis] += tDelta[axis];
+                if (cell[axis] < 0 || cell[axis] >= cellsPerAxis)
+                {
+                    break;
+                }
+                t = (std::max)(t, tCellEnd);
+            }
+        }
+
+        if (stepCount)
+        {
+            *stepCount = iStep;
+        }
+        return hit;
+    }
+
+    CpuMetaballGridDesc CpuMetaballGrid::Append(std::vector<UINT>* cells, std::vector<UINT>* indices, std::vector<Metaball>* metaballs) const
+    {
+        CpuMetaballGridDesc desc = m_desc;
+        desc.cellOffset = static_cast<UINT>(cells->size());
+        const UINT indexOffset = static_cast<UINT>(indices->size());
+        const UINT metaballOffset = static_cast<UINT>(metaballs->size());
+        for (UINT first : m_cells)
+        {
+            cells->push_back(indexOffset + first);
+        }
+        for (UINT index : m_indices)
+        {
+            indices->push_back(metaballOffset + index);
+        }
+        metaballs->insert(metaballs->end(), m_metaballs.begin(), m_metaballs.end());
+        return desc;
+    }
+}
@@ -0,0 +1,73 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Uniform grids culling large metaball fields.
+//
+// The <-1,1> AABB of a metaball primitive is split into cellsPerAxis^3 cells, and each cell lists the metaballs
+// whose bounding sphere overlaps it. Every metaball that contributes to the potential at a point is listed in the
+// point's cell, so a ray marches each cell it passes through with only that cell's metaballs. The grids are CPU
+// only for now: Append() packs them into buffers a shader could read, but the sample has no shader for them.
+
+#include "VolumetricPrimitives.h"
+#include <vector>
+
+namespace CpuRT
+{
+    static const UINT c_metaballGridMaxSteps = 1024;    // Potential and bound evaluations per ray.
+
+    // Where a grid lives in the buffers Append() fills.
+    struct CpuMetaballGridDesc
+    {
+        UINT cellsPerAxis;          // 0 for a primitive without a grid.
+        UINT cellOffset;            // First entry of the grid in the cell buffer.
+        float cellSize;             // Local space size of a cell.
+        float stepLength;           // Local space length segments are halved down to when looking for a crossing.
+    };
+
+    class CpuMetaballGrid
+    {
+    public:
+        CpuMetaballGrid();
+
+        // Lists the metaballs overlapping each cell. Metaballs outside the AABB are dropped. The step length is the
+        // uniform step of RayMetaballsIntersectionTest() across the AABB or a quarter of the smallest radius,
+        // whichever is shorter.
+        void Build(const Metaball* metaballs, UINT metaballCount, UINT cellsPerAxis);
+
+        // A cell count that keeps about two metaballs per cell for metaballCount metaballs.
+        static UINT GetDefaultCellsPerAxis(UINT metaballCount);
+
+        // Marches the cells along the ray, each with its own metaballs. stepCount, if not null, receives the number of
+        // potential and bound evaluations.
+        bool RayTest(const Ray& ray, UINT rayFlags, float* tHit, float3* normal, UINT* stepCount = nullptr) const;
+
+        // Appends the grid to buffers shared by several grids and returns its descriptor for those buffers.
+        CpuMetaballGridDesc Append(std::vector<UINT>* cells, std::vector<UINT>* indices, std::vector<Metaball>* metaballs) const;
+
+        const CpuMetaballGridDesc& GetDesc() const { return m_desc; }
+        const std::vector<UINT>& GetCells() const { return m_cells; }
+        const std::vector<UINT>& GetIndices() const { return m_indices; }
+        const std::vector<Metaball>& GetMetaballs() const { return m_metaballs; }
+        size_t GetSizeInBytes() const
+        {
+            return (m_cells.size() + m_indices.size()) * sizeof(UINT) + m_metaballs.size() * sizeof(Metaball);
+        }
+
+    private:
+        CpuMetaballGridDesc m_desc;
+        std::vector<UINT> m_cells;              // First index per cell, x fastest, and the end of the last cell.
+        std::vector<UINT> m_indices;            // Metaballs per cell.
+        std::vector<Metaball> m_metaballs;
+        std::vector<Metaball> m_cellMetaballs;  // m_metaballs[m_indices[i]], so cells march contiguous metaballs.
+    };
+}
@@ -0,0 +1,377 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "MortonBuilder.h"
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace CpuRT
+{
+    namespace
+    {
+        // Spreads the low 10 bits of x so there are two zero bits between each.
+        inline UINT ExpandBits10(UINT x)
+        {
+            x &= 0x000003FF;
+            x = (x | (x << 16)) & 0x030000FF;
+            x = (x | (x << 8)) & 0x0300F00F;
+            x = (x | (x << 4)) & 0x030C30C3;
+            x = (x | (x << 2)) & 0x09249249;
+            return x;
+        }
+
+        // Spreads the low 21 bits of x so there are two zero bits between each.
+        inline UINT64 ExpandBits21(UINT64 x)
+        {
+            x &= 0x1FFFFF;
+            x = (x | (x << 32)) & 0x001F00000000FFFFull;
+            x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+            x = (x | (x << 8)) & 0x100F00F00F00F00Full;
+            x = (x | (x << 4)) & 0x10C30C30C30C30C3ull;
+            x = (x | (x << 2)) & 0x1249249249249249ull;
+            return x;
+        }
+
+        inline void EncodeMorton(UINT x, UINT y, UINT z, UINT* code)
+        {
+            *code = (ExpandBits10(x) << 2) | (ExpandBits10(y) << 1) | ExpandBits10(z);
+        }
+
+        inline void EncodeMorton(UINT x, UINT y, UINT z, UINT64* code)
+        {
+            *code = (ExpandBits21(x) << 2) | (ExpandBits21(y) << 1) | ExpandBits21(z);
+        }
+
+        // True if the highest set bit of a is below the highest set bit of b.
+        template <typename Key>
+        inline bool HighestBitLess(Key a, Key b)
+        {
+            return a < b && a < (a ^ b);
+        }
+
+        // Runs func(chunkIndex, begin, end) over chunkCount equal slices of [0, count), one thread per chunk.
+        template <typename ChunkFunc>
+        void ParallelChunks(UINT count, UINT chunkCount, ChunkFunc&& func)
+        {
+            auto Begin = [&](UINT chunk) { return static_cast<UINT>(static_cast<UINT64>(count) * chunk / chunkCount); };
+
+            std::vector<std::thread> threads;
+            for (UINT chunk = 1; chunk < chunkCount; chunk++)
+            {
+                threads.emplace_back([&, chunk]() { func(chunk, Begin(chunk), Begin(chunk + 1)); });
+            }
+            func(0, Begin(0), Begin(1));
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        template <typename Key>
+        class MortonBuilder
+        {
+        public:
+            static const UINT c_bitsPerAxis = (sizeof(Key) == sizeof(UINT)) ? 10 : 21;
+            static const UINT c_radixBits = 8;
+            static const UINT c_radixSize = 1 << c_radixBits;
+
+            MortonBuilder(const AABB* primBounds, UINT primCount, const MortonBuildSettings& settings, UINT* primIndices) :
+                m_primBounds(primBounds),
+                m_primCount(primCount),
+                m_settings(settings),
+                m_primIndices(primIndices),
+                m_codes(primCount)
+            {
+                m_settings.maxLeafSize = (std::max)(m_settings.maxLeafSize, 1u);
+                m_settings.parallelThreshold = (std::max)(m_settings.parallelThreshold, 1u);
+
+                UINT numThreads = m_settings.numThreads ? m_settings.numThreads : std::thread::hardware_concurrency();
+                numThreads = (std::max)(numThreads, 1u);
+                m_freeThreads = static_cast<int>(numThreads) - 1;
+                m_chunkCount = (std::min)(numThreads, primCount / m_settings.parallelThreshold + 1);
+            }
+
+            void ComputeCodes()
+            {
+                std::vector<AABB> chunkBounds(m_chunkCount);
+                ParallelChunks(m_primCount, m_chunkCount, [&](UINT chunk, UINT begin, UINT end)
+                {
+                    for (UINT i = begin; i < end; i++)
+                    {
+                        chunkBounds[chunk].Grow(m_primBounds[i].Center());
+                    }
+                });
+
+                AABB centroidBounds;
+                for (const AABB& bounds : chunkBounds)
+                {
+                    centroidBounds.Grow(bounds);
+                }
+
+                const float gridMax = static_cast<float>((1u << c_bitsPerAxis) - 1);
+                float3 extent = centroidBounds.Extent();
+                float3 scale;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    scale[axis] = (extent[axis] > 0.0f) ? gridMax / extent[axis] : 0.0f;
+                }
+
+                ParallelChunks(m_primCount, m_chunkCount, [&](UINT, UINT begin, UINT end)
+                {
+                    for (UINT i = begin; i < end; i++)
+                    {
+                        float3 cell = (m_primBounds[i].Center() - centroidBounds.minimum) * scale;
+                        UINT x = static_cast<UINT>((std::min)((std::max)(cell.x, 0.0f), gridMax));
+                        UINT y = static_cast<UINT>((std::min)((std::max)(cell.y, 0.0f), gridMax));
+                        UINT z = static_cast<UINT>((std::min)((std::max)(cell.z, 0.0f), gridMax));
+                        EncodeMorton(x, y, z, &m_codes[i]);
+                        m_primIndices[i] = i;
+                    }
+                });
+            }
+
+            // Stable LSD radix sort of (code, primIndex) pairs, c_radixBits per pass.
+            // Each chunk histograms its slice, then scatters to offsets ordered by (digit, chunk).
+            void SortCodes()
+            {
+                std::vector<Key> codesTemp(m_primCount);
+                std::vector<UINT> indicesTemp(m_primCount);
+                Key* codesIn = m_codes.data();
+                Key* codesOut = codesTemp.data();
+                UINT* indicesIn = m_primIndices;
+                UINT* indicesOut = indicesTemp.data();
+
+                std::vector<UINT> histograms(static_cast<size_t>(m_chunkCount) * c_radixSize);
+                const UINT keyBits = 3 * c_bitsPerAxis;
+                for (UINT shift = 0; shift < keyBits; shift += c_radixBits)
+                {
+                    std::fill(histograms.begin(), histograms.end(), 0);
+                    ParallelChunks(m_primCount, m_chunkCount, [&](UINT chunk, UINT begin, UINT end)
+                    {
+                        UINT* histogram = &histograms[static_cast<size_t>(chunk) * c_radixSize];
+                        for (UINT i = begin; i < end; i++)
+                        {
+                            histogram[(codesIn[i] >> shift) & (c_radixSize - 1)]++;
+                        }
+                    });
+
+                    // Turn counts into scatter offsets. A pass where every key has the same digit is a no-op.
+                    UINT offset = 0;
+                    bool trivialPass = false;
+                    for (UINT digit = 0; digit < c_radixSize; digit++)
+                    {
+                        UINT digitStart = offset;
+                        for (UINT chunk = 0; chunk < m_chunkCount; chunk++)
+                        {
+                            UINT& entry = histograms[static_cast<size_t>(chunk) * c_radixSize + digit];
+                            UINT count = entry;
+                            entry = offset;
+                            offset += count;
+                        }
+                        trivialPass = trivialPass || (offset - digitStart == m_primCount);
+                    }
+                    if (trivialPass)
+                    {
+                        continue;
+                    }
+
+                    ParallelChunks(m_primCount, m_chunkCount, [&](UINT chunk, UINT begin, UINT end)
+                    {
+                        UINT* offsets = &histograms[static_cast<size_t>(chunk) * c_radixSize];
+                        for (UINT i = begin; i < end; i++)
+                        {
+                            UINT destination = offsets[(codesIn[i] >> shift) & (c_radixSize - 1)]++;
+                            codesOut[destination] = codesIn[i];
+                            indicesOut[destination] = indicesIn[i];
+                        }
+                    });
+                    std::swap(codesIn, codesOut);
+                    std::swap(indicesIn, indicesOut);
+                }
+
+                if (indicesIn != m_primIndices)
+                {
+                    std::copy(indicesIn, indicesIn + m_primCount, m_primIndices);
+                    std::copy(codesIn, codesIn + m_primCount, m_codes.data());
+                }
+            }
+
+            // Builds the subtree over the sorted range [first, first + count) into nodes, rooted at nodes[nodeIndex].
+            // Ranges split where the highest differing Morton bit flips; equal codes split at the middle.
+            void BuildSubtree(std::vector<BvhNode>& nodes, UINT nodeIndex, UINT first, UINT count, UINT depth)
+            {
+                BvhNode& node = nodes[nodeIndex];
+                if (count <= m_settings.maxLeafSize || depth + 1 >= c_maxBvhDepth)
+                {
+                    AABB bounds;
+                    for (UINT i = first; i < first + count; i++)
+                    {
+                        bounds.Grow(m_primBounds[m_primIndices[i]]);
+                    }
+                    node.bounds = bounds;
+                    node.leftOrFirst = first;
+                    node.primCount = count;
+                    return;
+                }
+
+                UINT leftCount = FindSplit(first, count);
+                UINT rightFirst = first + leftCount;
+                UINT rightCount = count - leftCount;
+
+                if (count <= m_settings.parallelThreshold)
+                {
+                    UINT leftIndex = static_cast<UINT>(nodes.size());
+                    nodes.push_back(BvhNode());
+                    nodes.push_back(BvhNode());
+                    nodes[nodeIndex].leftOrFirst = leftIndex;
+                    nodes[nodeIndex].primCount = 0;
+                    BuildSubtree(nodes, leftIndex, first, leftCount, depth + 1);
+                    BuildSubtree(nodes, leftIndex + 1, rightFirst, rightCount, depth + 1);
+                    nodes[nodeIndex].bounds = nodes[leftIndex].bounds;
+                    nodes[nodeIndex].bounds.Grow(nodes[leftIndex + 1].bounds);
+                    return;
+                }
+
+                // Same scheme as the binned SAH builder: large subtrees are built separately and
+                // spliced in left-to-right so the layout is identical for any thread count.
+                std::vector<BvhNode> leftNodes(1);
+                std::vector<BvhNode> rightNodes(1);
+                std::future<void> leftTask;
+                if (AcquireThread())
+                {
+                    leftTask = std::async(std::launch::async, [&]()
+                    {
+                        BuildSubtree(leftNodes, 0, first, leftCount, depth + 1);
+                        ReleaseThread();
+                    });
+                }
+                else
+                {
+                    BuildSubtree(leftNodes, 0, first, leftCount, depth + 1);
+                }
+                BuildSubtree(rightNodes, 0, rightFirst, rightCount, depth + 1);
+                if (leftTask.valid())
+                {
+                    leftTask.get();
+                }
+
+                UINT leftIndex = static_cast<UINT>(nodes.size());
+                nodes[nodeIndex].leftOrFirst = leftIndex;
+                nodes[nodeIndex].primCount = 0;
+                nodes[nodeIndex].bounds = leftNodes[0].bounds;
+                nodes[nodeIndex].bounds.Grow(rightNodes[0].bounds);
+                nodes.push_back(leftNodes[0]);
+                nodes.push_back(rightNodes[0]);
+                SpliceBvhSubtree(&nodes, leftIndex, leftNodes);
+                SpliceBvhSubtree(&nodes, leftIndex + 1, rightNodes);
+            }
+
+        private:
+            bool AcquireThread()
+            {
+                int available = m_freeThreads.load();
+                while (available > 0)
+                {
+                    if (m_freeThreads.compare_exchange_weak(available, available - 1))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void ReleaseThread()
+            {
+                m_freeThreads++;
+            }
+
+            // Returns the size of the left half: the codes sharing the first code's bit at the
+            // highest position where the first and last codes differ (Karras 2012).
+            UINT FindSplit(UINT first, UINT count) const
+            {
+                UINT last = first + count - 1;
+                Key firstCode = m_codes[first];
+                Key difference = firstCode ^ m_codes[last];
+                if (difference == 0)
+                {
+                    return count / 2;
+                }
+
+                // Binary search for the last index whose code differs from firstCode only below that bit.
+                UINT split = first;
+                UINT step = count - 1;
+                do
+                {
+                    step = (step + 1) >> 1;
+                    UINT candidate = split + step;
+                    if (candidate < last && HighestBitLess<Key>(firstCode ^ m_codes[candidate], difference))
+                    {
+                        split = candidate;
+                    }
+                } while (step > 1);
+                return split - first + 1;
+            }
+
+            const AABB* m_primBounds;
+            UINT m_primCount;
+            MortonBuildSettings m_settings;
+            UINT* m_primIndices;
+            std::vector<Key> m_codes;
+            UINT m_chunkCount;
+            std::atomic<int> m_freeThreads;
+        };
+
+        template <typename Key>
+        void BuildMorton(const AABB* primBounds, UINT primCount, const MortonBuildSettings& settings, Bvh* bvh)
+        {
+            MortonBuilder<Key> builder(primBounds, primCount, settings, bvh->primIndices.data());
+            builder.ComputeCodes();
+            builder.SortCodes();
+            bvh->nodes.reserve(2 * static_cast<size_t>(primCount));
+            bvh->nodes.resize(1);
+            builder.BuildSubtree(bvh->nodes, 0, 0, primCount, 0);
+        }
+    }
+
+    void BuildBvhMorton(const AABB* primBounds, UINT primCount, const MortonBuildSettings& settings, Bvh* bvh)
+    {
+        bvh->nodes.clear();
+        bvh->primIndices.resize(primCount);
+        if (primCount == 0)
+        {
+            return;
+        }
+
+        if (settings.mortonBits > 30)
+        {
+            BuildMorton<UINT64>(primBounds, primCount, settings, bvh);
+        }
+        else
+        {
+            BuildMorton<UINT>(primBounds, primCount, settings, bvh);
+        }
+    }
+
+    void BuildBvhMorton(const CpuTriangleGeometryDesc& geometry, const MortonBuildSettings& settings, Bvh* bvh)
+    {
+        std::vector<AABB> primBounds;
+        ComputeTriangleBounds(geometry, &primBounds);
+        BuildBvhMorton(primBounds.data(), static_cast<UINT>(primBounds.size()), settings, bvh);
+    }
+
+    void BuildBvhMorton(const CpuAABBGeometryDesc& geometry, const MortonBuildSettings& settings, Bvh* bvh)
+    {
+        std::vector<AABB> primBounds;
+        ComputeAABBBounds(geometry, &primBounds);
+        BuildBvhMorton(primBounds.data(), static_cast<UINT>(primBounds.size()), settings, bvh);
+    }
+}
@@ -0,0 +1,37 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Linear BVH builder over Morton-sorted primitive centroids, the CPU analog of
+// D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD. Builds several times faster
+// than the binned SAH builder at a higher SAH cost, for test cases that rebuild every frame.
+
+#include "CpuBvh.h"
+#include "CpuGeometry.h"
+
+namespace CpuRT
+{
+    struct MortonBuildSettings
+    {
+        UINT mortonBits = 30;           // 30 (10 bits per axis) or 63 (21 bits per axis).
+        UINT maxLeafSize = 4;           // Ranges of at most this many primitives become leaves.
+        UINT numThreads = 0;            // 0 selects the hardware thread count, 1 builds serially.
+        UINT parallelThreshold = 16384; // Sort chunks and subtrees above this primitive count are separate tasks.
+    };
+
+    // Output is deterministic: it does not depend on numThreads.
+    void BuildBvhMorton(const AABB* primBounds, UINT primCount, const MortonBuildSettings& settings, Bvh* bvh);
+
+    // Convenience overloads over the framework's vertex/index or AABB buffers.
+    void BuildBvhMorton(const CpuTriangleGeometryDesc& geometry, const MortonBuildSettings& settings, Bvh* bvh);
+    void BuildBvhMorton(const CpuAABBGeometryDesc& geometry, const MortonBuildSettings& settings, Bvh* bvh);
+}
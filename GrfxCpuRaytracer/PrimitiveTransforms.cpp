@@ -0,0 +1,77 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "PrimitiveTransforms.h"
+
+namespace CpuRT
+{
+    namespace
+    {
+        // Primitives per thread pool task, a multiple of the AVX2 kernel's eight.
+        const UINT c_primitiveTransformRangeSize = 4096;
+    }
+
+    PrimitiveTransformKernel::Enum GetDefaultPrimitiveTransformKernel()
+    {
+        return CpuSupportsAvx2() ? PrimitiveTransformKernel::Avx2 : PrimitiveTransformKernel::Scalar;
+    }
+
+    void UpdatePrimitiveTransformsScalar(const PrimitiveTransformBatch& batch, UINT begin, UINT end,
+        PrimitiveInstancePerFrameBuffer* transforms)
+    {
+        for (UINT i = begin; i < end; i++)
+        {
+            ComputePrimitiveTransform(float3(batch.scale[0][i], batch.scale[1][i], batch.scale[2][i]), batch.rotationY[i],
+                float3(batch.translation[0][i], batch.translation[1][i], batch.translation[2][i]), &transforms[i]);
+        }
+    }
+
+    void UpdatePrimitiveTransforms(PrimitiveTransformKernel::Enum kernel, const PrimitiveTransformBatch& batch,
+        PrimitiveInstancePerFrameBuffer* transforms, CpuThreadPool* pool)
+    {
+        const UINT count = batch.GetCount();
+        auto UpdateRange = [&](UINT range, UINT)
+        {
+            UINT begin = range * c_primitiveTransformRangeSize;
+            UINT end = (std::min)(count, begin + c_primitiveTransformRangeSize);
+            if (kernel == PrimitiveTransformKernel::Avx2)
+            {
+                UpdatePrimitiveTransformsAvx2(batch, begin, end, transforms);
+            }
+            else
+            {
+                UpdatePrimitiveTransformsScalar(batch, begin, end, transforms);
+            }
+        };
+
+        UINT rangeCount = (count + c_primitiveTransformRangeSize - 1) / c_primitiveTransformRangeSize;
+        if (pool && rangeCount > 1)
+        {
+            pool->Run(rangeCount, UpdateRange);
+        }
+        else
+        {
+            for (UINT range = 0; range < rangeCount; range++)
+            {
+                UpdateRange(range, 0);
+            }
+        }
+    }
+
+#if !GRFX_CPU_X86
+    // No AVX2 on this architecture; CpuSupportsAvx2() is false so this is never selected.
+    void UpdatePrimitiveTransformsAvx2(const PrimitiveTransformBatch& batch, UINT begin, UINT end,
+        PrimitiveInstancePerFrameBuffer* transforms)
+    {
+        UpdatePrimitiveTransformsScalar(batch, begin, end, transforms);
+    }
+#endif
+}
@@ -0,0 +1,165 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Per-frame AABB primitive transforms of D3D12RaytracingProceduralGeometry's UpdateAABBPrimitiveAttributes().
+//
+// Every transform is mScale * XMMatrixRotationY(angle) * mTranslation, so its inverse is
+// mTranslation^-1 * XMMatrixRotationY(-angle) * mScale^-1 in closed form, without the general XMMatrixInverse().
+// The parameters are kept in structure-of-arrays layout so the AVX2 kernel computes eight primitives per
+// iteration; UpdatePrimitiveTransforms() splits the primitives over a thread pool.
+
+#include "CpuMath.h"
+#include "CpuFeatures.h"
+#include "CpuThreadPool.h"
+#include <vector>
+
+namespace CpuRT
+{
+    // Same layout as PrimitiveInstancePerFrameBuffer of RayTracingHlslCompat.h.
+    struct PrimitiveInstancePerFrameBuffer
+    {
+        float4x4 localSpaceToBottomLevelAS;     // Matrix from local primitive space to bottom-level object space.
+        float4x4 bottomLevelASToLocalSpace;     // Matrix from bottom-level object space to local primitive space.
+    };
+
+    // Scale, rotation about Y and translation of each primitive, in structure-of-arrays layout.
+    struct PrimitiveTransformBatch
+    {
+        std::vector<float> scale[3];
+        std::vector<float> rotationY;           // Radians, as passed to XMMatrixRotationY().
+        std::vector<float> translation[3];
+
+        UINT GetCount() const { return static_cast<UINT>(rotationY.size()); }
+
+        void Resize(UINT count)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                scale[axis].resize(count);
+                translation[axis].resize(count);
+            }
+            rotationY.resize(count);
+        }
+
+        void Set(UINT index, const float3& primitiveScale, float angle, const float3& primitiveTranslation)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                scale[axis][index] = primitiveScale[axis];
+                translation[axis][index] = primitiveTranslation[axis];
+            }
+            rotationY[index] = angle;
+        }
+    };
+
+    // XMScalarSinCos(): the angle is reduced to [-pi/2, pi/2] and sin and cos are 11 and 10 degree minimax
+    // polynomials. The AVX2 kernel evaluates the same polynomials.
+    inline void ScalarSinCos(float value, float* sinValue, float* cosValue)
+    {
+        const float c_pi = 3.141592654f;
+        const float c_2pi = 6.283185307f;
+        const float c_1div2pi = 0.159154943f;
+        const float c_pidiv2 = 1.570796327f;
+
+        // Map value to y in [-pi,pi], x = 2*pi*quotient + remainder.
+        float quotient = c_1div2pi * value;
+        if (value >= 0.0f)
+        {
+            quotient = static_cast<float>(static_cast<int>(quotient + 0.5f));
+        }
+        else
+        {
+            quotient = static_cast<float>(static_cast<int>(quotient - 0.5f));
+        }
+        float y = value - c_2pi * quotient;
+
+        // Map y to [-pi/2,pi/2] with sin(y) = sin(value).
+        float sign;
+        if (y > c_pidiv2)
+        {
+            y = c_pi - y;
+            sign = -1.0f;
+        }
+        else if (y < -c_pidiv2)
+        {
+            y = -c_pi - y;
+            sign = -1.0f;
+        }
+        else
+        {
+            sign = +1.0f;
+        }
+
+        float y2 = y * y;
+        *sinValue = (((((-2.3889859e-08f * y2 + 2.7525562e-06f) * y2 - 0.00019840874f) * y2 + 0.0083333310f) * y2 - 0.16666667f) * y2 + 1.0f) * y;
+        float p = ((((-2.6051615e-07f * y2 + 2.4760495e-05f) * y2 - 0.0013888378f) * y2 + 0.041666638f) * y2 - 0.5f) * y2 + 1.0f;
+        *cosValue = sign * p;
+    }
+
+    // Closed-form transform and inverse of one primitive. Translation rows are computed as
+    // -(t.x * inverse.m[0] + t.y * inverse.m[1] + t.z * inverse.m[2]) over the nonzero terms only.
+    inline void ComputePrimitiveTransform(const float3& scale, float rotationY, const float3& translation,
+        PrimitiveInstancePerFrameBuffer* transforms)
+    {
+        float sinAngle, cosAngle;
+        ScalarSinCos(rotationY, &sinAngle, &cosAngle);
+        float rcpScaleX = 1.0f / scale.x;
+        float rcpScaleY = 1.0f / scale.y;
+        float rcpScaleZ = 1.0f / scale.z;
+
+        float4x4& transform = transforms->localSpaceToBottomLevelAS;
+        transform = float4x4();
+        transform.m[0][0] = scale.x * cosAngle;
+        transform.m[0][2] = -(scale.x * sinAngle);
+        transform.m[1][1] = scale.y;
+        transform.m[2][0] = scale.z * sinAngle;
+        transform.m[2][2] = scale.z * cosAngle;
+        transform.m[3][0] = translation.x;
+        transform.m[3][1] = translation.y;
+        transform.m[3][2] = translation.z;
+
+        float4x4& inverse = transforms->bottomLevelASToLocalSpace;
+        inverse = float4x4();
+        inverse.m[0][0] = cosAngle * rcpScaleX;
+        inverse.m[0][2] = sinAngle * rcpScaleZ;
+        inverse.m[1][1] = rcpScaleY;
+        inverse.m[2][0] = -(sinAngle * rcpScaleX);
+        inverse.m[2][2] = cosAngle * rcpScaleZ;
+        inverse.m[3][0] = -(translation.x * inverse.m[0][0] + translation.z * inverse.m[2][0]);
+        inverse.m[3][1] = -(translation.y * inverse.m[1][1]);
+        inverse.m[3][2] = -(translation.x * inverse.m[0][2] + translation.z * inverse.m[2][2]);
+    }
+
+    namespace PrimitiveTransformKernel
+    {
+        enum Enum
+        {
+            Scalar,
+            Avx2
+        };
+    }
+
+    // Avx2 when CpuSupportsAvx2(), Scalar otherwise.
+    PrimitiveTransformKernel::Enum GetDefaultPrimitiveTransformKernel();
+
+    // Transforms of primitives [begin, end) of batch into transforms[begin, end). Both kernels match
+    // ComputePrimitiveTransform() bit for bit; the AVX2 kernel requires CpuSupportsAvx2().
+    void UpdatePrimitiveTransformsScalar(const PrimitiveTransformBatch& batch, UINT begin, UINT end,
+        PrimitiveInstancePerFrameBuffer* transforms);
+    void UpdatePrimitiveTransformsAvx2(const PrimitiveTransformBatch& batch, UINT begin, UINT end,
+        PrimitiveInstancePerFrameBuffer* transforms);
+
+    // Transforms of all primitives of batch, in ranges spread over pool (or on the calling thread if null).
+    void UpdatePrimitiveTransforms(PrimitiveTransformKernel::Enum kernel, const PrimitiveTransformBatch& batch,
+        PrimitiveInstancePerFrameBuffer* transforms, CpuThreadPool* pool);
+}
@@ -0,0 +1,145 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// 8-wide AVX2 kernel for PrimitiveTransforms.h. Only this translation unit uses AVX2 instructions.
+
+#include "PrimitiveTransforms.h"
+
+#if GRFX_CPU_X86
+#include <immintrin.h>
+
+namespace CpuRT
+{
+    namespace
+    {
+        // Transposes eight vectors of eight floats in place: lane j of rows[i] moves to lane i of rows[j].
+        GRFX_INLINE_AVX2 void Transpose8x8(__m256 rows[8])
+        {
+            __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+            __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+            __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+            __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+            __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+            __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+            __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+            __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+            __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+            rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+            rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+            rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+            rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+            rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+            rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+            rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+            rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+        }
+
+        // Writes two rows (eight floats) of a matrix of eight primitives, given one vector per element.
+        GRFX_INLINE_AVX2 void StoreRows(__m256 elements[8], PrimitiveInstancePerFrameBuffer* transforms, UINT floatOffset)
+        {
+            Transpose8x8(elements);
+            for (int lane = 0; lane < 8; lane++)
+            {
+                _mm256_storeu_ps(reinterpret_cast<float*>(&transforms[lane]) + floatOffset, elements[lane]);
+            }
+        }
+    }
+
+    // Same operation order as ComputePrimitiveTransform() and ScalarSinCos().
+    GRFX_TARGET_AVX2 void UpdatePrimitiveTransformsAvx2(const PrimitiveTransformBatch& batch, UINT begin, UINT end,
+        PrimitiveInstancePerFrameBuffer* transforms)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        const __m256 pi = _mm256_set1_ps(3.141592654f);
+        const __m256 negativePi = _mm256_set1_ps(-3.141592654f);
+        const __m256 twoPi = _mm256_set1_ps(6.283185307f);
+        const __m256 oneDivTwoPi = _mm256_set1_ps(0.159154943f);
+        const __m256 piDivTwo = _mm256_set1_ps(1.570796327f);
+        const __m256 negativePiDivTwo = _mm256_set1_ps(-1.570796327f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        UINT i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 scaleX = _mm256_loadu_ps(&batch.scale[0][i]);
+            __m256 scaleY = _mm256_loadu_ps(&batch.scale[1][i]);
+            __m256 scaleZ = _mm256_loadu_ps(&batch.scale[2][i]);
+            __m256 angle = _mm256_loadu_ps(&batch.rotationY[i]);
+            __m256 translationX = _mm256_loadu_ps(&batch.translation[0][i]);
+            __m256 translationY = _mm256_loadu_ps(&batch.translation[1][i]);
+            __m256 translationZ = _mm256_loadu_ps(&batch.translation[2][i]);
+
+            // ScalarSinCos().
+            __m256 quotient = _mm256_mul_ps(oneDivTwoPi, angle);
+            quotient = _mm256_blendv_ps(_mm256_sub_ps(quotient, half), _mm256_add_ps(quotient, half), _mm256_cmp_ps(angle, zero, _CMP_GE_OQ));
+            quotient = _mm256_round_ps(quotient, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            __m256 y = _mm256_sub_ps(angle, _mm256_mul_ps(twoPi, quotient));
+            __m256 aboveHalfPi = _mm256_cmp_ps(y, piDivTwo, _CMP_GT_OQ);
+            __m256 belowHalfPi = _mm256_cmp_ps(y, negativePiDivTwo, _CMP_LT_OQ);
+            __m256 sign = _mm256_blendv_ps(one, _mm256_set1_ps(-1.0f), _mm256_or_ps(aboveHalfPi, belowHalfPi));
+            y = _mm256_blendv_ps(_mm256_blendv_ps(y, _mm256_sub_ps(negativePi, y), belowHalfPi), _mm256_sub_ps(pi, y), aboveHalfPi);
+            __m256 y2 = _mm256_mul_ps(y, y);
+
+            __m256 sinAngle = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-2.3889859e-08f), y2), _mm256_set1_ps(2.7525562e-06f));
+            sinAngle = _mm256_sub_ps(_mm256_mul_ps(sinAngle, y2), _mm256_set1_ps(0.00019840874f));
+            sinAngle = _mm256_add_ps(_mm256_mul_ps(sinAngle, y2), _mm256_set1_ps(0.0083333310f));
+            sinAngle = _mm256_sub_ps(_mm256_mul_ps(sinAngle, y2), _mm256_set1_ps(0.16666667f));
+            sinAngle = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sinAngle, y2), one), y);
+
+            __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-2.6051615e-07f), y2), _mm256_set1_ps(2.4760495e-05f));
+            p = _mm256_sub_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(0.0013888378f));
+            p = _mm256_add_ps(_mm256_mul_ps(p, y2), _mm256_set1_ps(0.041666638f));
+            p = _mm256_sub_ps(_mm256_mul_ps(p, y2), half);
+            p = _mm256_add_ps(_mm256_mul_ps(p, y2), one);
+            __m256 cosAngle = _mm256_mul_ps(sign, p);
+
+            __m256 rcpScaleX = _mm256_div_ps(one, scaleX);
+            __m256 rcpScaleY = _mm256_div_ps(one, scaleY);
+            __m256 rcpScaleZ = _mm256_div_ps(one, scaleZ);
+
+            // localSpaceToBottomLevelAS.
+            __m256 m00 = _mm256_mul_ps(scaleX, cosAngle);
+            __m256 m02 = _mm256_xor_ps(_mm256_mul_ps(scaleX, sinAngle), signBit);
+            __m256 m20 = _mm256_mul_ps(scaleZ, sinAngle);
+            __m256 m22 = _mm256_mul_ps(scaleZ, cosAngle);
+
+            // bottomLevelASToLocalSpace.
+            __m256 i00 = _mm256_mul_ps(cosAngle, rcpScaleX);
+            __m256 i02 = _mm256_mul_ps(sinAngle, rcpScaleZ);
+            __m256 i20 = _mm256_xor_ps(_mm256_mul_ps(sinAngle, rcpScaleX), signBit);
+            __m256 i22 = _mm256_mul_ps(cosAngle, rcpScaleZ);
+            __m256 i30 = _mm256_xor_ps(_mm256_add_ps(_mm256_mul_ps(translationX, i00), _mm256_mul_ps(translationZ, i20)), signBit);
+            __m256 i31 = _mm256_xor_ps(_mm256_mul_ps(translationY, rcpScaleY), signBit);
+            __m256 i32 = _mm256_xor_ps(_mm256_add_ps(_mm256_mul_ps(translationX, i02), _mm256_mul_ps(translationZ, i22)), signBit);
+
+            // Each pair of matrix rows is eight floats: transpose the element vectors into per-primitive rows.
+            __m256 forwardRows01[8] = { m00, zero, m02, zero, zero, scaleY, zero, zero };
+            __m256 forwardRows23[8] = { m20, zero, m22, zero, translationX, translationY, translationZ, one };
+            __m256 inverseRows01[8] = { i00, zero, i02, zero, zero, rcpScaleY, zero, zero };
+            __m256 inverseRows23[8] = { i20, zero, i22, zero, i30, i31, i32, one };
+            StoreRows(forwardRows01, &transforms[i], 0);
+            StoreRows(forwardRows23, &transforms[i], 8);
+            StoreRows(inverseRows01, &transforms[i], 16);
+            StoreRows(inverseRows23, &transforms[i], 24);
+        }
+        UpdatePrimitiveTransformsScalar(batch, i, end, transforms);
+    }
+}
+#endif
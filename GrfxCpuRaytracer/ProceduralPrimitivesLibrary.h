@@ -0,0 +1,124 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// C++ port of the intersection tests of ProceduralPrimitivesLibrary.hlsli in D3D12RaytracingProceduralGeometry.
+//
+// The tests are templates specialized per primitive type, so everything a test calls, down to the distance
+// function of every sphere tracing step, is compiled for that one type. The overloads taking the type at run
+// time, as the shaders read it from l_aabbCB.primitiveType, switch on it once per AABB hit and call the
+// specialization. This matches the per-type intersection shaders of USE_SPECIALIZED_INTERSECTION_SHADERS.
+
+#include "AnalyticPrimitives.h"
+#include "VolumetricPrimitives.h"
+
+namespace CpuRT
+{
+    // IntersectionShaderType::Enum of the sample's RaytracingSceneDefines.h.
+    namespace CpuIntersectionShaderType
+    {
+        enum Enum
+        {
+            AnalyticPrimitive = 0,
+            VolumetricPrimitive,
+            SignedDistancePrimitive,
+            Count
+        };
+
+        static const UINT TotalPrimitiveCount =
+            CpuAnalyticPrimitive::Count + CpuVolumetricPrimitive::Count + CpuSignedDistancePrimitive::Count;
+    }
+
+    // Analytic geometry intersection test.
+    // AABB local space dimensions: <-1,1>.
+    template <CpuAnalyticPrimitive::Enum analyticPrimitive>
+    bool RayAnalyticGeometryIntersectionTest(const Ray& ray, UINT rayFlags, float* tHit, float3* normal);
+
+    template <>
+    inline bool RayAnalyticGeometryIntersectionTest<CpuAnalyticPrimitive::AABB>(const Ray& ray, UINT rayFlags, float* tHit, float3* normal)
+    {
+        const float3 aabb[2] = { float3(-1.0f), float3(1.0f) };
+        return RayAABBIntersectionTest(ray, rayFlags, aabb, tHit, normal);
+    }
+
+    template <>
+    inline bool RayAnalyticGeometryIntersectionTest<CpuAnalyticPrimitive::Spheres>(const Ray& ray, UINT rayFlags, float* tHit, float3* normal)
+    {
+        return RaySpheresIntersectionTest(ray, rayFlags, tHit, normal);
+    }
+
+    inline bool RayAnalyticGeometryIntersectionTest(const Ray& ray, UINT rayFlags, CpuAnalyticPrimitive::Enum analyticPrimitive,
+        float* tHit, float3* normal)
+    {
+        switch (analyticPrimitive)
+        {
+        case CpuAnalyticPrimitive::AABB: return RayAnalyticGeometryIntersectionTest<CpuAnalyticPrimitive::AABB>(ray, rayFlags, tHit, normal);
+        case CpuAnalyticPrimitive::Spheres: return RayAnalyticGeometryIntersectionTest<CpuAnalyticPrimitive::Spheres>(ray, rayFlags, tHit, normal);
+        default: return false;
+        }
+    }
+
+    // Volumetric geometry intersection test of already initialized metaballs, which it reorders.
+    // AABB local space dimensions: <-1,1>.
+    template <CpuVolumetricPrimitive::Enum volumetricPrimitive>
+    bool RayVolumetricGeometryIntersectionTest(const Ray& ray, UINT rayFlags, Metaball* blobs, UINT metaballCount,
+        float* tHit, float3* normal);
+
+    template <>
+    inline bool RayVolumetricGeometryIntersectionTest<CpuVolumetricPrimitive::Metaballs>(const Ray& ray, UINT rayFlags,
+        Metaball* blobs, UINT metaballCount, float* tHit, float3* normal)
+    {
+        return RayMetaballsIntersectionTest(ray, rayFlags, blobs, metaballCount, tHit, normal);
+    }
+
+    inline bool RayVolumetricGeometryIntersectionTest(const Ray& ray, UINT rayFlags, CpuVolumetricPrimitive::Enum volumetricPrimitive,
+        Metaball* blobs, UINT metaballCount, float* tHit, float3* normal)
+    {
+        switch (volumetricPrimitive)
+        {
+        case CpuVolumetricPrimitive::Metaballs:
+            return RayVolumetricGeometryIntersectionTest<CpuVolumetricPrimitive::Metaballs>(ray, rayFlags, blobs, metaballCount, tHit, normal);
+        default: return false;
+        }
+    }
+
+    // Signed distance geometry intersection test: RaySignedDistancePrimitiveTest() specialized for sdPrimitive,
+    // which is switched on once instead of at every step.
+    // AABB local space dimensions: <-1,1>.
+    inline bool RaySignedDistanceGeometryIntersectionTest(const Ray& ray, UINT rayFlags, CpuSignedDistancePrimitive::Enum sdPrimitive,
+        float* tHit, float3* normal, float stepScale = 1.0f, UINT* stepCount = nullptr)
+    {
+        switch (sdPrimitive)
+        {
+        case CpuSignedDistancePrimitive::MiniSpheres:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::MiniSpheres>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        case CpuSignedDistancePrimitive::IntersectedRoundCube:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::IntersectedRoundCube>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        case CpuSignedDistancePrimitive::SquareTorus:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::SquareTorus>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        case CpuSignedDistancePrimitive::TwistedTorus:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::TwistedTorus>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        case CpuSignedDistancePrimitive::Cog:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::Cog>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        case CpuSignedDistancePrimitive::Cylinder:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::Cylinder>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        case CpuSignedDistancePrimitive::FractalPyramid:
+            return RaySignedDistancePrimitiveTest<CpuSignedDistancePrimitive::FractalPyramid>(ray, rayFlags, tHit, normal, stepScale, stepCount);
+        default:
+            if (stepCount)
+            {
+                *stepCount = 0;
+            }
+            return false;
+        }
+    }
+}
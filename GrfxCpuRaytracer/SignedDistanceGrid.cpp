@@ -0,0 +1,212 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SignedDistanceGrid.h"
+#include "CpuThreadPool.h"
+#include <cfloat>
+#include <stdexcept>
+
+namespace CpuRT
+{
+    CpuSignedDistanceGrid::CpuSignedDistanceGrid() :
+        m_desc(),
+        m_storedBrickCount(0)
+    {
+    }
+
+    void CpuSignedDistanceGrid::Bake(CpuSignedDistancePrimitive::Enum sdPrimitive, UINT bricksPerAxis, float bandVoxels,
+        CpuThreadPool* pool)
+    {
+        if (bricksPerAxis == 0)
+        {
+            throw std::invalid_argument("A signed distance grid needs at least one brick per axis.");
+        }
+
+        const UINT brickSize = c_signedDistanceGridBrickSize;
+        const UINT sampleStride = brickSize + 1;
+        const UINT brickCount = bricksPerAxis * bricksPerAxis * bricksPerAxis;
+        const float voxelSize = 2.0f / (bricksPerAxis * brickSize);
+        const float band = (std::max)(bandVoxels, 2.0f) * voxelSize;
+        const float voxelDiagonal = std::sqrt(3.0f) * voxelSize;
+
+        std::vector<float> brickSamples(static_cast<size_t>(brickCount) * c_signedDistanceGridBrickSamples);
+        std::vector<float> emptyDistances(brickCount);
+        std::vector<UINT8> keepBrick(brickCount);
+
+        auto BakeBrick = [&](UINT brickIndex, UINT)
+        {
+            UINT brick[3] = { brickIndex % bricksPerAxis, (brickIndex / bricksPerAxis) % bricksPerAxis, brickIndex / (bricksPerAxis * bricksPerAxis) };
+            float* samples = &brickSamples[static_cast<size_t>(brickIndex) * c_signedDistanceGridBrickSamples];
+            float minAbsDistance = FLT_MAX;
+            bool inside = false;
+            bool outside = false;
+            for (UINT z = 0; z < sampleStride; z++)
+            {
+                for (UINT y = 0; y < sampleStride; y++)
+                {
+                    for (UINT x = 0; x < sampleStride; x++)
+                    {
+                        float3 position(
+                            -1.0f + (brick[0] * brickSize + x) * voxelSize,
+                            -1.0f + (brick[1] * brickSize + y) * voxelSize,
+                            -1.0f + (brick[2] * brickSize + z) * voxelSize);
+                        float distance = GetDistanceFromSignedDistancePrimitive(position, sdPrimitive);
+                        *samples++ = distance;
+                        minAbsDistance = (std::min)(minAbsDistance, std::abs(distance));
+                        inside |= distance < 0.0f;
+                        outside |= distance >= 0.0f;
+                    }
+                }
+            }
+            keepBrick[brickIndex] = (minAbsDistance <= band) || (inside && outside);
+
+            // Every point of the brick is within half a voxel diagonal of a sample. Subtracting a whole diagonal
+            // also covers distance functions that grow up to twice as fast as the true distance.
+            emptyDistances[brickIndex] = (inside ? -1.0f : 1.0f) * (minAbsDistance - voxelDiagonal);
+        };
+
+        if (pool)
+        {
+            pool->Run(brickCount, BakeBrick);
+        }
+        else
+        {
+            for (UINT i = 0; i < brickCount; i++)
+            {
+                BakeBrick(i, 0);
+            }
+        }
+
+        m_brickTable.assign(brickCount, c_signedDistanceGridEmptyBrick);
+        m_samples = std::move(emptyDistances);
+        m_storedBrickCount = 0;
+        for (UINT i = 0; i < brickCount; i++)
+        {
+            if (keepBrick[i])
+            {
+                m_brickTable[i] = m_storedBrickCount++;
+                const float* samples = &brickSamples[static_cast<size_t>(i) * c_signedDistanceGridBrickSamples];
+                m_samples.insert(m_samples.end(), samples, samples + c_signedDistanceGridBrickSamples);
+            }
+        }
+
+        m_desc.bricksPerAxis = bricksPerAxis;
+        m_desc.brickTableOffset = 0;
+        m_desc.sampleOffset = 0;
+        m_desc.voxelSize = voxelSize;
+    }
+
+    float CpuSignedDistanceGrid::GetDistance(const float3& position) const
+    {
+        const UINT brickSize = c_signedDistanceGridBrickSize;
+        const UINT sampleStride = brickSize + 1;
+        const UINT bricksPerAxis = m_desc.bricksPerAxis;
+        const float voxelsPerAxis = static_cast<float>(bricksPerAxis * brickSize);
+
+        float voxel[3];
+        UINT brick[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            voxel[axis] = (std::min)((std::max)((position[axis] + 1.0f) / m_desc.voxelSize, 0.0f), voxelsPerAxis);
+            brick[axis] = (std::min)(static_cast<UINT>(voxel[axis]) / brickSize, bricksPerAxis - 1);
+        }
+
+        UINT brickIndex = (brick[2] * bricksPerAxis + brick[1]) * bricksPerAxis + brick[0];
+        UINT brickEntry = m_brickTable[brickIndex];
+        if (brickEntry == c_signedDistanceGridEmptyBrick)
+        {
+            return m_samples[brickIndex];
+        }
+
+        // Trilinear interpolation between the eight samples around the position.
+        UINT cell[3];
+        float fraction[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float local = voxel[axis] - static_cast<float>(brick[axis] * brickSize);
+            cell[axis] = (std::min)(static_cast<UINT>(local), brickSize - 1);
+            fraction[axis] = local - static_cast<float>(cell[axis]);
+        }
+
+        const UINT brickCount = bricksPerAxis * bricksPerAxis * bricksPerAxis;
+        const float* s = &m_samples[brickCount + static_cast<size_t>(brickEntry) * c_signedDistanceGridBrickSamples
+            + (cell[2] * sampleStride + cell[1]) * sampleStride + cell[0]];
+        const UINT dy = sampleStride;
+        const UINT dz = sampleStride * sampleStride;
+        float d00 = lerp(s[0], s[1], fraction[0]);
+        float d10 = lerp(s[dy], s[dy + 1], fraction[0]);
+        float d01 = lerp(s[dz], s[dz + 1], fraction[0]);
+        float d11 = lerp(s[dz + dy], s[dz + dy + 1], fraction[0]);
+        return lerp(lerp(d00, d10, fraction[1]), lerp(d01, d11, fraction[1]), fraction[2]);
+    }
+
+    float3 CpuSignedDistanceGrid::CalculateNormal(const float3& position) const
+    {
+        // Tetrahedron taps as in sdCalculateNormal(), spread over half a voxel to smooth the interpolated field.
+        const float e = 0.5773f * 0.5f * m_desc.voxelSize;
+        const float3 xyy(e, -e, -e), yyx(-e, -e, e), yxy(-e, e, -e), xxx(e, e, e);
+        return normalize(
+            xyy * GetDistance(position + xyy) +
+            yyx * GetDistance(position + yyx) +
+            yxy * GetDistance(position + yxy) +
+            xxx * GetDistance(position + xxx));
+    }
+
+    bool CpuSignedDistanceGrid::RayTest(const Ray& ray, UINT rayFlags, float* tHit, float3* normal, float stepScale) const
+    {
+        if (m_desc.bricksPerAxis == 0)
+        {
+            return false;
+        }
+
+        // Clip the ray to the AABB the grid covers.
+        const float3 aabb[2] = { float3(-1.0f), float3(1.0f) };
+        float tEntry, tExit;
+        if (!RayAABBIntersectionTest(ray, aabb, &tEntry, &tExit))
+        {
+            return false;
+        }
+
+        float t = (std::max)(ray.tMin, tEntry);
+        const float tEnd = (std::min)(ray.tMax, tExit);
+
+        UINT i = 0;
+        while (i++ < c_maxSignedDistanceSteps && t <= tEnd)
+        {
+            float3 position = ray.origin + ray.direction * t;
+            float distance = GetDistance(position);
+
+            if (distance <= c_signedDistanceThreshold * t)
+            {
+                float3 hitSurfaceNormal = CalculateNormal(position);
+                if (t >= ray.tMin && t <= ray.tMax && !IsCulled(ray.direction, hitSurfaceNormal, rayFlags))
+                {
+                    *tHit = t;
+                    *normal = hitSurfaceNormal;
+                    return true;
+                }
+            }
+
+            t += stepScale * distance;
+        }
+        return false;
+    }
+
+    CpuSignedDistanceGridDesc CpuSignedDistanceGrid::Append(std::vector<UINT>* brickTable, std::vector<float>* samples) const
+    {
+        CpuSignedDistanceGridDesc desc = m_desc;
+        desc.brickTableOffset = static_cast<UINT>(brickTable->size());
+        desc.sampleOffset = static_cast<UINT>(samples->size());
+        brickTable->insert(brickTable->end(), m_brickTable.begin(), m_brickTable.end());
+        samples->insert(samples->end(), m_samples.begin(), m_samples.end());
+        return desc;
+    }
+}
@@ -0,0 +1,78 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Sparse narrow band distance field grids baked from the signed distance primitives.
+//
+// The <-1,1> AABB of a primitive is split into bricksPerAxis^3 bricks of c_signedDistanceGridBrickSize^3
+// voxels. Bricks the surface passes near store (c_signedDistanceGridBrickSize + 1)^3 samples of the
+// primitive's distance function, including their shared faces, so a lookup interpolates within a single
+// brick. Every other brick stores one distance that is safe to step anywhere inside it. The grids are CPU
+// only for now: Append() packs them into buffers a shader could read, but the sample has no shader for them.
+
+#include "SignedDistancePrimitives.h"
+#include <vector>
+
+namespace CpuRT
+{
+    class CpuThreadPool;
+
+    static const UINT c_signedDistanceGridBrickSize = 8;
+    static const UINT c_signedDistanceGridBrickSamples =
+        (c_signedDistanceGridBrickSize + 1) * (c_signedDistanceGridBrickSize + 1) * (c_signedDistanceGridBrickSize + 1);
+    static const UINT c_signedDistanceGridEmptyBrick = 0xffffffff;
+
+    // Where a grid lives in the buffers Append() fills.
+    struct CpuSignedDistanceGridDesc
+    {
+        UINT bricksPerAxis;         // 0 for a primitive without a grid.
+        UINT brickTableOffset;      // First entry of the grid in the brick table buffer.
+        UINT sampleOffset;          // First value of the grid in the sample buffer.
+        float voxelSize;            // Distance between neighbouring samples.
+    };
+
+    class CpuSignedDistanceGrid
+    {
+    public:
+        CpuSignedDistanceGrid();
+
+        // Samples sdPrimitive over its AABB and keeps the bricks that have a sample within bandVoxels voxels
+        // of the surface or samples on both sides of it. bandVoxels is raised to 2 so the distance stored for
+        // the other bricks stays positive. Bricks are baked in parallel on pool if it is not null.
+        void Bake(CpuSignedDistancePrimitive::Enum sdPrimitive, UINT bricksPerAxis, float bandVoxels = 2.0f,
+            CpuThreadPool* pool = nullptr);
+
+        // Trilinearly interpolated distance; positions outside the AABB are clamped to it.
+        float GetDistance(const float3& position) const;
+
+        // Gradient of the interpolated field over half a voxel.
+        float3 CalculateNormal(const float3& position) const;
+
+        // RaySignedDistancePrimitiveTest() over the grid, marching only the part of the ray inside the AABB.
+        bool RayTest(const Ray& ray, UINT rayFlags, float* tHit, float3* normal, float stepScale = 1.0f) const;
+
+        // Appends the grid to buffers shared by several grids and returns its descriptor for those buffers.
+        CpuSignedDistanceGridDesc Append(std::vector<UINT>* brickTable, std::vector<float>* samples) const;
+
+        const CpuSignedDistanceGridDesc& GetDesc() const { return m_desc; }
+        const std::vector<UINT>& GetBrickTable() const { return m_brickTable; }
+        const std::vector<float>& GetSamples() const { return m_samples; }
+        UINT GetStoredBrickCount() const { return m_storedBrickCount; }
+        size_t GetSizeInBytes() const { return m_brickTable.size() * sizeof(UINT) + m_samples.size() * sizeof(float); }
+
+    private:
+        CpuSignedDistanceGridDesc m_desc;
+        std::vector<UINT> m_brickTable;     // Brick index or c_signedDistanceGridEmptyBrick per brick, x fastest.
+        std::vector<float> m_samples;       // One distance per brick for empty bricks, then the stored bricks.
+        UINT m_storedBrickCount;
+    };
+}
@@ -0,0 +1,52 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SignedDistancePrimitives.h"
+
+namespace CpuRT
+{
+    SignedDistanceKernel::Enum GetDefaultSignedDistanceKernel()
+    {
+        return CpuSupportsAvx2() ? SignedDistanceKernel::Avx2 : SignedDistanceKernel::Scalar;
+    }
+
+    UINT RaySignedDistancePrimitiveTest8Scalar(const SignedDistanceRayBatch& rays, UINT rayFlags,
+        CpuSignedDistancePrimitive::Enum sdPrimitive, float stepScale, SignedDistanceBatchHits* hits)
+    {
+        UINT hitMask = 0;
+        const UINT count = (std::min)(rays.count, c_signedDistanceRayBatchWidth);
+        for (UINT lane = 0; lane < count; lane++)
+        {
+            Ray ray(float3(rays.origin[0][lane], rays.origin[1][lane], rays.origin[2][lane]),
+                float3(rays.direction[0][lane], rays.direction[1][lane], rays.direction[2][lane]),
+                rays.tMin[lane], rays.tMax[lane]);
+            float3 normal;
+            if (RaySignedDistancePrimitiveTest(ray, rayFlags, sdPrimitive, &hits->t[lane], &normal, stepScale))
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    hits->normal[axis][lane] = normal[axis];
+                }
+                hitMask |= 1u << lane;
+            }
+        }
+        return hitMask;
+    }
+
+#if !GRFX_CPU_X86
+    // No AVX2 on this architecture; CpuSupportsAvx2() is false so this is never selected.
+    UINT RaySignedDistancePrimitiveTest8Avx2(const SignedDistanceRayBatch& rays, UINT rayFlags,
+        CpuSignedDistancePrimitive::Enum sdPrimitive, float stepScale, SignedDistanceBatchHits* hits)
+    {
+        return RaySignedDistancePrimitiveTest8Scalar(rays, rayFlags, sdPrimitive, stepScale, hits);
+    }
+#endif
+}
@@ -0,0 +1,616 @@
+//*********************************************************************************
+//
+// This file is based on or incorporates material from the projects listed below
+// (Third Party OSS). The original copyright notice and the license under which
+// Microsoft received such Third Party OSS, are set forth below. Such licenses
+// and notices are provided for informational purposes only. Microsoft licenses
+// the Third Party OSS to you under the licensing terms for the Microsoft product
+// or service. Microsoft reserves all other rights not expressly granted under
+// this agreement, whether by implication, estoppel or otherwise.
+//
+// MIT License
+// Copyright(c) 2013 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the Software), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is furnished
+// to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+// OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+// IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************************************
+
+#pragma once
+
+// C++ port of SignedDistancePrimitives.hlsli, SignedDistanceFractals.hlsli and the signed distance part of
+// ProceduralPrimitivesLibrary.hlsli in D3D12RaytracingProceduralGeometry. Functions keep their HLSL names and
+// operation order. RayTMin(), RayTCurrent() and RayFlags() become parameters of the sphere tracer.
+//
+// SignedDistancePrimitivesAvx2.h has the same functions for eight rays at a time; the batched sphere tracers
+// below run either version.
+
+#include "AnalyticPrimitives.h"
+#include "CpuFeatures.h"
+
+namespace CpuRT
+{
+    // SignedDistancePrimitive::Enum of RayTracingHlslCompat.h.
+    namespace CpuSignedDistancePrimitive
+    {
+        enum Enum
+        {
+            MiniSpheres = 0,
+            IntersectedRoundCube,
+            SquareTorus,
+            TwistedTorus,
+            Cog,
+            Cylinder,
+            FractalPyramid,
+            Count
+        };
+    }
+
+    static const UINT c_fractalIterations = 4;              // N_FRACTAL_ITERATIONS
+    static const UINT c_maxSignedDistanceSteps = 512;       // MaxSteps of RaySignedDistancePrimitiveTest().
+    static const float c_signedDistanceThreshold = 0.0001f;
+
+    // HLSL fmod() as DXC lowers it: frac(abs(x / y)) * y with the sign of x / y.
+    inline float HlslFmod(float x, float y)
+    {
+        float div = x / y;
+        float absDiv = std::fabs(div);
+        float fraction = absDiv - std::floor(absDiv);
+        return (div >= 0.0f ? fraction : -fraction) * y;
+    }
+
+    inline float clamp(float x, float minimum, float maximum) { return (std::min)((std::max)(x, minimum), maximum); }
+    inline float sign(float x) { return (x > 0.0f) ? 1.0f : ((x < 0.0f) ? -1.0f : 0.0f); }
+
+    //------------------------------------------------------------------
+
+    // Subtract: Obj1 - Obj2
+    inline float opS(float d1, float d2) { return (std::max)(d1, -d2); }
+
+    // Union: Obj1 + Obj2
+    inline float opU(float d1, float d2) { return (std::min)(d1, d2); }
+
+    // Intersection: Obj1 & Obj2
+    inline float opI(float d1, float d2) { return (std::max)(d1, d2); }
+
+    // Repetitions
+    inline float3 opRep(const float3& p, const float3& c)
+    {
+        return float3(HlslFmod(p.x, c.x), HlslFmod(p.y, c.y), HlslFmod(p.z, c.z)) - c * 0.5f;
+    }
+
+    // Polynomial smooth min/union (k = 0.1)
+    inline float smin(float a, float b, float k)
+    {
+        float h = clamp(0.5f + 0.5f * (b - a) / k, 0.0f, 1.0f);
+        return lerp(b, a, h) - k * h * (1.0f - h);
+    }
+
+    // Polynomial smooth max/intersection (k = 0.1)
+    inline float smax(float a, float b, float k)
+    {
+        float h = clamp(0.5f + 0.5f * (b - a) / k, 0.0f, 1.0f);
+        return lerp(a, b, h) + k * h * (1.0f - h);
+    }
+
+    // Smooth blend as union
+    inline float opBlendU(float d1, float d2) { return smin(d1, d2, 0.1f); }
+
+    // Smooth blend as intersect
+    inline float opBlendI(float d1, float d2) { return smax(d1, d2, 0.1f); }
+
+    // Twist
+    inline float3 opTwist(const float3& p)
+    {
+        float c = std::cos(3.0f * p.y);
+        float s = std::sin(3.0f * p.y);
+        return float3(c * p.x - s * p.z, s * p.x + c * p.z, p.y);
+    }
+
+    //------------------------------------------------------------------
+
+    inline float sdPlane(const float3& p) { return p.y; }
+
+    inline float sdSphere(const float3& p, float s) { return length(p) - s; }
+
+    // Box extents: <-b,b>
+    inline float sdBox(const float3& p, const float3& b)
+    {
+        float3 d = abs(p) - b;
+        return (std::min)((std::max)(d.x, (std::max)(d.y, d.z)), 0.0f) + length(max(d, float3(0.0f)));
+    }
+
+    inline float sdEllipsoid(const float3& p, const float3& r)
+    {
+        return (length(p / r) - 1.0f) * (std::min)((std::min)(r.x, r.y), r.z);
+    }
+
+    inline float udRoundBox(const float3& p, const float3& b, float r)
+    {
+        return length(max(abs(p) - b, float3(0.0f))) - r;
+    }
+
+    // t: {radius, tube radius}
+    inline float sdTorus(const float3& p, const float2& t)
+    {
+        float2 q(length(float2(p.x, p.z)) - t.x, p.y);
+        return length(q) - t.y;
+    }
+
+    inline float sdHexPrism(const float3& p, const float2& h)
+    {
+        float3 q = abs(p);
+        float d1 = q.z - h.y;
+        float d2 = (std::max)(q.x * 0.866025f + q.y * 0.5f, q.y) - h.x;
+        return length(max(float2(d1, d2), float2(0.0f))) + (std::min)((std::max)(d1, d2), 0.0f);
+    }
+
+    inline float sdCapsule(const float3& p, const float3& a, const float3& b, float r)
+    {
+        float3 pa = p - a, ba = b - a;
+        float h = clamp(dot(pa, ba) / dot(ba, ba), 0.0f, 1.0f);
+        return length(pa - ba * h) - r;
+    }
+
+    inline float sdEquilateralTriangle(float2 p)
+    {
+        const float k = 1.73205f;   // sqrt(3.0)
+        p.x = std::fabs(p.x) - 1.0f;
+        p.y = p.y + 1.0f / k;
+        if (p.x + k * p.y > 0.0f)
+        {
+            p = float2((p.x - k * p.y) / 2.0f, (-k * p.x - p.y) / 2.0f);
+        }
+        p.x += 2.0f - 2.0f * clamp((p.x + 2.0f) / 2.0f, 0.0f, 1.0f);
+        return -length(p) * sign(p.y);
+    }
+
+    // Distance bound, the variant the HLSL compiles.
+    inline float sdTriPrism(const float3& p, const float2& h)
+    {
+        float3 q = abs(p);
+        float d1 = q.z - h.y;
+        float d2 = (std::max)(q.x * 0.866025f + p.y * 0.5f, -p.y) - h.x * 0.5f;
+        return length(max(float2(d1, d2), float2(0.0f))) + (std::min)((std::max)(d1, d2), 0.0f);
+    }
+
+    inline float sdCylinder(const float3& p, const float2& h)
+    {
+        float2 d = abs(float2(length(float2(p.x, p.z)), p.y)) - h;
+        return (std::min)((std::max)(d.x, d.y), 0.0f) + length(max(d, float2(0.0f)));
+    }
+
+    inline float sdCone(const float3& p, const float3& c)
+    {
+        float2 q(length(float2(p.x, p.z)), p.y);
+        float d1 = -q.y - c.z;
+        float d2 = (std::max)(dot(q, float2(c.x, c.y)), q.y);
+        return length(max(float2(d1, d2), float2(0.0f))) + (std::min)((std::max)(d1, d2), 0.0f);
+    }
+
+    inline float sdConeSection(const float3& p, float h, float r1, float r2)
+    {
+        float d1 = -p.y - h;
+        float q = p.y - h;
+        float si = 0.5f * (r1 - r2) / h;
+        float d2 = (std::max)(std::sqrt(dot(float2(p.x, p.z), float2(p.x, p.z)) * (1.0f - si * si)) + q * si - r2, q);
+        return length(max(float2(d1, d2), float2(0.0f))) + (std::min)((std::max)(d1, d2), 0.0f);
+    }
+
+    // h = { sin a, cos a, height of a pyramid }
+    // a = pyramid's inner angle between its side plane and a ground plane.
+    // Octahedron position - ground plane intersecting in the middle.
+    inline float sdOctahedron(const float3& p, const float3& h)
+    {
+        // Distance against the pyramid's sides going through the origin, minus the distance to a side at height h.z.
+        float d = dot(float2((std::max)(std::fabs(p.x), std::fabs(p.z)), std::fabs(p.y)), float2(h.x, h.y));
+        return d - h.y * h.z;
+    }
+
+    // Pyramid position - sitting on a ground plane.
+    inline float sdPyramid(const float3& p, const float3& h)
+    {
+        float octa = sdOctahedron(p, h);
+
+        // Subtract bottom half
+        return opS(octa, p.y);
+    }
+
+    inline float length_toPowNegative6(float2 p)
+    {
+        p = p * p * p;
+        p = p * p;
+        return std::pow(p.x + p.y, 1.0f / 6.0f);
+    }
+
+    // pow(x, 1/8) is taken as three square roots, which the SIMD port can match exactly.
+    inline float length_toPowNegative8(float2 p)
+    {
+        p = p * p; p = p * p; p = p * p;
+        return std::sqrt(std::sqrt(std::sqrt(p.x + p.y)));
+    }
+
+    inline float sdTorus82(const float3& p, const float2& t)
+    {
+        float2 q(length(float2(p.x, p.z)) - t.x, p.y);
+        return length_toPowNegative8(q) - t.y;
+    }
+
+    inline float sdTorus88(const float3& p, const float2& t)
+    {
+        float2 q(length_toPowNegative8(float2(p.x, p.z)) - t.x, p.y);
+        return length_toPowNegative8(q) - t.y;
+    }
+
+    inline float sdCylinder6(const float3& p, const float2& h)
+    {
+        return (std::max)(length_toPowNegative6(float2(p.x, p.z)) - h.x, std::fabs(p.y) - h.y);
+    }
+
+    // Returns a signed distance to a recursive pyramid fractal.
+    // h = { sin a, cos a, height of a pyramid}.
+    // Pyramid span: {<-a,0,-a>, <a,h.z,a>}, where a = width of base = h.z * h.y / h.x.
+    GRFX_FORCEINLINE float sdFractalPyramid(float3 position, const float3& h, float scale = 2.0f)
+    {
+        // Set pyramid vertices to AABB's extremities.
+        float a = h.z * h.y / h.x;
+        const float3 vertices[5] = { float3(0, h.z, 0), float3(-a, 0, a), float3(a, 0, -a), float3(a, 0, a), float3(-a, 0, -a) };
+
+        for (UINT n = 0; n < c_fractalIterations; n++)
+        {
+            // Find the closest vertex.
+            float3 v = vertices[0];
+            float dist = dot(position - vertices[0], position - vertices[0]);
+            for (UINT i = 1; i < 5; i++)
+            {
+                float d = dot(position - vertices[i], position - vertices[i]);
+                if (d < dist)
+                {
+                    v = vertices[i];
+                    dist = d;
+                }
+            }
+
+            // Update to a relative position in the current fractal iteration.
+            position = position * scale - v * (scale - 1.0f);
+        }
+        float distance = sdPyramid(position, h);
+
+        // Convert the distance from within a fractal iteration to the object space.
+        return distance * std::pow(scale, -static_cast<float>(c_fractalIterations));
+    }
+
+    //------------------------------------------------------------------
+
+    // Distance to one primitive type, specialized per CpuSignedDistancePrimitive::Enum so the sphere tracers
+    // below can be compiled per type.
+    // AABB local space dimensions: <-1,1>.
+    template <CpuSignedDistancePrimitive::Enum sdPrimitive>
+    float GetDistanceFromSignedDistancePrimitive(const float3& position);
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::MiniSpheres>(const float3& position)
+    {
+        return opI(sdSphere(opRep(position + 1.0f, float3(2.0f / 4)), 0.65f / 4), sdBox(position, float3(1.0f)));
+    }
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::IntersectedRoundCube>(const float3& position)
+    {
+        return opS(opS(udRoundBox(position, float3(0.75f), 0.2f), sdSphere(position, 1.20f)), -sdSphere(position, 1.32f));
+    }
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::SquareTorus>(const float3& position)
+    {
+        return sdTorus82(position, float2(0.75f, 0.15f));
+    }
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::TwistedTorus>(const float3& position)
+    {
+        return sdTorus(opTwist(position), float2(0.6f, 0.2f));
+    }
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::Cog>(const float3& position)
+    {
+        return opS(sdTorus82(position, float2(0.60f, 0.3f)),
+            sdCylinder(opRep(float3(std::atan2(position.z, position.x) / 6.2831f, 1.0f, 0.015f + 0.25f * length(position)) + 1.0f,
+                float3(0.05f, 1.0f, 0.075f)),
+                float2(0.02f, 0.8f)));
+    }
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::Cylinder>(const float3& position)
+    {
+        return opI(sdCylinder(opRep(position + float3(1, 1, 1), float3(1, 2, 1)), float2(0.3f, 2.0f)),
+            sdBox(position + float3(1, 1, 1), float3(2, 2, 2)));
+    }
+
+    template <>
+    GRFX_FORCEINLINE float GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::FractalPyramid>(const float3& position)
+    {
+        // Pyramid with its base at y == -1 of the AABB: 63.435 degrees at base, height 2.
+        return sdFractalPyramid(position + float3(0, 1, 0), float3(0.894f, 0.447f, 2.0f), 2.0f);
+    }
+
+    // The shader's version, switching on the primitive type at every call.
+    inline float GetDistanceFromSignedDistancePrimitive(const float3& position, CpuSignedDistancePrimitive::Enum sdPrimitive)
+    {
+        switch (sdPrimitive)
+        {
+        case CpuSignedDistancePrimitive::MiniSpheres:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::MiniSpheres>(position);
+        case CpuSignedDistancePrimitive::IntersectedRoundCube:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::IntersectedRoundCube>(position);
+        case CpuSignedDistancePrimitive::SquareTorus:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::SquareTorus>(position);
+        case CpuSignedDistancePrimitive::TwistedTorus:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::TwistedTorus>(position);
+        case CpuSignedDistancePrimitive::Cog:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::Cog>(position);
+        case CpuSignedDistancePrimitive::Cylinder:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::Cylinder>(position);
+        case CpuSignedDistancePrimitive::FractalPyramid:
+            return GetDistanceFromSignedDistancePrimitive<CpuSignedDistancePrimitive::FractalPyramid>(position);
+        default:
+            return 0;
+        }
+    }
+
+    // Offsets of the tetrahedral central difference in sdCalculateNormal().
+    static const float c_signedDistanceNormalEpsilon = 0.5773f * 0.0001f;
+
+    // Normal of any distance function float(const float3&), e.g. one of the specializations above.
+    template <typename DistanceFunction>
+    inline float3 sdCalculateNormal(const float3& pos, const DistanceFunction& distanceFunction)
+    {
+        const float e = c_signedDistanceNormalEpsilon;
+        const float3 xyy(e, -e, -e), yyx(-e, -e, e), yxy(-e, e, -e), xxx(e, e, e);
+        return normalize(
+            xyy * distanceFunction(pos + xyy) +
+            yyx * distanceFunction(pos + yyx) +
+            yxy * distanceFunction(pos + yxy) +
+            xxx * distanceFunction(pos + xxx));
+    }
+
+    inline float3 sdCalculateNormal(const float3& pos, CpuSignedDistancePrimitive::Enum sdPrimitive)
+    {
+        return sdCalculateNormal(pos, [sdPrimitive](const float3& p) { return GetDistanceFromSignedDistancePrimitive(p, sdPrimitive); });
+    }
+
+    // The sphere tracer of RaySignedDistancePrimitiveTest() for any distance function float(const float3&).
+    template <typename DistanceFunction>
+    inline bool RaySignedDistanceFunctionTest(const Ray& ray, UINT rayFlags, const DistanceFunction& distanceFunction,
+        float* tHit, float3* normal, float stepScale, UINT* stepCount)
+    {
+        float t = ray.tMin;
+        bool hit = false;
+
+        // Do sphere tracing through the AABB.
+        UINT i = 0;
+        while (i < c_maxSignedDistanceSteps && t <= ray.tMax)
+        {
+            i++;
+            float3 position = ray.origin + ray.direction * t;
+            float distance = distanceFunction(position);
+
+            // Has the ray intersected the primitive?
+            if (distance <= c_signedDistanceThreshold * t)
+            {
+                float3 hitSurfaceNormal = sdCalculateNormal(position, distanceFunction);
+                if (IsAValidHit(ray, rayFlags, t, hitSurfaceNormal))
+                {
+                    *tHit = t;
+                    *normal = hitSurfaceNormal;
+                    hit = true;
+                    break;
+                }
+            }
+
+            // Distance is the minimum distance to the primitive, so stepping by it cannot cross the surface.
+            // stepScale compensates for transformations that don't preserve distances.
+            t += stepScale * distance;
+        }
+
+        if (stepCount)
+        {
+            *stepCount = i;
+        }
+        return hit;
+    }
+
+    // Sphere traces ray from ray.tMin while t <= ray.tMax, which stands in for RayTCurrent(), switching on
+    // sdPrimitive at every step as the shader does. stepCount, if not null, receives the number of distance
+    // evaluations, not counting those of the normal.
+    inline bool RaySignedDistancePrimitiveTest(const Ray& ray, UINT rayFlags, CpuSignedDistancePrimitive::Enum sdPrimitive,
+        float* tHit, float3* normal, float stepScale = 1.0f, UINT* stepCount = nullptr)
+    {
+        return RaySignedDistanceFunctionTest(ray, rayFlags,
+            [sdPrimitive](const float3& p) { return GetDistanceFromSignedDistancePrimitive(p, sdPrimitive); },
+            tHit, normal, stepScale, stepCount);
+    }
+
+    // RaySignedDistancePrimitiveTest() compiled for one primitive type, without a switch in the loop.
+    template <CpuSignedDistancePrimitive::Enum sdPrimitive>
+    inline bool RaySignedDistancePrimitiveTest(const Ray& ray, UINT rayFlags, float* tHit, float3* normal,
+        float stepScale = 1.0f, UINT* stepCount = nullptr)
+    {
+        return RaySignedDistanceFunctionTest(ray, rayFlags,
+            [](const float3& p) { return GetDistanceFromSignedDistancePrimitive<sdPrimitive>(p); },
+            tHit, normal, stepScale, stepCount);
+    }
+
+    static const float c_sphereTracingRelaxation = 1.6f;    // SPHERE_TRACING_RELAXATION
+
+    // The over-relaxed sphere tracer of RaySignedDistancePrimitiveTestRelaxed() for any distance function
+    // float(const float3&). Marches only the part of the ray inside the <-1,1> AABB and steps relaxation times
+    // the safe distance. A step that overshoots the last safe sphere is detected before its hit test, undone and
+    // marching continues with unrelaxed steps (Keinert et al., Enhanced Sphere Tracing, 2014).
+    //
+    // The loop performs the float operations of the HLSL version in the same order, so the two agree bit for bit
+    // only as long as neither compiler contracts a multiply and an add into one fused operation. HLSL compilers
+    // may turn a * b + c into mad, which DXIL lets the GPU evaluate fused or unfused unless the result is precise;
+    // C++ compilers contract under /fp:contract or -ffp-contract=fast with FMA enabled. In the loop only the
+    // position, ray.origin + ray.direction * t, can be contracted (the undo step is written as a product so that
+    // it cannot); the distance functions and sdCalculateNormal() contain many more such sites. The
+    // sdf.relaxedcontraction test of GrfxCpuTests bounds how far the hits move under those rounding differences.
+    template <typename DistanceFunction>
+    inline bool RaySignedDistanceFunctionTestRelaxed(const Ray& ray, UINT rayFlags, const DistanceFunction& distanceFunction,
+        float* tHit, float3* normal, float stepScale, float relaxation, UINT* stepCount)
+    {
+        const float3 aabb[2] = { float3(-1.0f), float3(1.0f) };
+        bool hit = false;
+        UINT i = 0;
+
+        float tmin, tmax;
+        if (RayAABBIntersectionTest(ray, aabb, &tmin, &tmax))
+        {
+            float t = (std::max)(ray.tMin, tmin);
+            float tEnd = (std::min)(ray.tMax, tmax);
+            float omega = relaxation;
+            float previousRadius = 0;
+            float stepLength = 0;
+
+            while (i < c_maxSignedDistanceSteps && t <= tEnd)
+            {
+                i++;
+                float3 position = ray.origin + ray.direction * t;
+                float distance = distanceFunction(position);
+                float radius = stepScale * std::abs(distance);
+
+                // The spheres around the last two positions don't overlap, so the step may have crossed the surface.
+                bool relaxationFailed = omega > 1 && radius + previousRadius < stepLength;
+                if (relaxationFailed)
+                {
+                    stepLength *= 1 - omega;
+                    omega = 1;
+                }
+                else
+                {
+                    if (distance <= c_signedDistanceThreshold * t)
+                    {
+                        float3 hitSurfaceNormal = sdCalculateNormal(position, distanceFunction);
+                        if (t >= ray.tMin && t <= ray.tMax && !IsCulled(ray.direction, hitSurfaceNormal, rayFlags))
+                        {
+                            *tHit = t;
+                            *normal = hitSurfaceNormal;
+                            hit = true;
+                            break;
+                        }
+                    }
+                    stepLength = omega * stepScale * distance;
+                }
+                previousRadius = radius;
+                t += stepLength;
+            }
+        }
+
+        if (stepCount)
+        {
+            *stepCount = i;
+        }
+        return hit;
+    }
+
+    // RaySignedDistancePrimitiveTestRelaxed() of SignedDistancePrimitives.hlsli, switching on sdPrimitive at every
+    // step as the shader does. stepCount, if not null, receives the number of distance evaluations.
+    inline bool RaySignedDistancePrimitiveTestRelaxed(const Ray& ray, UINT rayFlags, CpuSignedDistancePrimitive::Enum sdPrimitive,
+        float* tHit, float3* normal, float stepScale = 1.0f, float relaxation = c_sphereTracingRelaxation, UINT* stepCount = nullptr)
+    {
+        return RaySignedDistanceFunctionTestRelaxed(ray, rayFlags,
+            [sdPrimitive](const float3& p) { return GetDistanceFromSignedDistancePrimitive(p, sdPrimitive); },
+            tHit, normal, stepScale, relaxation, stepCount);
+    }
+
+    static const UINT c_signedDistanceStepHistogramBins = 11;
+
+    // Bin 0 counts rays without steps, bin b rays with [2^(b - 1), 2^b) steps and the last bin rays that
+    // used all c_maxSignedDistanceSteps.
+    inline UINT GetSignedDistanceStepHistogramBin(UINT steps)
+    {
+        UINT bin = 0;
+        while (steps >> bin)
+        {
+            bin++;
+        }
+        return (std::min)(bin, c_signedDistanceStepHistogramBins - 1);
+    }
+
+    // Step counts of sphere traced rays; zero-initialize, e.g. SignedDistanceStepHistogram histogram = {}.
+    struct SignedDistanceStepHistogram
+    {
+        UINT64 bins[c_signedDistanceStepHistogramBins];
+        UINT64 rayCount;
+        UINT64 stepCount;
+
+        void Add(UINT steps)
+        {
+            bins[GetSignedDistanceStepHistogramBin(steps)]++;
+            rayCount++;
+            stepCount += steps;
+        }
+
+        void Add(const SignedDistanceStepHistogram& other)
+        {
+            for (UINT b = 0; b < c_signedDistanceStepHistogramBins; b++)
+            {
+                bins[b] += other.bins[b];
+            }
+            rayCount += other.rayCount;
+            stepCount += other.stepCount;
+        }
+
+        double GetAverageSteps() const { return rayCount ? static_cast<double>(stepCount) / rayCount : 0.0; }
+    };
+
+    //------------------------------------------------------------------
+
+    // The batch types of AnalyticPrimitives.h under their original names.
+    static const UINT c_signedDistanceRayBatchWidth = c_rayBatchWidth;
+    typedef RayBatch SignedDistanceRayBatch;
+    typedef RayBatchHits SignedDistanceBatchHits;
+
+    namespace SignedDistanceKernel
+    {
+        enum Enum
+        {
+            Scalar,
+            Avx2
+        };
+    }
+
+    // Avx2 when CpuSupportsAvx2(), Scalar otherwise.
+    SignedDistanceKernel::Enum GetDefaultSignedDistanceKernel();
+
+    // RaySignedDistancePrimitiveTest() for the rays of a batch; returns the mask of lanes that hit. The AVX2
+    // kernel marches all lanes together and retires each one when it hits or leaves its range. Both kernels
+    // match RaySignedDistancePrimitiveTest() bit for bit; the AVX2 kernel requires CpuSupportsAvx2().
+    UINT RaySignedDistancePrimitiveTest8Scalar(const SignedDistanceRayBatch& rays, UINT rayFlags,
+        CpuSignedDistancePrimitive::Enum sdPrimitive, float stepScale, SignedDistanceBatchHits* hits);
+    UINT RaySignedDistancePrimitiveTest8Avx2(const SignedDistanceRayBatch& rays, UINT rayFlags,
+        CpuSignedDistancePrimitive::Enum sdPrimitive, float stepScale, SignedDistanceBatchHits* hits);
+
+    inline UINT RaySignedDistancePrimitiveTest8(SignedDistanceKernel::Enum kernel, const SignedDistanceRayBatch& rays, UINT rayFlags,
+        CpuSignedDistancePrimitive::Enum sdPrimitive, float stepScale, SignedDistanceBatchHits* hits)
+    {
+        return (kernel == SignedDistanceKernel::Avx2)
+            ? RaySignedDistancePrimitiveTest8Avx2(rays, rayFlags, sdPrimitive, stepScale, hits)
+            : RaySignedDistancePrimitiveTest8Scalar(rays, rayFlags, sdPrimitive, stepScale, hits);
+    }
+}
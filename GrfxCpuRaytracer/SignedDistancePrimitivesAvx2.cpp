@@ -0,0 +1,72 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// 8-wide AVX2 sphere tracer for SignedDistancePrimitives.h. Only this translation unit runs AVX2 code.
+
+#include "SignedDistancePrimitivesAvx2.h"
+
+#if GRFX_CPU_X86
+namespace CpuRT
+{
+    // RaySignedDistancePrimitiveTest() with one lane per ray. All lanes step together; a lane retires when it
+    // finds a valid hit or its t leaves [tMin, tMax], and the loop ends once no lane is left.
+    GRFX_TARGET_AVX2 UINT RaySignedDistancePrimitiveTest8Avx2(const SignedDistanceRayBatch& rays, UINT rayFlags,
+        CpuSignedDistancePrimitive::Enum sdPrimitive, float stepScale, SignedDistanceBatchHits* hits)
+    {
+        const float3x8 origin = Load8(rays.origin);
+        const float3x8 direction = Load8(rays.direction);
+        const float8 tMin = Load8(rays.tMin);
+        const float8 tMax = Load8(rays.tMax);
+
+        float8 t = tMin;
+        float8 hitT = Splat(0.0f);
+        float3x8 hitNormal = Splat(float3(0.0f));
+        UINT active = (rays.count >= c_signedDistanceRayBatchWidth) ? 0xFF : (1u << rays.count) - 1;
+        UINT hitMask = 0;
+
+        for (UINT i = 0; i < c_maxSignedDistanceSteps; i++)
+        {
+            active &= MoveMask(t <= tMax);
+            if (!active)
+            {
+                break;
+            }
+
+            float3x8 position = origin + direction * t;
+            float8 distance = GetDistanceFromSignedDistancePrimitive(position, sdPrimitive);
+
+            UINT candidates = active & MoveMask(distance <= c_signedDistanceThreshold * t);
+            if (candidates)
+            {
+                float3x8 hitSurfaceNormal = sdCalculateNormal(position, sdPrimitive);
+                float8 valid = AndNot(IsCulled(direction, hitSurfaceNormal, rayFlags), (t >= tMin) & (t <= tMax));
+                UINT newHits = candidates & MoveMask(valid);
+                if (newHits)
+                {
+                    float8 newHitLanes = LaneMask(newHits);
+                    hitT = Select(newHitLanes, t, hitT);
+                    hitNormal = Select(newHitLanes, hitSurfaceNormal, hitNormal);
+                    hitMask |= newHits;
+                    active &= ~newHits;
+                }
+            }
+
+            t = t + stepScale * distance;
+        }
+
+        _mm256_storeu_ps(hits->t, hitT.v);
+        _mm256_storeu_ps(hits->normal[0], hitNormal.x.v);
+        _mm256_storeu_ps(hits->normal[1], hitNormal.y.v);
+        _mm256_storeu_ps(hits->normal[2], hitNormal.z.v);
+        return hitMask;
+    }
+}
+#endif
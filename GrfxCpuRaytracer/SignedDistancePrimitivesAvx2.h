@@ -0,0 +1,269 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// The functions of SignedDistancePrimitives.h for eight lanes at a time, on the float8 types of CpuMathAvx2.h.
+// Every function mirrors its scalar version operation by operation, so each lane matches the scalar result
+// bit for bit.
+//
+// Only for translation units that run AVX2 code: every function is GRFX_INLINE_AVX2 and callers must
+// check CpuSupportsAvx2().
+
+#include "AnalyticPrimitivesAvx2.h"
+#include "SignedDistancePrimitives.h"
+
+#if GRFX_CPU_X86
+namespace CpuRT
+{
+    GRFX_INLINE_AVX2 float8 HlslFmod(const float8& x, float y)
+    {
+        float8 div = x / y;
+        float8 absDiv = abs(div);
+        float8 fraction = absDiv - floor(absDiv);
+        return Select(div >= Splat(0.0f), fraction, -fraction) * y;
+    }
+
+    GRFX_INLINE_AVX2 float8 opS(const float8& d1, const float8& d2) { return max(d1, -d2); }
+    GRFX_INLINE_AVX2 float8 opU(const float8& d1, const float8& d2) { return min(d1, d2); }
+    GRFX_INLINE_AVX2 float8 opI(const float8& d1, const float8& d2) { return max(d1, d2); }
+
+    GRFX_INLINE_AVX2 float3x8 opRep(const float3x8& p, const float3& c)
+    {
+        float3x8 r = { HlslFmod(p.x, c.x), HlslFmod(p.y, c.y), HlslFmod(p.z, c.z) };
+        return r - c * 0.5f;
+    }
+
+    GRFX_INLINE_AVX2 float8 smin(const float8& a, const float8& b, float k)
+    {
+        float8 h = clamp(0.5f + 0.5f * (b - a) / k, 0.0f, 1.0f);
+        return lerp(b, a, h) - k * h * (1.0f - h);
+    }
+
+    GRFX_INLINE_AVX2 float8 smax(const float8& a, const float8& b, float k)
+    {
+        float8 h = clamp(0.5f + 0.5f * (b - a) / k, 0.0f, 1.0f);
+        return lerp(a, b, h) + k * h * (1.0f - h);
+    }
+
+    GRFX_INLINE_AVX2 float8 opBlendU(const float8& d1, const float8& d2) { return smin(d1, d2, 0.1f); }
+    GRFX_INLINE_AVX2 float8 opBlendI(const float8& d1, const float8& d2) { return smax(d1, d2, 0.1f); }
+
+    GRFX_INLINE_AVX2 float3x8 opTwist(const float3x8& p)
+    {
+        float8 c = cos(3.0f * p.y);
+        float8 s = sin(3.0f * p.y);
+        return { c * p.x - s * p.z, s * p.x + c * p.z, p.y };
+    }
+
+    //------------------------------------------------------------------
+
+    GRFX_INLINE_AVX2 float8 sdPlane(const float3x8& p) { return p.y; }
+
+    GRFX_INLINE_AVX2 float8 sdSphere(const float3x8& p, float s) { return length(p) - s; }
+
+    GRFX_INLINE_AVX2 float8 sdBox(const float3x8& p, const float3& b)
+    {
+        float3x8 d = abs(p) - b;
+        return min(max(d.x, max(d.y, d.z)), 0.0f) + length(max(d, 0.0f));
+    }
+
+    GRFX_INLINE_AVX2 float8 sdEllipsoid(const float3x8& p, const float3& r)
+    {
+        return (length(p / r) - 1.0f) * (std::min)((std::min)(r.x, r.y), r.z);
+    }
+
+    GRFX_INLINE_AVX2 float8 udRoundBox(const float3x8& p, const float3& b, float r)
+    {
+        return length(max(abs(p) - b, 0.0f)) - r;
+    }
+
+    GRFX_INLINE_AVX2 float8 sdTorus(const float3x8& p, const float2& t)
+    {
+        float2x8 q = { length(float2x8{ p.x, p.z }) - t.x, p.y };
+        return length(q) - t.y;
+    }
+
+    GRFX_INLINE_AVX2 float8 sdHexPrism(const float3x8& p, const float2& h)
+    {
+        float3x8 q = abs(p);
+        float8 d1 = q.z - h.y;
+        float8 d2 = max(q.x * 0.866025f + q.y * 0.5f, q.y) - h.x;
+        return length(max(float2x8{ d1, d2 }, 0.0f)) + min(max(d1, d2), 0.0f);
+    }
+
+    GRFX_INLINE_AVX2 float8 sdCapsule(const float3x8& p, const float3& a, const float3& b, float r)
+    {
+        float3x8 pa = p - a;
+        float3 ba = b - a;
+        float8 h = clamp(dot(pa, ba) / Splat(dot(ba, ba)), 0.0f, 1.0f);
+        return length(pa - ba * h) - r;
+    }
+
+    GRFX_INLINE_AVX2 float8 sdEquilateralTriangle(float2x8 p)
+    {
+        const float k = 1.73205f;
+        p.x = abs(p.x) - 1.0f;
+        p.y = p.y + 1.0f / k;
+        float8 fold = (p.x + k * p.y) > Splat(0.0f);
+        float2x8 folded = { (p.x - k * p.y) / 2.0f, (-k * p.x - p.y) / 2.0f };
+        p = { Select(fold, folded.x, p.x), Select(fold, folded.y, p.y) };
+        p.x = p.x + (2.0f - 2.0f * clamp((p.x + 2.0f) / 2.0f, 0.0f, 1.0f));
+        return -length(p) * sign(p.y);
+    }
+
+    GRFX_INLINE_AVX2 float8 sdTriPrism(const float3x8& p, const float2& h)
+    {
+        float3x8 q = abs(p);
+        float8 d1 = q.z - h.y;
+        float8 d2 = max(q.x * 0.866025f + p.y * 0.5f, -p.y) - h.x * 0.5f;
+        return length(max(float2x8{ d1, d2 }, 0.0f)) + min(max(d1, d2), 0.0f);
+    }
+
+    GRFX_INLINE_AVX2 float8 sdCylinder(const float3x8& p, const float2& h)
+    {
+        float2x8 d = abs(float2x8{ length(float2x8{ p.x, p.z }), p.y }) - h;
+        return min(max(d.x, d.y), 0.0f) + length(max(d, 0.0f));
+    }
+
+    GRFX_INLINE_AVX2 float8 sdCone(const float3x8& p, const float3& c)
+    {
+        float2x8 q = { length(float2x8{ p.x, p.z }), p.y };
+        float8 d1 = -q.y - c.z;
+        float8 d2 = max(dot(q, float2(c.x, c.y)), q.y);
+        return length(max(float2x8{ d1, d2 }, 0.0f)) + min(max(d1, d2), 0.0f);
+    }
+
+    GRFX_INLINE_AVX2 float8 sdConeSection(const float3x8& p, float h, float r1, float r2)
+    {
+        float8 d1 = -p.y - h;
+        float8 q = p.y - h;
+        float si = 0.5f * (r1 - r2) / h;
+        float2x8 pxz = { p.x, p.z };
+        float8 d2 = max(sqrt(dot(pxz, pxz) * (1.0f - si * si)) + q * si - r2, q);
+        return length(max(float2x8{ d1, d2 }, 0.0f)) + min(max(d1, d2), 0.0f);
+    }
+
+    GRFX_INLINE_AVX2 float8 sdOctahedron(const float3x8& p, const float3& h)
+    {
+        float8 d = dot(float2x8{ max(abs(p.x), abs(p.z)), abs(p.y) }, float2(h.x, h.y));
+        return d - h.y * h.z;
+    }
+
+    GRFX_INLINE_AVX2 float8 sdPyramid(const float3x8& p, const float3& h)
+    {
+        return opS(sdOctahedron(p, h), p.y);
+    }
+
+    GRFX_INLINE_AVX2 float8 length_toPowNegative6(float2x8 p)
+    {
+        p = p * p * p;
+        p = p * p;
+        return pow(p.x + p.y, 1.0f / 6.0f);
+    }
+
+    GRFX_INLINE_AVX2 float8 length_toPowNegative8(float2x8 p)
+    {
+        p = p * p; p = p * p; p = p * p;
+        return sqrt(sqrt(sqrt(p.x + p.y)));
+    }
+
+    GRFX_INLINE_AVX2 float8 sdTorus82(const float3x8& p, const float2& t)
+    {
+        float2x8 q = { length(float2x8{ p.x, p.z }) - t.x, p.y };
+        return length_toPowNegative8(q) - t.y;
+    }
+
+    GRFX_INLINE_AVX2 float8 sdTorus88(const float3x8& p, const float2& t)
+    {
+        float2x8 q = { length_toPowNegative8(float2x8{ p.x, p.z }) - t.x, p.y };
+        return length_toPowNegative8(q) - t.y;
+    }
+
+    GRFX_INLINE_AVX2 float8 sdCylinder6(const float3x8& p, const float2& h)
+    {
+        return max(length_toPowNegative6(float2x8{ p.x, p.z }) - h.x, abs(p.y) - h.y);
+    }
+
+    GRFX_INLINE_AVX2 float8 sdFractalPyramid(float3x8 position, const float3& h, float scale = 2.0f)
+    {
+        float a = h.z * h.y / h.x;
+        const float3 vertices[5] = { float3(0, h.z, 0), float3(-a, 0, a), float3(a, 0, -a), float3(a, 0, a), float3(-a, 0, -a) };
+
+        for (UINT n = 0; n < c_fractalIterations; n++)
+        {
+            // Closest vertex per lane.
+            float3x8 v = Splat(vertices[0]);
+            float3x8 offset = position - vertices[0];
+            float8 dist = dot(offset, offset);
+            for (UINT i = 1; i < 5; i++)
+            {
+                offset = position - vertices[i];
+                float8 d = dot(offset, offset);
+                float8 closer = d < dist;
+                v = Select(closer, Splat(vertices[i]), v);
+                dist = Select(closer, d, dist);
+            }
+
+            position = position * scale - v * (scale - 1.0f);
+        }
+        return sdPyramid(position, h) * std::pow(scale, -static_cast<float>(c_fractalIterations));
+    }
+
+    //------------------------------------------------------------------
+
+    GRFX_INLINE_AVX2 float8 GetDistanceFromSignedDistancePrimitive(const float3x8& position, CpuSignedDistancePrimitive::Enum sdPrimitive)
+    {
+        switch (sdPrimitive)
+        {
+        case CpuSignedDistancePrimitive::MiniSpheres:
+            return opI(sdSphere(opRep(position + 1.0f, float3(2.0f / 4)), 0.65f / 4), sdBox(position, float3(1.0f)));
+
+        case CpuSignedDistancePrimitive::IntersectedRoundCube:
+            return opS(opS(udRoundBox(position, float3(0.75f), 0.2f), sdSphere(position, 1.20f)), -sdSphere(position, 1.32f));
+
+        case CpuSignedDistancePrimitive::SquareTorus:
+            return sdTorus82(position, float2(0.75f, 0.15f));
+
+        case CpuSignedDistancePrimitive::TwistedTorus:
+            return sdTorus(opTwist(position), float2(0.6f, 0.2f));
+
+        case CpuSignedDistancePrimitive::Cog:
+        {
+            float3x8 cogPosition = { atan2(position.z, position.x) / 6.2831f, Splat(1.0f), 0.015f + 0.25f * length(position) };
+            return opS(sdTorus82(position, float2(0.60f, 0.3f)),
+                sdCylinder(opRep(cogPosition + 1.0f, float3(0.05f, 1.0f, 0.075f)), float2(0.02f, 0.8f)));
+        }
+
+        case CpuSignedDistancePrimitive::Cylinder:
+            return opI(sdCylinder(opRep(position + float3(1, 1, 1), float3(1, 2, 1)), float2(0.3f, 2.0f)),
+                sdBox(position + float3(1, 1, 1), float3(2, 2, 2)));
+
+        case CpuSignedDistancePrimitive::FractalPyramid:
+            return sdFractalPyramid(position + float3(0, 1, 0), float3(0.894f, 0.447f, 2.0f), 2.0f);
+
+        default:
+            return Splat(0.0f);
+        }
+    }
+
+    GRFX_INLINE_AVX2 float3x8 sdCalculateNormal(const float3x8& pos, CpuSignedDistancePrimitive::Enum sdPrimitive)
+    {
+        const float e = c_signedDistanceNormalEpsilon;
+        const float3 xyy(e, -e, -e), yyx(-e, -e, e), yxy(-e, e, -e), xxx(e, e, e);
+        return normalize(
+            xyy * GetDistanceFromSignedDistancePrimitive(pos + xyy, sdPrimitive) +
+            yyx * GetDistanceFromSignedDistancePrimitive(pos + yyx, sdPrimitive) +
+            yxy * GetDistanceFromSignedDistancePrimitive(pos + yxy, sdPrimitive) +
+            xxx * GetDistanceFromSignedDistancePrimitive(pos + xxx, sdPrimitive));
+    }
+}
+#endif
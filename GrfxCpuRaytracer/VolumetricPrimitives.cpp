@@ -0,0 +1,53 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "VolumetricPrimitives.h"
+#include <stdexcept>
+
+namespace CpuRT
+{
+    void InitializeAnimatedMetaballs(Metaball* blobs, UINT metaballCount, float elapsedTime, float cycleDuration)
+    {
+        // Metaball centers at t0 and t1 key frames.
+        static const float3 keyFrameCenters5[5][2] =
+        {
+            { float3(-0.7f, 0, 0), float3(0.7f, 0, 0) },
+            { float3(0.7f, 0, 0), float3(-0.7f, 0, 0) },
+            { float3(0, -0.7f, 0), float3(0, 0.7f, 0) },
+            { float3(0, 0.7f, 0), float3(0, -0.7f, 0) },
+            { float3(0, 0, 0), float3(0, 0, 0) }
+        };
+        static const float radii5[5] = { 0.35f, 0.35f, 0.35f, 0.35f, 0.25f };
+
+        static const float3 keyFrameCenters3[3][2] =
+        {
+            { float3(-0.3f, -0.3f, -0.4f), float3(0.3f, -0.3f, -0.0f) },
+            { float3(0.0f, -0.2f, 0.5f), float3(0.0f, 0.4f, 0.5f) },
+            { float3(0.4f, 0.4f, 0.4f), float3(-0.4f, 0.2f, -0.4f) }
+        };
+        static const float radii3[3] = { 0.45f, 0.55f, 0.45f };
+
+        if (metaballCount != 3 && metaballCount != 5)
+        {
+            throw std::invalid_argument("The sample animates either 3 or 5 metaballs.");
+        }
+        const bool fiveMetaballs = metaballCount == 5;
+
+        // Calculate animated metaball center positions.
+        float tAnimate = CalculateAnimationInterpolant(elapsedTime, cycleDuration);
+        for (UINT j = 0; j < metaballCount; j++)
+        {
+            const float3* keyFrames = fiveMetaballs ? keyFrameCenters5[j] : keyFrameCenters3[j];
+            blobs[j].center = lerp(keyFrames[0], keyFrames[1], tAnimate);
+            blobs[j].radius = fiveMetaballs ? radii5[j] : radii3[j];
+        }
+    }
+}
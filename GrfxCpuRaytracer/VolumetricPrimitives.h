@@ -0,0 +1,324 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// C++ port of VolumetricPrimitives.hlsli in D3D12RaytracingProceduralGeometry: ray marching of metaballs.
+// Functions keep their HLSL names and operation order. RayTMin(), RayTCurrent() and RayFlags() become
+// ray.tMin, ray.tMax and a parameter, and the metaballs are passed in so any number of them can be traced.
+// The ray tests always limit their loops to the metaballs the ray intersects, which doesn't change the sums.
+
+#include "SignedDistancePrimitives.h"
+
+namespace CpuRT
+{
+    // VolumetricPrimitive::Enum of RayTracingHlslCompat.h.
+    namespace CpuVolumetricPrimitive
+    {
+        enum Enum
+        {
+            Metaballs = 0,
+            Count
+        };
+    }
+
+    static const UINT c_metaballMaxSteps = 128;                 // MAX_STEPS of RayMetaballsIntersectionTest().
+    static const UINT c_metaballIntervalMaxSteps = 256;         // METABALL_INTERVAL_MAX_STEPS
+    static const UINT c_metaballIntervalRefinementSteps = 4;    // METABALL_INTERVAL_REFINEMENT_STEPS
+    static const float c_metaballThreshold = 0.25f;             // Threshold of the isosurface.
+
+    // Matches Metaball in the sample's VolumetricPrimitives.hlsli.
+    struct Metaball
+    {
+        float3 center;
+        float radius;
+    };
+
+    // Calculate a magnitude of an influence from a Metaball charge.
+    // Return metaball potential range: <0,1>
+    inline float CalculateMetaballPotential(const float3& position, const Metaball& blob, float* distance)
+    {
+        *distance = length(position - blob.center);
+
+        if (*distance <= blob.radius)
+        {
+            // Quintic polynomial of the distance to the radius.
+            float d = blob.radius - *distance;
+
+            float r = blob.radius;
+            return 6 * (d * d * d * d * d) / (r * r * r * r * r)
+                - 15 * (d * d * d * d) / (r * r * r * r)
+                + 10 * (d * d * d) / (r * r * r);
+        }
+        return 0;
+    }
+
+    // Calculate field potential from all active metaballs.
+    inline float CalculateMetaballsPotential(const float3& position, const Metaball* blobs, UINT nActiveMetaballs)
+    {
+        float sumFieldPotential = 0;
+        for (UINT j = 0; j < nActiveMetaballs; j++)
+        {
+            float dummy;
+            sumFieldPotential += CalculateMetaballPotential(position, blobs[j], &dummy);
+        }
+        return sumFieldPotential;
+    }
+
+    // Calculate a normal via central differences.
+    inline float3 CalculateMetaballsNormal(const float3& position, const Metaball* blobs, UINT nActiveMetaballs)
+    {
+        const float e = 0.5773f * 0.00001f;
+        return normalize(float3(
+            CalculateMetaballsPotential(position + float3(-e, 0, 0), blobs, nActiveMetaballs) -
+            CalculateMetaballsPotential(position + float3(e, 0, 0), blobs, nActiveMetaballs),
+            CalculateMetaballsPotential(position + float3(0, -e, 0), blobs, nActiveMetaballs) -
+            CalculateMetaballsPotential(position + float3(0, e, 0), blobs, nActiveMetaballs),
+            CalculateMetaballsPotential(position + float3(0, 0, -e), blobs, nActiveMetaballs) -
+            CalculateMetaballsPotential(position + float3(0, 0, e), blobs, nActiveMetaballs)));
+    }
+
+    // CalculateAnimationInterpolant() of RaytracingShaderHelper.hlsli.
+    inline float CalculateAnimationInterpolant(float elapsedTime, float cycleDuration)
+    {
+        float curLinearCycleTime = HlslFmod(elapsedTime, cycleDuration) / cycleDuration;
+        curLinearCycleTime = (curLinearCycleTime <= 0.5f) ? 2 * curLinearCycleTime : 1 - 2 * (curLinearCycleTime - 0.5f);
+        return smoothstep(0, 1, curLinearCycleTime);
+    }
+
+    // The sample's animated metaballs; metaballCount is N_METABALLS, 3 or 5.
+    void InitializeAnimatedMetaballs(Metaball* blobs, UINT metaballCount, float elapsedTime, float cycleDuration);
+
+    // Find all metaballs that ray intersects.
+    // The passed in array is sorted to the first nActiveMetaballs.
+    inline void FindIntersectingMetaballs(const Ray& ray, float* tmin, float* tmax, Metaball* blobs, UINT metaballCount,
+        UINT* nActiveMetaballs)
+    {
+        // Find the entry and exit points for all metaball bounding spheres combined.
+        *tmin = c_infinity;
+        *tmax = -c_infinity;
+
+        *nActiveMetaballs = 0;
+        for (UINT i = 0; i < metaballCount; i++)
+        {
+            float _thit, _tmax;
+            if (RaySolidSphereIntersectionTest(ray, &_thit, &_tmax, blobs[i].center, blobs[i].radius))
+            {
+                *tmin = (std::min)(_thit, *tmin);
+                *tmax = (std::max)(_tmax, *tmax);
+                blobs[(*nActiveMetaballs)++] = blobs[i];
+            }
+        }
+        *tmin = (std::max)(*tmin, ray.tMin);
+        *tmax = (std::min)(*tmax, ray.tMax);
+    }
+
+    // RayMetaballsIntersectionTest() for already initialized metaballs: 128 uniform steps between the first and
+    // last metaball intersections. blobs is reordered by FindIntersectingMetaballs(). stepCount, if not null,
+    // receives the number of field potential evaluations, not counting those of the normal.
+    inline bool RayMetaballsIntersectionTest(const Ray& ray, UINT rayFlags, Metaball* blobs, UINT metaballCount,
+        float* tHit, float3* normal, UINT* stepCount = nullptr)
+    {
+        float tmin, tmax;   // Ray extents to first and last metaball intersections.
+        UINT nActiveMetaballs = 0;  // Number of metaballs's that the ray intersects.
+        FindIntersectingMetaballs(ray, &tmin, &tmax, blobs, metaballCount, &nActiveMetaballs);
+
+        const UINT MAX_STEPS = c_metaballMaxSteps;
+        float t = tmin;
+        float minTStep = (tmax - tmin) / (MAX_STEPS / 1);
+        UINT iStep = 0;
+        bool hit = false;
+
+        while (iStep < MAX_STEPS)
+        {
+            iStep++;
+            float3 position = ray.origin + ray.direction * t;
+            float sumFieldPotential = CalculateMetaballsPotential(position, blobs, nActiveMetaballs);
+
+            // Have we crossed the isosurface?
+            if (sumFieldPotential >= c_metaballThreshold)
+            {
+                float3 hitSurfaceNormal = CalculateMetaballsNormal(position, blobs, nActiveMetaballs);
+                if (t >= ray.tMin && t <= ray.tMax && !IsCulled(ray.direction, hitSurfaceNormal, rayFlags))
+                {
+                    *tHit = t;
+                    *normal = hitSurfaceNormal;
+                    hit = true;
+                    break;
+                }
+            }
+            t += minTStep;
+        }
+
+        if (stepCount)
+        {
+            *stepCount = iStep;
+        }
+        return hit;
+    }
+
+    // Upper bound of a metaball's potential over the ray segment <t0, t1>.
+    // The potential only falls with the distance from the center, so it peaks at the segment's closest point.
+    inline float CalculateMetaballPotentialBound(const Ray& ray, const Metaball& blob, float t0, float t1)
+    {
+        float tClosest = clamp(dot(blob.center - ray.origin, ray.direction) / dot(ray.direction, ray.direction), t0, t1);
+        float distance;
+        return CalculateMetaballPotential(ray.origin + ray.direction * tClosest, blob, &distance);
+    }
+
+    // Calculate field potential from all active metaballs and its derivative along the ray.
+    inline float CalculateMetaballsPotentialAndDerivative(const Ray& ray, float t, const Metaball* blobs, UINT nActiveMetaballs,
+        float* derivative)
+    {
+        float3 position = ray.origin + ray.direction * t;
+        float sumFieldPotential = 0;
+        *derivative = 0;
+        for (UINT j = 0; j < nActiveMetaballs; j++)
+        {
+            float distance;
+            sumFieldPotential += CalculateMetaballPotential(position, blobs[j], &distance);
+            if (distance < blobs[j].radius && distance > 0)
+            {
+                // d/dx (6x^5 - 15x^4 + 10x^3) = 30x^2 (1 - x)^2 with x = (radius - distance) / radius.
+                float r = blobs[j].radius;
+                float x = (r - distance) / r;
+                float dPotentialdDistance = -30 * x * x * (1 - x) * (1 - x) / r;
+                float dDistancedT = dot(position - blobs[j].center, ray.direction) / distance;
+                *derivative += dPotentialdDistance * dDistancedT;
+            }
+        }
+        return sumFieldPotential;
+    }
+
+    // RayMetaballsIntervalSegmentTest() of VolumetricPrimitives.hlsli: finds the first crossing of the isosurface
+    // within <tmin, tmax>. Bounds the potential over whole ray segments, skips those that stay below the threshold
+    // and halves the others down to minTStep, then refines the crossing with Newton iterations safeguarded by
+    // bisection. iStep counts potential and bound evaluations and the test gives up once it reaches maxSteps.
+    inline bool RayMetaballsIntervalSegmentTest(const Ray& ray, UINT rayFlags, const Metaball* blobs, UINT nActiveMetaballs,
+        float tmin, float tmax, float minTStep, UINT maxSteps, float* tHit, float3* normal, UINT* iStep)
+    {
+        float t = tmin;
+        float tStep = tmax - tmin;
+        bool inside = CalculateMetaballsPotential(ray.origin + ray.direction * t, blobs, nActiveMetaballs) >= c_metaballThreshold;
+        (*iStep)++;
+
+        while (*iStep < maxSteps)
+        {
+            if (inside)
+            {
+                // The segment starts inside the isosurface or its crossing was rejected:
+                // test every minTStep inside as RayMetaballsIntersectionTest() does.
+                float3 position = ray.origin + ray.direction * t;
+                float3 hitSurfaceNormal = CalculateMetaballsNormal(position, blobs, nActiveMetaballs);
+                if (t >= ray.tMin && t <= ray.tMax && !IsCulled(ray.direction, hitSurfaceNormal, rayFlags))
+                {
+                    *tHit = t;
+                    *normal = hitSurfaceNormal;
+                    return true;
+                }
+                if (t >= tmax)
+                {
+                    break;
+                }
+                t = (std::min)(t + minTStep, tmax);
+                inside = CalculateMetaballsPotential(ray.origin + ray.direction * t, blobs, nActiveMetaballs) >= c_metaballThreshold;
+                (*iStep)++;
+                continue;
+            }
+            if (t >= tmax)
+            {
+                break;
+            }
+
+            float tEnd = (std::min)(t + tStep, tmax);
+            float potentialBound = 0;
+            for (UINT j = 0; j < nActiveMetaballs; j++)
+            {
+                potentialBound += CalculateMetaballPotentialBound(ray, blobs[j], t, tEnd);
+            }
+            (*iStep)++;
+
+            // No crossing within the segment, skip it.
+            if (potentialBound < c_metaballThreshold)
+            {
+                t = tEnd;
+                tStep *= 2;
+                continue;
+            }
+            if (tEnd - t > minTStep)
+            {
+                tStep = 0.5f * (tEnd - t);
+                continue;
+            }
+
+            // Has the segment's end crossed the isosurface?
+            inside = CalculateMetaballsPotential(ray.origin + ray.direction * tEnd, blobs, nActiveMetaballs) >= c_metaballThreshold;
+            (*iStep)++;
+            if (!inside)
+            {
+                t = tEnd;
+                continue;
+            }
+
+            // Refine the crossing within <t, tEnd>.
+            float tLow = t;
+            float tHigh = tEnd;
+            float tRoot = 0.5f * (tLow + tHigh);
+            for (UINT i = 0; i < c_metaballIntervalRefinementSteps; i++)
+            {
+                float derivative;
+                float f = CalculateMetaballsPotentialAndDerivative(ray, tRoot, blobs, nActiveMetaballs, &derivative) - c_metaballThreshold;
+                (*iStep)++;
+                if (f >= 0)
+                {
+                    tHigh = tRoot;
+                }
+                else
+                {
+                    tLow = tRoot;
+                }
+                float tNewton = tRoot - f / derivative;
+                tRoot = (derivative > 0 && tNewton > tLow && tNewton < tHigh) ? tNewton : 0.5f * (tLow + tHigh);
+            }
+
+            float3 hitSurfaceNormal = CalculateMetaballsNormal(ray.origin + ray.direction * tRoot, blobs, nActiveMetaballs);
+            if (tRoot >= ray.tMin && tRoot <= ray.tMax && !IsCulled(ray.direction, hitSurfaceNormal, rayFlags))
+            {
+                *tHit = tRoot;
+                *normal = hitSurfaceNormal;
+                return true;
+            }
+            t = tEnd;
+        }
+        return false;
+    }
+
+    // RayMetaballsIntervalIntersectionTest() of VolumetricPrimitives.hlsli for already initialized metaballs:
+    // RayMetaballsIntervalSegmentTest() between the first and last metaball intersections, halving segments down
+    // to the uniform step of RayMetaballsIntersectionTest(). stepCount counts potential and bound evaluations.
+    inline bool RayMetaballsIntervalIntersectionTest(const Ray& ray, UINT rayFlags, Metaball* blobs, UINT metaballCount,
+        float* tHit, float3* normal, UINT* stepCount = nullptr)
+    {
+        float tmin, tmax;   // Ray extents to first and last metaball intersections.
+        UINT nActiveMetaballs = 0;  // Number of metaballs's that the ray intersects.
+        FindIntersectingMetaballs(ray, &tmin, &tmax, blobs, metaballCount, &nActiveMetaballs);
+
+        UINT iStep = 0;
+        bool hit = tmin <= tmax && RayMetaballsIntervalSegmentTest(ray, rayFlags, blobs, nActiveMetaballs, tmin, tmax,
+            (tmax - tmin) / c_metaballMaxSteps, c_metaballIntervalMaxSteps, tHit, normal, &iStep);
+
+        if (stepCount)
+        {
+            *stepCount = iStep;
+        }
+        return hit;
+    }
+}
@@ -0,0 +1,134 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "WatertightTriangle.h"
+
+#if GRFX_CPU_X86
+#include <emmintrin.h>
+#endif
+
+namespace CpuRT
+{
+    namespace
+    {
+        bool IntersectLane(const TriangleBlock& block, UINT lane, const WatertightRay& ray, float tMax, TriangleBlockHits* hits)
+        {
+            float3 v0(block.v0[0][lane], block.v0[1][lane], block.v0[2][lane]);
+            float3 v1(block.v1[0][lane], block.v1[1][lane], block.v1[2][lane]);
+            float3 v2(block.v2[0][lane], block.v2[1][lane], block.v2[2][lane]);
+            float2 barycentrics;
+            if (!IntersectRayTriangleWatertight(ray, v0, v1, v2, tMax, &hits->t[lane], &barycentrics, &hits->determinant[lane]))
+            {
+                return false;
+            }
+            hits->u[lane] = barycentrics.x;
+            hits->v[lane] = barycentrics.y;
+            return true;
+        }
+    }
+
+    UINT IntersectTriangleBlockScalar(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits)
+    {
+        UINT hitMask = 0;
+        for (UINT lane = 0; lane < block.count; lane++)
+        {
+            if (IntersectLane(block, lane, ray, tMax, hits))
+            {
+                hitMask |= 1u << lane;
+            }
+        }
+        return hitMask;
+    }
+
+    UINT ResolveTriangleBlockFallbackLanes(const TriangleBlock& block, UINT fallbackMask, const WatertightRay& ray, float tMax,
+        UINT hitMask, TriangleBlockHits* hits)
+    {
+        for (UINT lane = 0; fallbackMask != 0; lane++, fallbackMask >>= 1)
+        {
+            if (fallbackMask & 1)
+            {
+                hitMask &= ~(1u << lane);
+                if (IntersectLane(block, lane, ray, tMax, hits))
+                {
+                    hitMask |= 1u << lane;
+                }
+            }
+        }
+        return hitMask;
+    }
+
+#if GRFX_CPU_X86
+    // SSE2 is part of the x64 baseline, so this kernel needs no runtime check.
+    // Every operation mirrors IntersectRayTriangleWatertight() in the same order.
+    UINT IntersectTriangleBlock4Sse(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 shearX = _mm_set1_ps(ray.shearX);
+        const __m128 shearY = _mm_set1_ps(ray.shearY);
+        const __m128 shearZ = _mm_set1_ps(ray.shearZ);
+        const __m128 originX = _mm_set1_ps(ray.origin[ray.kx]);
+        const __m128 originY = _mm_set1_ps(ray.origin[ray.ky]);
+        const __m128 originZ = _mm_set1_ps(ray.origin[ray.kz]);
+
+        auto Shear = [&](const float (*vertex)[c_triangleBlockWidth], __m128& x, __m128& y, __m128& z)
+        {
+            __m128 px = _mm_sub_ps(_mm_load_ps(vertex[ray.kx]), originX);
+            __m128 py = _mm_sub_ps(_mm_load_ps(vertex[ray.ky]), originY);
+            __m128 pz = _mm_sub_ps(_mm_load_ps(vertex[ray.kz]), originZ);
+            x = _mm_sub_ps(px, _mm_mul_ps(shearX, pz));
+            y = _mm_sub_ps(py, _mm_mul_ps(shearY, pz));
+            z = _mm_mul_ps(shearZ, pz);
+        };
+
+        __m128 ax, ay, az, bx, by, bz, cx, cy, cz;
+        Shear(block.v0, ax, ay, az);
+        Shear(block.v1, bx, by, bz);
+        Shear(block.v2, cx, cy, cz);
+
+        __m128 u = _mm_sub_ps(_mm_mul_ps(cx, by), _mm_mul_ps(cy, bx));
+        __m128 v = _mm_sub_ps(_mm_mul_ps(ax, cy), _mm_mul_ps(ay, cx));
+        __m128 w = _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax));
+
+        __m128 anyZero = _mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(u, zero), _mm_cmpeq_ps(v, zero)), _mm_cmpeq_ps(w, zero));
+        __m128 anyNegative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmplt_ps(v, zero)), _mm_cmplt_ps(w, zero));
+        __m128 anyPositive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero), _mm_cmpgt_ps(v, zero)), _mm_cmpgt_ps(w, zero));
+
+        __m128 det = _mm_add_ps(_mm_add_ps(u, v), w);
+        __m128 rcpDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u, az), _mm_mul_ps(v, bz)), _mm_mul_ps(w, cz)), rcpDet);
+        __m128 inRange = _mm_and_ps(_mm_cmpge_ps(t, _mm_set1_ps(ray.tMin)), _mm_cmple_ps(t, _mm_set1_ps(tMax)));
+        __m128 miss = _mm_or_ps(_mm_and_ps(anyNegative, anyPositive), _mm_cmpeq_ps(det, zero));
+
+        _mm_storeu_ps(hits->t, t);
+        _mm_storeu_ps(hits->u, _mm_mul_ps(v, rcpDet));
+        _mm_storeu_ps(hits->v, _mm_mul_ps(w, rcpDet));
+        _mm_storeu_ps(hits->determinant, det);
+
+        UINT laneMask = (1u << (std::min)(block.count, 4u)) - 1;
+        UINT fallbackMask = static_cast<UINT>(_mm_movemask_ps(anyZero)) & laneMask;
+        UINT hitMask = static_cast<UINT>(_mm_movemask_ps(_mm_andnot_ps(miss, inRange))) & laneMask & ~fallbackMask;
+        return fallbackMask ? ResolveTriangleBlockFallbackLanes(block, fallbackMask, ray, tMax, hitMask, hits) : hitMask;
+    }
+#else
+    UINT IntersectTriangleBlock4Sse(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits)
+    {
+        TriangleBlock firstLanes = block;
+        firstLanes.count = (std::min)(block.count, 4u);
+        return IntersectTriangleBlockScalar(firstLanes, ray, tMax, hits);
+    }
+
+    // CpuSupportsAvx2() is false on this architecture so this is never selected.
+    UINT IntersectTriangleBlock8Avx2(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits)
+    {
+        return IntersectTriangleBlockScalar(block, ray, tMax, hits);
+    }
+#endif
+}
@@ -0,0 +1,164 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Watertight ray-triangle intersection (Woop, Benthin and Wald 2013, "Watertight Ray/Triangle Intersection").
+// Vertices are translated to the ray origin and sheared so the ray runs along +Z, then 2D edge functions
+// decide coverage. Triangles sharing an edge evaluate the same edge function with opposite sign, so a ray
+// through a shared edge or vertex always hits at least one of them.
+//
+// Results follow the DXR conventions of IntersectRayTriangle(): barycentrics are the weights of v1 and v2,
+// and a positive determinant means the triangle is clockwise as seen along the ray, i.e. front facing
+// unless the instance sets D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE.
+
+#include "CpuMath.h"
+#include "CpuFeatures.h"
+
+namespace CpuRT
+{
+    // Per-ray setup shared by all triangles tested against the ray.
+    struct WatertightRay
+    {
+        float3 origin;
+        int kx;                 // Permuted axes, kz is the dominant direction axis.
+        int ky;
+        int kz;
+        float shearX;
+        float shearY;
+        float shearZ;
+        float tMin;
+
+        WatertightRay() {}      // Uninitialized, for arrays that are filled per ray.
+        explicit WatertightRay(const Ray& ray) :
+            origin(ray.origin),
+            tMin(ray.tMin)
+        {
+            float3 absDir = abs(ray.direction);
+            kz = (absDir.x > absDir.y) ? ((absDir.x > absDir.z) ? 0 : 2) : ((absDir.y > absDir.z) ? 1 : 2);
+            kx = (kz + 1) % 3;
+            ky = (kx + 1) % 3;
+            // Swapping keeps the winding, and with it the sign of the determinant, independent of the direction.
+            if (ray.direction[kz] < 0.0f)
+            {
+                std::swap(kx, ky);
+            }
+            shearX = ray.direction[kx] / ray.direction[kz];
+            shearY = ray.direction[ky] / ray.direction[kz];
+            shearZ = 1.0f / ray.direction[kz];
+        }
+    };
+
+    // Edge functions that are exactly zero are recomputed in double precision, as in the paper,
+    // so the sign test at edges and vertices is exact.
+    inline void ComputeEdgeFunctions(float ax, float ay, float bx, float by, float cx, float cy, float* u, float* v, float* w)
+    {
+        *u = cx * by - cy * bx;
+        *v = ax * cy - ay * cx;
+        *w = bx * ay - by * ax;
+        if (*u == 0.0f || *v == 0.0f || *w == 0.0f)
+        {
+            *u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+            *v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+            *w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+        }
+    }
+
+    // Same contract as IntersectRayTriangle(): hits are accepted within [ray.tMin, tMax].
+    inline bool IntersectRayTriangleWatertight(const WatertightRay& ray, const float3& v0, const float3& v1, const float3& v2,
+        float tMax, float* t, float2* barycentrics, float* determinant)
+    {
+        const float3 a = v0 - ray.origin;
+        const float3 b = v1 - ray.origin;
+        const float3 c = v2 - ray.origin;
+
+        const float ax = a[ray.kx] - ray.shearX * a[ray.kz];
+        const float ay = a[ray.ky] - ray.shearY * a[ray.kz];
+        const float bx = b[ray.kx] - ray.shearX * b[ray.kz];
+        const float by = b[ray.ky] - ray.shearY * b[ray.kz];
+        const float cx = c[ray.kx] - ray.shearX * c[ray.kz];
+        const float cy = c[ray.ky] - ray.shearY * c[ray.kz];
+
+        float u, v, w;
+        ComputeEdgeFunctions(ax, ay, bx, by, cx, cy, &u, &v, &w);
+        if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+        {
+            return false;
+        }
+
+        const float det = u + v + w;
+        if (det == 0.0f)
+        {
+            return false;
+        }
+
+        const float az = ray.shearZ * a[ray.kz];
+        const float bz = ray.shearZ * b[ray.kz];
+        const float cz = ray.shearZ * c[ray.kz];
+        const float rcpDet = 1.0f / det;
+        const float tHit = (u * az + v * bz + w * cz) * rcpDet;
+        if (!(tHit >= ray.tMin && tHit <= tMax))
+        {
+            return false;
+        }
+
+        *t = tHit;
+        *barycentrics = float2(v * rcpDet, w * rcpDet);
+        // Twice the signed area of the sheared triangle; has the sign of the Moller-Trumbore determinant.
+        *determinant = det;
+        return true;
+    }
+
+    static const UINT c_triangleBlockWidth = 8;
+
+    // Up to eight triangles in structure-of-arrays layout. Lanes [count, 8) are ignored but should be
+    // zero-initialized, e.g. TriangleBlock block = {}, as the SIMD kernels still compute them.
+    struct alignas(32) TriangleBlock
+    {
+        float v0[3][c_triangleBlockWidth];
+        float v1[3][c_triangleBlockWidth];
+        float v2[3][c_triangleBlockWidth];
+        UINT primIndex[c_triangleBlockWidth];
+        UINT count;
+
+        void Set(UINT lane, const float3& p0, const float3& p1, const float3& p2, UINT index)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                v0[axis][lane] = p0[axis];
+                v1[axis][lane] = p1[axis];
+                v2[axis][lane] = p2[axis];
+            }
+            primIndex[lane] = index;
+        }
+    };
+
+    // Per-lane results; only lanes set in the returned hit mask are valid.
+    struct TriangleBlockHits
+    {
+        float t[c_triangleBlockWidth];
+        float u[c_triangleBlockWidth];
+        float v[c_triangleBlockWidth];
+        float determinant[c_triangleBlockWidth];
+    };
+
+    // Tests a ray against the triangles of a block and returns the mask of lanes hit within [ray.tMin, tMax].
+    // All kernels match IntersectRayTriangleWatertight() bit for bit. The 4-wide SSE kernel reads the first
+    // four lanes and runs scalar code on non-x86 hosts; the 8-wide AVX2 kernel requires CpuSupportsAvx2().
+    UINT IntersectTriangleBlockScalar(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits);
+    UINT IntersectTriangleBlock4Sse(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits);
+    UINT IntersectTriangleBlock8Avx2(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits);
+
+    // Used by the SIMD kernels: reruns lanes whose edge functions were exactly zero through the scalar
+    // double precision path and returns the corrected hit mask.
+    UINT ResolveTriangleBlockFallbackLanes(const TriangleBlock& block, UINT fallbackMask, const WatertightRay& ray, float tMax,
+        UINT hitMask, TriangleBlockHits* hits);
+}
@@ -0,0 +1,75 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// 8-wide AVX2 kernel for WatertightTriangle.h. Only this translation unit uses AVX2 instructions.
+
+#include "WatertightTriangle.h"
+
+#if GRFX_CPU_X86
+#include <immintrin.h>
+
+namespace CpuRT
+{
+    // Same operation order as IntersectTriangleBlock4Sse().
+    GRFX_TARGET_AVX2 UINT IntersectTriangleBlock8Avx2(const TriangleBlock& block, const WatertightRay& ray, float tMax, TriangleBlockHits* hits)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 shearX = _mm256_set1_ps(ray.shearX);
+        const __m256 shearY = _mm256_set1_ps(ray.shearY);
+        const __m256 shearZ = _mm256_set1_ps(ray.shearZ);
+        const __m256 originX = _mm256_set1_ps(ray.origin[ray.kx]);
+        const __m256 originY = _mm256_set1_ps(ray.origin[ray.ky]);
+        const __m256 originZ = _mm256_set1_ps(ray.origin[ray.kz]);
+
+        __m256 shearedX[3], shearedY[3], shearedZ[3];
+        const float (*vertices[3])[c_triangleBlockWidth] = { block.v0, block.v1, block.v2 };
+        for (int i = 0; i < 3; i++)
+        {
+            __m256 px = _mm256_sub_ps(_mm256_load_ps(vertices[i][ray.kx]), originX);
+            __m256 py = _mm256_sub_ps(_mm256_load_ps(vertices[i][ray.ky]), originY);
+            __m256 pz = _mm256_sub_ps(_mm256_load_ps(vertices[i][ray.kz]), originZ);
+            shearedX[i] = _mm256_sub_ps(px, _mm256_mul_ps(shearX, pz));
+            shearedY[i] = _mm256_sub_ps(py, _mm256_mul_ps(shearY, pz));
+            shearedZ[i] = _mm256_mul_ps(shearZ, pz);
+        }
+        const __m256 ax = shearedX[0], ay = shearedY[0], az = shearedZ[0];
+        const __m256 bx = shearedX[1], by = shearedY[1], bz = shearedZ[1];
+        const __m256 cx = shearedX[2], cy = shearedY[2], cz = shearedZ[2];
+
+        __m256 u = _mm256_sub_ps(_mm256_mul_ps(cx, by), _mm256_mul_ps(cy, bx));
+        __m256 v = _mm256_sub_ps(_mm256_mul_ps(ax, cy), _mm256_mul_ps(ay, cx));
+        __m256 w = _mm256_sub_ps(_mm256_mul_ps(bx, ay), _mm256_mul_ps(by, ax));
+
+        __m256 anyZero = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_EQ_OQ), _mm256_cmp_ps(v, zero, _CMP_EQ_OQ)),
+            _mm256_cmp_ps(w, zero, _CMP_EQ_OQ));
+        __m256 anyNegative = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ), _mm256_cmp_ps(v, zero, _CMP_LT_OQ)),
+            _mm256_cmp_ps(w, zero, _CMP_LT_OQ));
+        __m256 anyPositive = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_GT_OQ), _mm256_cmp_ps(v, zero, _CMP_GT_OQ)),
+            _mm256_cmp_ps(w, zero, _CMP_GT_OQ));
+
+        __m256 det = _mm256_add_ps(_mm256_add_ps(u, v), w);
+        __m256 rcpDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(u, az), _mm256_mul_ps(v, bz)), _mm256_mul_ps(w, cz)), rcpDet);
+        __m256 inRange = _mm256_and_ps(_mm256_cmp_ps(t, _mm256_set1_ps(ray.tMin), _CMP_GE_OQ), _mm256_cmp_ps(t, _mm256_set1_ps(tMax), _CMP_LE_OQ));
+        __m256 miss = _mm256_or_ps(_mm256_and_ps(anyNegative, anyPositive), _mm256_cmp_ps(det, zero, _CMP_EQ_OQ));
+
+        _mm256_storeu_ps(hits->t, t);
+        _mm256_storeu_ps(hits->u, _mm256_mul_ps(v, rcpDet));
+        _mm256_storeu_ps(hits->v, _mm256_mul_ps(w, rcpDet));
+        _mm256_storeu_ps(hits->determinant, det);
+
+        UINT laneMask = (block.count >= c_triangleBlockWidth) ? 0xFF : (1u << block.count) - 1;
+        UINT fallbackMask = static_cast<UINT>(_mm256_movemask_ps(anyZero)) & laneMask;
+        UINT hitMask = static_cast<UINT>(_mm256_movemask_ps(_mm256_andnot_ps(miss, inRange))) & laneMask & ~fallbackMask;
+        return fallbackMask ? ResolveTriangleBlockFallbackLanes(block, fallbackMask, ray, tMax, hitMask, hits) : hitMask;
+    }
+}
+#endif
@@ -0,0 +1,27 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CpuTestCase.h"
+#include "HelloWorldCpuTestCase.h"
+#include "SimpleLightingCpuTestCase.h"
+
+std::unique_ptr<CpuTestCase> CreateCpuTestCase(const std::string& name, UINT width, UINT height)
+{
+    if (name == "HelloWorld")
+    {
+        return std::unique_ptr<CpuTestCase>(new HelloWorldCpuTestCase(width, height));
+    }
+    if (name == "SimpleLighting")
+    {
+        return std::unique_ptr<CpuTestCase>(new SimpleLightingCpuTestCase(width, height));
+    }
+    return nullptr;
+}
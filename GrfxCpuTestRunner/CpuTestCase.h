@@ -0,0 +1,161 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "CpuScene.h"
+#include "CpuReferenceRenderer.h"
+#include "TestCaseXml.h"
+#include <memory>
+#include <string>
+
+// CPU counterpart of a DXSample test case: builds the scene from the sample's descs and
+// reproduces its shaders so the output image can be produced without a GPU.
+class CpuTestCase
+{
+public:
+    CpuTestCase(UINT width, UINT height) :
+        m_width(width),
+        m_height(height),
+        m_aspectRatio(static_cast<float>(width) / static_cast<float>(height)),
+        m_loadedDescs(nullptr) {}
+    virtual ~CpuTestCase() {}
+
+    virtual const char* GetName() const = 0;
+
+    // Makes CreateTestCase() use descs loaded from a testcases.xml file instead of the ones it hard-codes.
+    // descs must outlive CreateTestCase().
+    void SetTestCaseDescs(const TestCaseDescs* descs) { m_loadedDescs = descs; }
+
+    // Mirrors the sample's CreateTestCase(): fills the descs and geometry, then builds the scene.
+    virtual void CreateTestCase() = 0;
+
+    // Mirrors the sample's raygen shader for one DispatchRaysIndex().
+    virtual CpuRT::float4 RayGen(UINT x, UINT y) const = 0;
+
+    // Runs the raygen shader for the tile of up to 8x8 pixels at (x, y) and writes the colors to output.
+    // Test cases with coherent primary rays override it to trace them as a packet; the result must match RayGen().
+    virtual void RayGenPacket(UINT x, UINT y, CpuRT::CpuImage* output) const
+    {
+        UINT xEnd = (std::min)(x + CpuRT::c_rayPacketWidth, m_width);
+        UINT yEnd = (std::min)(y + CpuRT::c_rayPacketHeight, m_height);
+        for (UINT py = y; py < yEnd; py++)
+        {
+            for (UINT px = x; px < xEnd; px++)
+            {
+                output->SetPixel(px, py, RayGen(px, py));
+            }
+        }
+    }
+
+    // Mirrors the sample's DispatchRays(): renders every pixel through the test case's CpuRaytracingPipeline and
+    // shader tables. Returns false for test cases whose shaders are not ported to a pipeline.
+    virtual bool DispatchRays(const CpuRT::CpuDispatchRaysDesc& /*desc*/, CpuRT::CpuThreadPool* /*pool*/, CpuRT::CpuImage* /*output*/,
+        std::vector<CpuRT::CpuTileTiming>* /*tileTimings*/ = nullptr) const
+    {
+        return false;
+    }
+
+    // Checks the shader tables the test case built in its BuildShaderTables() against the scene and the
+    // TraceRay() calls of its shaders. Returns one message per problem; test cases without tables have none.
+    std::vector<std::string> ValidateShaderTables() const
+    {
+        if (m_shaderTableUsage.traceRayCalls.empty())
+        {
+            return {};
+        }
+        return CpuRT::ValidateShaderTables(m_shaderTableBindings, m_scene, m_shaderTableUsage);
+    }
+
+    UINT GetWidth() const { return m_width; }
+    UINT GetHeight() const { return m_height; }
+    const CpuRT::CpuScene& GetScene() const { return m_scene; }
+
+    const std::vector<GeomDesc>& GetGeomDescs() const { return m_geomDescs; }
+    const std::vector<DxBlasDesc>& GetBlasDescs() const { return m_listOfBlasDesc; }
+    const std::vector<DxTlasDesc>& GetTlasDescs() const { return m_listOfTlasDesc; }
+    const CpuRT::CpuShaderTableBindings& GetShaderTableBindings() const { return m_shaderTableBindings; }
+
+protected:
+    void AddGeometryDesc(UINT index,
+        D3D12_RAYTRACING_GEOMETRY_TYPE geomType = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
+        D3D12_RAYTRACING_GEOMETRY_FLAGS flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE)
+    {
+        GeomDesc geomDesc;
+        geomDesc.geomIndex = index;
+        geomDesc.geomType = geomType;
+        geomDesc.flags = flags;
+        m_geomDescs.push_back(geomDesc);
+    }
+
+    void AddBlasDesc(const std::initializer_list<UINT>& geomIndices,
+        D3D12_RAYTRACING_GEOMETRY_TYPE type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+    {
+        DxBlasDesc blasDesc;
+        blasDesc.geomType = type;
+        for (UINT x : geomIndices)
+        {
+            blasDesc.geomIndices.push_back(x);
+        }
+        m_listOfBlasDesc.push_back(blasDesc);
+    }
+
+    void AddTlasDesc(UINT blasIndex,
+        UINT hitIndexContribution = 0,
+        FLOAT scaleX = 1.0f,
+        FLOAT scaleY = 1.0f,
+        FLOAT scaleZ = 1.0f,
+        FLOAT translateX = 0.0f,
+        FLOAT translateY = 0.0f,
+        FLOAT translateZ = 0.0f)
+    {
+        DxTlasDesc tlasDesc;
+        tlasDesc.blasIndex = blasIndex;
+        tlasDesc.instanceContributionToHitIndex = hitIndexContribution;
+        GetTransform3x4Matrix(&tlasDesc.transformMatrix, scaleX, scaleY, scaleZ, translateX, translateY, translateZ);
+        m_listOfTlasDesc.push_back(tlasDesc);
+    }
+
+    // Adds the descs set with SetTestCaseDescs(). Returns false if there are none.
+    bool AddLoadedDescs()
+    {
+        if (!m_loadedDescs)
+        {
+            return false;
+        }
+        m_geomDescs.insert(m_geomDescs.end(), m_loadedDescs->geomDescs.begin(), m_loadedDescs->geomDescs.end());
+        m_listOfBlasDesc.insert(m_listOfBlasDesc.end(), m_loadedDescs->blasDescs.begin(), m_loadedDescs->blasDescs.end());
+        m_listOfTlasDesc.insert(m_listOfTlasDesc.end(), m_loadedDescs->tlasDescs.begin(), m_loadedDescs->tlasDescs.end());
+        return true;
+    }
+
+    void BuildScene()
+    {
+        m_scene.Build(m_geomDescs, m_listOfBlasDesc, m_listOfTlasDesc);
+    }
+
+    UINT m_width;
+    UINT m_height;
+    float m_aspectRatio;
+
+    CpuRT::CpuScene m_scene;
+    // Filled by test cases that mirror the sample's BuildShaderTables(): the ranges DispatchRays() would bind
+    // and how the shaders index them.
+    CpuRT::CpuShaderTableBindings m_shaderTableBindings;
+    CpuRT::CpuShaderTableUsage m_shaderTableUsage;
+    std::vector<GeomDesc> m_geomDescs;
+    std::vector<DxBlasDesc> m_listOfBlasDesc;
+    std::vector<DxTlasDesc> m_listOfTlasDesc;
+    const TestCaseDescs* m_loadedDescs;
+};
+
+// Returns nullptr for unknown names.
+std::unique_ptr<CpuTestCase> CreateCpuTestCase(const std::string& name, UINT width, UINT height);
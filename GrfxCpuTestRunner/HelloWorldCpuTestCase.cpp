@@ -0,0 +1,390 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "HelloWorldCpuTestCase.h"
+
+using namespace CpuRT;
+
+namespace
+{
+    // Export names of the sample's state object.
+    const CpuShaderIdentifier c_raygenShaderIdentifier = CpuShaderIdentifier::FromName("MyRaygenShader");
+    const CpuShaderIdentifier c_missShaderIdentifier = CpuShaderIdentifier::FromName("MyMissShader");
+    const CpuShaderIdentifier c_hitGroupIdentifier = CpuShaderIdentifier::FromName("MyHitGroup");
+    const CpuShaderIdentifier c_hitGroupIdentifierRed = CpuShaderIdentifier::FromName("MyHitGroupRed");
+    const CpuShaderIdentifier c_hitGroupIdentifierAABB_1 = CpuShaderIdentifier::FromName("MyHitGroupAABB_1");
+}
+
+HelloWorldCpuTestCase::HelloWorldCpuTestCase(UINT width, UINT height) :
+    CpuTestCase(width, height),
+    m_hitGroupShaderStrideInBytes(0)
+{
+    m_viewport = { -1.0f, -1.0f, 1.0f, 1.0f };
+
+    FLOAT border = 0.0f;
+    if (m_width <= m_height)
+    {
+        m_stencil = { -1 + border, -1 + border * m_aspectRatio, 1.0f - border, 1 - border * m_aspectRatio };
+    }
+    else
+    {
+        m_stencil = { -1 + border / m_aspectRatio, -1 + border, 1 - border / m_aspectRatio, 1.0f - border };
+    }
+
+    m_aabbCircleCB[0] = { 0.45f, float3(0.5f, -0.5f, -1.0f), float4(0.0f, 1.0f, 0.0f, 1.0f) };
+    m_aabbCircleCB[1] = { 0.45f, float3(-0.5f, -0.5f, -1.0f), float4(0.0f, 0.0f, 1.0f, 1.0f) };
+}
+
+void HelloWorldCpuTestCase::GetAABBBoundingBox(D3D12_RAYTRACING_AABB& aabbBox, FLOAT scale, FLOAT indexX, FLOAT indexY)
+{
+    float translateX = -1 + scale + indexX * scale * 2;
+    float translateY = -1 + scale + indexY * scale * 2;
+    float border = 0.03f;
+    float depthValue = 1.0;
+    float offset = scale - border;
+
+    aabbBox.MinX = -offset + translateX;
+    aabbBox.MinY = -offset + translateY;
+    aabbBox.MinZ = depthValue;
+    aabbBox.MaxX = offset + translateX;
+    aabbBox.MaxY = offset + translateY;
+    aabbBox.MaxZ = depthValue;
+}
+
+void HelloWorldCpuTestCase::GetGeometryIndicesAndVertices(ModelGeometry geometry,
+    std::vector<Vertex>* vertices,
+    std::vector<Index>* indices,
+    FLOAT scale,
+    FLOAT indexX,
+    FLOAT indexY,
+    FLOAT zPos)
+{
+    float translateX = -1 + scale + indexX * scale * 2;
+    float translateY = -1 + scale + indexY * scale * 2;
+    float border = 0.03f;
+    float offset = scale - border;
+
+    if (geometry == TriangleModel)
+    {
+        *indices = { 0, 1, 2 };
+        *vertices =
+        {
+            { 0, -offset, zPos },
+            { -offset, offset, zPos },
+            { offset, offset, zPos }
+        };
+    }
+    else
+    {
+        *indices = { 0, 1, 2, 3, 0, 2 };
+        *vertices =
+        {
+            { -offset, -offset, zPos },
+            { -offset, offset, zPos },
+            { offset, offset, zPos },
+            { offset, -offset, zPos }
+        };
+    }
+
+    for (Vertex& vertex : *vertices)
+    {
+        vertex.v1 += translateX;
+        vertex.v2 += translateY;
+    }
+}
+
+void HelloWorldCpuTestCase::CreateGeometry(FLOAT scale, FLOAT indexX, FLOAT indexY, FLOAT depth)
+{
+    UINT maxIndex = static_cast<UINT>(1.0f / scale);
+
+    auto IncrementIndex = [&]()
+    {
+        indexX++;
+        if (indexX >= maxIndex)
+        {
+            indexY++;
+            indexX = 0;
+        }
+    };
+
+    GetGeometryIndicesAndVertices(TriangleModel, &m_vertices[0], &m_indices[0], scale, indexX, indexY, depth);
+    IncrementIndex();
+
+    GetGeometryIndicesAndVertices(SquareModel, &m_vertices[1], &m_indices[1], scale, indexX, indexY, depth);
+    IncrementIndex();
+
+    GetAABBBoundingBox(m_aabb, scale, indexX, indexY);
+
+    for (UINT i = 0; i < 2; i++)
+    {
+        CpuTriangleGeometryDesc desc = {};
+        desc.vertexData = m_vertices[i].data();
+        desc.vertexCount = static_cast<UINT>(m_vertices[i].size());
+        desc.vertexStrideInBytes = sizeof(Vertex);
+        desc.indexData = m_indices[i].data();
+        desc.indexCount = static_cast<UINT>(m_indices[i].size());
+        desc.indexFormat = CpuIndexFormat::R16_UINT;
+        m_scene.SetTriangleGeometry(i, desc);
+
+        // The sample binds its single m_aabbBuffer for every AABB geometry.
+        m_scene.SetAABBGeometry(i, { &m_aabb, 1, sizeof(D3D12_RAYTRACING_AABB) });
+    }
+}
+
+void HelloWorldCpuTestCase::CreateTestCase()
+{
+    CreateGeometry(0.5f, 0, 0, 1.0f);
+
+    if (!AddLoadedDescs())
+    {
+        AddGeometryDesc(0);
+        AddGeometryDesc(1);
+        AddGeometryDesc(0, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS);
+        AddGeometryDesc(1, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS);
+
+        AddBlasDesc({ 0 });
+        AddBlasDesc({ 1 });
+        AddBlasDesc({ 2 }, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS);
+        AddBlasDesc({ 3 }, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS);
+
+        AddTlasDesc(0);
+        AddTlasDesc(1, 1);
+        AddTlasDesc(2, 2);
+        AddTlasDesc(3, 3, 1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    // MyIntersectionShader: reports hit kind 0 inside the circle of the record's constant buffer.
+    m_scene.SetIntersectionFunction([this](const CpuIntersectionInput& input, float* tHit, UINT* hitKind, float*)
+    {
+        CpuShaderRecord record;
+        if (!ResolveHitGroupRecord(m_shaderTableBindings, input.hitGroupIndex, &record)
+            || *record.shaderIdentifier != c_hitGroupIdentifierAABB_1)
+        {
+            return false;
+        }
+        const CircleAABBConstantBuffer& cb = record.GetLocalRootArguments<CircleAABBConstantBuffer>();
+        float3 worldRayOrigin = input.worldRay.origin + cb.center;
+        float sqRadius = cb.radius * cb.radius;
+        float sqX = worldRayOrigin.x * worldRayOrigin.x;
+        float sqY = worldRayOrigin.y * worldRayOrigin.y;
+
+        *tHit = 0.1f;
+        *hitKind = (sqX + sqY < sqRadius) ? 0 : 1;
+        return true;
+    });
+
+    BuildScene();
+    CreateRaytracingPipeline();
+    BuildShaderTables();
+}
+
+void HelloWorldCpuTestCase::CreateRaytracingPipeline()
+{
+    // MaxTraceRecursionDepth 1: primary rays only.
+    m_pipeline.reset(new Pipeline(1));
+    m_pipeline->AddRayGenerationShader("MyRaygenShader", &MyRaygenShader);
+    m_pipeline->AddClosestHitShader("MyClosestHitShader", &MyClosestHitShader);
+    m_pipeline->AddMissShader("MyMissShader", &MyMissShader);
+    m_pipeline->AddClosestHitShader("MyClosestHitShaderRed", &MyClosestHitShaderRed);
+    m_pipeline->AddIntersectionShader("MyIntersectionShader", &MyIntersectionShader);
+    m_pipeline->AddClosestHitShader("MyClosestHitIntersectionShader", &MyClosestHitIntersectionShader);
+
+    m_pipeline->AddHitGroup("MyHitGroup", "MyClosestHitShader");
+    m_pipeline->AddHitGroup("MyHitGroupRed", "MyClosestHitShaderRed");
+    m_pipeline->AddHitGroup("MyHitGroupAABB_1", "MyClosestHitIntersectionShader", nullptr, "MyIntersectionShader");
+}
+
+void HelloWorldCpuTestCase::BuildShaderTables()
+{
+    const UINT shaderIdentifierSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
+
+    // Ray gen shader table
+    {
+        RayGenConstantBuffer rootArguments = { m_viewport, m_stencil };
+        UINT shaderRecordSize = shaderIdentifierSize + sizeof(rootArguments);
+        m_rayGenShaderTable.reset(new CpuShaderTable(1, shaderRecordSize, "RayGenShaderTable"));
+        m_rayGenShaderTable->push_back(c_raygenShaderIdentifier, &rootArguments, sizeof(rootArguments));
+    }
+
+    // Miss shader table
+    {
+        m_missShaderTable.reset(new CpuShaderTable(1, shaderIdentifierSize, "MissShaderTable"));
+        m_missShaderTable->push_back(c_missShaderIdentifier);
+    }
+
+    // Hit group shader table: two triangle records, then one circle record per AABB instance.
+    {
+        m_hitGroupShaderStrideInBytes = shaderIdentifierSize + sizeof(CircleAABBConstantBuffer);
+        m_hitGroupShaderTable.reset(new CpuShaderTable(4, static_cast<UINT>(m_hitGroupShaderStrideInBytes), "HitGroupShaderTable"));
+        m_hitGroupShaderTable->push_back(c_hitGroupIdentifier, nullptr, sizeof(CircleAABBConstantBuffer));
+        m_hitGroupShaderTable->push_back(c_hitGroupIdentifierRed, nullptr, sizeof(CircleAABBConstantBuffer));
+        m_hitGroupShaderTable->push_back(c_hitGroupIdentifierAABB_1, &m_aabbCircleCB[0], sizeof(CircleAABBConstantBuffer));
+        m_hitGroupShaderTable->push_back(c_hitGroupIdentifierAABB_1, &m_aabbCircleCB[1], sizeof(CircleAABBConstantBuffer));
+    }
+
+    // The ranges DoRaytracing() binds; the miss table stride is its whole size, as in the sample.
+    m_shaderTableBindings.rayGenerationShaderRecord = CpuShaderTableRange(*m_rayGenShaderTable, 0);
+    m_shaderTableBindings.missShaderTable = CpuShaderTableRange(*m_missShaderTable, m_missShaderTable->GetSizeInBytes());
+    m_shaderTableBindings.hitGroupTable = CpuShaderTableRange(*m_hitGroupShaderTable, m_hitGroupShaderStrideInBytes);
+
+    // MyRaygenShader: TraceRay(Scene, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, ~0, 0, 1, 0, ray, payload).
+    m_shaderTableUsage.traceRayCalls = { { 0, 1, 0 } };
+    m_shaderTableUsage.rayGenerationLocalRootArgumentsSize = sizeof(RayGenConstantBuffer);
+    m_shaderTableUsage.hitGroupLocalRootArgumentsSize = sizeof(CircleAABBConstantBuffer);
+}
+
+bool HelloWorldCpuTestCase::IsInsideStencil(const Ray& ray) const
+{
+    return (ray.origin.x >= m_stencil.left && ray.origin.x <= m_stencil.right)
+        && (ray.origin.y >= m_stencil.top && ray.origin.y <= m_stencil.bottom);
+}
+
+float4 HelloWorldCpuTestCase::ShadeHit(bool hasHit, const CpuHit& hit) const
+{
+    if (!hasHit)
+    {
+        // MyMissShader
+        return float4(0.0f, 0.0f, 0.3f, 1);
+    }
+
+    // Out of range hit group records are undefined behavior on the GPU; flag them loudly.
+    const float4 invalidRecordColor(1, 0, 1, 1);
+    CpuShaderRecord record;
+    if (!ResolveHitGroupRecord(m_shaderTableBindings, hit.hitGroupIndex, &record))
+    {
+        return invalidRecordColor;
+    }
+    if (*record.shaderIdentifier == c_hitGroupIdentifier)
+    {
+        return float4(1, 1, 0, 1);
+    }
+    if (*record.shaderIdentifier == c_hitGroupIdentifierRed)
+    {
+        return float4(1, 0, 0, 1);
+    }
+    if (*record.shaderIdentifier == c_hitGroupIdentifierAABB_1)
+    {
+        return (hit.hitKind == 0) ? record.GetLocalRootArguments<CircleAABBConstantBuffer>().color : float4(0.1f, 0.2f, 0.4f, 1);
+    }
+    return invalidRecordColor;
+}
+
+float4 HelloWorldCpuTestCase::RayGen(UINT x, UINT y) const
+{
+    float2 lerpValues;
+    Ray ray = GenerateOrthographicRay(x, y, m_width, m_height,
+        m_viewport.left, m_viewport.top, m_viewport.right, m_viewport.bottom, &lerpValues);
+
+    if (!IsInsideStencil(ray))
+    {
+        // Render interpolated DispatchRaysIndex outside the stencil window
+        return float4(lerpValues.x, lerpValues.y, 0, 1);
+    }
+
+    CpuHit hit;
+    bool hasHit = m_scene.TraceRay(ray, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, ~0u, 0, 1, &hit);
+    return ShadeHit(hasHit, hit);
+}
+
+bool HelloWorldCpuTestCase::DispatchRays(const CpuDispatchRaysDesc& desc, CpuThreadPool* pool, CpuImage* output,
+    std::vector<CpuTileTiming>* tileTimings) const
+{
+    GlobalRootArguments globalRootArguments = { &m_scene, output };
+    m_pipeline->DispatchRays(m_shaderTableBindings, desc, pool, &globalRootArguments, tileTimings);
+    return true;
+}
+
+void HelloWorldCpuTestCase::MyRaygenShader(Pipeline::ShaderContext& context)
+{
+    const GlobalRootArguments& globals = context.GetGlobalRootArguments<GlobalRootArguments>();
+    const RayGenConstantBuffer& rayGenCB = context.GetLocalRootArguments<RayGenConstantBuffer>();
+    const uint3& index = context.DispatchRaysIndex();
+    const uint3& dimensions = context.DispatchRaysDimensions();
+
+    float2 lerpValues;
+    Ray ray = GenerateOrthographicRay(index.x, index.y, dimensions.x, dimensions.y,
+        rayGenCB.viewport.left, rayGenCB.viewport.top, rayGenCB.viewport.right, rayGenCB.viewport.bottom, &lerpValues);
+
+    if ((ray.origin.x >= rayGenCB.stencil.left && ray.origin.x <= rayGenCB.stencil.right)
+        && (ray.origin.y >= rayGenCB.stencil.top && ray.origin.y <= rayGenCB.stencil.bottom))
+    {
+        RayPayload payload = { float4(0, 0, 0, 0) };
+        context.TraceRay(*globals.scene, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, ~0u, 0, 1, 0, ray, payload);
+        globals.renderTarget->SetPixel(index.x, index.y, payload.color);
+    }
+    else
+    {
+        // Render interpolated DispatchRaysIndex outside the stencil window
+        globals.renderTarget->SetPixel(index.x, index.y, float4(lerpValues.x, lerpValues.y, 0, 1));
+    }
+}
+
+void HelloWorldCpuTestCase::MyClosestHitShader(Pipeline::ShaderContext&, RayPayload& payload, const MyAttributes&)
+{
+    payload.color = float4(1, 1, 0, 1);
+}
+
+void HelloWorldCpuTestCase::MyClosestHitShaderRed(Pipeline::ShaderContext&, RayPayload& payload, const MyAttributes&)
+{
+    payload.color = float4(1, 0, 0, 1);
+}
+
+void HelloWorldCpuTestCase::MyClosestHitIntersectionShader(Pipeline::ShaderContext& context, RayPayload& payload, const MyAttributes&)
+{
+    if (context.HitKind() == 0)
+    {
+        payload.color = context.GetLocalRootArguments<CircleAABBConstantBuffer>().color;
+    }
+    else
+    {
+        payload.color = float4(0.1f, 0.2f, 0.4f, 1);
+    }
+}
+
+void HelloWorldCpuTestCase::MyMissShader(Pipeline::ShaderContext&, RayPayload& payload)
+{
+    payload.color = float4(0.0f, 0.0f, 0.3f, 1);
+}
+
+void HelloWorldCpuTestCase::MyIntersectionShader(Pipeline::ShaderContext& context)
+{
+    const CircleAABBConstantBuffer& cb = context.GetLocalRootArguments<CircleAABBConstantBuffer>();
+    HelloWorldIntersectionAttrs attr = {};
+
+    float3 worldRayOrigin = context.WorldRayOrigin() + cb.center;
+    float sqRadius = cb.radius * cb.radius;
+    float sqX = worldRayOrigin.x * worldRayOrigin.x;
+    float sqY = worldRayOrigin.y * worldRayOrigin.y;
+    context.ReportHit(0.1f, (sqX + sqY < sqRadius) ? 0 : 1, attr);
+}
+
+void HelloWorldCpuTestCase::RayGenPacket(UINT x, UINT y, CpuImage* output) const
+{
+    RayPacket packet;
+    GenerateOrthographicRayPacket(x, y, m_width, m_height,
+        m_viewport.left, m_viewport.top, m_viewport.right, m_viewport.bottom, &packet);
+    for (UINT i = 0; i < packet.GetRayCount(); i++)
+    {
+        if (!IsInsideStencil(packet.rays[i]))
+        {
+            // Tiles crossing the stencil edge take the per-pixel path.
+            CpuTestCase::RayGenPacket(x, y, output);
+            return;
+        }
+    }
+
+    CpuHit hits[c_rayPacketSize];
+    UINT64 hitMask = m_scene.TraceRayPacket(packet, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, ~0u, 0, 1, hits);
+    for (UINT i = 0; i < packet.GetRayCount(); i++)
+    {
+        output->SetPixel(x + i % packet.width, y + i / packet.width, ShadeHit(((hitMask >> i) & 1) != 0, hits[i]));
+    }
+}
@@ -0,0 +1,108 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "CpuTestCase.h"
+#include "CpuRaytracingPipeline.h"
+
+// CPU port of D3D12RaytracingHelloWorld: triangle, square and two circle AABBs traced orthographically.
+class HelloWorldCpuTestCase : public CpuTestCase
+{
+public:
+    HelloWorldCpuTestCase(UINT width, UINT height);
+
+    virtual const char* GetName() const override { return "HelloWorld"; }
+    virtual void CreateTestCase() override;
+    virtual CpuRT::float4 RayGen(UINT x, UINT y) const override;
+    virtual void RayGenPacket(UINT x, UINT y, CpuRT::CpuImage* output) const override;
+    virtual bool DispatchRays(const CpuRT::CpuDispatchRaysDesc& desc, CpuRT::CpuThreadPool* pool, CpuRT::CpuImage* output,
+        std::vector<CpuRT::CpuTileTiming>* tileTimings) const override;
+
+private:
+    struct Vertex
+    {
+        float v1, v2, v3;
+    };
+    typedef UINT16 Index;
+
+    struct Viewport
+    {
+        float left;
+        float top;
+        float right;
+        float bottom;
+    };
+
+    struct RayGenConstantBuffer
+    {
+        Viewport viewport;
+        Viewport stencil;
+    };
+
+    struct CircleAABBConstantBuffer
+    {
+        float radius;
+        CpuRT::float3 center;
+        CpuRT::float4 color;
+    };
+
+    struct HelloWorldIntersectionAttrs
+    {
+        float attr;
+    };
+
+    struct RayPayload
+    {
+        CpuRT::float4 color;
+    };
+
+    // Bindings of the global root signature: Scene and RenderTarget.
+    struct GlobalRootArguments
+    {
+        const CpuRT::CpuScene* scene;
+        CpuRT::CpuImage* renderTarget;
+    };
+
+    typedef CpuRT::CpuRaytracingPipeline<RayPayload, CpuRT::CpuBuiltInTriangleIntersectionAttributes> Pipeline;
+    typedef CpuRT::CpuBuiltInTriangleIntersectionAttributes MyAttributes;
+
+    // Raytracing.hlsl
+    static void MyRaygenShader(Pipeline::ShaderContext& context);
+    static void MyClosestHitShader(Pipeline::ShaderContext& context, RayPayload& payload, const MyAttributes& attr);
+    static void MyClosestHitShaderRed(Pipeline::ShaderContext& context, RayPayload& payload, const MyAttributes& attr);
+    static void MyClosestHitIntersectionShader(Pipeline::ShaderContext& context, RayPayload& payload, const MyAttributes& attr);
+    static void MyMissShader(Pipeline::ShaderContext& context, RayPayload& payload);
+    static void MyIntersectionShader(Pipeline::ShaderContext& context);
+
+    void GetGeometryIndicesAndVertices(ModelGeometry geometry, std::vector<Vertex>* vertices, std::vector<Index>* indices,
+        FLOAT scale, FLOAT indexX, FLOAT indexY, FLOAT zPos);
+    void GetAABBBoundingBox(D3D12_RAYTRACING_AABB& aabbBox, FLOAT scale, FLOAT indexX, FLOAT indexY);
+    void CreateGeometry(FLOAT scale, FLOAT indexX, FLOAT indexY, FLOAT depth);
+    void CreateRaytracingPipeline();
+    void BuildShaderTables();
+    bool IsInsideStencil(const CpuRT::Ray& ray) const;
+    CpuRT::float4 ShadeHit(bool hasHit, const CpuRT::CpuHit& hit) const;
+
+    Viewport m_viewport;
+    Viewport m_stencil;
+    CircleAABBConstantBuffer m_aabbCircleCB[2];
+
+    std::unique_ptr<Pipeline> m_pipeline;
+    std::unique_ptr<CpuRT::CpuShaderTable> m_rayGenShaderTable;
+    std::unique_ptr<CpuRT::CpuShaderTable> m_missShaderTable;
+    std::unique_ptr<CpuRT::CpuShaderTable> m_hitGroupShaderTable;
+    UINT64 m_hitGroupShaderStrideInBytes;
+
+    std::vector<Vertex> m_vertices[2];
+    std::vector<Index> m_indices[2];
+    D3D12_RAYTRACING_AABB m_aabb;
+};
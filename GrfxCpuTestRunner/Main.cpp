@@ -0,0 +1,575 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Headless runner that renders test cases with the CPU reference raytracer.
+//
+// Usage: GrfxCpuTestRunner [-case <name>]... [-width <w>] [-height <h>] [-threads <n>] [-tile <n>] [-packets]
+//                          [-pipeline] [-image <dir>] [-tiletimes <dir>] [-testcases <file>] [-compile <file>]
+//                          [-shards <n>] [-cache <file>]
+// Without -case every registered test case is run. Prints one line per case with the image hash.
+// -testcases runs each <testcase> of a testcases.xml file with the descs it lists in place of the ones the test
+// case hard-codes, on the -case test cases or HelloWorld; lines are named <case>[<testcase name>]. The file may
+// also be a binary suite (TestSuiteBinary.h), which is memory mapped and read one test case at a time. A file
+// without test cases is an error.
+// -compile writes the -testcases file as a binary suite and exits.
+// Shader tables a test case builds are validated against its scene first; problems are reported as failures.
+// -tiletimes writes <case>_tiles.csv with the time each DispatchRays tile took.
+// -packets traces each 8x8 pixel block of a tile through CpuTestCase::RayGenPacket(). It is off by default: packets
+// only win on meshes of about 10k to 100k triangles, not on the sample test cases.
+// -pipeline renders through CpuTestCase::DispatchRays(), the test case's shaders on a CpuRaytracingPipeline;
+// test cases without a pipeline fall back to RayGen().
+// -shards runs the test cases on n worker processes (0 for one per core), each with one thread unless -threads is
+// given, and prints their results in order followed by a summary. A test case that crashes its worker fails alone.
+// Workers are this runner started with -worker (TestShard.h).
+// -cache skips runs whose inputs match a passed run recorded in the file (TestResultCache.h) and prints only the
+// delta: runs new to the cache, runs whose image changed from the one last recorded under their name, and runs
+// whose inputs changed but whose image did not, followed by a summary. The key covers the descs, the sources of
+// the test cases the shaders are compiled from, the shader tables, the resolution and the render path. Runs
+// writing -image or -tiletimes files are always rendered.
+
+#include "CpuTestCase.h"
+#include "TestResultCache.h"
+#include "TestShard.h"
+#include "TestSuiteBinary.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+// The build defines CPU_TEST_CASE_SOURCE_HASH as the hashes of the test case sources, which stand in for the shader
+// bytecode in cache keys: the CPU test cases' shaders are compiled from them. Changes to the raytracer library do
+// not invalidate the cache. Builds that do not define it hash the runner executable instead, so every rebuild does.
+#if defined(CPU_TEST_CASE_SOURCE_HASH)
+#define CPU_TEST_CASE_SOURCE_STRING(hash) #hash
+#define CPU_TEST_CASE_SOURCE_HASH_STRING(hash) CPU_TEST_CASE_SOURCE_STRING(hash)
+#else
+static std::string GetExecutablePath(const char* argv0)
+{
+#if defined(_WIN32)
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return (length > 0 && length < MAX_PATH) ? std::string(path, length) : std::string(argv0);
+#elif defined(__linux__)
+    (void)argv0;
+    return "/proc/self/exe";
+#else
+    return argv0;
+#endif
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> caseNames;
+    UINT width = 1024;
+    UINT height = 1024;
+    UINT numThreads = 0;
+    UINT tileSize = 16;
+    const char* imageDirectory = nullptr;
+    const char* tileTimesDirectory = nullptr;
+    const char* testCasesPath = nullptr;
+    const char* compilePath = nullptr;
+    const char* cachePath = nullptr;
+    bool usePackets = false;
+    bool usePipeline = false;
+    bool threadsGiven = false;
+    int numShards = -1;
+    bool isWorker = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        auto HasValue = [&]()
+        {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "Missing value for %s\n", argv[i]);
+                exit(2);
+            }
+            return true;
+        };
+
+        if (strcmp(argv[i], "-case") == 0 && HasValue())
+        {
+            caseNames.push_back(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-width") == 0 && HasValue())
+        {
+            width = static_cast<UINT>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-height") == 0 && HasValue())
+        {
+            height = static_cast<UINT>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-threads") == 0 && HasValue())
+        {
+            numThreads = static_cast<UINT>(atoi(argv[++i]));
+            threadsGiven = true;
+        }
+        else if (strcmp(argv[i], "-tile") == 0 && HasValue())
+        {
+            tileSize = static_cast<UINT>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-packets") == 0)
+        {
+            usePackets = true;
+        }
+        else if (strcmp(argv[i], "-pipeline") == 0)
+        {
+            usePipeline = true;
+        }
+        else if (strcmp(argv[i], "-image") == 0 && HasValue())
+        {
+            imageDirectory = argv[++i];
+        }
+        else if (strcmp(argv[i], "-tiletimes") == 0 && HasValue())
+        {
+            tileTimesDirectory = argv[++i];
+        }
+        else if (strcmp(argv[i], "-testcases") == 0 && HasValue())
+        {
+            testCasesPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-compile") == 0 && HasValue())
+        {
+            compilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-shards") == 0 && HasValue())
+        {
+            numShards = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-cache") == 0 && HasValue())
+        {
+            cachePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-worker") == 0)
+        {
+            isWorker = true;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (compilePath && !testCasesPath)
+    {
+        fprintf(stderr, "-compile requires -testcases\n");
+        return 2;
+    }
+
+    // A binary suite stays mapped and each run copies out its test case; XML suites are parsed up front.
+    TestSuiteView testSuite;
+    std::vector<TestCaseDescs> xmlTestCases;
+    UINT numLoadedTestCases = 0;
+    if (testCasesPath)
+    {
+        try
+        {
+            if (IsTestSuiteFile(testCasesPath))
+            {
+                testSuite.Open(testCasesPath);
+                numLoadedTestCases = testSuite.GetTestCaseCount();
+            }
+            else
+            {
+                xmlTestCases = LoadTestCasesXml(testCasesPath);
+                numLoadedTestCases = static_cast<UINT>(xmlTestCases.size());
+            }
+
+            // An empty or truncated suite must not pass as a clean run.
+            if (numLoadedTestCases == 0)
+            {
+                throw std::runtime_error(std::string(testCasesPath) + " has no test cases");
+            }
+
+            if (compilePath)
+            {
+                SaveTestSuite(xmlTestCases.empty() ? LoadTestCases(testCasesPath) : xmlTestCases, compilePath);
+                printf("Compiled %u test cases to %s\n", numLoadedTestCases, compilePath);
+                return 0;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            return 2;
+        }
+    }
+
+    if (caseNames.empty())
+    {
+        caseNames = testCasesPath ? std::vector<std::string>{ "HelloWorld" } : std::vector<std::string>{ "HelloWorld", "SimpleLighting" };
+    }
+
+    // Each test case once with its own descs, or once per loaded <testcase>.
+    struct CaseRun
+    {
+        std::string caseName;
+        int testCaseIndex;      // Into the -testcases file, or -1 for the test case's own descs.
+    };
+    std::vector<CaseRun> runs;
+    for (const std::string& caseName : caseNames)
+    {
+        if (!testCasesPath)
+        {
+            runs.push_back({ caseName, -1 });
+        }
+        for (UINT i = 0; i < numLoadedTestCases; i++)
+        {
+            runs.push_back({ caseName, static_cast<int>(i) });
+        }
+    }
+
+    if (tileSize == 0)
+    {
+        fprintf(stderr, "-tile must be at least 1\n");
+        return 2;
+    }
+    if (usePackets)
+    {
+        // Packets must not straddle tiles.
+        tileSize = (tileSize + CpuRT::c_rayPacketWidth - 1) / CpuRT::c_rayPacketWidth * CpuRT::c_rayPacketWidth;
+    }
+
+    // Workers only look runs up; the driver, or a serial run, records the new results and saves the cache.
+    TestResultCache cache;
+    UINT64 shaderKey = 0;
+    if (cachePath)
+    {
+        try
+        {
+            cache.Load(cachePath);
+            TestCacheKeyBuilder key;
+#if defined(CPU_TEST_CASE_SOURCE_HASH)
+            key.AddString(CPU_TEST_CASE_SOURCE_HASH_STRING(CPU_TEST_CASE_SOURCE_HASH));
+#else
+            key.AddFile(GetExecutablePath(argv[0]).c_str());
+#endif
+            shaderKey = key.GetKey();
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            return 2;
+        }
+    }
+    const bool useCachedResults = cachePath && !imageDirectory && !tileTimesDirectory;
+
+    auto RunName = [&](const CaseRun& run)
+    {
+        if (run.testCaseIndex < 0)
+        {
+            return run.caseName;
+        }
+        std::string testCaseName = xmlTestCases.empty() ? std::string(testSuite.GetTestCase(run.testCaseIndex).name)
+                                                        : xmlTestCases[run.testCaseIndex].name;
+        return run.caseName + "[" + testCaseName + "]";
+    };
+
+    struct CacheStatistics
+    {
+        UINT cached;
+        UINT added;
+        UINT changed;
+        UINT same;
+        double cachedMs;
+    };
+    CacheStatistics cacheStatistics = {};
+
+    auto PrintResult = [&](const CaseRun& run, const TestShardResult& result)
+    {
+        std::string name = RunName(run);
+        if (result.status == TestShardStatus::Crashed)
+        {
+            fprintf(stderr, "%s crashed: %s\n", name.c_str(), result.message.c_str());
+            return;
+        }
+
+        // With a cache only the delta is printed. Runs recorded under their name with the same key are counted;
+        // the others are compared against the last image recorded under their name. Cached results can still be
+        // part of the delta, when another run with the same inputs was recorded.
+        char delta[64] = "";
+        UINT64 lastKey = 0;
+        const TestCacheEntry* last = cachePath ? cache.FindLast(name, &lastKey) : nullptr;
+        if (result.cached)
+        {
+            cacheStatistics.cached++;
+            cacheStatistics.cachedMs += result.buildMs + result.renderMs;
+            if (last && lastKey == result.cacheKey)
+            {
+                return;
+            }
+        }
+        if (cachePath && result.status == TestShardStatus::Passed)
+        {
+            if (!last)
+            {
+                cacheStatistics.added++;
+                snprintf(delta, sizeof(delta), " new");
+            }
+            else if (last->imageHash != result.imageHash)
+            {
+                cacheStatistics.changed++;
+                snprintf(delta, sizeof(delta), " changed from %016llx", static_cast<unsigned long long>(last->imageHash));
+            }
+            else
+            {
+                cacheStatistics.same++;
+                snprintf(delta, sizeof(delta), " same image");
+            }
+            cache.Record(name, result.cacheKey, { result.imageHash, result.buildMs, result.renderMs });
+        }
+
+        fprintf(stderr, "%s", result.message.c_str());
+        if (result.rendered)
+        {
+            printf("%s %ux%u hash=%016llx build=%.3fms render=%.3fms%s%s\n", name.c_str(), width, height,
+                static_cast<unsigned long long>(result.imageHash), result.buildMs, result.renderMs, delta, result.cached ? " (cached)" : "");
+        }
+    };
+
+    // Returns false if the cache cannot be saved.
+    auto SaveCache = [&]()
+    {
+        if (!cachePath)
+        {
+            return true;
+        }
+        printf("%u of %zu runs taken from the cache (%.1fms of rendering), %u new, %u changed, %u with the same image\n",
+            cacheStatistics.cached, runs.size(), cacheStatistics.cachedMs, cacheStatistics.added, cacheStatistics.changed,
+            cacheStatistics.same);
+        try
+        {
+            cache.Save(cachePath);
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            return false;
+        }
+    };
+
+    if (numShards >= 0 && !isWorker)
+    {
+        // The workers get the same arguments, so they load the same suite and number the runs the same way.
+        std::vector<std::string> workerArgs = { argv[0], "-worker" };
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-shards") == 0)
+            {
+                i++;
+                continue;
+            }
+            workerArgs.push_back(argv[i]);
+        }
+        if (!threadsGiven)
+        {
+            workerArgs.insert(workerArgs.end(), { "-threads", "1" });
+        }
+        UINT numWorkers = numShards ? static_cast<UINT>(numShards) : (std::max)(1u, std::thread::hardware_concurrency());
+
+        try
+        {
+            TestShardDriver driver(workerArgs, numWorkers);
+            TestShardStatistics statistics = driver.Run(static_cast<UINT>(runs.size()),
+                [&](const TestShardResult& result) { PrintResult(runs[result.runIndex], result); });
+            printf("%u runs on %u workers (%u started): %u passed, %u failed, %u crashed, %.1fms of work in %.1fms\n",
+                statistics.runs, numWorkers, statistics.workers, statistics.passed, statistics.failed, statistics.crashed,
+                statistics.workerMs, statistics.totalMs);
+            bool cacheSaved = SaveCache();
+            return (statistics.failed || statistics.crashed || !cacheSaved) ? 1 : 0;
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            return 2;
+        }
+    }
+
+    CpuRT::CpuThreadPool threadPool(numThreads);
+    CpuRT::CpuDispatchRaysDesc dispatchDesc;
+    dispatchDesc.width = width;
+    dispatchDesc.height = height;
+    dispatchDesc.tileWidth = tileSize;
+    dispatchDesc.tileHeight = tileSize;
+
+    auto RunCase = [&](UINT runIndex)
+    {
+        const CaseRun& run = runs[runIndex];
+        TestShardResult result = {};
+        result.runIndex = runIndex;
+        result.status = TestShardStatus::Failed;
+
+        const std::string& caseName = run.caseName;
+        std::unique_ptr<CpuTestCase> testCase = CreateCpuTestCase(caseName, width, height);
+        if (!testCase)
+        {
+            result.message = "Unknown test case " + caseName + "\n";
+            return result;
+        }
+        const TestCaseDescs* descs = nullptr;
+        TestCaseDescs suiteDescs;
+        if (run.testCaseIndex >= 0 && !xmlTestCases.empty())
+        {
+            descs = &xmlTestCases[run.testCaseIndex];
+        }
+        else if (run.testCaseIndex >= 0)
+        {
+            testSuite.GetTestCase(run.testCaseIndex).ToDescs(&suiteDescs);
+            descs = &suiteDescs;
+        }
+        testCase->SetTestCaseDescs(descs);
+        std::string name = RunName(run);
+        bool failed = false;
+
+        try
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            testCase->CreateTestCase();
+            auto built = std::chrono::high_resolution_clock::now();
+
+            std::vector<std::string> shaderTableErrors = testCase->ValidateShaderTables();
+            for (const std::string& error : shaderTableErrors)
+            {
+                result.message += name + " shader tables: " + error + "\n";
+            }
+            failed |= !shaderTableErrors.empty();
+
+            // Shader tables that fail validation are never cached, so only valid ones need to be keyed.
+            if (cachePath && !failed)
+            {
+                TestCacheKeyBuilder key;
+                key.Add(shaderKey);
+                key.AddString(caseName);
+                key.Add(width);
+                key.Add(height);
+                key.Add(usePackets);
+                key.Add(usePipeline);
+                key.AddDescs(testCase->GetGeomDescs(), testCase->GetBlasDescs(), testCase->GetTlasDescs());
+                if (descs)
+                {
+                    key.AddModels(descs->models);
+                }
+                const CpuRT::CpuShaderTableBindings& bindings = testCase->GetShaderTableBindings();
+                for (const CpuRT::CpuShaderTableRange* range : { &bindings.rayGenerationShaderRecord, &bindings.missShaderTable,
+                                                                  &bindings.hitGroupTable, &bindings.callableShaderTable })
+                {
+                    key.Add(range->sizeInBytes);
+                    key.Add(range->strideInBytes);
+                    if (range->startAddress)
+                    {
+                        key.AddBytes(range->startAddress, static_cast<size_t>(range->sizeInBytes));
+                    }
+                }
+                result.cacheKey = key.GetKey();
+
+                const TestCacheEntry* entry = useCachedResults ? cache.Find(result.cacheKey) : nullptr;
+                if (entry)
+                {
+                    result.status = TestShardStatus::Passed;
+                    result.rendered = true;
+                    result.cached = true;
+                    result.imageHash = entry->imageHash;
+                    result.buildMs = entry->buildMs;
+                    result.renderMs = entry->renderMs;
+                    return result;
+                }
+            }
+
+            CpuRT::CpuImage image(width, height);
+            std::vector<CpuRT::CpuTileTiming> tileTimings;
+            std::vector<CpuRT::CpuTileTiming>* timings = tileTimesDirectory ? &tileTimings : nullptr;
+            if (!usePipeline || !testCase->DispatchRays(dispatchDesc, &threadPool, &image, timings))
+            {
+                if (usePackets)
+                {
+                    CpuRT::DispatchRayTiles(dispatchDesc, [&](const CpuRT::CpuDispatchTile& tile)
+                    {
+                        for (UINT y = tile.y; y < tile.y + tile.height; y += CpuRT::c_rayPacketHeight)
+                        {
+                            for (UINT x = tile.x; x < tile.x + tile.width; x += CpuRT::c_rayPacketWidth)
+                            {
+                                testCase->RayGenPacket(x, y, &image);
+                            }
+                        }
+                    }, &threadPool, timings);
+                }
+                else
+                {
+                    CpuRT::DispatchRaysTiled(dispatchDesc,
+                        [&](UINT x, UINT y, UINT) { image.SetPixel(x, y, testCase->RayGen(x, y)); }, &threadPool, timings);
+                }
+            }
+            auto rendered = std::chrono::high_resolution_clock::now();
+
+            result.rendered = true;
+            result.imageHash = image.Hash();
+            result.buildMs = std::chrono::duration<float, std::milli>(built - start).count();
+            result.renderMs = std::chrono::duration<float, std::milli>(rendered - built).count();
+
+            if (imageDirectory)
+            {
+                std::string path = std::string(imageDirectory) + "/" + name + ".bmp";
+                if (!image.SaveBmp(path.c_str()))
+                {
+                    result.message += "Failed to write " + path + "\n";
+                    failed = true;
+                }
+            }
+
+            if (tileTimesDirectory)
+            {
+                std::string path = std::string(tileTimesDirectory) + "/" + name + "_tiles.csv";
+                if (!CpuRT::SaveTileTimingsCsv(path.c_str(), tileTimings))
+                {
+                    result.message += "Failed to write " + path + "\n";
+                    failed = true;
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            result.message += name + " failed: " + e.what() + "\n";
+            failed = true;
+        }
+
+        result.status = failed ? TestShardStatus::Failed : TestShardStatus::Passed;
+        return result;
+    };
+
+    if (isWorker)
+    {
+        TestShardWorker worker;
+        UINT runIndex;
+        while (worker.NextRun(&runIndex))
+        {
+            if (runIndex >= runs.size() || !worker.WriteResult(RunCase(runIndex)))
+            {
+                return 2;
+            }
+        }
+        return 0;
+    }
+
+    int failures = 0;
+    for (UINT i = 0; i < runs.size(); i++)
+    {
+        TestShardResult result = RunCase(i);
+        PrintResult(runs[i], result);
+        failures += result.status != TestShardStatus::Passed;
+    }
+    failures += !SaveCache();
+
+    return failures ? 1 : 0;
+}
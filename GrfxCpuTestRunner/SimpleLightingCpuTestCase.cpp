@@ -0,0 +1,289 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SimpleLightingCpuTestCase.h"
+
+using namespace CpuRT;
+
+namespace HitGroup
+{
+    enum Enum
+    {
+        Cube = 0,
+        CubeShadow,
+        Floor,
+        FloorShadow,
+        Sphere,
+        SphereShadow,   // Intersection shader only, no closest hit.
+        Count
+    };
+}
+
+SimpleLightingCpuTestCase::SimpleLightingCpuTestCase(UINT width, UINT height) :
+    CpuTestCase(width, height)
+{
+}
+
+void SimpleLightingCpuTestCase::InitializeScene()
+{
+    // Setup materials.
+    m_cubeAlbedo = float4(0.3f, 0.2f, 1.0f, 1.0f);
+    m_floorAlbedo = float4(0.7f, 0.7f, 0.7f, 1.0f);
+
+    // Setup camera.
+    float3 eye(0.0f, 2.0f, -10.0f);
+    float3 at(0.0f, 0.0f, 0.0f);
+    float3 right(1.0f, 0.0f, 0.0f);
+    float3 direction = normalize(at - eye);
+    float3 up = normalize(cross(direction, right));
+
+    // Rotate camera around Y axis (XMMatrixRotationY, row-vector convention).
+    float angle = 45.0f * 3.14159265f / 180.0f;
+    auto RotateY = [&](const float3& v)
+    {
+        return float3(v.x * std::cos(angle) + v.z * std::sin(angle), v.y, -v.x * std::sin(angle) + v.z * std::cos(angle));
+    };
+    eye = RotateY(eye);
+    up = RotateY(up);
+
+    float fovAngleY = 45.0f * 3.14159265f / 180.0f;
+    float4x4 view = float4x4::LookAtLH(eye, at, up);
+    float4x4 proj = float4x4::PerspectiveFovLH(fovAngleY, m_aspectRatio, 1.0f, 125.0f);
+    m_projectionToWorld = (view * proj).Inverse();
+    m_cameraPosition = eye;
+
+    // Setup lights.
+    m_lightPosition = float3(0.0f, 1.8f, -3.0f);
+}
+
+void SimpleLightingCpuTestCase::BuildGeometry()
+{
+    // Cube indices.
+    m_indices =
+    {
+        3,1,0,
+        2,1,3,
+
+        6,4,5,
+        7,4,6,
+
+        11,9,8,
+        10,9,11,
+
+        14,12,13,
+        15,12,14,
+
+        19,17,16,
+        18,17,19,
+
+        22,20,21,
+        23,20,22
+    };
+
+    // Cube vertices positions and corresponding triangle normals.
+    m_vertices =
+    {
+        { float3(-1.0f, 1.0f, -1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(1.0f, 1.0f, -1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(1.0f, 1.0f, 1.0f), float3(0.0f, 1.0f, 0.0f) },
+        { float3(-1.0f, 1.0f, 1.0f), float3(0.0f, 1.0f, 0.0f) },
+
+        { float3(-1.0f, -1.0f, -1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(1.0f, -1.0f, -1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(1.0f, -1.0f, 1.0f), float3(0.0f, -1.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, 1.0f), float3(0.0f, -1.0f, 0.0f) },
+
+        { float3(-1.0f, -1.0f, 1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, -1.0f, -1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, 1.0f, -1.0f), float3(-1.0f, 0.0f, 0.0f) },
+        { float3(-1.0f, 1.0f, 1.0f), float3(-1.0f, 0.0f, 0.0f) },
+
+        { float3(1.0f, -1.0f, 1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, -1.0f, -1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, 1.0f, -1.0f), float3(1.0f, 0.0f, 0.0f) },
+        { float3(1.0f, 1.0f, 1.0f), float3(1.0f, 0.0f, 0.0f) },
+
+        { float3(-1.0f, -1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(1.0f, -1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(1.0f, 1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+        { float3(-1.0f, 1.0f, -1.0f), float3(0.0f, 0.0f, -1.0f) },
+
+        { float3(-1.0f, -1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+        { float3(1.0f, -1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+        { float3(1.0f, 1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+        { float3(-1.0f, 1.0f, 1.0f), float3(0.0f, 0.0f, 1.0f) },
+    };
+
+    // Sphere of radius 1 at the origin.
+    m_aabb = { -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+    CpuTriangleGeometryDesc desc = {};
+    desc.vertexData = m_vertices.data();
+    desc.vertexCount = static_cast<UINT>(m_vertices.size());
+    desc.vertexStrideInBytes = sizeof(Vertex);
+    desc.indexData = m_indices.data();
+    desc.indexCount = static_cast<UINT>(m_indices.size());
+    desc.indexFormat = CpuIndexFormat::R16_UINT;
+    m_scene.SetTriangleGeometry(0, desc);
+    m_scene.SetAABBGeometry(0, { &m_aabb, 1, sizeof(D3D12_RAYTRACING_AABB) });
+}
+
+void SimpleLightingCpuTestCase::CreateTestCase()
+{
+    InitializeScene();
+    BuildGeometry();
+
+    if (!AddLoadedDescs())
+    {
+        AddGeometryDesc(0); //index 0
+        AddGeometryDesc(0); //index 1
+        AddGeometryDesc(0, D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS);
+
+        AddBlasDesc({ 0 });
+        AddBlasDesc({ 1 });
+        AddBlasDesc({ 2 });
+
+        AddTlasDesc(0, 0, 1.0f, 1.0f, 1.0, 2, 2);
+        AddTlasDesc(1, 2, 20.0f, 0.2f, 20.0f, 0, -1, 0);
+        AddTlasDesc(2, 4, 1.0f, 1.0f, 1.0f, -0.5f, 0.8f, 0.5f);
+    }
+
+    // SphereIntersectionShader: unit sphere at the object space origin, lit along -Z.
+    m_scene.SetIntersectionFunction([](const CpuIntersectionInput& input, float* tHit, UINT* hitKind, float* attributes)
+    {
+        float3 rayOrigin = input.objectRay.origin;
+        float3 rayDirection = input.objectRay.direction;
+        float sphereRadius = 1.0f;
+
+        float3 oc = rayOrigin;
+        float a = dot(rayDirection, rayDirection);
+        float b = 2.0f * dot(oc, rayDirection);
+        float c = dot(oc, oc) - (sphereRadius * sphereRadius);
+        float discriminant = b * b - 4 * a * c;
+
+        // Find the nearest intersection point along the ray
+        float t0 = (-b - std::sqrt(discriminant)) / (2.0f * a);
+        float t1 = (-b + std::sqrt(discriminant)) / (2.0f * a);
+        float t = (t0 < t1) ? t0 : t1;
+
+        float3 normal = normalize(rayOrigin + t * rayDirection);
+        float3 lightDirection = float3(0, 0, -1);
+        attributes[0] = dot(normal, lightDirection);
+
+        // A negative discriminant yields NaN, which ReportHit rejects.
+        *tHit = t;
+        *hitKind = 0;
+        return true;
+    });
+
+    BuildScene();
+}
+
+float4 SimpleLightingCpuTestCase::CalculateDiffuseLighting(const float4& albedo, const float3& hitPosition, const float3& normal) const
+{
+    float3 pixelToLight = normalize(m_lightPosition - hitPosition);
+
+    // Diffuse contribution.
+    float fNDotL = (std::max)(0.0f, dot(pixelToLight, normal));
+    return albedo * fNDotL * 0.7f + albedo * 0.3f;
+}
+
+bool SimpleLightingCpuTestCase::TraceShadowRayAndReportIfHit(const Ray& ray, UINT currentRecursionDepth) const
+{
+    if (currentRecursionDepth > 2)
+    {
+        return false;
+    }
+
+    Ray shadowRay(ray.origin, ray.direction, 0.5f, 10000.0f);
+    CpuHit hit;
+    if (!m_scene.TraceRay(shadowRay, RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH | RAY_FLAG_FORCE_OPAQUE, ~0u, 1, 0, &hit))
+    {
+        // MyMissShader_Shadow
+        return false;
+    }
+
+    // The sphere's shadow hit group has no closest hit shader, so the payload keeps its initial value.
+    return hit.hitGroupIndex != HitGroup::SphereShadow;
+}
+
+float4 SimpleLightingCpuTestCase::TraceRadianceRay(const Ray& ray, UINT currentRayRecursionDepth) const
+{
+    if (currentRayRecursionDepth > 2)
+    {
+        return float4(0, 0, 0, 0);
+    }
+
+    Ray radianceRay(ray.origin, ray.direction, 0.0f, 10000.0f);
+    CpuHit hit;
+    if (!m_scene.TraceRay(radianceRay, RAY_FLAG_NONE, ~0u, 0, 1, &hit))
+    {
+        // MyMissShader
+        return float4(0.0f, 0.2f, 0.4f, 1.0f);
+    }
+    return ShadeRadianceHit(ray, hit, currentRayRecursionDepth + 1);
+}
+
+float4 SimpleLightingCpuTestCase::ShadeRadianceHit(const Ray& ray, const CpuHit& hit, UINT recursionDepth) const
+{
+    if (hit.hitGroupIndex == HitGroup::Sphere)
+    {
+        return float4(0.8f, 0.3f, 0.3f, 1.0f) * hit.attributes[0] + float4(0.2f, 0.1f, 0.2f, 1.0f);
+    }
+
+    if (hit.hitGroupIndex != HitGroup::Cube && hit.hitGroupIndex != HitGroup::Floor)
+    {
+        return float4(1, 0, 1, 1);
+    }
+
+    // FloorClosestHitShader / CubeClosestHitShader
+    float3 hitPosition = ray.origin + hit.t * ray.direction;
+    UINT baseIndex = hit.primitiveIndex * 3;
+    float3 vertexNormals[3] =
+    {
+        m_vertices[m_indices[baseIndex]].normal,
+        m_vertices[m_indices[baseIndex + 1]].normal,
+        m_vertices[m_indices[baseIndex + 2]].normal
+    };
+    float2 barycentrics = hit.Barycentrics();
+    float3 triangleNormal = vertexNormals[0] +
+        barycentrics.x * (vertexNormals[1] - vertexNormals[0]) +
+        barycentrics.y * (vertexNormals[2] - vertexNormals[0]);
+
+    bool isFloor = hit.hitGroupIndex == HitGroup::Floor;
+    float4 color = CalculateDiffuseLighting(isFloor ? m_floorAlbedo : m_cubeAlbedo, hitPosition, triangleNormal);
+
+    Ray shadowRay(hitPosition, normalize(m_lightPosition - hitPosition));
+    bool hitgeom = TraceShadowRayAndReportIfHit(shadowRay, recursionDepth);
+    return color - color * (hitgeom ? 1.0f : 0.0f) * (isFloor ? 0.4f : 0.1f);
+}
+
+float4 SimpleLightingCpuTestCase::RayGen(UINT x, UINT y) const
+{
+    Ray ray = GeneratePinholeRay(x, y, m_width, m_height, m_projectionToWorld, m_cameraPosition);
+    return TraceRadianceRay(ray, 0);
+}
+
+void SimpleLightingCpuTestCase::RayGenPacket(UINT x, UINT y, CpuImage* output) const
+{
+    // Primary rays are traced as a packet, shadow rays one by one. GeneratePinholeRay() already uses the
+    // radiance ray's [0, 10000] interval.
+    RayPacket packet;
+    GeneratePinholeRayPacket(x, y, m_width, m_height, m_projectionToWorld, m_cameraPosition, &packet);
+    CpuHit hits[c_rayPacketSize];
+    UINT64 hitMask = m_scene.TraceRayPacket(packet, RAY_FLAG_NONE, ~0u, 0, 1, hits);
+    for (UINT i = 0; i < packet.GetRayCount(); i++)
+    {
+        // MyMissShader
+        float4 color = ((hitMask >> i) & 1) ? ShadeRadianceHit(packet.rays[i], hits[i], 1) : float4(0.0f, 0.2f, 0.4f, 1.0f);
+        output->SetPixel(x + i % packet.width, y + i / packet.width, color);
+    }
+}
@@ -0,0 +1,51 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "CpuTestCase.h"
+
+// CPU port of D3D12RaytracingSimpleLighting: lit cube, floor and sphere AABB with shadow rays.
+class SimpleLightingCpuTestCase : public CpuTestCase
+{
+public:
+    SimpleLightingCpuTestCase(UINT width, UINT height);
+
+    virtual const char* GetName() const override { return "SimpleLighting"; }
+    virtual void CreateTestCase() override;
+    virtual CpuRT::float4 RayGen(UINT x, UINT y) const override;
+    virtual void RayGenPacket(UINT x, UINT y, CpuRT::CpuImage* output) const override;
+
+private:
+    struct Vertex
+    {
+        CpuRT::float3 position;
+        CpuRT::float3 normal;
+    };
+    typedef UINT16 Index;
+
+    void BuildGeometry();
+    void InitializeScene();
+    CpuRT::float4 TraceRadianceRay(const CpuRT::Ray& ray, UINT currentRayRecursionDepth) const;
+    CpuRT::float4 ShadeRadianceHit(const CpuRT::Ray& ray, const CpuRT::CpuHit& hit, UINT recursionDepth) const;
+    bool TraceShadowRayAndReportIfHit(const CpuRT::Ray& ray, UINT currentRayRecursionDepth) const;
+    CpuRT::float4 CalculateDiffuseLighting(const CpuRT::float4& albedo, const CpuRT::float3& hitPosition, const CpuRT::float3& normal) const;
+
+    std::vector<Vertex> m_vertices;
+    std::vector<Index> m_indices;
+    D3D12_RAYTRACING_AABB m_aabb;
+
+    CpuRT::float4x4 m_projectionToWorld;
+    CpuRT::float3 m_cameraPosition;
+    CpuRT::float3 m_lightPosition;
+    CpuRT::float4 m_cubeAlbedo;
+    CpuRT::float4 m_floorAlbedo;
+};
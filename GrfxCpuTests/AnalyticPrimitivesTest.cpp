@@ -0,0 +1,169 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// The robust analytic sphere and AABB tests: the float versions against the double reference over rays from
+// origins up to 10000 AABB sizes away, where the HLSL port's b * b - 4 * a * c has lost all its digits, and the
+// 8-ray batch kernels against RayAnalyticPrimitiveTestRobust<float>() bit for bit.
+
+#include "Test.h"
+#include "CpuFeatures.h"
+#include "ProceduralPrimitivesLibrary.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace CpuRT;
+
+namespace
+{
+    const CpuAnalyticPrimitive::Enum c_primitives[] = { CpuAnalyticPrimitive::Spheres, CpuAnalyticPrimitive::AABB };
+    const float c_distances[] = { 2.0f, 100.0f, 10000.0f };
+    const UINT c_raysPerDistance = 20000;
+
+    // Largest share of rays that may hit or miss unlike the reference, or hit another surface, and largest error of
+    // the hit position relative to the distance travelled, or to the AABB size for hits closer than that. At most
+    // 6 of 20000 rays mismatch, grazing the spheres from 10000 away, and the error stays below 3e-6.
+    const double c_maxMismatchRatio = 0.001;
+    const double c_maxDistanceError = 1e-5;
+    const double c_maxNormalError = 0.1;
+
+    // Origins at distance from the center in a random direction, aimed at a random point of the AABB grown by 20%,
+    // with unnormalized directions and one in sixteen with a zero component, as in the "analytic" benchmark.
+    std::vector<Ray> GenerateRays(UINT count, float distance, UINT seed)
+    {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> gaussian;
+        std::uniform_real_distribution<float> target(-1.2f, 1.2f);
+        std::uniform_real_distribution<float> logScale(-2.0f, 2.0f);
+        std::uniform_int_distribution<int> axisPick(0, 15);
+
+        std::vector<Ray> rays(count);
+        for (Ray& ray : rays)
+        {
+            float3 origin(gaussian(rng), gaussian(rng), gaussian(rng));
+            origin = normalize(origin) * distance;
+            float3 direction = normalize(float3(target(rng), target(rng), target(rng)) - origin) * std::exp2(logScale(rng));
+            int axis = axisPick(rng);
+            if (axis < 3)
+            {
+                direction[axis] = 0.0f;
+            }
+            ray = Ray(origin, direction, 0.0f, 1e30f);
+        }
+        return rays;
+    }
+
+    bool IsSameFloat(float a, float b)
+    {
+        return std::memcmp(&a, &b, sizeof(float)) == 0;
+    }
+}
+
+static void RobustAnalyticAccuracyTest()
+{
+    for (CpuAnalyticPrimitive::Enum primitive : c_primitives)
+    {
+        for (float distance : c_distances)
+        {
+            std::vector<Ray> rays = GenerateRays(c_raysPerDistance, distance, static_cast<UINT>(distance));
+            size_t hits = 0;
+            size_t mismatches = 0;
+            double maxDistanceError = 0.0;
+            for (const Ray& ray : rays)
+            {
+                float t = 0.0f;
+                float normal[3] = {};
+                bool hit = RayAnalyticPrimitiveTestRobust(AnalyticRay<float>(ray), RAY_FLAG_NONE, primitive, &t, normal);
+                double referenceT = 0.0;
+                double referenceNormal[3] = {};
+                bool referenceHit = RayAnalyticPrimitiveTestRobust(AnalyticRay<double>(ray), RAY_FLAG_NONE, primitive,
+                    &referenceT, referenceNormal);
+                hits += referenceHit;
+
+                double normalError = 0.0;
+                if (hit && referenceHit)
+                {
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        normalError += (normal[axis] - referenceNormal[axis]) * (normal[axis] - referenceNormal[axis]);
+                    }
+                    normalError = std::sqrt(normalError);
+                }
+                if (hit != referenceHit || !(normalError <= c_maxNormalError))
+                {
+                    mismatches++;
+                }
+                else if (hit)
+                {
+                    double directionLength = length(ray.direction);
+                    double distanceError = std::fabs(t - referenceT) * directionLength
+                        / (std::max)(std::fabs(referenceT) * directionLength, 2.0);
+                    maxDistanceError = (std::max)(maxDistanceError, distanceError);
+                }
+            }
+
+            CHECK(hits > 0);
+            CHECK(mismatches <= c_maxMismatchRatio * rays.size());
+            CHECK(maxDistanceError <= c_maxDistanceError);
+        }
+    }
+}
+
+static void AnalyticBatchKernelsTest()
+{
+    std::vector<AnalyticKernel::Enum> kernels = { AnalyticKernel::Scalar };
+    if (CpuSupportsAvx2())
+    {
+        kernels.push_back(AnalyticKernel::Avx2);
+    }
+
+    const UINT rayFlagsList[] = { RAY_FLAG_NONE, RAY_FLAG_CULL_BACK_FACING_TRIANGLES, RAY_FLAG_CULL_FRONT_FACING_TRIANGLES };
+    for (CpuAnalyticPrimitive::Enum primitive : c_primitives)
+    {
+        for (UINT rayFlags : rayFlagsList)
+        {
+            std::vector<Ray> rays = GenerateRays(4001, 10.0f, primitive + 7 * rayFlags);
+            for (AnalyticKernel::Enum kernel : kernels)
+            {
+                for (size_t first = 0; first < rays.size(); first += c_rayBatchWidth)
+                {
+                    RayBatch batch = {};
+                    for (size_t i = first; i < (std::min)(rays.size(), first + c_rayBatchWidth); i++)
+                    {
+                        batch.Set(batch.count++, rays[i]);
+                    }
+                    RayBatchHits hits;
+                    UINT hitMask = RayAnalyticPrimitiveTest8(kernel, batch, rayFlags, primitive, &hits);
+
+                    for (UINT lane = 0; lane < batch.count; lane++)
+                    {
+                        float t = 0.0f;
+                        float normal[3] = {};
+                        bool hit = RayAnalyticPrimitiveTestRobust(AnalyticRay<float>(rays[first + lane]), rayFlags,
+                            primitive, &t, normal);
+                        CHECK_EQUAL(hit, ((hitMask >> lane) & 1) != 0);
+                        if (hit)
+                        {
+                            CHECK(IsSameFloat(hits.t[lane], t));
+                            for (int axis = 0; axis < 3; axis++)
+                            {
+                                CHECK(IsSameFloat(hits.normal[axis][lane], normal[axis]));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+REGISTER_TEST("analytic.robustaccuracy", RobustAnalyticAccuracyTest);
+REGISTER_TEST("analytic.batchkernels", AnalyticBatchKernelsTest);
@@ -0,0 +1,211 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// DirtyElementTracker against a reference model that keeps one bool per element and instance. Random marks
+// and copies run over element counts around the 64 bit word boundaries, with packed and strided layouts.
+// Source elements are also changed without being marked, so a copy of a clean element shows up as a mismatch.
+
+#include "Test.h"
+#include "DirtyElementTracker.h"
+#include <cstdint>
+#include <random>
+
+namespace
+{
+    const size_t c_elementSize = 12;
+
+    struct ReferenceTracker
+    {
+        void Reset(UINT numElements, UINT numInstances)
+        {
+            dirty.assign(numInstances, std::vector<bool>(numElements, true));
+        }
+
+        void MarkDirty(UINT first, UINT count)
+        {
+            for (std::vector<bool>& instance : dirty)
+            {
+                for (UINT element = first; element < first + count; element++)
+                {
+                    instance[element] = true;
+                }
+            }
+        }
+
+        std::vector<std::vector<bool>> dirty;
+    };
+
+    void CheckDirtyState(const DirtyElementTracker& tracker, const ReferenceTracker& reference)
+    {
+        for (UINT instance = 0; instance < tracker.NumInstances(); instance++)
+        {
+            UINT count = 0;
+            for (UINT element = 0; element < tracker.NumElements(); element++)
+            {
+                CHECK_EQUAL(static_cast<bool>(reference.dirty[instance][element]), tracker.IsDirty(instance, element));
+                count += reference.dirty[instance][element];
+            }
+            CHECK_EQUAL(count, tracker.NumDirtyElements(instance));
+        }
+    }
+
+    void RunRandomMarksAndCopies(UINT numElements, UINT numInstances, size_t sourceStride, size_t destinationStride, std::mt19937& rng)
+    {
+        DirtyElementTracker tracker;
+        ReferenceTracker reference;
+        tracker.Reset(numElements, numInstances);
+        reference.Reset(numElements, numInstances);
+        CheckDirtyState(tracker, reference);
+
+        std::vector<uint8_t> source(numElements * sourceStride);
+        std::vector<std::vector<uint8_t>> destinations(numInstances, std::vector<uint8_t>(numElements * destinationStride));
+        for (uint8_t& byte : source)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+        for (std::vector<uint8_t>& destination : destinations)
+        {
+            for (uint8_t& byte : destination)
+            {
+                byte = static_cast<uint8_t>(rng());
+            }
+        }
+
+        auto writeElement = [&](UINT element)
+        {
+            for (size_t byte = 0; byte < c_elementSize; byte++)
+            {
+                source[element * sourceStride + byte] = static_cast<uint8_t>(rng());
+            }
+        };
+
+        UINT64 expectedBytes = 0;
+        UINT64 expectedRanges = 0;
+        for (UINT step = 0; step < 400; step++)
+        {
+            UINT op = rng() % 8;
+            if (numElements == 0 || op == 7)
+            {
+                UINT instance = rng() % numInstances;
+                const std::vector<uint8_t> before = destinations[instance];
+                UINT dirtyElements = 0;
+                UINT dirtyRanges = 0;
+                for (UINT element = 0; element < numElements; element++)
+                {
+                    if (reference.dirty[instance][element])
+                    {
+                        dirtyElements++;
+                        dirtyRanges += (element == 0 || !reference.dirty[instance][element - 1]);
+                    }
+                }
+
+                UINT64 bytes = tracker.CopyDirty(instance, source.data(), sourceStride, destinations[instance].data(), destinationStride, c_elementSize);
+                CHECK_EQUAL(dirtyElements * c_elementSize, bytes);
+                expectedBytes += bytes;
+                expectedRanges += dirtyRanges;
+
+                for (UINT element = 0; element < numElements; element++)
+                {
+                    const uint8_t* expected = reference.dirty[instance][element] ? &source[element * sourceStride] : &before[element * destinationStride];
+                    CHECK(memcmp(&destinations[instance][element * destinationStride], expected, c_elementSize) == 0);
+                    // The bytes between strided elements are not the tracker's to write.
+                    CHECK(memcmp(&destinations[instance][element * destinationStride + c_elementSize], &before[element * destinationStride + c_elementSize],
+                        destinationStride - c_elementSize) == 0);
+                    reference.dirty[instance][element] = false;
+                }
+            }
+            else if (op < 3)
+            {
+                UINT element = rng() % numElements;
+                writeElement(element);
+                tracker.MarkDirty(element);
+                reference.MarkDirty(element, 1);
+            }
+            else if (op < 5)
+            {
+                UINT first = rng() % numElements;
+                UINT count = rng() % (numElements - first + 1);
+                for (UINT element = first; element < first + count; element++)
+                {
+                    writeElement(element);
+                }
+                tracker.MarkDirty(first, count);
+                reference.MarkDirty(first, count);
+            }
+            else if (op == 5)
+            {
+                // Written but not marked: no copy may pick it up until it is marked.
+                writeElement(rng() % numElements);
+            }
+            else if (rng() % 8 == 0)
+            {
+                tracker.MarkAllDirty();
+                reference.MarkDirty(0, numElements);
+            }
+            CheckDirtyState(tracker, reference);
+        }
+
+        CHECK_EQUAL(expectedBytes, tracker.UploadedBytes());
+        CHECK_EQUAL(expectedRanges, tracker.UploadedRanges());
+        tracker.ResetUploadStatistics();
+        CHECK_EQUAL(0ull, tracker.UploadedBytes());
+        CHECK_EQUAL(0ull, tracker.UploadedRanges());
+    }
+
+    void TestDirtyElementTrackerPacked()
+    {
+        std::mt19937 rng(1);
+        for (UINT numElements : { 0u, 1u, 63u, 64u, 65u, 127u, 128u, 129u, 300u })
+        {
+            for (UINT numInstances : { 1u, 3u })
+            {
+                RunRandomMarksAndCopies(numElements, numInstances, c_elementSize, c_elementSize, rng);
+            }
+        }
+    }
+
+    void TestDirtyElementTrackerStrided()
+    {
+        std::mt19937 rng(2);
+        for (UINT numElements : { 1u, 64u, 65u, 200u })
+        {
+            // A padded source, a padded destination (as in a constant buffer array) and both.
+            RunRandomMarksAndCopies(numElements, 3, c_elementSize + 4, c_elementSize, rng);
+            RunRandomMarksAndCopies(numElements, 3, c_elementSize, 256, rng);
+            RunRandomMarksAndCopies(numElements, 2, 16, 32, rng);
+        }
+    }
+
+    void TestDirtyElementTrackerRanges()
+    {
+        DirtyElementTracker tracker;
+        tracker.Reset(130, 2);
+        std::vector<uint8_t> source(130 * 4, 1);
+        std::vector<uint8_t> destination(130 * 4, 0);
+        CHECK_EQUAL(130ull * 4, tracker.CopyDirty(0, source.data(), 4, destination.data(), 4, 4));
+        CHECK_EQUAL(1ull, tracker.UploadedRanges());
+
+        // Runs across a word boundary are one range; separate runs are one range each.
+        tracker.MarkDirty(60, 8);
+        tracker.MarkDirty(100);
+        tracker.MarkDirty(129);
+        CHECK_EQUAL(10u, tracker.NumDirtyElements(0));
+        CHECK_EQUAL(130u, tracker.NumDirtyElements(1));
+        CHECK_EQUAL(10ull * 4, tracker.CopyDirty(0, source.data(), 4, destination.data(), 4, 4));
+        CHECK_EQUAL(4ull, tracker.UploadedRanges());
+        CHECK_EQUAL(0u, tracker.NumDirtyElements(0));
+        CHECK_EQUAL(0ull, tracker.CopyDirty(0, source.data(), 4, destination.data(), 4, 4));
+    }
+}
+
+REGISTER_TEST("dirtytracker.packed", TestDirtyElementTrackerPacked);
+REGISTER_TEST("dirtytracker.strided", TestDirtyElementTrackerStrided);
+REGISTER_TEST("dirtytracker.ranges", TestDirtyElementTrackerRanges);
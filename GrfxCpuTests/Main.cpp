@@ -0,0 +1,113 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Test driver for the CPU raytracer and the test framework. Runs every test, or the named ones, and
+// returns non-zero if any of them failed.
+//
+// Usage: GrfxCpuTests [test]...
+//        GrfxCpuTests -list
+//        GrfxCpuTests -worker <name>   (started by the tests themselves)
+
+#include "Test.h"
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+std::vector<TestDesc>& GetTests()
+{
+    static std::vector<TestDesc> tests;
+    return tests;
+}
+
+std::vector<TestWorkerDesc>& GetTestWorkers()
+{
+    static std::vector<TestWorkerDesc> workers;
+    return workers;
+}
+
+static const char* s_testExecutable = nullptr;
+
+const char* GetTestExecutable()
+{
+    return s_testExecutable;
+}
+
+int main(int argc, char* argv[])
+{
+    s_testExecutable = argv[0];
+
+    if (argc == 3 && strcmp(argv[1], "-worker") == 0)
+    {
+        for (const TestWorkerDesc& desc : GetTestWorkers())
+        {
+            if (strcmp(desc.name, argv[2]) == 0)
+            {
+                return desc.func();
+            }
+        }
+        fprintf(stderr, "Unknown worker %s\n", argv[2]);
+        return 2;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "-list") == 0)
+    {
+        for (const TestDesc& desc : GetTests())
+        {
+            printf("%s\n", desc.name);
+        }
+        return 0;
+    }
+
+    std::vector<const TestDesc*> selected;
+    for (int i = 1; i < argc; i++)
+    {
+        const TestDesc* match = nullptr;
+        for (const TestDesc& desc : GetTests())
+        {
+            if (strcmp(desc.name, argv[i]) == 0)
+            {
+                match = &desc;
+            }
+        }
+        if (!match)
+        {
+            fprintf(stderr, "Unknown test %s\n", argv[i]);
+            return 2;
+        }
+        selected.push_back(match);
+    }
+    if (selected.empty())
+    {
+        for (const TestDesc& desc : GetTests())
+        {
+            selected.push_back(&desc);
+        }
+    }
+
+    UINT numFailed = 0;
+    for (const TestDesc* desc : selected)
+    {
+        try
+        {
+            desc->func();
+            printf("[pass] %s\n", desc->name);
+        }
+        catch (const std::exception& e)
+        {
+            printf("[FAIL] %s: %s\n", desc->name, e.what());
+            numFailed++;
+        }
+        fflush(stdout);
+    }
+
+    printf("%u tests, %u passed, %u failed\n", static_cast<UINT>(selected.size()), static_cast<UINT>(selected.size()) - numFailed, numFailed);
+    return numFailed ? 1 : 0;
+}
@@ -0,0 +1,345 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Shader table resolution for the layouts of the HelloWorld, SimpleLighting and ProceduralGeometry samples.
+// Each test builds the tables and instances the way the sample's BuildShaderTables() and acceleration
+// structures do, checks them with ValidateShaderTables() and resolves the record every TraceRay() call
+// reaches for each instance and geometry, comparing it with the hit group or miss shader the sample means.
+
+#include "Test.h"
+#include "CpuScene.h"
+#include "CpuShaderTable.h"
+
+using namespace CpuRT;
+
+namespace
+{
+    // Local root argument layouts of the samples (RaytracingHlslCompat.h and RaytracingSceneDefines.h).
+    struct CircleAABBConstantBuffer
+    {
+        float radius;
+        float center[3];
+        float color[4];
+    };
+
+    struct CubeConstantBuffer
+    {
+        float albedo[4];
+        float padding[4];
+    };
+
+    struct ProceduralAABBRootArguments
+    {
+        struct
+        {
+            float albedo[4];
+            float reflectanceCoef;
+            float diffuseCoef;
+            float specularCoef;
+            float specularPower;
+            float stepScale;
+            float padding[3];
+        } materialCb;
+        struct
+        {
+            UINT instanceIndex;
+            UINT primitiveType;
+        } aabbCB;
+    };
+
+    const UINT c_shaderIdentifierSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
+
+    // A scene with one triangle and one AABB geometry slot, and BLASes and instances as the descs give them.
+    class LayoutScene
+    {
+    public:
+        LayoutScene()
+        {
+            CpuTriangleGeometryDesc triangles = {};
+            triangles.vertexData = m_vertices;
+            triangles.vertexCount = 3;
+            triangles.vertexStrideInBytes = 3 * sizeof(float);
+            triangles.indexData = m_indices;
+            triangles.indexCount = 3;
+            triangles.indexFormat = CpuIndexFormat::R16_UINT;
+            m_scene.SetTriangleGeometry(0, triangles);
+            m_scene.SetAABBGeometry(0, { &m_aabb, 1, sizeof(D3D12_RAYTRACING_AABB) });
+        }
+
+        void AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE type, UINT numGeometries)
+        {
+            DxBlasDesc blasDesc;
+            blasDesc.geomType = type;
+            for (UINT i = 0; i < numGeometries; i++)
+            {
+                blasDesc.geomIndices.push_back(static_cast<int>(m_geomDescs.size()));
+                m_geomDescs.push_back({ 0, type, D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE });
+            }
+            m_blasDescs.push_back(blasDesc);
+        }
+
+        void AddInstance(UINT blasIndex, UINT instanceContributionToHitIndex)
+        {
+            DxTlasDesc tlasDesc;
+            tlasDesc.blasIndex = blasIndex;
+            tlasDesc.instanceContributionToHitIndex = instanceContributionToHitIndex;
+            GetTransform3x4Matrix(&tlasDesc.transformMatrix, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+            m_tlasDescs.push_back(tlasDesc);
+        }
+
+        const CpuScene& Build()
+        {
+            m_scene.Build(m_geomDescs, m_blasDescs, m_tlasDescs);
+            return m_scene;
+        }
+
+    private:
+        float m_vertices[9] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+        UINT16 m_indices[3] = { 0, 1, 2 };
+        D3D12_RAYTRACING_AABB m_aabb = { -1, -1, -1, 1, 1, 1 };
+        std::vector<GeomDesc> m_geomDescs;
+        std::vector<DxBlasDesc> m_blasDescs;
+        std::vector<DxTlasDesc> m_tlasDescs;
+        CpuScene m_scene;
+    };
+
+    void CheckValid(const CpuShaderTableBindings& bindings, const CpuScene& scene, const CpuShaderTableUsage& usage)
+    {
+        std::vector<std::string> errors = ValidateShaderTables(bindings, scene, usage);
+        CHECK_EQUAL(std::string(), errors.empty() ? std::string() : errors[0]);
+    }
+
+    void CheckHitGroup(const CpuShaderTableBindings& bindings, const CpuShaderTableUsage::TraceRayCall& call, UINT geometryIndex,
+        UINT instanceContribution, const char* expectedHitGroup)
+    {
+        UINT hitGroupIndex = ComputeHitGroupIndex(call.rayContributionToHitGroupIndex, call.multiplierForGeometryContributionToHitGroupIndex,
+            geometryIndex, instanceContribution);
+        CpuShaderRecord record;
+        CHECK(ResolveHitGroupRecord(bindings, hitGroupIndex, &record));
+        CHECK_EQUAL(hitGroupIndex, record.recordIndex);
+        CHECK(*record.shaderIdentifier == CpuShaderIdentifier::FromName(expectedHitGroup));
+    }
+
+    void CheckMiss(const CpuShaderTableBindings& bindings, const CpuShaderTableUsage::TraceRayCall& call, const char* expectedMissShader)
+    {
+        CpuShaderRecord record;
+        CHECK(ResolveMissRecord(bindings, call.missShaderIndex, &record));
+        CHECK(*record.shaderIdentifier == CpuShaderIdentifier::FromName(expectedMissShader));
+    }
+
+    // D3D12RaytracingHelloWorld: two triangle and two AABB instances, one hit group record each, one ray type.
+    void TestHelloWorldShaderTables()
+    {
+        LayoutScene layout;
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, 1);
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, 1);
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS, 1);
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS, 1);
+        for (UINT i = 0; i < 4; i++)
+        {
+            layout.AddInstance(i, i);
+        }
+        const CpuScene& scene = layout.Build();
+
+        struct RayGenConstantBuffer
+        {
+            float viewport[4];
+            float stencil[4];
+        } rayGenCB = {};
+        CpuShaderTable rayGenTable(1, c_shaderIdentifierSize + sizeof(rayGenCB), "RayGenShaderTable");
+        rayGenTable.push_back(CpuShaderIdentifier::FromName("MyRaygenShader"), &rayGenCB, sizeof(rayGenCB));
+
+        CpuShaderTable missTable(1, c_shaderIdentifierSize, "MissShaderTable");
+        missTable.push_back(CpuShaderIdentifier::FromName("MyMissShader"));
+
+        const char* hitGroups[] = { "MyHitGroup", "MyHitGroupRed", "MyHitGroup_AABB_1", "MyHitGroup_AABB_1" };
+        CircleAABBConstantBuffer circles[2] = { { 0.25f, { 0, 0, 0 }, { 1, 0, 0, 1 } }, { 0.5f, { 1, 0, 0 }, { 0, 1, 0, 1 } } };
+        UINT hitGroupStride = c_shaderIdentifierSize + sizeof(CircleAABBConstantBuffer);
+        CpuShaderTable hitGroupTable(4, hitGroupStride, "HitGroupShaderTable");
+        hitGroupTable.push_back(CpuShaderIdentifier::FromName(hitGroups[0]), nullptr, sizeof(CircleAABBConstantBuffer));
+        hitGroupTable.push_back(CpuShaderIdentifier::FromName(hitGroups[1]), nullptr, sizeof(CircleAABBConstantBuffer));
+        hitGroupTable.push_back(CpuShaderIdentifier::FromName(hitGroups[2]), &circles[0], sizeof(CircleAABBConstantBuffer));
+        hitGroupTable.push_back(CpuShaderIdentifier::FromName(hitGroups[3]), &circles[1], sizeof(CircleAABBConstantBuffer));
+
+        CpuShaderTableBindings bindings;
+        bindings.rayGenerationShaderRecord = CpuShaderTableRange(rayGenTable, 0);
+        bindings.missShaderTable = CpuShaderTableRange(missTable, missTable.GetSizeInBytes());
+        bindings.hitGroupTable = CpuShaderTableRange(hitGroupTable, hitGroupStride);
+
+        CpuShaderTableUsage usage;
+        usage.traceRayCalls = { { 0, 1, 0 } };
+        usage.rayGenerationLocalRootArgumentsSize = sizeof(RayGenConstantBuffer);
+        usage.hitGroupLocalRootArgumentsSize = sizeof(CircleAABBConstantBuffer);
+        CheckValid(bindings, scene, usage);
+
+        CpuShaderRecord record;
+        CHECK(ResolveRayGenerationRecord(bindings, &record));
+        CHECK(*record.shaderIdentifier == CpuShaderIdentifier::FromName("MyRaygenShader"));
+        CheckMiss(bindings, usage.traceRayCalls[0], "MyMissShader");
+        for (UINT instance = 0; instance < 4; instance++)
+        {
+            CheckHitGroup(bindings, usage.traceRayCalls[0], 0, instance, hitGroups[instance]);
+        }
+
+        // Each AABB instance reads its own circle through the stride.
+        CHECK(ResolveHitGroupRecord(bindings, 3, &record));
+        CHECK_EQUAL(0.5f, record.GetLocalRootArguments<CircleAABBConstantBuffer>().radius);
+        CHECK_EQUAL(3ull * hitGroupStride, record.byteOffset);
+    }
+
+    // D3D12RaytracingSimpleLighting: radiance and shadow hit groups interleaved per instance, two miss shaders.
+    void TestSimpleLightingShaderTables()
+    {
+        LayoutScene layout;
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, 1);
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, 1);
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS, 1);
+        layout.AddInstance(0, 0);
+        layout.AddInstance(1, 2);
+        layout.AddInstance(2, 4);
+        const CpuScene& scene = layout.Build();
+
+        CpuShaderTable rayGenTable(1, c_shaderIdentifierSize, "RayGenShaderTable");
+        rayGenTable.push_back(CpuShaderIdentifier::FromName("MyRaygenShader"));
+
+        CpuShaderTable missTable(2, c_shaderIdentifierSize, "MissShaderTable");
+        missTable.push_back(CpuShaderIdentifier::FromName("MyMissShader"));
+        missTable.push_back(CpuShaderIdentifier::FromName("MyMissShader_Shadow"));
+
+        const char* hitGroups[] = { "CubeHitGroup", "CubeShadowHitGroup", "FloorHitGroup", "FloorShadowHitGroup",
+                                    "SphereAABBHitGroup", "SphereShadowAABBHitGroup" };
+        CubeConstantBuffer cubeCB = { { 1, 0, 0, 1 }, {} };
+        UINT hitGroupStride = c_shaderIdentifierSize + sizeof(CubeConstantBuffer);
+        CpuShaderTable hitGroupTable(6, hitGroupStride, "HitGroupShaderTable");
+        for (UINT i = 0; i < 6; i++)
+        {
+            hitGroupTable.push_back(CpuShaderIdentifier::FromName(hitGroups[i]), (i % 2 == 0) ? &cubeCB : nullptr, sizeof(cubeCB));
+        }
+
+        CpuShaderTableUsage usage;
+        usage.traceRayCalls = { { 0, 1, 0 }, { 1, 0, 1 } };
+        usage.hitGroupLocalRootArgumentsSize = sizeof(CubeConstantBuffer);
+
+        CpuShaderTableBindings bindings;
+        bindings.rayGenerationShaderRecord = CpuShaderTableRange(rayGenTable, 0);
+        bindings.hitGroupTable = CpuShaderTableRange(hitGroupTable, hitGroupStride);
+
+        // The sample used to bind the miss table with its size as the stride, which puts the shadow miss
+        // record past the end of the table.
+        bindings.missShaderTable = CpuShaderTableRange(missTable, missTable.GetSizeInBytes());
+        CHECK(!ValidateShaderTables(bindings, scene, usage).empty());
+
+        bindings.missShaderTable = CpuShaderTableRange(missTable, missTable.GetShaderRecordSize());
+        CheckValid(bindings, scene, usage);
+        CheckMiss(bindings, usage.traceRayCalls[0], "MyMissShader");
+        CheckMiss(bindings, usage.traceRayCalls[1], "MyMissShader_Shadow");
+        for (UINT instance = 0; instance < 3; instance++)
+        {
+            const CpuInstance& cpuInstance = scene.GetInstance(instance);
+            CheckHitGroup(bindings, usage.traceRayCalls[0], 0, cpuInstance.instanceContributionToHitGroupIndex, hitGroups[2 * instance]);
+            CheckHitGroup(bindings, usage.traceRayCalls[1], 0, cpuInstance.instanceContributionToHitGroupIndex, hitGroups[2 * instance + 1]);
+        }
+    }
+
+    // D3D12RaytracingProceduralGeometry: a triangle plane and ten AABB geometries in one BLAS, each geometry with
+    // a radiance and a shadow record, addressed with a geometry multiplier of RayType::Count.
+    void TestProceduralGeometryShaderTables()
+    {
+        const UINT rayTypeCount = 2;
+        const UINT primitiveCounts[] = { 2, 1, 7 };    // Analytic, volumetric and signed distance primitives.
+        const UINT totalPrimitiveCount = 10;
+        const char* aabbHitGroups[][2] =
+        {
+            { "MyHitGroup_AABB_AnalyticPrimitive", "MyHitGroup_AABB_AnalyticPrimitive_ShadowRay" },
+            { "MyHitGroup_AABB_VolumetricPrimitive", "MyHitGroup_AABB_VolumetricPrimitive_ShadowRay" },
+            { "MyHitGroup_AABB_SignedDistancePrimitive", "MyHitGroup_AABB_SignedDistancePrimitive_ShadowRay" },
+        };
+        const char* triangleHitGroups[] = { "MyHitGroup_Triangle", "MyHitGroup_Triangle_ShadowRay" };
+
+        LayoutScene layout;
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES, 1);
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS, totalPrimitiveCount);
+        layout.AddInstance(0, 0);
+        layout.AddInstance(1, 1 * rayTypeCount);
+        const CpuScene& scene = layout.Build();
+
+        CpuShaderTable rayGenTable(1, c_shaderIdentifierSize, "RayGenShaderTable");
+        rayGenTable.push_back(CpuShaderIdentifier::FromName("MyRaygenShader"));
+
+        CpuShaderTable missTable(rayTypeCount, c_shaderIdentifierSize, "MissShaderTable");
+        missTable.push_back(CpuShaderIdentifier::FromName("MyMissShader"));
+        missTable.push_back(CpuShaderIdentifier::FromName("MyMissShader_ShadowRay"));
+
+        ProceduralAABBRootArguments rootArgs = {};
+        CpuShaderTable hitGroupTable(rayTypeCount + totalPrimitiveCount * rayTypeCount, c_shaderIdentifierSize + sizeof(rootArgs),
+            "HitGroupShaderTable");
+        for (const char* hitGroup : triangleHitGroups)
+        {
+            hitGroupTable.push_back(CpuShaderIdentifier::FromName(hitGroup), &rootArgs.materialCb, sizeof(rootArgs.materialCb));
+        }
+        for (UINT shaderType = 0, instanceIndex = 0; shaderType < 3; shaderType++)
+        {
+            for (UINT primitiveType = 0; primitiveType < primitiveCounts[shaderType]; primitiveType++, instanceIndex++)
+            {
+                rootArgs.aabbCB.instanceIndex = instanceIndex;
+                rootArgs.aabbCB.primitiveType = primitiveType;
+                for (UINT rayType = 0; rayType < rayTypeCount; rayType++)
+                {
+                    hitGroupTable.push_back(CpuShaderIdentifier::FromName(aabbHitGroups[shaderType][rayType]), &rootArgs, sizeof(rootArgs));
+                }
+            }
+        }
+
+        CpuShaderTableBindings bindings;
+        bindings.rayGenerationShaderRecord = CpuShaderTableRange(rayGenTable, 0);
+        bindings.missShaderTable = CpuShaderTableRange(missTable, missTable.GetShaderRecordSize());
+        bindings.hitGroupTable = CpuShaderTableRange(hitGroupTable, hitGroupTable.GetShaderRecordSize());
+
+        // TraceRayParameters: HitGroup::Offset is the ray type, GeometryStride RayType::Count, MissShader::Offset the ray type.
+        CpuShaderTableUsage usage;
+        usage.traceRayCalls = { { 0, rayTypeCount, 0 }, { 1, rayTypeCount, 1 } };
+        usage.hitGroupLocalRootArgumentsSize = sizeof(ProceduralAABBRootArguments);
+        CheckValid(bindings, scene, usage);
+
+        for (UINT rayType = 0; rayType < rayTypeCount; rayType++)
+        {
+            const CpuShaderTableUsage::TraceRayCall& call = usage.traceRayCalls[rayType];
+            CheckMiss(bindings, call, rayType == 0 ? "MyMissShader" : "MyMissShader_ShadowRay");
+            CheckHitGroup(bindings, call, 0, scene.GetInstance(0).instanceContributionToHitGroupIndex, triangleHitGroups[rayType]);
+
+            // Geometry i of the AABB BLAS is primitive i and must see its own instance index and primitive type.
+            for (UINT shaderType = 0, geometryIndex = 0; shaderType < 3; shaderType++)
+            {
+                for (UINT primitiveType = 0; primitiveType < primitiveCounts[shaderType]; primitiveType++, geometryIndex++)
+                {
+                    UINT instanceContribution = scene.GetInstance(1).instanceContributionToHitGroupIndex;
+                    CheckHitGroup(bindings, call, geometryIndex, instanceContribution, aabbHitGroups[shaderType][rayType]);
+
+                    CpuShaderRecord record;
+                    CHECK(ResolveHitGroupRecord(bindings, ComputeHitGroupIndex(call.rayContributionToHitGroupIndex,
+                        call.multiplierForGeometryContributionToHitGroupIndex, geometryIndex, instanceContribution), &record));
+                    const ProceduralAABBRootArguments& args = record.GetLocalRootArguments<ProceduralAABBRootArguments>();
+                    CHECK_EQUAL(geometryIndex, args.aabbCB.instanceIndex);
+                    CHECK_EQUAL(primitiveType, args.aabbCB.primitiveType);
+                }
+            }
+        }
+
+        // One geometry more than the table holds records for is caught.
+        layout.AddBlas(D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS, totalPrimitiveCount + 1);
+        layout.AddInstance(2, 1 * rayTypeCount);
+        CHECK(!ValidateShaderTables(bindings, layout.Build(), usage).empty());
+    }
+}
+
+REGISTER_TEST("shadertable.helloworld", TestHelloWorldShaderTables);
+REGISTER_TEST("shadertable.simplelighting", TestSimpleLightingShaderTables);
+REGISTER_TEST("shadertable.proceduralgeometry", TestProceduralGeometryShaderTables);
@@ -0,0 +1,128 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Bounds the difference between the over-relaxed sphere tracer and the same tracer evaluated with the rounding
+// of a compiler that contracts multiplies and adds into fused multiply-adds. Contraction changes the marched
+// position by at most about an ulp per component and each distance by a few ulps of its intermediate values,
+// so the perturbed run nudges every position component by one ulp and every distance by 4 * FLT_EPSILON, in
+// directions hashed from the position's bits, and compares the hits with the unperturbed run.
+
+#include "Test.h"
+#include "SignedDistancePrimitives.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace CpuRT;
+
+namespace
+{
+    struct SignedDistanceTestPrimitiveDesc
+    {
+        CpuSignedDistancePrimitive::Enum primitive;
+        float stepScale;            // As set up by the sample's UpdateAABBPrimitiveAttributes().
+    };
+
+    const SignedDistanceTestPrimitiveDesc c_primitives[] =
+    {
+        { CpuSignedDistancePrimitive::MiniSpheres, 1.0f },
+        { CpuSignedDistancePrimitive::IntersectedRoundCube, 1.0f },
+        { CpuSignedDistancePrimitive::SquareTorus, 1.0f },
+        { CpuSignedDistancePrimitive::TwistedTorus, 0.5f },
+        { CpuSignedDistancePrimitive::Cog, 1.0f },
+        { CpuSignedDistancePrimitive::Cylinder, 1.0f },
+        { CpuSignedDistancePrimitive::FractalPyramid, 0.8f },
+    };
+
+    const UINT c_raysPerAxis = 96;
+
+    // Largest share of rays whose hit/miss may flip and largest hit distance change, in AABB local space. No ray
+    // flips and hits move by up to 6.5e-4, a fraction of the hit threshold c_signedDistanceThreshold * t.
+    const double c_maxHitFlipRatio = 0.005;
+    const float c_maxHitDistanceDifference = 2e-3f;
+
+    uint32_t HashPosition(const float3& position)
+    {
+        uint32_t bits[3];
+        std::memcpy(bits, &position, sizeof(bits));
+        uint32_t hash = 2166136261u;
+        for (uint32_t b : bits)
+        {
+            hash = (hash ^ b) * 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    float NudgeUlp(float value, bool up)
+    {
+        return std::nextafter(value, up ? FLT_MAX : -FLT_MAX);
+    }
+
+    // Rays from outside the AABB through a grid on the plane z = 0, as a camera in front of the primitive sees it.
+    Ray GetTestRay(UINT x, UINT y)
+    {
+        const float3 eye(1.8f, 1.6f, -3.2f);
+        float3 target(2.2f * (x + 0.5f) / c_raysPerAxis - 1.1f, 2.2f * (y + 0.5f) / c_raysPerAxis - 1.1f, 0.0f);
+        return Ray(eye, normalize(target - eye), 0.0f, 100.0f);
+    }
+}
+
+static void SignedDistanceRelaxedContractionTest()
+{
+    for (const SignedDistanceTestPrimitiveDesc& desc : c_primitives)
+    {
+        auto distanceFunction = [&desc](const float3& p)
+        {
+            return GetDistanceFromSignedDistancePrimitive(p, desc.primitive);
+        };
+        auto contractedDistanceFunction = [&desc](const float3& p)
+        {
+            uint32_t hash = HashPosition(p);
+            float3 position(NudgeUlp(p.x, hash & 1), NudgeUlp(p.y, hash & 2), NudgeUlp(p.z, hash & 4));
+            float distance = GetDistanceFromSignedDistancePrimitive(position, desc.primitive);
+            return distance + (hash & 8 ? 4.0f : -4.0f) * FLT_EPSILON;
+        };
+
+        UINT hits = 0;
+        UINT hitFlips = 0;
+        float maxHitDistanceDifference = 0.0f;
+        for (UINT y = 0; y < c_raysPerAxis; y++)
+        {
+            for (UINT x = 0; x < c_raysPerAxis; x++)
+            {
+                Ray ray = GetTestRay(x, y);
+                float t = 0.0f, contractedT = 0.0f;
+                float3 normal, contractedNormal;
+                bool hit = RaySignedDistanceFunctionTestRelaxed(ray, RAY_FLAG_NONE, distanceFunction,
+                    &t, &normal, desc.stepScale, c_sphereTracingRelaxation, nullptr);
+                bool contractedHit = RaySignedDistanceFunctionTestRelaxed(ray, RAY_FLAG_NONE, contractedDistanceFunction,
+                    &contractedT, &contractedNormal, desc.stepScale, c_sphereTracingRelaxation, nullptr);
+
+                hits += hit;
+                if (hit != contractedHit)
+                {
+                    hitFlips++;
+                }
+                else if (hit)
+                {
+                    maxHitDistanceDifference = (std::max)(maxHitDistanceDifference, std::abs(t - contractedT));
+                }
+            }
+        }
+
+        CHECK(hits > 0);
+        CHECK(hitFlips <= c_maxHitFlipRatio * c_raysPerAxis * c_raysPerAxis);
+        CHECK(maxHitDistanceDifference <= c_maxHitDistanceDifference);
+    }
+}
+
+REGISTER_TEST("sdf.relaxedcontraction", SignedDistanceRelaxedContractionTest);
@@ -0,0 +1,103 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Minimal test registry. Each test lives in a translation unit of its area and registers itself with
+// REGISTER_TEST; a failed CHECK throws, which fails that test and lets Main.cpp run the others.
+
+#include "D3D12Compat.h"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef void (*TestFunc)();
+
+struct TestDesc
+{
+    const char* name;
+    TestFunc func;
+};
+
+std::vector<TestDesc>& GetTests();
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, TestFunc func)
+    {
+        GetTests().push_back({ name, func });
+    }
+};
+
+#define REGISTER_TEST(name, func) \
+    static TestRegistration s_registration_##func(name, func)
+
+// Tests that need a child process start this executable with "-worker <name>", which runs the worker
+// registered under that name instead of any test and exits with its return value.
+typedef int (*TestWorkerFunc)();
+
+struct TestWorkerDesc
+{
+    const char* name;
+    TestWorkerFunc func;
+};
+
+std::vector<TestWorkerDesc>& GetTestWorkers();
+
+struct TestWorkerRegistration
+{
+    TestWorkerRegistration(const char* name, TestWorkerFunc func)
+    {
+        GetTestWorkers().push_back({ name, func });
+    }
+};
+
+#define REGISTER_TEST_WORKER(name, func) \
+    static TestWorkerRegistration s_workerRegistration_##func(name, func)
+
+// argv[0] of the test executable, to start workers with.
+const char* GetTestExecutable();
+
+class TestFailure : public std::runtime_error
+{
+public:
+    TestFailure(const char* file, int line, const std::string& message) :
+        std::runtime_error(std::string(file) + "(" + std::to_string(line) + "): " + message)
+    {
+    }
+};
+
+#define CHECK(condition) \
+    do { if (!(condition)) throw TestFailure(__FILE__, __LINE__, "CHECK(" #condition ") failed"); } while (0)
+
+// Prints both values on failure, so they need an operator<<.
+#define CHECK_EQUAL(expected, actual) \
+    do \
+    { \
+        const auto& expectedValue = (expected); \
+        const auto& actualValue = (actual); \
+        if (!(expectedValue == actualValue)) \
+        { \
+            std::ostringstream stream; \
+            stream << "CHECK_EQUAL(" #expected ", " #actual ") failed: expected " << expectedValue << ", got " << actualValue; \
+            throw TestFailure(__FILE__, __LINE__, stream.str()); \
+        } \
+    } while (0)
+
+// Passes if the expression throws std::exception.
+#define CHECK_THROWS(expression) \
+    do \
+    { \
+        bool threw = false; \
+        try { expression; } catch (const std::exception&) { threw = true; } \
+        if (!threw) throw TestFailure(__FILE__, __LINE__, "CHECK_THROWS(" #expression ") did not throw"); \
+    } while (0)
@@ -0,0 +1,116 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// TestShardDriver over real worker processes: this executable started with -worker. The workers pass every
+// run except one that fails and two that end the worker, one with abort() and one with a non-zero exit.
+// The driver must report those two as crashed, start replacement workers for the runs queued behind them
+// and still hand on every result in run order.
+
+#include "Test.h"
+#include "TestShard.h"
+#include <cstdlib>
+
+namespace
+{
+    const UINT c_numRuns = 24;
+    const UINT c_failingRun = 5;
+    const UINT c_abortingRun = 9;
+    const UINT c_exitingRun = 17;
+
+    UINT64 ImageHash(UINT runIndex)
+    {
+        return 0x9E3779B97F4A7C15ull * (runIndex + 1);
+    }
+
+    int CrashingShardWorker()
+    {
+        TestShardWorker worker;
+        UINT runIndex;
+        while (worker.NextRun(&runIndex))
+        {
+            if (runIndex == c_abortingRun)
+            {
+#if defined(_WIN32)
+                // No abort message box or Windows Error Reporting, the test would wait on them.
+                _set_abort_behavior(0, _WRITE_ABORT_MSG | _CALL_REPORTFAULT);
+#endif
+                abort();
+            }
+            if (runIndex == c_exitingRun)
+            {
+                exit(3);
+            }
+
+            TestShardResult result = {};
+            result.runIndex = runIndex;
+            result.status = (runIndex == c_failingRun) ? TestShardStatus::Failed : TestShardStatus::Passed;
+            result.rendered = true;
+            result.imageHash = ImageHash(runIndex);
+            result.buildMs = 1.0f;
+            result.renderMs = 2.0f;
+            if (runIndex == c_failingRun)
+            {
+                result.message = "expected failure\n";
+            }
+            if (!worker.WriteResult(result))
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    void TestShardRunWithCrashingCases()
+    {
+        for (UINT numWorkers : { 1u, 3u })
+        {
+            TestShardDriver driver({ GetTestExecutable(), "-worker", "shard.crashing" }, numWorkers);
+            std::vector<TestShardResult> results;
+            TestShardStatistics statistics = driver.Run(c_numRuns, [&](const TestShardResult& result)
+            {
+                results.push_back(result);
+            });
+
+            CHECK_EQUAL(static_cast<size_t>(c_numRuns), results.size());
+            for (UINT i = 0; i < c_numRuns; i++)
+            {
+                const TestShardResult& result = results[i];
+                CHECK_EQUAL(i, result.runIndex);
+                if (i == c_abortingRun || i == c_exitingRun)
+                {
+                    CHECK_EQUAL(static_cast<int>(TestShardStatus::Crashed), static_cast<int>(result.status));
+                    CHECK(!result.rendered);
+                    CHECK(result.message.find("worker died") == 0);
+                }
+                else
+                {
+                    TestShardStatus::Enum expected = (i == c_failingRun) ? TestShardStatus::Failed : TestShardStatus::Passed;
+                    CHECK_EQUAL(static_cast<int>(expected), static_cast<int>(result.status));
+                    CHECK(result.rendered);
+                    CHECK_EQUAL(ImageHash(i), result.imageHash);
+                    CHECK_EQUAL(std::string(i == c_failingRun ? "expected failure\n" : ""), result.message);
+                }
+            }
+
+            CHECK_EQUAL(c_numRuns, statistics.runs);
+            CHECK_EQUAL(c_numRuns - 3, statistics.passed);
+            CHECK_EQUAL(1u, statistics.failed);
+            CHECK_EQUAL(2u, statistics.crashed);
+            CHECK_EQUAL(0u, statistics.cached);
+            // Each crash takes a worker, and the suite continues on a new one.
+            CHECK_EQUAL(numWorkers + 2, statistics.workers);
+            CHECK_EQUAL(3.0 * (c_numRuns - 2), statistics.workerMs);
+        }
+    }
+}
+
+REGISTER_TEST_WORKER("shard.crashing", CrashingShardWorker);
+REGISTER_TEST("shard.crashingcases", TestShardRunWithCrashingCases);
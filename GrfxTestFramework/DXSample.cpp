@@ -12,6 +12,7 @@
 #include "pch.h"
 #include "DXSample.h"
 #include "DirectXRaytracingHelper.h"
+#include <fstream>
 
 using namespace Microsoft::WRL;
 using namespace std;
@@ -25,6 +26,8 @@ DXSample::DXSample(UINT width, UINT height, std::wstring name) :
     m_aspectRatio(0.0f),
     m_enableUI(true),
     m_dumpOutput(false),
+    m_batchRun(false),
+    m_batchTestCase(nullptr),
     m_numFrames(1),
     m_adapterIDoverride(UINT_MAX),
     m_descriptorsAllocated(0),
@@ -344,8 +347,82 @@ void DXSample::ParseCommandLineArgs(WCHAR* argv[], int argc)
         {
             m_dumpOutput = true;
         }
+        else if (CheckCommandLineArg(argv[i], L"-batch"))
+        {
+            m_batchRun = true;
+        }
+        // -testcases before -testcase, which is a prefix of it.
+        else if (CheckCommandLineArg(argv[i], L"-testcases"))
+        {
+            ThrowIfFalse(i + 1 < argc, L"Incorrect argument format passed in.");
+
+            m_testCasesPath = argv[i + 1];
+            i++;
+        }
+        else if (CheckCommandLineArg(argv[i], L"-testcase"))
+        {
+            ThrowIfFalse(i + 1 < argc, L"Incorrect argument format passed in.");
+
+            m_testCaseName = argv[i + 1];
+            i++;
+        }
+    }
+
+}
+
+std::vector<TestCaseDescs> DXSample::ReadTestCasesFile()
+{
+    std::ifstream file(m_testCasesPath, std::ios::binary);
+    ThrowIfFalse(file.is_open(), L"Cannot open the -testcases file.");
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!IsTestSuiteBinary(text.data(), text.size()))
+    {
+        return ParseTestCasesXml(text, "testcases.xml");
     }
 
+    // A binary suite's arrays are read in place, so copy it to 8 byte aligned memory first.
+    std::vector<UINT64> blob((text.size() + sizeof(UINT64) - 1) / sizeof(UINT64));
+    memcpy(blob.data(), text.data(), text.size());
+    TestSuiteView suite;
+    suite.OpenMemory(blob.data(), text.size(), "testcases");
+    std::vector<TestCaseDescs> testCases(suite.GetTestCaseCount());
+    for (UINT i = 0; i < suite.GetTestCaseCount(); i++)
+    {
+        suite.GetTestCase(i).ToDescs(&testCases[i]);
+    }
+    return testCases;
+}
+
+void DXSample::SwapTestCase(const TestCaseDescs& descs)
+{
+    UNREFERENCED_PARAMETER(descs);
+    ThrowIfFalse(false, L"This sample does not support batch runs.");
+}
+
+bool DXSample::LoadTestCaseDescs(TestCaseDescs* descs)
+{
+    if (m_batchTestCase)
+    {
+        *descs = *m_batchTestCase;
+        return true;
+    }
+    if (m_testCasesPath.empty())
+    {
+        return false;
+    }
+
+    std::vector<TestCaseDescs> testCases = ReadTestCasesFile();
+    std::string name(m_testCaseName.begin(), m_testCaseName.end());
+    for (TestCaseDescs& testCase : testCases)
+    {
+        if (name.empty() || testCase.name == name)
+        {
+            *descs = std::move(testCase);
+            return true;
+        }
+    }
+    ThrowIfFalse(false, L"No <testcase> with the -testcase name.");
+    return false;
 }
 
 void DXSample::SetWindowBounds(int left, int top, int right, int bottom)
@@ -15,36 +15,11 @@
 #include "DXSampleHelper.h"
 #include "Win32Application.h"
 #include "DeviceResources.h"
+#include "TestCaseDesc.h"
+#include "TestSuiteBinary.h"
 
 using namespace DirectX;
 
-enum ModelGeometry
-{
-    TriangleModel,
-    SquareModel,
-    AABBModel
-};
-
-struct GeomDesc
-{
-    int geomIndex;
-    D3D12_RAYTRACING_GEOMETRY_TYPE geomType;
-    D3D12_RAYTRACING_GEOMETRY_FLAGS flags;
-};
-
-struct DxBlasDesc
-{
-    std::vector<int> geomIndices;
-    D3D12_RAYTRACING_GEOMETRY_TYPE geomType;
-};
-
-struct DxTlasDesc
-{
-    UINT blasIndex;
-    UINT instanceContributionToHitIndex;
-    DirectX::XMFLOAT3X4 transformMatrix;
-};
-
 class DXSample : public DX::IDeviceNotify
 {
 public:
@@ -76,6 +51,13 @@ public:
     // Overridable members.
     virtual void ParseCommandLineArgs(_In_reads_(argc) WCHAR* argv[], int argc);
 
+    // Batch runs (-batch): replaces the current test case with descs, keeping the device and pipeline state.
+    // Samples that support batch runs override it.
+    virtual void SwapTestCase(const TestCaseDescs& descs);
+    bool IsBatchRun() const { return m_batchRun; }
+    // Every test case of the -testcases file, a testcases.xml file or a binary suite.
+    std::vector<TestCaseDescs> ReadTestCasesFile();
+
     // Accessors.
     UINT GetWidth() const { return m_width; }
     UINT GetHeight() const { return m_height; }
@@ -103,6 +85,10 @@ protected:
         float transformX,
         float transformY,
         float transformZ);
+    // Loads the test case SwapTestCase() is swapping in, or else the <testcase> given with -testcase (or the
+    // first one) from the -testcases file. Returns false without either, in which case the sample uses the descs
+    // it hard-codes.
+    bool LoadTestCaseDescs(TestCaseDescs* descs);
     // Viewport dimensions.
     UINT m_width;
     UINT m_height;
@@ -115,6 +101,10 @@ protected:
     bool m_enableUI;
     UINT m_numFrames;
     bool m_dumpOutput;
+    std::wstring m_testCasesPath;
+    std::wstring m_testCaseName;
+    bool m_batchRun;
+    const TestCaseDescs* m_batchTestCase;
     // D3D device resources
     UINT m_adapterIDoverride;
     std::unique_ptr<DX::DeviceResources> m_deviceResources;
@@ -0,0 +1,49 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "DXSample.h"
+#include "TestBatch.h"
+
+// Runs a batch on a DXSample. The sample's OnInit() creates the device together with its root signatures and
+// raytracing state object, so CreatePipeline() has nothing left to do; SwapTestCase() replaces only the scene.
+class DXSampleBatchBackend : public TestBatchBackend
+{
+public:
+    explicit DXSampleBatchBackend(DXSample* sample) : m_sample(sample) {}
+
+    void CreateDevice() override { m_sample->OnInit(); }
+    void CreatePipeline() override {}
+    void LoadTestCase(const TestCaseDescs& descs) override { m_sample->SwapTestCase(descs); }
+
+    // The image is not read back, so there is no hash to report.
+    UINT64 Render() override
+    {
+        m_sample->OnUpdate();
+        m_sample->OnRender();
+        m_sample->GetDeviceResources()->WaitForGpu();
+        return 0;
+    }
+
+    void ReleaseTestCase() override {}
+
+    bool IsDeviceLost() const override
+    {
+        ID3D12Device* device = m_sample->GetDeviceResources() ? m_sample->GetDeviceResources()->GetD3DDevice() : nullptr;
+        return !device || device->GetDeviceRemovedReason() != S_OK;
+    }
+
+    void DestroyDevice() override { m_sample->OnDestroy(); }
+
+private:
+    DXSample* m_sample;
+};
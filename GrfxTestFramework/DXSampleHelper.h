@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include "DirtyElementTracker.h"
+
 // Note that while ComPtr is used to manage the lifetime of resources on the CPU,
 // it has no understanding of the lifetime of resources on the GPU. Apps must account
 // for the GPU lifetime of resources to avoid destroying objects that may still be
@@ -266,15 +268,17 @@ struct D3DBuffer
 // Usage: 
 //    ConstantBuffer<...> cb;
 //    cb.Create(...);
-//    cb.staging.var = ... ; | cb->var = ... ; 
+//    cb.staging.var = ... ; cb.MarkDirty(); | cb->var = ... ; 
 //    cb.CopyStagingToGPU(...);
 //    Set...View(..., cb.GputVirtualAddress());
+// CopyStagingToGpu() only writes instances whose copy is older than staging.
 template <class T>
 class ConstantBuffer : public GpuUploadBuffer
 {
     uint8_t* m_mappedConstantData;
     UINT m_alignedInstanceSize;
     UINT m_numInstances;
+    DirtyElementTracker m_dirtyElements;
 
 public:
     ConstantBuffer() : m_alignedInstanceSize(0), m_numInstances(0), m_mappedConstantData(nullptr) {}
@@ -286,17 +290,24 @@ public:
         UINT bufferSize = numInstances * m_alignedInstanceSize;
         Allocate(device, bufferSize, resourceName);
         m_mappedConstantData = MapCpuWriteOnly();
+        m_dirtyElements.Reset(1, numInstances);
     }
 
     void CopyStagingToGpu(UINT instanceIndex = 0)
     {
-        memcpy(m_mappedConstantData + instanceIndex * m_alignedInstanceSize, &staging, sizeof(T));
+        m_dirtyElements.CopyDirty(instanceIndex, &staging, sizeof(T), m_mappedConstantData + instanceIndex * m_alignedInstanceSize, sizeof(T), sizeof(T));
     }
 
+    // Required after writing staging directly; operator-> marks it.
+    void MarkDirty() { m_dirtyElements.MarkAllDirty(); }
+
     // Accessors
     T staging;
-    T* operator->() { return &staging; }
+    T* operator->() { m_dirtyElements.MarkAllDirty(); return &staging; }
+    const T* operator->() const { return &staging; }
     UINT NumInstances() { return m_numInstances; }
+    const DirtyElementTracker& DirtyElements() const { return m_dirtyElements; }
+    void ResetUploadStatistics() { m_dirtyElements.ResetUploadStatistics(); }
     D3D12_GPU_VIRTUAL_ADDRESS GpuVirtualAddress(UINT instanceIndex = 0)
     {
         return m_resource->GetGPUVirtualAddress() + instanceIndex * m_alignedInstanceSize;
@@ -311,12 +322,15 @@ public:
 //    sb[index].var = ... ; 
 //    sb.CopyStagingToGPU(...);
 //    Set...View(..., sb.GputVirtualAddress());
+// Non-const operator[] marks the element dirty and CopyStagingToGpu() writes only the dirty elements of
+// the instance, so elements that stay the same from frame to frame are not uploaded again.
 template <class T>
 class StructuredBuffer : public GpuUploadBuffer
 {
     T* m_mappedBuffers;
     std::vector<T> m_staging;
     UINT m_numInstances;
+    DirtyElementTracker m_dirtyElements;
 
 public:
     // Performance tip: Align structures on sizeof(float4) boundary.
@@ -331,18 +345,25 @@ public:
         UINT bufferSize = numInstances * numElements * sizeof(T);
         Allocate(device, bufferSize, resourceName);
         m_mappedBuffers = reinterpret_cast<T*>(MapCpuWriteOnly());
+        m_dirtyElements.Reset(numElements, numInstances);
     }
 
     void CopyStagingToGpu(UINT instanceIndex = 0)
     {
-        memcpy(m_mappedBuffers + instanceIndex * NumElementsPerInstance(), &m_staging[0], InstanceSize());
+        m_dirtyElements.CopyDirty(instanceIndex, &m_staging[0], sizeof(T), m_mappedBuffers + instanceIndex * NumElementsPerInstance(), sizeof(T), sizeof(T));
     }
 
+    void MarkDirty(UINT elementIndex) { m_dirtyElements.MarkDirty(elementIndex); }
+    void MarkDirty(UINT firstElement, UINT numElements) { m_dirtyElements.MarkDirty(firstElement, numElements); }
+
     // Accessors
-    T& operator[](UINT elementIndex) { return m_staging[elementIndex]; }
+    T& operator[](UINT elementIndex) { m_dirtyElements.MarkDirty(elementIndex); return m_staging[elementIndex]; }
+    const T& operator[](UINT elementIndex) const { return m_staging[elementIndex]; }
     size_t NumElementsPerInstance() { return m_staging.size(); }
     UINT NumInstances() { return m_staging.size(); }
     size_t InstanceSize() { return NumElementsPerInstance() * sizeof(T); }
+    const DirtyElementTracker& DirtyElements() const { return m_dirtyElements; }
+    void ResetUploadStatistics() { m_dirtyElements.ResetUploadStatistics(); }
     D3D12_GPU_VIRTUAL_ADDRESS GpuVirtualAddress(UINT instanceIndex = 0)
     {
         return m_resource->GetGPUVirtualAddress() + instanceIndex * InstanceSize();
@@ -0,0 +1,187 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Dirty element tracking for the staging arrays of ConstantBuffer and StructuredBuffer.
+//
+// An upload buffer holds one copy of the staging array per frame (instance). Marking an element dirty
+// marks it in every instance, since each frame's copy has to catch up once; CopyDirty() writes the dirty
+// elements of one instance, a run of adjacent elements at a time, and clears them. The tracker only
+// deals with memory pointers, so it works the same on a mapped upload heap and on a plain array.
+
+#include "D3D12Compat.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class DirtyElementTracker
+{
+public:
+    DirtyElementTracker() : m_numElements(0), m_numInstances(0), m_wordsPerInstance(0), m_uploadedBytes(0), m_uploadedRanges(0) {}
+
+    // Starts with every element of every instance dirty, as nothing has been uploaded yet.
+    void Reset(UINT numElements, UINT numInstances)
+    {
+        m_numElements = numElements;
+        m_numInstances = numInstances;
+        m_wordsPerInstance = (numElements + 63) / 64;
+        m_dirtyBits.assign(static_cast<size_t>(m_wordsPerInstance) * numInstances, 0);
+        MarkAllDirty();
+        ResetUploadStatistics();
+    }
+
+    void MarkDirty(UINT elementIndex)
+    {
+        UINT64 bit = 1ull << (elementIndex % 64);
+        for (UINT instance = 0; instance < m_numInstances; instance++)
+        {
+            m_dirtyBits[static_cast<size_t>(instance) * m_wordsPerInstance + elementIndex / 64] |= bit;
+        }
+    }
+
+    // Marks elements [firstElement, firstElement + numElements).
+    void MarkDirty(UINT firstElement, UINT numElements)
+    {
+        UINT end = firstElement + numElements;
+        for (UINT element = firstElement; element < end;)
+        {
+            UINT word = element / 64;
+            UINT wordEnd = (std::min)(end, (word + 1) * 64);
+            UINT64 bits = ~0ull << (element % 64);
+            if (wordEnd % 64)
+            {
+                bits &= ~(~0ull << (wordEnd % 64));
+            }
+            for (UINT instance = 0; instance < m_numInstances; instance++)
+            {
+                m_dirtyBits[static_cast<size_t>(instance) * m_wordsPerInstance + word] |= bits;
+            }
+            element = wordEnd;
+        }
+    }
+
+    void MarkAllDirty() { MarkDirty(0, m_numElements); }
+
+    bool IsDirty(UINT instanceIndex, UINT elementIndex) const
+    {
+        return (m_dirtyBits[static_cast<size_t>(instanceIndex) * m_wordsPerInstance + elementIndex / 64] >> (elementIndex % 64)) & 1;
+    }
+
+    UINT NumDirtyElements(UINT instanceIndex) const
+    {
+        UINT count = 0;
+        const UINT64* words = &m_dirtyBits[static_cast<size_t>(instanceIndex) * m_wordsPerInstance];
+        for (UINT word = 0; word < m_wordsPerInstance; word++)
+        {
+            for (UINT64 bits = words[word]; bits; bits &= bits - 1)
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // Copies the dirty elements of instanceIndex from source to destination and marks them clean.
+    // Element i lives at source + i * sourceStride and destination + i * destinationStride; adjacent dirty
+    // elements are copied with one memcpy when both strides equal elementSize. Returns the bytes written.
+    UINT64 CopyDirty(UINT instanceIndex, const void* source, size_t sourceStride, void* destination, size_t destinationStride, size_t elementSize)
+    {
+        if (m_numElements == 0)
+        {
+            return 0;
+        }
+
+        UINT64* words = &m_dirtyBits[static_cast<size_t>(instanceIndex) * m_wordsPerInstance];
+        const bool packed = sourceStride == elementSize && destinationStride == elementSize;
+        const uint8_t* src = static_cast<const uint8_t*>(source);
+        uint8_t* dst = static_cast<uint8_t*>(destination);
+        UINT64 bytes = 0;
+        UINT ranges = 0;
+
+        UINT begin = FindNext(words, 0, false);
+        while (begin < m_numElements)
+        {
+            UINT end = FindNext(words, begin, true);
+            if (packed)
+            {
+                memcpy(dst + begin * elementSize, src + begin * elementSize, (end - begin) * elementSize);
+            }
+            else
+            {
+                for (UINT element = begin; element < end; element++)
+                {
+                    memcpy(dst + element * destinationStride, src + element * sourceStride, elementSize);
+                }
+            }
+            bytes += static_cast<UINT64>(end - begin) * elementSize;
+            ranges++;
+            begin = (end < m_numElements) ? FindNext(words, end, false) : m_numElements;
+        }
+        memset(words, 0, m_wordsPerInstance * sizeof(UINT64));
+
+        m_uploadedBytes += bytes;
+        m_uploadedRanges += ranges;
+        return bytes;
+    }
+
+    // Totals of CopyDirty() since Reset() or ResetUploadStatistics(), e.g. reset once per frame.
+    UINT64 UploadedBytes() const { return m_uploadedBytes; }
+    UINT64 UploadedRanges() const { return m_uploadedRanges; }
+    void ResetUploadStatistics()
+    {
+        m_uploadedBytes = 0;
+        m_uploadedRanges = 0;
+    }
+
+    UINT NumElements() const { return m_numElements; }
+    UINT NumInstances() const { return m_numInstances; }
+
+private:
+    static UINT CountTrailingZeros(UINT64 bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<UINT>(index);
+#else
+        return static_cast<UINT>(__builtin_ctzll(bits));
+#endif
+    }
+
+    // The first dirty (or, if clean is set, clean) element at or after element, or m_numElements if none.
+    UINT FindNext(const UINT64* words, UINT element, bool clean) const
+    {
+        UINT word = element / 64;
+        UINT64 bits = (clean ? ~words[word] : words[word]) & (~0ull << (element % 64));
+        while (bits == 0)
+        {
+            if (++word == m_wordsPerInstance)
+            {
+                return m_numElements;
+            }
+            bits = clean ? ~words[word] : words[word];
+        }
+        return (std::min)(word * 64 + CountTrailingZeros(bits), m_numElements);
+    }
+
+    std::vector<UINT64> m_dirtyBits;    // m_wordsPerInstance words per instance, one bit per element.
+    UINT m_numElements;
+    UINT m_numInstances;
+    UINT m_wordsPerInstance;
+    UINT64 m_uploadedBytes;
+    UINT64 m_uploadedRanges;
+};
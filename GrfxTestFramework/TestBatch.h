@@ -0,0 +1,224 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Batch runs: many test cases in one process, on one device and one pipeline.
+//
+// TestBatchRunner creates the backend's device and pipeline once, then for each test case only loads its scene
+// (geometry, acceleration structures and shader tables), renders it and releases it. A test case that throws
+// fails on its own; if the backend then reports its device lost, the device and pipeline are recreated for the
+// next test case, up to a limit after which the remaining test cases are skipped. The runner only deals with the
+// backend interface, so the same bookkeeping drives the D3D12 samples and, on any platform, the CPU backends.
+
+#include "TestCaseXml.h"
+#include <chrono>
+#include <functional>
+
+// What a batch runs on. Every call may throw to fail the current test case.
+class TestBatchBackend
+{
+public:
+    virtual ~TestBatchBackend() {}
+
+    virtual void CreateDevice() = 0;
+    // Root signatures, state objects and anything else shared by all test cases.
+    virtual void CreatePipeline() = 0;
+    virtual void LoadTestCase(const TestCaseDescs& descs) = 0;
+    // Returns the image hash, or 0 if the backend does not read the image back.
+    virtual UINT64 Render() = 0;
+    virtual void ReleaseTestCase() = 0;
+    virtual bool IsDeviceLost() const { return false; }
+    virtual void DestroyDevice() = 0;
+};
+
+struct TestBatchResult
+{
+    UINT index;             // Of the test case in the batch.
+    std::string name;
+    bool passed;
+    bool skipped;           // Not run, after too many device losses.
+    UINT64 imageHash;
+    double loadMs;          // LoadTestCase().
+    double renderMs;
+    std::string error;
+};
+
+struct TestBatchStatistics
+{
+    UINT testCases;
+    UINT failures;
+    UINT skipped;
+    UINT deviceCreations;
+    UINT pipelineCreations;
+    UINT deviceLosses;
+    double setupMs;         // Creating devices and pipelines.
+    double loadMs;
+    double renderMs;
+    double totalMs;
+};
+
+class TestBatchRunner
+{
+public:
+    // Fills descs with test case index of the batch.
+    typedef std::function<void(UINT index, TestCaseDescs* descs)> TestCaseSource;
+    typedef std::function<void(const TestBatchResult& result)> ResultCallback;
+
+    explicit TestBatchRunner(TestBatchBackend* backend, UINT maxDeviceLosses = 3) :
+        m_backend(backend),
+        m_maxDeviceLosses(maxDeviceLosses),
+        m_hasDevice(false),
+        m_hasPipeline(false)
+    {}
+
+    ~TestBatchRunner()
+    {
+        try
+        {
+            ReleaseDevice();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    // Runs numTestCases test cases in order and reports each one to onResult as soon as it is done. The device
+    // stays alive for the next Run().
+    TestBatchStatistics Run(UINT numTestCases, const TestCaseSource& getTestCase, const ResultCallback& onResult)
+    {
+        TestBatchStatistics statistics = {};
+        const auto start = Clock::now();
+        TestCaseDescs descs;
+
+        for (UINT index = 0; index < numTestCases; index++)
+        {
+            TestBatchResult result = {};
+            result.index = index;
+            getTestCase(index, &descs);
+            result.name = descs.name;
+
+            if (statistics.deviceLosses > m_maxDeviceLosses)
+            {
+                result.skipped = true;
+                result.error = "skipped after " + std::to_string(statistics.deviceLosses) + " device losses";
+            }
+            else
+            {
+                RunTestCase(descs, &result, &statistics);
+            }
+
+            statistics.testCases++;
+            statistics.failures += !result.passed && !result.skipped;
+            statistics.skipped += result.skipped;
+            statistics.loadMs += result.loadMs;
+            statistics.renderMs += result.renderMs;
+            onResult(result);
+        }
+
+        statistics.totalMs = ElapsedMs(start);
+        return statistics;
+    }
+
+    TestBatchStatistics Run(const std::vector<TestCaseDescs>& testCases, const ResultCallback& onResult)
+    {
+        return Run(static_cast<UINT>(testCases.size()), [&](UINT index, TestCaseDescs* descs) { *descs = testCases[index]; }, onResult);
+    }
+
+    void ReleaseDevice()
+    {
+        if (m_hasDevice)
+        {
+            m_hasDevice = false;
+            m_hasPipeline = false;
+            m_backend->DestroyDevice();
+        }
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    static double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void RunTestCase(const TestCaseDescs& descs, TestBatchResult* result, TestBatchStatistics* statistics)
+    {
+        bool loaded = false;
+        try
+        {
+            auto start = Clock::now();
+            if (!m_hasDevice)
+            {
+                statistics->deviceCreations++;
+                m_backend->CreateDevice();
+                m_hasDevice = true;
+            }
+            if (!m_hasPipeline)
+            {
+                statistics->pipelineCreations++;
+                m_backend->CreatePipeline();
+                m_hasPipeline = true;
+            }
+            statistics->setupMs += ElapsedMs(start);
+
+            start = Clock::now();
+            loaded = true;
+            m_backend->LoadTestCase(descs);
+            result->loadMs = ElapsedMs(start);
+
+            start = Clock::now();
+            result->imageHash = m_backend->Render();
+            result->renderMs = ElapsedMs(start);
+            result->passed = true;
+        }
+        catch (const std::exception& e)
+        {
+            result->error = e.what();
+        }
+
+        if (loaded)
+        {
+            try
+            {
+                m_backend->ReleaseTestCase();
+            }
+            catch (const std::exception& e)
+            {
+                result->passed = false;
+                result->error += (result->error.empty() ? "" : "; ") + std::string(e.what());
+            }
+        }
+
+        // A device that failed to come up counts as lost, so a broken device does not fail every test case.
+        if ((m_hasDevice && m_backend->IsDeviceLost()) || (!result->passed && !m_hasPipeline))
+        {
+            statistics->deviceLosses++;
+            result->passed = false;
+            result->error += (result->error.empty() ? "" : "; ") + std::string("device lost");
+            try
+            {
+                ReleaseDevice();
+            }
+            catch (const std::exception&)
+            {
+            }
+            m_hasDevice = false;
+            m_hasPipeline = false;
+        }
+    }
+
+    TestBatchBackend* m_backend;
+    UINT m_maxDeviceLosses;
+    bool m_hasDevice;
+    bool m_hasPipeline;
+};
@@ -0,0 +1,71 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Test case descriptors shared by the D3D12 samples and the portable CPU raytracer.
+// Kept free of D3D12 objects so they can be consumed on hosts without a GPU.
+
+#include "D3D12Compat.h"
+#include <vector>
+
+enum ModelGeometry
+{
+    TriangleModel,
+    SquareModel,
+    AABBModel
+};
+
+struct GeomDesc
+{
+    int geomIndex;
+    D3D12_RAYTRACING_GEOMETRY_TYPE geomType;
+    D3D12_RAYTRACING_GEOMETRY_FLAGS flags;
+};
+
+struct DxBlasDesc
+{
+    std::vector<int> geomIndices;
+    D3D12_RAYTRACING_GEOMETRY_TYPE geomType;
+};
+
+struct DxTlasDesc
+{
+    UINT blasIndex;
+    UINT instanceContributionToHitIndex;
+    DirectX::XMFLOAT3X4 transformMatrix;
+};
+
+// Builds the scale * translation instance transform the samples use for DxTlasDesc::transformMatrix.
+// Matches DXSample::GetTransform3x4Matrix without requiring DirectXMath.
+inline void GetTransform3x4Matrix(DirectX::XMFLOAT3X4* transformMatrix,
+    float scaleX,
+    float scaleY,
+    float scaleZ,
+    float transformX,
+    float transformY,
+    float transformZ)
+{
+    const float rows[3][4] =
+    {
+        { scaleX, 0.0f, 0.0f, transformX },
+        { 0.0f, scaleY, 0.0f, transformY },
+        { 0.0f, 0.0f, scaleZ, transformZ }
+    };
+
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            transformMatrix->m[r][c] = rows[r][c];
+        }
+    }
+}
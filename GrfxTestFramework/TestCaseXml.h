@@ -0,0 +1,742 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Loader for testcases.xml files: each <testcase> element describes the geometry, BLAS and TLAS descs that a
+// sample's CreateTestCase() otherwise hard-codes.
+//
+// <testcase>
+//   <name>Simple Triangle</name>
+//   <geometry>                          One GeomDesc per element, in order.
+//     <name>triangle</name>             Optional, geometry1, geometry2, ... by default.
+//     <model>tri</model>                tri, square or aabb.
+//     <index>0</index>                  Optional buffer index: 0 for tri and aabb, 1 for square by default.
+//     <type>d3d12_tri</type>            Optional, d3d12_tri or d3d12_aabb: by default that of the model.
+//     <flags>opaque</flags>             Optional, opaque (default), none or no_duplicate_anyhit.
+//   </geometry>
+//   <blas>                              One DxBlasDesc per element, in order.
+//     <name>blas1</name>                Optional, blas1, blas2, ... by default.
+//     <geoptr>triangle</geoptr>         One or more geometry names.
+//     <type>d3d12_tri</type>            Optional, by default the type of the first geometry.
+//   </blas>
+//   <tlas>                              One DxTlasDesc per element, in order.
+//     <instanceDesc>                    Optional <scale> or <scaleX/Y/Z> (1) and <translateX/Y/Z> (0).
+//       <scale>1.0f</scale>
+//     </instanceDesc>
+//     <blasptr>blas1</blasptr>          BLAS name.
+//     <hitIndexContribution>0</hitIndexContribution>
+//   </tlas>
+// </testcase>
+//
+// Test cases may be top-level elements or the children of a root element. Names are resolved per test case and
+// may refer to elements further down. The parser reads the text in place, without building a document, and
+// resolves names through hash tables it keeps across test cases, so it allocates little beyond the descs
+// themselves. Malformed input throws std::runtime_error with the line it was found on.
+
+#include "TestCaseDesc.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The descs of one <testcase>.
+struct TestCaseDescs
+{
+    std::string name;
+    std::vector<ModelGeometry> models;      // <model> of each geometry desc.
+    std::vector<GeomDesc> geomDescs;
+    std::vector<DxBlasDesc> blasDescs;
+    std::vector<DxTlasDesc> tlasDescs;
+};
+
+class TestCaseXmlParser
+{
+public:
+    TestCaseXmlParser() : m_text(nullptr), m_cursor(nullptr), m_end(nullptr), m_sourceName(nullptr),
+        m_geometryNames("geometry"), m_blasNames("blas") {}
+
+    // Parses text[0, length), which must be followed by a null character as in a std::string, and appends its
+    // test cases to testCases. sourceName prefixes error messages.
+    void Parse(const char* text, size_t length, const char* sourceName, std::vector<TestCaseDescs>* testCases)
+    {
+        m_text = text;
+        m_cursor = text;
+        m_end = text + length;
+        m_sourceName = sourceName;
+
+        XmlString element;
+        bool empty;
+        while (SkipMarkup(), m_cursor < m_end)
+        {
+            if (!ReadStartTag(&element, &empty))
+            {
+                Error(m_cursor, "unexpected end tag");
+            }
+            if (element == "testcase")
+            {
+                ParseTestCase(empty, testCases);
+            }
+            else if (!empty)
+            {
+                // A root element around the test cases.
+                XmlString child;
+                bool childEmpty;
+                while (NextChild(element, &child, &childEmpty))
+                {
+                    if (child != "testcase")
+                    {
+                        UnknownElement(child, element);
+                    }
+                    ParseTestCase(childEmpty, testCases);
+                }
+            }
+        }
+    }
+
+private:
+    // Characters [begin, end) of the text.
+    struct XmlString
+    {
+        const char* begin;
+        const char* end;
+
+        size_t size() const { return static_cast<size_t>(end - begin); }
+        bool operator==(const char* s) const { return strlen(s) == size() && memcmp(begin, s, size()) == 0; }
+        bool operator!=(const char* s) const { return !(*this == s); }
+        std::string str() const { return std::string(begin, end); }
+    };
+
+    // Name to index of the geometry or BLAS elements of one test case, with open addressing. Clear() starts a
+    // new generation instead of touching the slots, so a table is reused across test cases at no cost.
+    // Unnamed elements are entered under their default name, prefix followed by their 1-based index.
+    class NameTable
+    {
+    public:
+        explicit NameTable(const char* prefix) : m_prefix(prefix), m_generation(1), m_count(0) { m_slots.resize(64); }
+
+        void Clear()
+        {
+            m_generation++;
+            m_count = 0;
+        }
+
+        // Returns false if the name is already taken.
+        bool Insert(const char* name, size_t length, UINT index)
+        {
+            char defaultName[32];
+            if (!name)
+            {
+                length = static_cast<size_t>(snprintf(defaultName, sizeof(defaultName), "%s%u", m_prefix, index + 1));
+            }
+            const char* key = name ? name : defaultName;
+            if (Find(key, length) != c_notFound)
+            {
+                return false;
+            }
+            if ((m_count + 1) * 2 > m_slots.size())
+            {
+                Grow();
+            }
+            Place(Slot{ Hash(key, length), m_generation, index, name, static_cast<UINT>(length) });
+            m_count++;
+            return true;
+        }
+
+        UINT Find(const char* key, size_t length) const
+        {
+            const size_t mask = m_slots.size() - 1;
+            const uint32_t hash = Hash(key, length);
+            for (size_t i = hash & mask; m_slots[i].generation == m_generation; i = (i + 1) & mask)
+            {
+                const Slot& slot = m_slots[i];
+                if (slot.hash == hash && slot.length == length && KeyEquals(slot, key))
+                {
+                    return slot.index;
+                }
+            }
+            return c_notFound;
+        }
+
+        static const UINT c_notFound = ~0u;
+
+    private:
+        struct Slot
+        {
+            uint32_t hash;
+            uint32_t generation;
+            UINT index;
+            const char* name;       // Null for a default name.
+            UINT length;
+        };
+
+        // FNV-1a.
+        static uint32_t Hash(const char* key, size_t length)
+        {
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < length; i++)
+            {
+                hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+            }
+            return hash;
+        }
+
+        bool KeyEquals(const Slot& slot, const char* key) const
+        {
+            if (slot.name)
+            {
+                return memcmp(slot.name, key, slot.length) == 0;
+            }
+            char defaultName[32];
+            snprintf(defaultName, sizeof(defaultName), "%s%u", m_prefix, slot.index + 1);
+            return memcmp(defaultName, key, slot.length) == 0;
+        }
+
+        void Place(const Slot& slot)
+        {
+            const size_t mask = m_slots.size() - 1;
+            size_t i = slot.hash & mask;
+            while (m_slots[i].generation == m_generation)
+            {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = slot;
+        }
+
+        void Grow()
+        {
+            std::vector<Slot> slots(m_slots.size() * 2);
+            slots.swap(m_slots);
+            for (const Slot& slot : slots)
+            {
+                if (slot.generation == m_generation)
+                {
+                    Place(slot);
+                }
+            }
+        }
+
+        const char* m_prefix;
+        std::vector<Slot> m_slots;      // Power of two size, at most half full.
+        uint32_t m_generation;
+        UINT m_count;
+    };
+
+    // A name that is resolved once the whole test case is read.
+    struct PendingReference
+    {
+        XmlString name;
+        UINT owner;     // BLAS or TLAS desc index.
+        UINT slot;      // Index into the BLAS desc's geomIndices.
+    };
+
+    [[noreturn]] void Error(const char* position, const std::string& message) const
+    {
+        UINT line = 1;
+        for (const char* c = m_text; c < position && c < m_end; c++)
+        {
+            line += (*c == '\n');
+        }
+        throw std::runtime_error(std::string(m_sourceName) + "(" + std::to_string(line) + "): " + message);
+    }
+
+    [[noreturn]] void UnknownElement(const XmlString& element, const XmlString& parent) const
+    {
+        Error(element.begin, "unknown element <" + element.str() + "> in <" + parent.str() + ">");
+    }
+
+    static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    bool StartsWith(const char* s) const
+    {
+        size_t length = strlen(s);
+        return static_cast<size_t>(m_end - m_cursor) >= length && memcmp(m_cursor, s, length) == 0;
+    }
+
+    void SkipPast(const char* terminator)
+    {
+        const char* start = m_cursor;
+        size_t length = strlen(terminator);
+        while (!StartsWith(terminator))
+        {
+            if (m_cursor >= m_end)
+            {
+                Error(start, std::string("missing ") + terminator);
+            }
+            m_cursor++;
+        }
+        m_cursor += length;
+    }
+
+    // Skips white space, comments, processing instructions and declarations.
+    void SkipMarkup()
+    {
+        for (;;)
+        {
+            while (m_cursor < m_end && IsSpace(*m_cursor))
+            {
+                m_cursor++;
+            }
+            if (StartsWith("<!--"))
+            {
+                SkipPast("-->");
+            }
+            else if (StartsWith("<?"))
+            {
+                SkipPast("?>");
+            }
+            else if (StartsWith("<!"))
+            {
+                SkipPast(">");
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    // Reads the tag at the cursor. Returns true for a start tag, with empty set for <name/>, and false for an
+    // end tag, whose name is returned. Attributes are skipped.
+    bool ReadStartTag(XmlString* name, bool* empty)
+    {
+        if (m_cursor >= m_end || *m_cursor != '<')
+        {
+            Error(m_cursor, (m_cursor >= m_end) ? "unexpected end of file" : "unexpected text");
+        }
+        m_cursor++;
+        bool endTag = (m_cursor < m_end && *m_cursor == '/');
+        m_cursor += endTag;
+
+        name->begin = m_cursor;
+        while (m_cursor < m_end && !IsSpace(*m_cursor) && *m_cursor != '/' && *m_cursor != '>')
+        {
+            m_cursor++;
+        }
+        name->end = m_cursor;
+        if (name->size() == 0)
+        {
+            Error(name->begin, "missing element name");
+        }
+
+        char quote = 0;
+        for (; m_cursor < m_end && (quote || *m_cursor != '>'); m_cursor++)
+        {
+            if (quote)
+            {
+                quote = (*m_cursor == quote) ? 0 : quote;
+            }
+            else if (*m_cursor == '"' || *m_cursor == '\'')
+            {
+                quote = *m_cursor;
+            }
+        }
+        if (m_cursor >= m_end)
+        {
+            Error(name->begin, "unterminated tag <" + name->str());
+        }
+        *empty = !endTag && m_cursor[-1] == '/';
+        m_cursor++;
+        return !endTag;
+    }
+
+    // Reads the next child element of parent. Returns false once the cursor has passed the end tag of parent.
+    bool NextChild(const XmlString& parent, XmlString* child, bool* empty)
+    {
+        SkipMarkup();
+        if (!ReadStartTag(child, empty))
+        {
+            if (child->size() != parent.size() || memcmp(child->begin, parent.begin, parent.size()) != 0)
+            {
+                Error(child->begin, "</" + child->str() + "> does not close <" + parent.str() + ">");
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // Reads the text of element up to its end tag, without leading and trailing white space.
+    XmlString ReadText(const XmlString& element, bool empty)
+    {
+        XmlString text = { m_cursor, m_cursor };
+        if (empty)
+        {
+            return text;
+        }
+        while (m_cursor < m_end && *m_cursor != '<')
+        {
+            m_cursor++;
+        }
+        text.end = m_cursor;
+        while (text.begin < text.end && IsSpace(*text.begin))
+        {
+            text.begin++;
+        }
+        while (text.end > text.begin && IsSpace(text.end[-1]))
+        {
+            text.end--;
+        }
+
+        XmlString child;
+        bool childEmpty;
+        if (NextChild(element, &child, &childEmpty))
+        {
+            Error(child.begin, "<" + element.str() + "> cannot contain elements");
+        }
+        return text;
+    }
+
+    // Text with the predefined entities replaced.
+    static std::string Decode(const XmlString& text)
+    {
+        static const struct { const char* entity; char c; } c_entities[] =
+        {
+            { "&lt;", '<' }, { "&gt;", '>' }, { "&amp;", '&' }, { "&quot;", '"' }, { "&apos;", '\'' }
+        };
+        std::string result;
+        result.reserve(text.size());
+        for (const char* c = text.begin; c < text.end; c++)
+        {
+            bool replaced = false;
+            for (const auto& entity : c_entities)
+            {
+                size_t length = strlen(entity.entity);
+                if (static_cast<size_t>(text.end - c) >= length && memcmp(c, entity.entity, length) == 0)
+                {
+                    result += entity.c;
+                    c += length - 1;
+                    replaced = true;
+                    break;
+                }
+            }
+            if (!replaced)
+            {
+                result += *c;
+            }
+        }
+        return result;
+    }
+
+    // A float with an optional f suffix, as in the samples' source: 1.0f.
+    float ParseFloat(const XmlString& text) const
+    {
+        char* end = nullptr;
+        float value = strtof(text.begin, &end);
+        if (end != text.begin && end < text.end && (*end == 'f' || *end == 'F'))
+        {
+            end++;
+        }
+        if (end == text.begin || end != text.end)
+        {
+            Error(text.begin, "'" + text.str() + "' is not a number");
+        }
+        return value;
+    }
+
+    UINT ParseUInt(const XmlString& text) const
+    {
+        char* end = nullptr;
+        unsigned long value = (text.size() && *text.begin != '-') ? strtoul(text.begin, &end, 10) : 0;
+        if (end != text.end || text.size() == 0 || value > 0xFFFFFFFFul)
+        {
+            Error(text.begin, "'" + text.str() + "' is not an unsigned integer");
+        }
+        return static_cast<UINT>(value);
+    }
+
+    D3D12_RAYTRACING_GEOMETRY_TYPE ParseGeometryType(const XmlString& text) const
+    {
+        if (text == "d3d12_tri") return D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+        if (text == "d3d12_aabb") return D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS;
+        Error(text.begin, "unknown geometry type '" + text.str() + "', expected d3d12_tri or d3d12_aabb");
+    }
+
+    void ParseTestCase(bool empty, std::vector<TestCaseDescs>* testCases)
+    {
+        static const XmlString c_testCase = { "testcase", "testcase" + 8 };
+        testCases->emplace_back();
+        TestCaseDescs& testCase = testCases->back();
+        m_geometryNames.Clear();
+        m_blasNames.Clear();
+        m_geometryReferences.clear();
+        m_blasReferences.clear();
+        m_blasTypeSet.clear();
+
+        XmlString child;
+        bool childEmpty;
+        while (!empty && NextChild(c_testCase, &child, &childEmpty))
+        {
+            if (child == "name")
+            {
+                testCase.name = Decode(ReadText(child, childEmpty));
+            }
+            else if (child == "geometry")
+            {
+                ParseGeometry(child, childEmpty, &testCase);
+            }
+            else if (child == "blas")
+            {
+                ParseBlas(child, childEmpty, &testCase);
+            }
+            else if (child == "tlas")
+            {
+                ParseTlas(child, childEmpty, &testCase);
+            }
+            else
+            {
+                UnknownElement(child, c_testCase);
+            }
+        }
+
+        for (const PendingReference& reference : m_geometryReferences)
+        {
+            UINT geometry = Resolve(m_geometryNames, reference.name, "geometry");
+            DxBlasDesc& blas = testCase.blasDescs[reference.owner];
+            blas.geomIndices[reference.slot] = static_cast<int>(geometry);
+            if (reference.slot == 0 && !m_blasTypeSet[reference.owner])
+            {
+                blas.geomType = testCase.geomDescs[geometry].geomType;
+            }
+        }
+        for (const PendingReference& reference : m_blasReferences)
+        {
+            testCase.tlasDescs[reference.owner].blasIndex = Resolve(m_blasNames, reference.name, "BLAS");
+        }
+        if (testCase.name.empty())
+        {
+            testCase.name = "testcase" + std::to_string(testCases->size());
+        }
+    }
+
+    UINT Resolve(const NameTable& names, const XmlString& name, const char* kind) const
+    {
+        UINT index = names.Find(name.begin, name.size());
+        if (index == NameTable::c_notFound)
+        {
+            Error(name.begin, std::string("no ") + kind + " named '" + name.str() + "'");
+        }
+        return index;
+    }
+
+    void AddName(NameTable* names, const XmlString* name, UINT index, const char* kind)
+    {
+        if (!names->Insert(name ? name->begin : nullptr, name ? name->size() : 0, index))
+        {
+            Error(name ? name->begin : m_cursor, std::string("duplicate ") + kind + " name");
+        }
+    }
+
+    void ParseGeometry(const XmlString& element, bool empty, TestCaseDescs* testCase)
+    {
+        const UINT index = static_cast<UINT>(testCase->geomDescs.size());
+        const char* start = element.begin;
+        XmlString name = {};
+        bool hasName = false;
+        const char* modelText = nullptr;
+        ModelGeometry model = TriangleModel;
+        int geomIndex = -1;
+        int geomType = -1;
+        D3D12_RAYTRACING_GEOMETRY_FLAGS flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+
+        XmlString child;
+        bool childEmpty;
+        while (!empty && NextChild(element, &child, &childEmpty))
+        {
+            XmlString text = ReadText(child, childEmpty);
+            if (child == "name")
+            {
+                name = text;
+                hasName = true;
+            }
+            else if (child == "model")
+            {
+                modelText = text.begin;
+                if (text == "tri") model = TriangleModel;
+                else if (text == "square") model = SquareModel;
+                else if (text == "aabb") model = AABBModel;
+                else Error(text.begin, "unknown model '" + text.str() + "', expected tri, square or aabb");
+            }
+            else if (child == "index")
+            {
+                geomIndex = static_cast<int>(ParseUInt(text));
+            }
+            else if (child == "type")
+            {
+                geomType = ParseGeometryType(text);
+            }
+            else if (child == "flags")
+            {
+                if (text == "opaque") flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+                else if (text == "none") flags = D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
+                else if (text == "no_duplicate_anyhit") flags = D3D12_RAYTRACING_GEOMETRY_FLAG_NO_DUPLICATE_ANYHIT_INVOCATION;
+                else Error(text.begin, "unknown geometry flags '" + text.str() + "', expected opaque, none or no_duplicate_anyhit");
+            }
+            else
+            {
+                UnknownElement(child, element);
+            }
+        }
+        if (!modelText)
+        {
+            Error(start, "<geometry> without <model>");
+        }
+
+        GeomDesc geomDesc;
+        geomDesc.geomIndex = (geomIndex >= 0) ? geomIndex : (model == SquareModel ? 1 : 0);
+        geomDesc.geomType = (geomType >= 0) ? static_cast<D3D12_RAYTRACING_GEOMETRY_TYPE>(geomType)
+            : (model == AABBModel ? D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS : D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES);
+        geomDesc.flags = flags;
+        testCase->geomDescs.push_back(geomDesc);
+        testCase->models.push_back(model);
+        AddName(&m_geometryNames, hasName ? &name : nullptr, index, "geometry");
+    }
+
+    void ParseBlas(const XmlString& element, bool empty, TestCaseDescs* testCase)
+    {
+        const UINT index = static_cast<UINT>(testCase->blasDescs.size());
+        testCase->blasDescs.emplace_back();
+        DxBlasDesc& blasDesc = testCase->blasDescs.back();
+        blasDesc.geomType = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+        m_blasTypeSet.push_back(0);
+        XmlString name = {};
+        bool hasName = false;
+
+        XmlString child;
+        bool childEmpty;
+        while (!empty && NextChild(element, &child, &childEmpty))
+        {
+            XmlString text = ReadText(child, childEmpty);
+            if (child == "name")
+            {
+                name = text;
+                hasName = true;
+            }
+            else if (child == "geoptr")
+            {
+                m_geometryReferences.push_back({ text, index, static_cast<UINT>(blasDesc.geomIndices.size()) });
+                blasDesc.geomIndices.push_back(-1);
+            }
+            else if (child == "type")
+            {
+                blasDesc.geomType = ParseGeometryType(text);
+                m_blasTypeSet[index] = 1;
+            }
+            else
+            {
+                UnknownElement(child, element);
+            }
+        }
+        if (blasDesc.geomIndices.empty())
+        {
+            Error(element.begin, "<blas> without <geoptr>");
+        }
+        AddName(&m_blasNames, hasName ? &name : nullptr, index, "BLAS");
+    }
+
+    void ParseTlas(const XmlString& element, bool empty, TestCaseDescs* testCase)
+    {
+        const UINT index = static_cast<UINT>(testCase->tlasDescs.size());
+        float scale[3] = { 1.0f, 1.0f, 1.0f };
+        float translate[3] = { 0.0f, 0.0f, 0.0f };
+        UINT hitIndexContribution = 0;
+        bool hasBlas = false;
+
+        XmlString child;
+        bool childEmpty;
+        while (!empty && NextChild(element, &child, &childEmpty))
+        {
+            if (child == "instanceDesc")
+            {
+                XmlString field;
+                bool fieldEmpty;
+                while (!childEmpty && NextChild(child, &field, &fieldEmpty))
+                {
+                    float value = ParseFloat(ReadText(field, fieldEmpty));
+                    if (field == "scale") scale[0] = scale[1] = scale[2] = value;
+                    else if (field == "scaleX") scale[0] = value;
+                    else if (field == "scaleY") scale[1] = value;
+                    else if (field == "scaleZ") scale[2] = value;
+                    else if (field == "translateX") translate[0] = value;
+                    else if (field == "translateY") translate[1] = value;
+                    else if (field == "translateZ") translate[2] = value;
+                    else UnknownElement(field, child);
+                }
+                continue;
+            }
+
+            XmlString text = ReadText(child, childEmpty);
+            if (child == "blasptr")
+            {
+                m_blasReferences.push_back({ text, index, 0 });
+                hasBlas = true;
+            }
+            else if (child == "hitIndexContribution")
+            {
+                hitIndexContribution = ParseUInt(text);
+            }
+            else
+            {
+                UnknownElement(child, element);
+            }
+        }
+        if (!hasBlas)
+        {
+            Error(element.begin, "<tlas> without <blasptr>");
+        }
+
+        DxTlasDesc tlasDesc;
+        tlasDesc.blasIndex = 0;
+        tlasDesc.instanceContributionToHitIndex = hitIndexContribution;
+        GetTransform3x4Matrix(&tlasDesc.transformMatrix, scale[0], scale[1], scale[2], translate[0], translate[1], translate[2]);
+        testCase->tlasDescs.push_back(tlasDesc);
+    }
+
+    const char* m_text;
+    const char* m_cursor;
+    const char* m_end;
+    const char* m_sourceName;
+
+    NameTable m_geometryNames;
+    NameTable m_blasNames;
+    std::vector<PendingReference> m_geometryReferences;
+    std::vector<PendingReference> m_blasReferences;
+    std::vector<UINT8> m_blasTypeSet;
+};
+
+// Parses the test cases of an XML text. Throws std::runtime_error on malformed input.
+inline std::vector<TestCaseDescs> ParseTestCasesXml(const std::string& text, const char* sourceName = "testcases.xml")
+{
+    std::vector<TestCaseDescs> testCases;
+    TestCaseXmlParser parser;
+    parser.Parse(text.c_str(), text.size(), sourceName, &testCases);
+    return testCases;
+}
+
+// Reads and parses a testcases.xml file. Throws std::runtime_error if it cannot be read or is malformed.
+inline std::vector<TestCaseDescs> LoadTestCasesXml(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        throw std::runtime_error(std::string("Cannot open ") + path);
+    }
+    std::string text;
+    char buffer[65536];
+    for (size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+    {
+        text.append(buffer, read);
+    }
+    fclose(file);
+    return ParseTestCasesXml(text, path);
+}
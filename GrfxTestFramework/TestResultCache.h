@@ -0,0 +1,229 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Result caches: the image hash and timings of passed runs, keyed on a hash of everything that decides the image,
+// so a run whose key is already recorded does not have to be rendered again.
+//
+// TestCacheKeyBuilder hashes field by field, never whole structs, so padding never reaches a key and keys stay
+// stable between builds. What goes into a key is up to the runner: the descs, the shaders, the shader tables and
+// the resolution at least.
+//
+// The cache file is text, one line per run name: "<key> <image hash> <build ms> <render ms> <name>", with the
+// hashes as 16 hex digits. Saving keeps only the last key recorded for each name, so the file does not grow with
+// every change to a test case.
+
+#include "TestSuiteBinary.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+
+static const char c_testResultCacheHeader[] = "# GrfxTestResultCache 1";
+
+// 64 bit FNV-1a over the values added to it.
+class TestCacheKeyBuilder
+{
+public:
+    TestCacheKeyBuilder() : m_key(14695981039346656037ull) {}
+
+    void AddBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_key = (m_key ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    void Add(T value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Add() takes scalars; add structs by field");
+        AddBytes(&value, sizeof(value));
+    }
+
+    // Prefixed with its length, so that consecutive strings cannot run into each other.
+    void AddString(const std::string& text)
+    {
+        Add(static_cast<uint64_t>(text.size()));
+        AddBytes(text.data(), text.size());
+    }
+
+    void AddDescs(const std::vector<GeomDesc>& geomDescs, const std::vector<DxBlasDesc>& blasDescs, const std::vector<DxTlasDesc>& tlasDescs)
+    {
+        Add(static_cast<uint64_t>(geomDescs.size()));
+        for (const GeomDesc& geomDesc : geomDescs)
+        {
+            Add(geomDesc.geomIndex);
+            Add(geomDesc.geomType);
+            Add(geomDesc.flags);
+        }
+        Add(static_cast<uint64_t>(blasDescs.size()));
+        for (const DxBlasDesc& blasDesc : blasDescs)
+        {
+            Add(blasDesc.geomType);
+            Add(static_cast<uint64_t>(blasDesc.geomIndices.size()));
+            for (int geomIndex : blasDesc.geomIndices)
+            {
+                Add(geomIndex);
+            }
+        }
+        Add(static_cast<uint64_t>(tlasDescs.size()));
+        for (const DxTlasDesc& tlasDesc : tlasDescs)
+        {
+            Add(tlasDesc.blasIndex);
+            Add(tlasDesc.instanceContributionToHitIndex);
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    Add(tlasDesc.transformMatrix.m[r][c]);
+                }
+            }
+        }
+    }
+
+    void AddModels(const std::vector<ModelGeometry>& models)
+    {
+        Add(static_cast<uint64_t>(models.size()));
+        for (ModelGeometry model : models)
+        {
+            Add(model);
+        }
+    }
+
+    // The contents of a file, such as a shader blob or the executable the shaders are compiled into.
+    // Throws std::runtime_error if path cannot be read.
+    void AddFile(const char* path)
+    {
+        MappedFile file;
+        file.Open(path);
+        Add(static_cast<uint64_t>(file.GetSize()));
+        AddBytes(file.GetData(), file.GetSize());
+    }
+
+    UINT64 GetKey() const { return m_key; }
+
+private:
+    UINT64 m_key;
+};
+
+struct TestCacheEntry
+{
+    UINT64 imageHash;
+    float buildMs;
+    float renderMs;
+};
+
+class TestResultCache
+{
+public:
+    // A missing file is an empty cache. Throws std::runtime_error if the file exists but is not a cache.
+    void Load(const char* path)
+    {
+        m_entries.clear();
+        m_keysByName.clear();
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            return;
+        }
+
+        char line[4096];
+        bool valid = fgets(line, sizeof(line), file) && strncmp(line, c_testResultCacheHeader, sizeof(c_testResultCacheHeader) - 1) == 0;
+        while (valid && fgets(line, sizeof(line), file))
+        {
+            unsigned long long key, imageHash;
+            TestCacheEntry entry;
+            int nameOffset = 0;
+            valid = sscanf(line, "%16llx %16llx %f %f %n", &key, &imageHash, &entry.buildMs, &entry.renderMs, &nameOffset) == 4 && nameOffset > 0;
+            if (valid)
+            {
+                std::string name(line + nameOffset);
+                name.erase(name.find_last_not_of("\r\n") + 1);
+                entry.imageHash = imageHash;
+                Record(name, key, entry);
+            }
+        }
+        fclose(file);
+        if (!valid)
+        {
+            throw std::runtime_error(std::string(path) + " is not a test result cache");
+        }
+    }
+
+    // Writes a temporary file and replaces path with it in one step, so an interrupted save leaves the old cache.
+    // Throws std::runtime_error on failure.
+    void Save(const char* path) const
+    {
+        std::string temporaryPath = std::string(path) + ".tmp";
+        FILE* file = fopen(temporaryPath.c_str(), "wb");
+        bool written = file && fprintf(file, "%s\n", c_testResultCacheHeader) > 0;
+        for (const auto& keyByName : m_keysByName)
+        {
+            const TestCacheEntry& entry = m_entries.at(keyByName.second);
+            written = written && fprintf(file, "%016llx %016llx %.3f %.3f %s\n", static_cast<unsigned long long>(keyByName.second),
+                static_cast<unsigned long long>(entry.imageHash), entry.buildMs, entry.renderMs, keyByName.first.c_str()) > 0;
+        }
+        if (file && fclose(file) != 0)
+        {
+            written = false;
+        }
+#if defined(_WIN32)
+        written = written && MoveFileExA(temporaryPath.c_str(), path, MOVEFILE_REPLACE_EXISTING);
+#else
+        written = written && rename(temporaryPath.c_str(), path) == 0;
+#endif
+        if (!written)
+        {
+            remove(temporaryPath.c_str());
+            throw std::runtime_error(std::string("Cannot write ") + path);
+        }
+    }
+
+    // Returns nullptr if no run with this key has been recorded, under any name.
+    const TestCacheEntry* Find(UINT64 key) const
+    {
+        auto entry = m_entries.find(key);
+        return (entry != m_entries.end()) ? &entry->second : nullptr;
+    }
+
+    // The last result recorded for name and its key, to compare a new result against. Returns nullptr if there is
+    // none.
+    const TestCacheEntry* FindLast(const std::string& name, UINT64* key = nullptr) const
+    {
+        auto keyByName = m_keysByName.find(name);
+        if (keyByName == m_keysByName.end())
+        {
+            return nullptr;
+        }
+        if (key)
+        {
+            *key = keyByName->second;
+        }
+        return Find(keyByName->second);
+    }
+
+    void Record(const std::string& name, UINT64 key, const TestCacheEntry& entry)
+    {
+        m_entries[key] = entry;
+        m_keysByName[name] = key;
+    }
+
+    size_t GetRunCount() const { return m_keysByName.size(); }
+
+private:
+    std::unordered_map<UINT64, TestCacheEntry> m_entries;
+    std::map<std::string, UINT64> m_keysByName;     // Sorted, so saved caches diff well.
+};
@@ -0,0 +1,654 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Sharded runs: a driver process spreads the runs of a test suite over worker processes and merges their results.
+//
+// Each worker reads run indices from its stdin and answers each with a TestShardRecordHeader followed by the
+// run's error messages on its stdout, in the order the runs were sent. The driver keeps a couple of runs
+// queued per worker, so workers that finish early take more of the suite. When a worker dies, the run it was on
+// is reported as crashed, the runs queued behind it go back to the pool and a new worker is started, so one
+// faulting test case costs one result instead of a shard. Results are handed on in run order.
+
+#include "D3D12Compat.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace TestShardStatus
+{
+    enum Enum
+    {
+        Passed,
+        Failed,
+        Crashed,    // The worker died while running it.
+        Count
+    };
+}
+
+struct TestShardResult
+{
+    UINT runIndex;
+    TestShardStatus::Enum status;
+    bool rendered;          // imageHash, buildMs and renderMs are valid.
+    bool cached;            // Taken from a TestResultCache instead of rendered.
+    UINT64 imageHash;
+    UINT64 cacheKey;        // 0 without a cache.
+    float buildMs;
+    float renderMs;
+    std::string message;    // Errors, one per line.
+};
+
+// On the wire, followed by messageSize bytes of message.
+struct TestShardRecordHeader
+{
+    uint32_t runIndex;
+    uint8_t status;
+    uint8_t rendered;
+    uint8_t cached;
+    uint8_t reserved;
+    UINT64 imageHash;
+    UINT64 cacheKey;
+    float buildMs;
+    float renderMs;
+    uint32_t messageSize;
+    uint32_t reserved2;
+};
+static_assert(sizeof(TestShardRecordHeader) == 40, "TestShardRecordHeader is part of the worker protocol");
+
+// Reads or writes all of size bytes on a pipe. Returns false on end of file or error.
+inline bool TestShardReadPipe(int fd, void* data, size_t size)
+{
+    for (size_t done = 0; done < size;)
+    {
+#if defined(_WIN32)
+        int count = _read(fd, static_cast<char*>(data) + done, static_cast<unsigned>(size - done));
+#else
+        ssize_t count = read(fd, static_cast<char*>(data) + done, size - done);
+#endif
+        if (count <= 0)
+        {
+            return false;
+        }
+        done += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+inline bool TestShardWritePipe(int fd, const void* data, size_t size)
+{
+    for (size_t done = 0; done < size;)
+    {
+#if defined(_WIN32)
+        int count = _write(fd, static_cast<const char*>(data) + done, static_cast<unsigned>(size - done));
+#else
+        ssize_t count = write(fd, static_cast<const char*>(data) + done, size - done);
+#endif
+        if (count <= 0)
+        {
+            return false;
+        }
+        done += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+inline bool TestShardReadResult(int fd, TestShardResult* result)
+{
+    TestShardRecordHeader header;
+    if (!TestShardReadPipe(fd, &header, sizeof(header)) || header.status >= TestShardStatus::Count
+        || header.messageSize > (1u << 24))
+    {
+        return false;
+    }
+    result->runIndex = header.runIndex;
+    result->status = static_cast<TestShardStatus::Enum>(header.status);
+    result->rendered = header.rendered != 0;
+    result->cached = header.cached != 0;
+    result->imageHash = header.imageHash;
+    result->cacheKey = header.cacheKey;
+    result->buildMs = header.buildMs;
+    result->renderMs = header.renderMs;
+    result->message.resize(header.messageSize);
+    return !header.messageSize || TestShardReadPipe(fd, &result->message[0], header.messageSize);
+}
+
+inline bool TestShardWriteResult(int fd, const TestShardResult& result)
+{
+    TestShardRecordHeader header = {};
+    header.runIndex = result.runIndex;
+    header.status = static_cast<uint8_t>(result.status);
+    header.rendered = result.rendered;
+    header.cached = result.cached;
+    header.imageHash = result.imageHash;
+    header.cacheKey = result.cacheKey;
+    header.buildMs = result.buildMs;
+    header.renderMs = result.renderMs;
+    header.messageSize = static_cast<uint32_t>(result.message.size());
+
+    // One write per record, so a record is never left half written by a worker that dies between calls.
+    std::vector<char> record(sizeof(header) + result.message.size());
+    memcpy(record.data(), &header, sizeof(header));
+    memcpy(record.data() + sizeof(header), result.message.data(), result.message.size());
+    return TestShardWritePipe(fd, record.data(), record.size());
+}
+
+// The worker's end: run indices come in on stdin and records go out on what was stdout. Stdout itself is pointed
+// at stderr, so nothing the test cases print can corrupt the records.
+class TestShardWorker
+{
+public:
+    TestShardWorker()
+    {
+        fflush(stdout);
+#if defined(_WIN32)
+        // A crash must end the process, not wait on an error dialog.
+        SetErrorMode(SEM_FAILCRITICALERRORS | SEM_NOGPFAULTERRORBOX);
+        _setmode(_fileno(stdin), _O_BINARY);
+        m_resultFd = _dup(_fileno(stdout));
+        _setmode(m_resultFd, _O_BINARY);
+        _dup2(_fileno(stderr), _fileno(stdout));
+#else
+        m_resultFd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+#endif
+        if (m_resultFd < 0)
+        {
+            throw std::runtime_error("Cannot open the shard result pipe");
+        }
+    }
+
+    // Returns false once the driver has no more runs for this worker.
+    bool NextRun(UINT* runIndex)
+    {
+        uint32_t index;
+        if (!TestShardReadPipe(0, &index, sizeof(index)))
+        {
+            return false;
+        }
+        *runIndex = index;
+        return true;
+    }
+
+    bool WriteResult(const TestShardResult& result) { return TestShardWriteResult(m_resultFd, result); }
+
+private:
+    int m_resultFd;
+};
+
+// A worker process with pipes on its stdin and stdout. Its stderr is the driver's.
+class TestShardProcess
+{
+public:
+    TestShardProcess() : m_input(-1), m_output(-1)
+    {
+#if defined(_WIN32)
+        m_process = nullptr;
+#else
+        m_pid = -1;
+#endif
+    }
+
+    ~TestShardProcess()
+    {
+        CloseInput();
+        CloseOutput();
+        std::string description;
+        Wait(&description);
+    }
+
+    TestShardProcess(const TestShardProcess&) = delete;
+    TestShardProcess& operator=(const TestShardProcess&) = delete;
+
+    // args[0] is the executable. Throws std::runtime_error if the process cannot be started.
+    void Start(const std::vector<std::string>& args)
+    {
+#if defined(_WIN32)
+        std::string commandLine;
+        for (const std::string& arg : args)
+        {
+            commandLine += (commandLine.empty() ? "" : " ") + QuoteArg(arg);
+        }
+
+        SECURITY_ATTRIBUTES security = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+        HANDLE inputRead, inputWrite, outputRead, outputWrite;
+        if (!CreatePipe(&inputRead, &inputWrite, &security, 0))
+        {
+            throw std::runtime_error("Cannot create a shard pipe");
+        }
+        if (!CreatePipe(&outputRead, &outputWrite, &security, 0))
+        {
+            CloseHandle(inputRead);
+            CloseHandle(inputWrite);
+            throw std::runtime_error("Cannot create a shard pipe");
+        }
+        SetHandleInformation(inputWrite, HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(outputRead, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOA startupInfo = {};
+        startupInfo.cb = sizeof(startupInfo);
+        startupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput = inputRead;
+        startupInfo.hStdOutput = outputWrite;
+        startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+        PROCESS_INFORMATION processInfo = {};
+        BOOL started = CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startupInfo, &processInfo);
+        CloseHandle(inputRead);
+        CloseHandle(outputWrite);
+        if (!started)
+        {
+            CloseHandle(inputWrite);
+            CloseHandle(outputRead);
+            throw std::runtime_error("Cannot start " + args[0]);
+        }
+        CloseHandle(processInfo.hThread);
+        m_process = processInfo.hProcess;
+        // Binary, or the CRT would turn 0x0A bytes of run indices and records into CR LF and stop reads at 0x1A.
+        m_input = _open_osfhandle(reinterpret_cast<intptr_t>(inputWrite), _O_WRONLY | _O_BINARY);
+        m_output = _open_osfhandle(reinterpret_cast<intptr_t>(outputRead), _O_RDONLY | _O_BINARY);
+#else
+        // The driver's ends are close-on-exec so that workers started later don't hold them open.
+        int input[2], output[2];
+        if (pipe(input) != 0)
+        {
+            throw std::runtime_error("Cannot create a shard pipe");
+        }
+        if (pipe(output) != 0)
+        {
+            close(input[0]);
+            close(input[1]);
+            throw std::runtime_error("Cannot create a shard pipe");
+        }
+        fcntl(input[1], F_SETFD, FD_CLOEXEC);
+        fcntl(output[0], F_SETFD, FD_CLOEXEC);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, input[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, input[0]);
+        posix_spawn_file_actions_addclose(&actions, output[1]);
+
+        std::vector<char*> argv;
+        for (const std::string& arg : args)
+        {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        int error = posix_spawnp(&m_pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(input[0]);
+        close(output[1]);
+        if (error != 0)
+        {
+            close(input[1]);
+            close(output[0]);
+            m_pid = -1;
+            throw std::runtime_error("Cannot start " + args[0]);
+        }
+        m_input = input[1];
+        m_output = output[0];
+#endif
+    }
+
+    int GetInput() const { return m_input; }
+    int GetOutput() const { return m_output; }
+
+    // Closing the input tells the worker there are no more runs.
+    void CloseInput() { CloseFd(&m_input); }
+    void CloseOutput() { CloseFd(&m_output); }
+
+    // Waits for the process to exit. Returns true if it exited with code 0, else describes how it ended.
+    bool Wait(std::string* description)
+    {
+#if defined(_WIN32)
+        if (!m_process)
+        {
+            return true;
+        }
+        DWORD exitCode = 1;
+        WaitForSingleObject(m_process, INFINITE);
+        GetExitCodeProcess(m_process, &exitCode);
+        CloseHandle(m_process);
+        m_process = nullptr;
+        char text[64];
+        snprintf(text, sizeof(text), "exit code 0x%08lx", static_cast<unsigned long>(exitCode));
+        *description = text;
+        return exitCode == 0;
+#else
+        if (m_pid < 0)
+        {
+            return true;
+        }
+        int status = 0;
+        while (waitpid(m_pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+        m_pid = -1;
+        if (WIFSIGNALED(status))
+        {
+            *description = "signal " + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+            return false;
+        }
+        *description = "exit code " + std::to_string(WEXITSTATUS(status));
+        return WEXITSTATUS(status) == 0;
+#endif
+    }
+
+private:
+    static void CloseFd(int* fd)
+    {
+        if (*fd >= 0)
+        {
+#if defined(_WIN32)
+            _close(*fd);
+#else
+            close(*fd);
+#endif
+            *fd = -1;
+        }
+    }
+
+#if defined(_WIN32)
+    static std::string QuoteArg(const std::string& arg)
+    {
+        if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos)
+        {
+            return arg;
+        }
+        std::string quoted = "\"";
+        size_t backslashes = 0;
+        for (char c : arg)
+        {
+            if (c == '\\')
+            {
+                backslashes++;
+                continue;
+            }
+            quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+            quoted += c;
+            backslashes = 0;
+        }
+        quoted.append(backslashes * 2, '\\');
+        return quoted + "\"";
+    }
+
+    HANDLE m_process;
+#else
+    pid_t m_pid;
+#endif
+    int m_input;
+    int m_output;
+};
+
+struct TestShardStatistics
+{
+    UINT runs;
+    UINT passed;
+    UINT failed;
+    UINT crashed;
+    UINT cached;            // Passed runs taken from a TestResultCache.
+    UINT workers;           // Started, including the ones replacing crashed workers.
+    double workerMs;        // Build and render time summed over the runs not taken from a cache.
+    double totalMs;
+};
+
+class TestShardDriver
+{
+public:
+    typedef std::function<void(const TestShardResult& result)> ResultCallback;
+
+    // workerArgs start a worker: args[0] is the executable. numWorkers are kept running at a time.
+    TestShardDriver(const std::vector<std::string>& workerArgs, UINT numWorkers, UINT runsQueuedPerWorker = 2) :
+        m_workerArgs(workerArgs),
+        m_numWorkers((std::max)(1u, numWorkers)),
+        m_runsQueuedPerWorker((std::max)(1u, runsQueuedPerWorker)),
+        m_nextWorkerId(0)
+    {}
+
+    // Runs numRuns runs and reports each one to onResult, in run order, as soon as it and every earlier run are
+    // done. Throws std::runtime_error if a worker cannot be started.
+    TestShardStatistics Run(UINT numRuns, const ResultCallback& onResult)
+    {
+#if !defined(_WIN32)
+        // Writing to a worker that just died must fail the write, not kill the driver.
+        signal(SIGPIPE, SIG_IGN);
+#endif
+        const auto start = Clock::now();
+        TestShardStatistics statistics = {};
+        statistics.runs = numRuns;
+
+        m_pending.clear();
+        for (UINT i = 0; i < numRuns; i++)
+        {
+            m_pending.push_back(i);
+        }
+        std::vector<std::unique_ptr<TestShardResult>> results(numRuns);
+        UINT nextToReport = 0;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        try
+        {
+            // One run each first, so that small suites still spread over all the workers.
+            for (UINT i = 0; i < m_numWorkers && !m_pending.empty(); i++)
+            {
+                workers.push_back(StartWorker(static_cast<UINT>(workers.size()), 1, &statistics));
+            }
+            for (std::unique_ptr<Worker>& worker : workers)
+            {
+                FillQueue(worker.get(), m_runsQueuedPerWorker);
+            }
+
+            while (nextToReport < numRuns)
+            {
+                Event event = WaitEvent();
+                Worker& worker = *workers[event.worker];
+
+                // A reader that has been joined may have queued more events before its worker was handled; they
+                // belong to that worker, not to the one that has since taken its slot.
+                if (event.workerId != worker.id || !worker.reader.joinable())
+                {
+                    continue;
+                }
+
+                if (!event.exited && !worker.queued.empty() && event.result.runIndex == worker.queued.front())
+                {
+                    worker.queued.pop_front();
+                    results[event.result.runIndex].reset(new TestShardResult(std::move(event.result)));
+                    FillQueue(&worker, m_runsQueuedPerWorker);
+                }
+                else
+                {
+                    // The worker ended, or broke the protocol: the run at the front of its queue crashed it.
+                    // Closing its output too makes sure a worker still writing cannot block the wait.
+                    worker.process.CloseInput();
+                    worker.reader.join();
+                    worker.process.CloseOutput();
+                    std::string description;
+                    bool exitedCleanly = worker.process.Wait(&description);
+                    if (!worker.queued.empty())
+                    {
+                        TestShardResult* crashed = new TestShardResult();
+                        crashed->runIndex = worker.queued.front();
+                        crashed->status = TestShardStatus::Crashed;
+                        crashed->rendered = false;
+                        crashed->cached = false;
+                        crashed->imageHash = 0;
+                        crashed->cacheKey = 0;
+                        crashed->buildMs = 0.0f;
+                        crashed->renderMs = 0.0f;
+                        crashed->message = exitedCleanly ? "worker stopped answering" : "worker died: " + description;
+                        results[crashed->runIndex].reset(crashed);
+                        worker.queued.pop_front();
+                        m_pending.insert(m_pending.begin(), worker.queued.begin(), worker.queued.end());
+                        worker.queued.clear();
+                    }
+                    if (!m_pending.empty())
+                    {
+                        workers[event.worker] = StartWorker(event.worker, m_runsQueuedPerWorker, &statistics);
+                    }
+                }
+
+                for (; nextToReport < numRuns && results[nextToReport]; nextToReport++)
+                {
+                    TestShardResult& result = *results[nextToReport];
+                    statistics.passed += result.status == TestShardStatus::Passed;
+                    statistics.failed += result.status == TestShardStatus::Failed;
+                    statistics.crashed += result.status == TestShardStatus::Crashed;
+                    statistics.cached += result.cached;
+                    statistics.workerMs += result.cached ? 0.0 : result.buildMs + result.renderMs;
+                    onResult(result);
+                    results[nextToReport].reset();
+                }
+            }
+        }
+        catch (...)
+        {
+            StopWorkers(&workers);
+            throw;
+        }
+
+        StopWorkers(&workers);
+        statistics.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return statistics;
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct Worker
+    {
+        UINT id;                    // Unique per start, to tell its events from those of earlier workers in its slot.
+        TestShardProcess process;
+        std::thread reader;
+        std::deque<UINT> queued;    // Sent to the worker and not answered yet, in the order they were sent.
+    };
+
+    struct Event
+    {
+        UINT worker;                // The slot in the workers vector.
+        UINT workerId;
+        bool exited;                // Set when the worker's output ended.
+        TestShardResult result;
+    };
+
+    std::unique_ptr<Worker> StartWorker(UINT index, UINT runsToQueue, TestShardStatistics* statistics)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->id = m_nextWorkerId++;
+        worker->process.Start(m_workerArgs);
+        statistics->workers++;
+
+        // Blocking reads on a thread per worker work the same on anonymous pipes everywhere.
+        Worker* w = worker.get();
+        UINT id = worker->id;
+        worker->reader = std::thread([this, w, index, id]()
+        {
+            Event event = {};
+            event.worker = index;
+            event.workerId = id;
+            while (TestShardReadResult(w->process.GetOutput(), &event.result))
+            {
+                PushEvent(event);
+            }
+            event.exited = true;
+            PushEvent(event);
+        });
+        FillQueue(worker.get(), runsToQueue);
+        return worker;
+    }
+
+    void FillQueue(Worker* worker, UINT runsToQueue)
+    {
+        while (worker->queued.size() < runsToQueue && !m_pending.empty())
+        {
+            uint32_t runIndex = m_pending.front();
+            // A failed write means the worker died; its reader reports that.
+            if (!TestShardWritePipe(worker->process.GetInput(), &runIndex, sizeof(runIndex)))
+            {
+                return;
+            }
+            m_pending.pop_front();
+            worker->queued.push_back(runIndex);
+        }
+        if (worker->queued.empty())
+        {
+            worker->process.CloseInput();
+        }
+    }
+
+    void PushEvent(const Event& event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push_back(event);
+        m_eventAdded.notify_one();
+    }
+
+    Event WaitEvent()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_eventAdded.wait(lock, [this]() { return !m_events.empty(); });
+        Event event = std::move(m_events.front());
+        m_events.pop_front();
+        return event;
+    }
+
+    void StopWorkers(std::vector<std::unique_ptr<Worker>>* workers)
+    {
+        for (std::unique_ptr<Worker>& worker : *workers)
+        {
+            if (worker->reader.joinable())
+            {
+                worker->process.CloseInput();
+                worker->reader.join();
+                worker->process.CloseOutput();
+                std::string description;
+                worker->process.Wait(&description);
+            }
+        }
+        workers->clear();
+        m_events.clear();
+    }
+
+    std::vector<std::string> m_workerArgs;
+    UINT m_numWorkers;
+    UINT m_runsQueuedPerWorker;
+    UINT m_nextWorkerId;
+    std::deque<UINT> m_pending;     // Runs not sent to any worker yet.
+    std::mutex m_mutex;
+    std::condition_variable m_eventAdded;
+    std::deque<Event> m_events;
+};
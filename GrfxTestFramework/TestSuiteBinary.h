@@ -0,0 +1,470 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Binary test suites: the test cases of a testcases.xml file compiled into one blob that is memory mapped and
+// read in place, so opening a suite of any size costs a validation pass instead of a parse.
+//
+// The blob is a TestSuiteHeader followed by sections at 16 byte aligned offsets:
+//   test cases      TestSuiteCase per test case: its name and ranges of the arrays below.
+//   geometry descs  GeomDesc, as the samples use them.
+//   models          UINT8 ModelGeometry per geometry desc.
+//   BLAS descs      TestSuiteBlasDesc: a range of the geometry indices and the geometry type.
+//   geometry indices  int per BLAS geometry, indexing the geometry descs of its test case.
+//   TLAS descs      DxTlasDesc, as the samples use them.
+//   strings         Null terminated test case names.
+// Everything is little endian. Bump c_testSuiteVersion when the layout changes; older blobs are rejected.
+
+#include "TestCaseXml.h"
+#include <cstddef>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char c_testSuiteMagic[8] = { 'G', 'R', 'F', 'X', 'S', 'U', 'I', 'T' };
+static const uint32_t c_testSuiteVersion = 1;
+static const uint32_t c_testSuiteEndianTag = 0x01020304;
+static const uint32_t c_testSuiteSectionAlignment = 16;
+
+namespace TestSuiteSection
+{
+    enum Enum
+    {
+        TestCases,
+        GeomDescs,
+        Models,
+        BlasDescs,
+        GeomIndices,
+        TlasDescs,
+        Strings,
+        Count
+    };
+}
+
+struct TestSuiteHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint64_t fileSize;
+    uint32_t counts[TestSuiteSection::Count];      // Elements (bytes for Strings) per section.
+    uint32_t reserved;
+    uint64_t offsets[TestSuiteSection::Count];
+};
+
+struct TestSuiteCase
+{
+    uint32_t nameOffset;        // Into the strings.
+    uint32_t nameLength;        // Without the null terminator.
+    uint32_t firstGeomDesc;
+    uint32_t numGeomDescs;
+    uint32_t firstBlasDesc;
+    uint32_t numBlasDescs;
+    uint32_t firstTlasDesc;
+    uint32_t numTlasDescs;
+};
+
+struct TestSuiteBlasDesc
+{
+    uint32_t firstGeomIndex;
+    uint32_t numGeomIndices;
+    D3D12_RAYTRACING_GEOMETRY_TYPE geomType;
+};
+
+// The descs are stored as the samples declare them.
+static_assert(sizeof(GeomDesc) == 12 && std::is_trivially_copyable<GeomDesc>::value, "GeomDesc layout changed");
+static_assert(sizeof(DxTlasDesc) == 56 && std::is_trivially_copyable<DxTlasDesc>::value, "DxTlasDesc layout changed");
+static_assert(sizeof(D3D12_RAYTRACING_GEOMETRY_TYPE) == 4, "Geometry types must be 32 bit");
+
+// Compiles testCases into a binary suite.
+inline void CompileTestSuite(const std::vector<TestCaseDescs>& testCases, std::vector<uint8_t>* blob)
+{
+    std::vector<TestSuiteCase> cases;
+    std::vector<GeomDesc> geomDescs;
+    std::vector<uint8_t> models;
+    std::vector<TestSuiteBlasDesc> blasDescs;
+    std::vector<int> geomIndices;
+    std::vector<DxTlasDesc> tlasDescs;
+    std::string strings;
+    cases.reserve(testCases.size());
+
+    for (const TestCaseDescs& testCase : testCases)
+    {
+        TestSuiteCase record;
+        record.nameOffset = static_cast<uint32_t>(strings.size());
+        record.nameLength = static_cast<uint32_t>(testCase.name.size());
+        record.firstGeomDesc = static_cast<uint32_t>(geomDescs.size());
+        record.numGeomDescs = static_cast<uint32_t>(testCase.geomDescs.size());
+        record.firstBlasDesc = static_cast<uint32_t>(blasDescs.size());
+        record.numBlasDescs = static_cast<uint32_t>(testCase.blasDescs.size());
+        record.firstTlasDesc = static_cast<uint32_t>(tlasDescs.size());
+        record.numTlasDescs = static_cast<uint32_t>(testCase.tlasDescs.size());
+        cases.push_back(record);
+
+        strings.append(testCase.name.c_str(), testCase.name.size() + 1);
+        geomDescs.insert(geomDescs.end(), testCase.geomDescs.begin(), testCase.geomDescs.end());
+        for (size_t i = 0; i < testCase.geomDescs.size(); i++)
+        {
+            models.push_back(static_cast<uint8_t>(i < testCase.models.size() ? testCase.models[i] : TriangleModel));
+        }
+        for (const DxBlasDesc& blasDesc : testCase.blasDescs)
+        {
+            TestSuiteBlasDesc blasRecord;
+            blasRecord.firstGeomIndex = static_cast<uint32_t>(geomIndices.size());
+            blasRecord.numGeomIndices = static_cast<uint32_t>(blasDesc.geomIndices.size());
+            blasRecord.geomType = blasDesc.geomType;
+            blasDescs.push_back(blasRecord);
+            geomIndices.insert(geomIndices.end(), blasDesc.geomIndices.begin(), blasDesc.geomIndices.end());
+        }
+        tlasDescs.insert(tlasDescs.end(), testCase.tlasDescs.begin(), testCase.tlasDescs.end());
+    }
+
+    const void* sections[TestSuiteSection::Count] =
+    {
+        cases.data(), geomDescs.data(), models.data(), blasDescs.data(), geomIndices.data(), tlasDescs.data(), strings.data()
+    };
+    const size_t counts[TestSuiteSection::Count] =
+    {
+        cases.size(), geomDescs.size(), models.size(), blasDescs.size(), geomIndices.size(), tlasDescs.size(), strings.size()
+    };
+    const size_t strides[TestSuiteSection::Count] =
+    {
+        sizeof(TestSuiteCase), sizeof(GeomDesc), sizeof(uint8_t), sizeof(TestSuiteBlasDesc), sizeof(int), sizeof(DxTlasDesc), 1
+    };
+
+    TestSuiteHeader header = {};
+    memcpy(header.magic, c_testSuiteMagic, sizeof(header.magic));
+    header.version = c_testSuiteVersion;
+    header.endianTag = c_testSuiteEndianTag;
+    uint64_t offset = sizeof(TestSuiteHeader);
+    for (int section = 0; section < TestSuiteSection::Count; section++)
+    {
+        if (counts[section] > 0xFFFFFFFFu)
+        {
+            throw std::runtime_error("Test suite too large for the binary format.");
+        }
+        offset = (offset + c_testSuiteSectionAlignment - 1) / c_testSuiteSectionAlignment * c_testSuiteSectionAlignment;
+        header.counts[section] = static_cast<uint32_t>(counts[section]);
+        header.offsets[section] = offset;
+        offset += counts[section] * strides[section];
+    }
+    header.fileSize = offset;
+
+    blob->assign(static_cast<size_t>(header.fileSize), 0);
+    memcpy(blob->data(), &header, sizeof(header));
+    for (int section = 0; section < TestSuiteSection::Count; section++)
+    {
+        if (counts[section])
+        {
+            memcpy(blob->data() + header.offsets[section], sections[section], counts[section] * strides[section]);
+        }
+    }
+}
+
+// Compiles testCases and writes the binary suite to path. Throws std::runtime_error if it cannot be written.
+inline void SaveTestSuite(const std::vector<TestCaseDescs>& testCases, const char* path)
+{
+    std::vector<uint8_t> blob;
+    CompileTestSuite(testCases, &blob);
+    FILE* file = fopen(path, "wb");
+    bool written = file && fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+    if (file && fclose(file) != 0)
+    {
+        written = false;
+    }
+    if (!written)
+    {
+        throw std::runtime_error(std::string("Cannot write ") + path);
+    }
+}
+
+inline bool IsTestSuiteBinary(const void* data, size_t size)
+{
+    return size >= sizeof(c_testSuiteMagic) && memcmp(data, c_testSuiteMagic, sizeof(c_testSuiteMagic)) == 0;
+}
+
+// Whether the file at path starts like a binary suite. False if it cannot be read.
+inline bool IsTestSuiteFile(const char* path)
+{
+    char magic[sizeof(c_testSuiteMagic)];
+    FILE* file = fopen(path, "rb");
+    size_t read = file ? fread(magic, 1, sizeof(magic), file) : 0;
+    if (file)
+    {
+        fclose(file);
+    }
+    return IsTestSuiteBinary(magic, read);
+}
+
+// A read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    MappedFile() : m_data(nullptr), m_size(0) {}
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Throws std::runtime_error if path cannot be opened or mapped.
+    void Open(const char* path)
+    {
+        Close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size = {};
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+        {
+            if (file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(file);
+            }
+            throw std::runtime_error(std::string("Cannot open ") + path);
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size)
+        {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            m_data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (mapping)
+            {
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = open(path, O_RDONLY);
+        struct stat status;
+        if (file < 0 || fstat(file, &status) != 0)
+        {
+            if (file >= 0)
+            {
+                close(file);
+            }
+            throw std::runtime_error(std::string("Cannot open ") + path);
+        }
+        m_size = static_cast<size_t>(status.st_size);
+        if (m_size)
+        {
+            void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+            m_data = (data != MAP_FAILED) ? data : nullptr;
+        }
+        close(file);
+#endif
+        if (m_size && !m_data)
+        {
+            m_size = 0;
+            throw std::runtime_error(std::string("Cannot map ") + path);
+        }
+    }
+
+    void Close()
+    {
+        if (m_data)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(m_data);
+#else
+            munmap(m_data, m_size);
+#endif
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const void* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    void* m_data;
+    size_t m_size;
+};
+
+// One test case of a TestSuiteView. The pointers point into the suite's memory.
+struct TestSuiteCaseView
+{
+    const char* name;           // Null terminated.
+    UINT nameLength;
+    const GeomDesc* geomDescs;
+    const uint8_t* models;      // ModelGeometry of each geometry desc.
+    UINT numGeomDescs;
+    const TestSuiteBlasDesc* blasDescs;
+    const int* geomIndices;     // TestSuiteBlasDesc::firstGeomIndex indexes this array.
+    UINT numBlasDescs;
+    const DxTlasDesc* tlasDescs;
+    UINT numTlasDescs;
+
+    // Copies the test case into the vectors the test cases consume.
+    void ToDescs(TestCaseDescs* descs) const
+    {
+        descs->name.assign(name, nameLength);
+        descs->models.resize(numGeomDescs);
+        for (UINT i = 0; i < numGeomDescs; i++)
+        {
+            descs->models[i] = static_cast<ModelGeometry>(models[i]);
+        }
+        descs->geomDescs.assign(geomDescs, geomDescs + numGeomDescs);
+        descs->blasDescs.resize(numBlasDescs);
+        for (UINT i = 0; i < numBlasDescs; i++)
+        {
+            const int* first = geomIndices + blasDescs[i].firstGeomIndex;
+            descs->blasDescs[i].geomIndices.assign(first, first + blasDescs[i].numGeomIndices);
+            descs->blasDescs[i].geomType = blasDescs[i].geomType;
+        }
+        descs->tlasDescs.assign(tlasDescs, tlasDescs + numTlasDescs);
+    }
+};
+
+// Read-only view of a binary suite, either memory mapped from a file or in memory the caller keeps alive.
+// Opening validates every range and index, so the views it hands out can be used without further checks.
+class TestSuiteView
+{
+public:
+    TestSuiteView() : m_header(nullptr), m_base(nullptr) {}
+
+    // Throws std::runtime_error if the file cannot be mapped or is not a valid suite.
+    void Open(const char* path)
+    {
+        m_header = nullptr;
+        m_file.Open(path);
+        Attach(m_file.GetData(), m_file.GetSize(), path);
+    }
+
+    // data must be 8 byte aligned and outlive the view.
+    void OpenMemory(const void* data, size_t size, const char* sourceName = "test suite")
+    {
+        m_header = nullptr;
+        m_file.Close();
+        Attach(data, size, sourceName);
+    }
+
+    UINT GetTestCaseCount() const { return m_header ? m_header->counts[TestSuiteSection::TestCases] : 0; }
+
+    TestSuiteCaseView GetTestCase(UINT index) const
+    {
+        const TestSuiteCase& record = Section<TestSuiteCase>(TestSuiteSection::TestCases)[index];
+        TestSuiteCaseView view;
+        view.name = Section<char>(TestSuiteSection::Strings) + record.nameOffset;
+        view.nameLength = record.nameLength;
+        view.geomDescs = Section<GeomDesc>(TestSuiteSection::GeomDescs) + record.firstGeomDesc;
+        view.models = Section<uint8_t>(TestSuiteSection::Models) + record.firstGeomDesc;
+        view.numGeomDescs = record.numGeomDescs;
+        view.blasDescs = Section<TestSuiteBlasDesc>(TestSuiteSection::BlasDescs) + record.firstBlasDesc;
+        view.geomIndices = Section<int>(TestSuiteSection::GeomIndices);
+        view.numBlasDescs = record.numBlasDescs;
+        view.tlasDescs = Section<DxTlasDesc>(TestSuiteSection::TlasDescs) + record.firstTlasDesc;
+        view.numTlasDescs = record.numTlasDescs;
+        return view;
+    }
+
+private:
+    template <typename T>
+    const T* Section(TestSuiteSection::Enum section) const
+    {
+        return reinterpret_cast<const T*>(m_base + m_header->offsets[section]);
+    }
+
+    void Attach(const void* data, size_t size, const char* sourceName)
+    {
+        auto Check = [&](bool condition, const char* message)
+        {
+            if (!condition)
+            {
+                throw std::runtime_error(std::string(sourceName) + ": " + message);
+            }
+        };
+
+        const uint8_t* base = static_cast<const uint8_t*>(data);
+        Check(IsTestSuiteBinary(data, size) && size >= sizeof(TestSuiteHeader), "not a binary test suite");
+        Check(reinterpret_cast<uintptr_t>(base) % alignof(TestSuiteHeader) == 0, "misaligned test suite");
+        const TestSuiteHeader* header = reinterpret_cast<const TestSuiteHeader*>(base);
+        Check(header->version == c_testSuiteVersion, "unsupported test suite version");
+        Check(header->endianTag == c_testSuiteEndianTag, "test suite has the wrong byte order");
+        Check(header->fileSize == size, "truncated test suite");
+
+        const size_t strides[TestSuiteSection::Count] =
+        {
+            sizeof(TestSuiteCase), sizeof(GeomDesc), sizeof(uint8_t), sizeof(TestSuiteBlasDesc), sizeof(int), sizeof(DxTlasDesc), 1
+        };
+        for (int section = 0; section < TestSuiteSection::Count; section++)
+        {
+            uint64_t offset = header->offsets[section];
+            Check(offset % c_testSuiteSectionAlignment == 0 && offset >= sizeof(TestSuiteHeader)
+                && offset + static_cast<uint64_t>(header->counts[section]) * strides[section] <= size, "test suite section out of range");
+        }
+
+        m_header = header;
+        m_base = base;
+        const uint32_t* counts = header->counts;
+        const TestSuiteCase* cases = Section<TestSuiteCase>(TestSuiteSection::TestCases);
+        const TestSuiteBlasDesc* blasDescs = Section<TestSuiteBlasDesc>(TestSuiteSection::BlasDescs);
+        const int* geomIndices = Section<int>(TestSuiteSection::GeomIndices);
+        const DxTlasDesc* tlasDescs = Section<DxTlasDesc>(TestSuiteSection::TlasDescs);
+        const char* strings = Section<char>(TestSuiteSection::Strings);
+        bool valid = (counts[TestSuiteSection::Models] == counts[TestSuiteSection::GeomDescs]);
+        for (uint32_t i = 0; valid && i < counts[TestSuiteSection::TestCases]; i++)
+        {
+            const TestSuiteCase& record = cases[i];
+            valid = static_cast<uint64_t>(record.nameOffset) + record.nameLength < counts[TestSuiteSection::Strings]
+                && strings[record.nameOffset + record.nameLength] == '\0'
+                && static_cast<uint64_t>(record.firstGeomDesc) + record.numGeomDescs <= counts[TestSuiteSection::GeomDescs]
+                && static_cast<uint64_t>(record.firstBlasDesc) + record.numBlasDescs <= counts[TestSuiteSection::BlasDescs]
+                && static_cast<uint64_t>(record.firstTlasDesc) + record.numTlasDescs <= counts[TestSuiteSection::TlasDescs];
+            for (uint32_t blas = 0; valid && blas < record.numBlasDescs; blas++)
+            {
+                const TestSuiteBlasDesc& blasDesc = blasDescs[record.firstBlasDesc + blas];
+                valid = static_cast<uint64_t>(blasDesc.firstGeomIndex) + blasDesc.numGeomIndices <= counts[TestSuiteSection::GeomIndices];
+                for (uint32_t geometry = 0; valid && geometry < blasDesc.numGeomIndices; geometry++)
+                {
+                    int geomIndex = geomIndices[blasDesc.firstGeomIndex + geometry];
+                    valid = geomIndex >= 0 && static_cast<uint32_t>(geomIndex) < record.numGeomDescs;
+                }
+            }
+            for (uint32_t tlas = 0; valid && tlas < record.numTlasDescs; tlas++)
+            {
+                valid = tlasDescs[record.firstTlasDesc + tlas].blasIndex < record.numBlasDescs;
+            }
+        }
+        if (!valid)
+        {
+            m_header = nullptr;
+            m_base = nullptr;
+            Check(false, "test suite refers to descs out of range");
+        }
+    }
+
+    MappedFile m_file;
+    const TestSuiteHeader* m_header;
+    const uint8_t* m_base;
+};
+
+// Loads the test cases of a binary suite or a testcases.xml file, told apart by the suite's magic.
+inline std::vector<TestCaseDescs> LoadTestCases(const char* path)
+{
+    if (!IsTestSuiteFile(path))
+    {
+        return LoadTestCasesXml(path);
+    }
+
+    TestSuiteView suite;
+    suite.Open(path);
+    std::vector<TestCaseDescs> testCases(suite.GetTestCaseCount());
+    for (UINT i = 0; i < suite.GetTestCaseCount(); i++)
+    {
+        suite.GetTestCase(i).ToDescs(&testCases[i]);
+    }
+    return testCases;
+}
@@ -12,6 +12,7 @@
 #include "pch.h"
 #include "Win32Application.h"
 #include "DXSampleHelper.h"
+#include "DXSampleBatchBackend.h"
 
 HWND Win32Application::m_hwnd = nullptr;
 bool Win32Application::m_fullscreenMode = false;
@@ -55,6 +56,12 @@ int Win32Application::Run(DXSample* pSample, HINSTANCE hInstance, int nCmdShow)
             hInstance,
             pSample);
 
+        if (pSample->IsBatchRun())
+        {
+            ShowWindow(m_hwnd, nCmdShow);
+            return RunBatch(pSample);
+        }
+
         // Initialize the sample. OnInit is defined in each child-implementation of DXSample.
         pSample->OnInit();
 
@@ -88,6 +95,54 @@ int Win32Application::Run(DXSample* pSample, HINSTANCE hInstance, int nCmdShow)
     }
 }
 
+// Runs every test case of the -testcases file on one device and pipeline, printing a line per test case.
+int Win32Application::RunBatch(DXSample* pSample)
+{
+    // Handled here: Run()'s handler calls OnDestroy(), and no device exists yet.
+    std::vector<TestCaseDescs> testCases;
+    try
+    {
+        testCases = pSample->ReadTestCasesFile();
+    }
+    catch (std::exception& e)
+    {
+        printf("Cannot read the test cases: %s\n", e.what());
+        OutputDebugStringA(e.what());
+        return EXIT_FAILURE;
+    }
+
+    DXSampleBatchBackend backend(pSample);
+    TestBatchStatistics statistics;
+    {
+        TestBatchRunner runner(&backend);
+        statistics = runner.Run(testCases, [&](const TestBatchResult& result)
+        {
+            char line[512];
+            snprintf(line, sizeof(line), "%-40s %s load %.2f ms render %.2f ms %s\n", result.name.c_str(),
+                result.skipped ? "SKIP" : (result.passed ? "PASS" : "FAIL"), result.loadMs, result.renderMs, result.error.c_str());
+            printf("%s", line);
+            OutputDebugStringA(line);
+
+            // Keep the window responsive, without WM_PAINT rendering frames of its own or ending the run.
+            ValidateRect(m_hwnd, nullptr);
+            MSG msg = {};
+            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE) && msg.message != WM_QUIT)
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+        });
+    }
+
+    char summary[256];
+    snprintf(summary, sizeof(summary), "%u test cases, %u failed, %u skipped, %u devices, %u device losses, %.1f ms setup, %.1f ms total\n",
+        statistics.testCases, statistics.failures, statistics.skipped, statistics.deviceCreations, statistics.deviceLosses,
+        statistics.setupMs, statistics.totalMs);
+    printf("%s", summary);
+    OutputDebugStringA(summary);
+    return (statistics.failures || statistics.skipped) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 // Convert a styled window into a fullscreen borderless window and back again.
 void Win32Application::ToggleFullscreenWindow(IDXGISwapChain* pSwapChain)
 {
@@ -26,6 +26,7 @@ public:
 
 protected:
     static LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+    static int RunBatch(DXSample* pSample);
 
 private:
     static HWND m_hwnd;